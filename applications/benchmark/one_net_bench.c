@@ -0,0 +1,1368 @@
+//! \defgroup BENCH ONE-NET protocol benchmark.
+//! @{
+
+/*
+    Copyright (c) 2012, Threshold Corporation
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+        * Redistributions of source code must retain the above copyright notice,
+          this list of conditions, and the following disclaimer.
+        * Redistributions in binary form must reproduce the above copyright
+          notice, this list of conditions and the following disclaimer in the
+          documentation and/or other materials provided with the distribution.
+        * Neither the name of Threshold Corporation (trustee of ONE-NET) nor the
+          names of its contributors may be used to endorse or promote products
+          derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+    CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+    INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+    BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+    OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+    BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHEWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*!
+    \file one_net_bench.c
+    \brief Measures ONE-NET latency and throughput on the simulated radio.
+
+    A MASTER and a chain of CLIENTs are run on the simulated transceiver
+    (see sim.h) using the dummy application code.  Every CLIENT is in range
+    of the devices next to it in the chain only, so the last CLIENT is the
+    given number of hops away from the MASTER.  The benchmark measures
+
+        single  the round trip of a single data message from the MASTER to
+                the last CLIENT, until the MASTER has the ACK
+        block   the time to send a block from the MASTER to the last CLIENT
+                and back, from on_master_initiate_block_msg /
+                on_client_initiate_block_msg until the sender is done
+        stream  the bytes per second a stream from the MASTER delivers to
+                the last CLIENT
+        invite  the time from one_net_master_invite until a CLIENT that is
+                looking for the invite has joined
+
+    for every combination of the data rates, hop counts, fragment delays and
+    chunk pauses asked for.  Each combination is one line of JSON on the
+    output with the number of runs, the failures, and the min, 50th, 90th,
+    99th percentile, max and mean of the runs that succeeded.
+
+    Times are simulated time, so the results depend only on the protocol
+    code, the options and the seed.  Links start out with no loss or delay,
+    and then every run of a combination is the same.  Given a range of link
+    loss or propagation delay, each run picks a new loss and delay for every
+    link that is in range, and the seed picks which packets are lost, so the
+    runs spread out.  The CPU time it took to simulate each combination is
+    reported too.
+*/
+
+#include "config_options.h"
+
+#if !defined(ONE_NET_MASTER) || !defined(ONE_NET_CLIENT)
+    #error "The benchmark needs both ONE_NET_MASTER and ONE_NET_CLIENT"
+#endif
+#if !defined(BLOCK_MESSAGES_ENABLED) || !defined(STREAM_MESSAGES_ENABLED)
+    #error "The benchmark needs BLOCK_MESSAGES_ENABLED and STREAM_MESSAGES_ENABLED"
+#endif
+#if !defined(ONE_NET_MULTI_HOP) || !defined(DATA_RATE_CHANNEL)
+    #error "The benchmark needs ONE_NET_MULTI_HOP and DATA_RATE_CHANNEL"
+#endif
+#ifndef ENHANCED_INVITE
+    #error "The benchmark needs ENHANCED_INVITE"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "sim.h"
+#include "one_net_types.h"
+#include "one_net_status_codes.h"
+#include "one_net_channel.h"
+#include "one_net_data_rate.h"
+#include "one_net_encode.h"
+#include "one_net_packet.h"
+#include "one_net_message.h"
+#include "one_net.h"
+#include "one_net_master.h"
+#include "one_net_client.h"
+#include "one_net_port_specific.h"
+#include "one_net_context.h"
+
+
+
+//==============================================================================
+//                                  CONSTANTS
+//! \defgroup BENCH_const
+//! \ingroup BENCH
+//! @{
+
+
+//! The most values any one option can be given
+#define BENCH_MAX_VALUES 16
+
+//! The most CLIENTs in the chain
+#define BENCH_MAX_CLIENTS (ON_MAX_HOPS_LIMIT + 1)
+
+//! Marks a fragment delay or chunk pause that was not given, so the ONE-NET
+//! default is used.
+#define BENCH_DEFAULT_VALUE 0xFFFF
+
+//! Ticks in a millisecond (ticks are microseconds on the Linux port)
+#define BENCH_TICKS_PER_MS 1000
+
+
+enum
+{
+    //! Runs of each combination if not given
+    BENCH_DEFAULT_RUNS = 10,
+
+    //! Block size in bytes if not given
+    BENCH_DEFAULT_BLOCK_SIZE = 2000,
+
+    //! Stream length in ms if not given
+    BENCH_DEFAULT_STREAM_TIME = 5000,
+
+    //! How long, in ms, a CLIENT looks for the invite and the MASTER sends
+    //! it.  The CLIENT has to scan every channel before it is sure to find
+    //! the MASTER.
+    BENCH_INVITE_TIMEOUT = 60000,
+
+    //! How long, in ms, a single message may take before the run failed
+    BENCH_SINGLE_TIMEOUT = 30000,
+
+    //! How long, in ms, a block may take before the run failed
+    BENCH_BLOCK_TIMEOUT = 600000,
+
+    //! How long, in ms, a stream may run over its length before the run
+    //! failed
+    BENCH_STREAM_OVERTIME = 60000,
+
+    //! Quiet time in ms between runs so one does not run into the next
+    BENCH_GAP = 100,
+
+    //! Quiet time in ms once a network is up so the CLIENTs are done with
+    //! joining (features, settings, etc.)
+    BENCH_SETTLE_TIME = 5000,
+
+    //! How long the devices stay on a data rate they were switched to for the
+    //! single message runs.  Any message resets it.
+    BENCH_DORMANT_TIME = 60000
+};
+
+
+//! The tests
+enum
+{
+    BENCH_SINGLE = 0x01,
+    BENCH_BLOCK = 0x02,
+    BENCH_STREAM = 0x04,
+    BENCH_INVITE = 0x08,
+    BENCH_ALL = 0x0F
+};
+
+
+//! @} BENCH_const
+//                                  CONSTANTS END
+//==============================================================================
+
+//==============================================================================
+//                                  TYPEDEFS
+//! \defgroup BENCH_typedefs
+//! \ingroup BENCH
+//! @{
+
+
+//! The values given for one option
+typedef struct
+{
+    UInt8 count;
+    UInt16 value[BENCH_MAX_VALUES];
+} bench_values_t;
+
+
+//! What one combination of the options is
+typedef struct
+{
+    const char* test;
+    const char* direction;
+    SInt16 data_rate;
+    SInt16 hops;
+    SInt32 frag_delay;
+    SInt32 chunk_pause;
+    UInt32 size;
+} bench_case_t;
+
+
+//! @} BENCH_typedefs
+//                                  TYPEDEFS END
+//==============================================================================
+
+//==============================================================================
+//                              PRIVATE VARIABLES
+//! \defgroup BENCH_pri_var
+//! \ingroup BENCH
+//! @{
+
+
+//! The tests to run
+static UInt8 tests = BENCH_ALL;
+
+//! The options to sweep.  Nothing given for the fragment delays or the
+//! chunk pauses means the ONE-NET defaults.
+static bench_values_t data_rates = {1, {ONE_NET_DATA_RATE_38_4}};
+static bench_values_t hop_counts = {1, {0}};
+static bench_values_t frag_delays = {1, {BENCH_DEFAULT_VALUE}};
+static bench_values_t chunk_pauses = {1, {BENCH_DEFAULT_VALUE}};
+
+static UInt16 runs = BENCH_DEFAULT_RUNS;
+static UInt32 block_size = BENCH_DEFAULT_BLOCK_SIZE;
+static UInt16 stream_time = BENCH_DEFAULT_STREAM_TIME;
+static UInt32 seed = 1;
+
+//! The link loss in hundredths of a percent and the propagation delay in
+//! ticks each run picks from, lowest and highest, for every link in range
+static UInt16 loss_range[2] = {SIM_LOSS_NONE, SIM_LOSS_NONE};
+static UInt16 delay_range[2] = {0, 0};
+
+//! State of the random numbers that pick the links for each run.  They are
+//! kept apart from the simulated radio's so the packets lost with a given
+//! loss do not change with how many links there are.
+static uint64_t link_random_state;
+
+static FILE* out;
+
+//! The MASTER is node 0 and CLIENT i is node i
+static on_device_context_t ctx[BENCH_MAX_CLIENTS + 1];
+static on_encoded_did_t node_did[BENCH_MAX_CLIENTS + 1];
+static UInt16 num_nodes;
+
+//! The node a run is waiting on, for the sim_run_until hooks
+static UInt16 wait_node;
+
+//! Packets put on the air
+static UInt32 tx_pkts;
+
+//! ACKs sent by ack_node
+static UInt16 ack_node = SIM_NO_NODE;
+static UInt32 acks;
+
+//! Stream data packets sent by stream_node, and when the first started and
+//! the last ended
+static UInt16 stream_node = SIM_NO_NODE;
+static UInt32 stream_pkts;
+static uint64_t stream_start;
+static uint64_t stream_end;
+
+//! The results of the runs of one combination
+static double* samples;
+static UInt16 num_samples;
+static UInt16 failures;
+static uint64_t total_pkts;
+static clock_t cpu_start;
+
+
+//! @} BENCH_pri_var
+//                              PRIVATE VARIABLES END
+//==============================================================================
+
+//==============================================================================
+//                      PRIVATE FUNCTION DECLARATIONS
+//! \defgroup BENCH_pri_func
+//! \ingroup BENCH
+//! @{
+
+
+static void usage(const char* name);
+static BOOL parse_tests(const char* arg);
+static BOOL parse_values(const char* arg, UInt16 max_value,
+  bench_values_t* values);
+static BOOL parse_range(const char* arg, UInt16 max_value, UInt16 scale,
+  UInt16* range);
+static UInt32 link_random(void);
+static UInt16 pick(const UInt16* range);
+static void set_links(UInt16 count);
+static void tx_hook(UInt16 node, uint64_t start, uint64_t end,
+  UInt8 channel, UInt8 data_rate, const UInt8* pkt, UInt8 len);
+static BOOL network_created(UInt16 node);
+static BOOL joined(UInt16 node);
+static BOOL single_done(UInt16 node);
+static BOOL bs_done(UInt16 node);
+static void free_network(void);
+static BOOL add_master(void);
+static BOOL add_client(UInt16 node, double* join_ms);
+static BOOL build_network(UInt8 hops);
+static void set_data_rate(UInt8 data_rate);
+static void wait_for_bs_idle(void);
+static void start_case(void);
+static void add_sample(double sample);
+static void report(const bench_case_t* bench_case, const char* unit);
+static int compare_samples(const void* a, const void* b);
+static double percentile(UInt8 pct);
+static void run_invite(void);
+static void run_single(UInt8 data_rate, UInt8 hops);
+static BOOL setup_block(UInt16 src, UInt16 dst, UInt8 data_rate,
+  UInt16 frag_delay, UInt16 chunk_pause, bench_case_t* bench_case);
+static void run_block(UInt16 src, UInt16 dst, UInt8 data_rate, UInt8 hops,
+  UInt16 frag_delay, UInt16 chunk_pause);
+static void run_stream(UInt8 data_rate, UInt8 hops, UInt16 frag_delay);
+
+
+//! @} BENCH_pri_func
+//                      PRIVATE FUNCTION DECLARATIONS END
+//==============================================================================
+
+//==============================================================================
+//                      PUBLIC FUNCTION IMPLEMENTATION
+//! \defgroup BENCH_pub_func
+//! \ingroup BENCH
+//! @{
+
+
+int main(int argc, char** argv)
+{
+    int opt;
+    UInt8 h, d, f, p;
+
+    out = stdout;
+    while((opt = getopt(argc, argv, "t:r:m:f:p:n:b:s:l:d:S:o:")) != -1)
+    {
+        BOOL ok = TRUE;
+        switch(opt)
+        {
+            case 't': ok = parse_tests(optarg); break;
+            case 'r': ok = parse_values(optarg, ONE_NET_DATA_RATE_LIMIT - 1,
+              &data_rates); break;
+            case 'm': ok = parse_values(optarg, ON_MAX_HOPS_LIMIT,
+              &hop_counts); break;
+            case 'f': ok = parse_values(optarg, 0xFFFE, &frag_delays); break;
+            case 'p': ok = parse_values(optarg, 0xFFFE, &chunk_pauses); break;
+            case 'n': runs = atoi(optarg); ok = (runs > 0); break;
+            case 'b': block_size = strtoul(optarg, NULL, 10);
+              ok = (block_size > 0); break;
+            case 's': stream_time = atoi(optarg); ok = (stream_time > 0);
+              break;
+            case 'l': ok = parse_range(optarg, 100, 100, loss_range); break;
+            case 'd': ok = parse_range(optarg, 0xFFFF, 1, delay_range); break;
+            case 'S': seed = strtoul(optarg, NULL, 10); break;
+            case 'o': ok = ((out = fopen(optarg, "w")) != NULL); break;
+            default: ok = FALSE;
+        }
+
+        if(!ok)
+        {
+            usage(argv[0]);
+            return 1;
+        } // if a bad option //
+    } // loop through the options //
+
+    if(optind != argc || !(samples = malloc(runs * sizeof(double))))
+    {
+        usage(argv[0]);
+        return 1;
+    } // if extra arguments or out of memory //
+
+    link_random_state = (((uint64_t) seed << 1) | 1) *
+      0x9E3779B97F4A7C15ULL;
+
+    if(tests & BENCH_INVITE)
+    {
+        run_invite();
+    } // if measuring invites //
+
+    for(h = 0; h < hop_counts.count; h++)
+    {
+        UInt8 hops = (UInt8) hop_counts.value[h];
+        UInt16 last = hops + 1;
+
+        if(!(tests & (BENCH_SINGLE | BENCH_BLOCK | BENCH_STREAM)))
+        {
+            break;
+        } // if nothing needs a network //
+
+        if(!build_network(hops))
+        {
+            fprintf(stderr, "Could not build a network with %u hops\n",
+              hops);
+            free_network();
+            return 1;
+        } // if the network could not be built //
+
+        for(d = 0; d < data_rates.count; d++)
+        {
+            UInt8 data_rate = (UInt8) data_rates.value[d];
+
+            if(tests & BENCH_SINGLE)
+            {
+                run_single(data_rate, hops);
+            } // if measuring single messages //
+
+            if(tests & BENCH_BLOCK)
+            {
+                for(f = 0; f < frag_delays.count; f++)
+                {
+                    for(p = 0; p < chunk_pauses.count; p++)
+                    {
+                        run_block(0, last, data_rate, hops,
+                          frag_delays.value[f], chunk_pauses.value[p]);
+                        run_block(last, 0, data_rate, hops,
+                          frag_delays.value[f], chunk_pauses.value[p]);
+                    } // loop through the chunk pauses //
+                } // loop through the fragment delays //
+            } // if measuring blocks //
+
+            if(tests & BENCH_STREAM)
+            {
+                for(f = 0; f < frag_delays.count; f++)
+                {
+                    run_stream(data_rate, hops, frag_delays.value[f]);
+                } // loop through the fragment delays //
+            } // if measuring streams //
+        } // loop through the data rates //
+    } // loop through the hop counts //
+
+    free_network();
+    free(samples);
+    if(out != stdout)
+    {
+        fclose(out);
+    } // if writing to a file //
+
+    return 0;
+} // main //
+
+
+//! @} BENCH_pub_func
+//                      PUBLIC FUNCTION IMPLEMENTATION END
+//==============================================================================
+
+//==============================================================================
+//                      PRIVATE FUNCTION IMPLEMENTATION
+//! \addtogroup BENCH_pri_func
+//! \ingroup BENCH
+//! @{
+
+
+static void usage(const char* name)
+{
+    fprintf(stderr,
+      "usage: %s [options]\n"
+      "  -t tests       single,block,stream,invite or all (all)\n"
+      "  -r rates       data rates, 0 (38400) to %d (0)\n"
+      "  -m hops        hop counts, 0 to %d (0)\n"
+      "  -f delays      fragment delays in ms (ONE-NET default)\n"
+      "  -p pauses      chunk pauses in ms (ONE-NET default)\n"
+      "  -n runs        runs of each combination (%d)\n"
+      "  -b bytes       block size (%d)\n"
+      "  -s ms          stream length (%d)\n"
+      "  -l pct         link loss in percent, or a range such as 5-10 (0)\n"
+      "  -d us          link propagation delay, or a range such as 0-2000 (0)\n"
+      "  -S seed        seed for the simulated radio and the links (1)\n"
+      "  -o file        write the results to a file (stdout)\n"
+      "Lists are separated by commas.  Each run picks the loss and the delay\n"
+      "of every link in range from the ranges given.  Each combination is\n"
+      "written as one line of JSON.\n", name, ONE_NET_DATA_RATE_LIMIT - 1, ON_MAX_HOPS_LIMIT,
+      BENCH_DEFAULT_RUNS, BENCH_DEFAULT_BLOCK_SIZE, BENCH_DEFAULT_STREAM_TIME);
+} // usage //
+
+
+static BOOL parse_tests(const char* arg)
+{
+    static const char* const NAMES[] = {"single", "block", "stream", "invite",
+      "all"};
+    static const UInt8 TESTS[] = {BENCH_SINGLE, BENCH_BLOCK, BENCH_STREAM,
+      BENCH_INVITE, BENCH_ALL};
+
+    tests = 0;
+    while(*arg)
+    {
+        UInt8 i;
+        size_t len = strcspn(arg, ",");
+
+        for(i = 0; i < sizeof(TESTS); i++)
+        {
+            if(strlen(NAMES[i]) == len && !strncmp(arg, NAMES[i], len))
+            {
+                tests |= TESTS[i];
+                break;
+            } // if the name matches //
+        } // loop through the tests //
+
+        if(i == sizeof(TESTS))
+        {
+            return FALSE;
+        } // if not a test //
+
+        arg += len;
+        if(*arg == ',')
+        {
+            arg++;
+        } // if there is another one //
+    } // loop through the list //
+
+    return (tests != 0);
+} // parse_tests //
+
+
+/*!
+    \brief Reads a list of numbers separated by commas.
+
+    \param[in] arg The list
+    \param[in] max_value The largest value allowed
+    \param[out] values The numbers
+
+    \return TRUE if the list is good
+*/
+static BOOL parse_values(const char* arg, UInt16 max_value,
+  bench_values_t* values)
+{
+    values->count = 0;
+    while(*arg)
+    {
+        char* end;
+        unsigned long value = strtoul(arg, &end, 10);
+
+        if(end == arg || (*end && *end != ',') || value > max_value ||
+          values->count >= BENCH_MAX_VALUES)
+        {
+            return FALSE;
+        } // if not a number, too big, or too many //
+
+        values->value[values->count++] = (UInt16) value;
+        arg = (*end == ',') ? end + 1 : end;
+    } // loop through the list //
+
+    return (values->count > 0);
+} // parse_values //
+
+
+/*!
+    \brief Reads a number or a range of numbers such as 5-10.
+
+    \param[in] arg The number or range
+    \param[in] max_value The largest value allowed
+    \param[in] scale What the numbers are multiplied by
+    \param[out] range The lowest and highest number, scaled.  The same
+      number twice if only one was given.
+
+    \return TRUE if the number or range is good
+*/
+static BOOL parse_range(const char* arg, UInt16 max_value, UInt16 scale,
+  UInt16* range)
+{
+    char* end;
+    unsigned long low = strtoul(arg, &end, 10);
+    unsigned long high = low;
+
+    if(end == arg)
+    {
+        return FALSE;
+    } // if not a number //
+
+    if(*end == '-')
+    {
+        arg = end + 1;
+        high = strtoul(arg, &end, 10);
+        if(end == arg)
+        {
+            return FALSE;
+        } // if not a number //
+    } // if a range //
+
+    if(*end || low > high || high > max_value)
+    {
+        return FALSE;
+    } // if extra characters, backwards, or too big //
+
+    range[0] = (UInt16) (low * scale);
+    range[1] = (UInt16) (high * scale);
+    return TRUE;
+} // parse_range //
+
+
+//! The same generator as the simulated radio's
+static UInt32 link_random(void)
+{
+    link_random_state ^= link_random_state >> 12;
+    link_random_state ^= link_random_state << 25;
+    link_random_state ^= link_random_state >> 27;
+    return (UInt32) ((link_random_state * 2685821657736338717ULL) >> 32);
+} // link_random //
+
+
+//! A random number from range[0] to range[1]
+static UInt16 pick(const UInt16* range)
+{
+    return range[0] + (UInt16) (link_random() % ((UInt32) range[1] -
+      range[0] + 1));
+} // pick //
+
+
+/*!
+    \brief Picks the loss and the delay of each link that is in range.
+
+    Devices next to each other in the chain are in range.  Each direction
+    of a link is picked on its own.
+
+    \param[in] count The number of devices
+
+    \return void
+*/
+static void set_links(UInt16 count)
+{
+    UInt16 i, j;
+
+    for(i = 0; i < count; i++)
+    {
+        for(j = 0; j < count; j++)
+        {
+            if(i != j && i <= j + 1 && j <= i + 1)
+            {
+                sim_set_link(i, j, pick(loss_range), pick(delay_range));
+            } // if next to each other //
+        } // loop through the other devices //
+    } // loop through the devices //
+} // set_links //
+
+
+/*!
+    \brief Counts what goes on the air.  See sim_tx_hook_t.
+*/
+static void tx_hook(UInt16 node, uint64_t start, uint64_t end,
+  UInt8 channel, UInt8 data_rate, const UInt8* pkt, UInt8 len)
+{
+    UInt16 raw_pid;
+
+    tx_pkts++;
+    if(!get_raw_pid(&pkt[ON_ENCODED_PID_IDX], &raw_pid))
+    {
+        return;
+    } // if the pid is not valid //
+
+    if(node == ack_node && packet_is_ack(raw_pid))
+    {
+        acks++;
+    } // if an ACK from the node being watched //
+
+    if(node == stream_node && (raw_pid & 0x3F) == ONE_NET_RAW_STREAM_DATA)
+    {
+        if(!stream_pkts)
+        {
+            stream_start = start;
+        } // if the first one //
+        stream_pkts++;
+        stream_end = end;
+    } // if stream data from the node being watched //
+} // tx_hook //
+
+
+//! The MASTER has picked its channel.  See sim_run_hook_t.
+static BOOL network_created(UInt16 node)
+{
+    return (node == wait_node && on_state != ON_JOIN_NETWORK &&
+      on_state != ON_INIT_STATE);
+} // network_created //
+
+
+//! The CLIENT being waited on has joined.  See sim_run_hook_t.
+static BOOL joined(UInt16 node)
+{
+    return (node == wait_node && client_joined_network);
+} // joined //
+
+
+//! The node being waited on has nothing more to send.  See sim_run_hook_t.
+static BOOL single_done(UInt16 node)
+{
+    return (node == wait_node && single_data_queue_size == 0 &&
+      single_txn.priority == ONE_NET_NO_PRIORITY);
+} // single_done //
+
+
+//! The node being waited on is done with its block or stream.  See
+//! sim_run_hook_t.
+static BOOL bs_done(UInt16 node)
+{
+    return (node == wait_node && !bs_msg.transfer_in_progress);
+} // bs_done //
+
+
+static void free_network(void)
+{
+    UInt16 i;
+
+    for(i = 0; i < num_nodes; i++)
+    {
+        one_net_context_free(&ctx[i]);
+    } // loop through the devices //
+    num_nodes = 0;
+    sim_free();
+} // free_network //
+
+
+static BOOL add_master(void)
+{
+    on_raw_sid_t sid = {0x00, 0x00, 0x00, 0x00, 0x10, 0x01};
+    one_net_xtea_key_t key;
+    UInt16 node;
+
+    if(one_net_context_init(&ctx[0]) != ONS_SUCCESS)
+    {
+        return FALSE;
+    } // if out of memory //
+
+    one_net_set_context(&ctx[0]);
+    one_net_memset(key, 0x5A, sizeof(key));
+    if(one_net_master_create_network(&sid, &key) != ONS_SUCCESS ||
+      sim_add_node(&ctx[0], TRUE, &node) != ONS_SUCCESS)
+    {
+        return FALSE;
+    } // if the network could not be created //
+
+    on_encode(node_did[0], MASTER_RAW_DID, ON_ENCODED_DID_LEN);
+    num_nodes = 1;
+
+    wait_node = 0;
+    return sim_run_until(sim_time() + (uint64_t) BENCH_INVITE_TIMEOUT *
+      BENCH_TICKS_PER_MS, &network_created);
+} // add_master //
+
+
+/*!
+    \brief Adds a CLIENT and invites it into the network.
+
+    \param[in] node The node the CLIENT is (the next one)
+    \param[out] join_ms How long it took to join, in ms
+
+    \return TRUE if the CLIENT joined
+*/
+static BOOL add_client(UInt16 node, double* join_ms)
+{
+    one_net_xtea_key_t key;
+    uint64_t start;
+    UInt16 added;
+
+    if(one_net_context_init(&ctx[node]) != ONS_SUCCESS)
+    {
+        return FALSE;
+    } // if out of memory //
+
+    one_net_set_context(&ctx[node]);
+    num_nodes++;
+    device_is_master = FALSE;
+    one_net_memset(key, 0x80 + node, sizeof(key));
+    if(one_net_client_look_for_invite(&key, 0,
+      ONE_NET_MAX_CHANNEL, BENCH_INVITE_TIMEOUT) != ONS_SUCCESS ||
+      sim_add_node(&ctx[node], FALSE, &added) != ONS_SUCCESS)
+    {
+        return FALSE;
+    } // if the CLIENT could not be started //
+
+    one_net_set_context(&ctx[0]);
+    if(one_net_master_invite(&key, BENCH_INVITE_TIMEOUT) != ONS_SUCCESS)
+    {
+        return FALSE;
+    } // if the MASTER would not send the invite //
+
+    sim_wake_node(0);
+    start = sim_time();
+    wait_node = node;
+    if(!sim_run_until(start + (uint64_t) BENCH_INVITE_TIMEOUT *
+      BENCH_TICKS_PER_MS, &joined))
+    {
+        return FALSE;
+    } // if the CLIENT did not join //
+
+    *join_ms = (double) (sim_time() - start) / BENCH_TICKS_PER_MS;
+    one_net_set_context(&ctx[0]);
+    one_net_memmove(node_did[node],
+      client_list[master_param->client_count - 1].device.did,
+      sizeof(on_encoded_did_t));
+    return TRUE;
+} // add_client //
+
+
+/*!
+    \brief Sets up a MASTER and a chain of CLIENTs.
+
+    The CLIENTs all join while they are in range of the MASTER.  Then they
+    are taken out of range of everything but the devices next to them in the
+    chain, and the devices are told how many hops they are from the MASTER
+    (the dummy application does not find that out by itself).
+
+    \param[in] hops The number of hops from the MASTER to the last CLIENT
+
+    \return TRUE if the network is up
+*/
+static BOOL build_network(UInt8 hops)
+{
+    UInt16 i, j;
+    double join_ms;
+
+    free_network();
+    if(sim_init(hops + 2, seed) != ONS_SUCCESS || !add_master())
+    {
+        return FALSE;
+    } // if the MASTER could not be added //
+
+    sim_set_tx_hook(&tx_hook);
+    for(i = 1; i <= hops + 1; i++)
+    {
+        if(!add_client(i, &join_ms))
+        {
+            return FALSE;
+        } // if the CLIENT could not join //
+    } // loop through the CLIENTs //
+
+    sim_run(sim_time() + (uint64_t) BENCH_SETTLE_TIME * BENCH_TICKS_PER_MS);
+    for(i = 0; i < num_nodes; i++)
+    {
+        for(j = 0; j < num_nodes; j++)
+        {
+            if(i + 1 < j || j + 1 < i)
+            {
+                sim_set_link(i, j, SIM_OUT_OF_RANGE, 0);
+            } // if not next to each other //
+        } // loop through the other devices //
+    } // loop through the devices //
+
+    for(i = 1; i < num_nodes; i++)
+    {
+        on_sending_device_t* device;
+
+        one_net_set_context(&ctx[0]);
+        if(!(device = (*get_sender_info)(
+          (const on_encoded_did_t*) &node_did[i])))
+        {
+            return FALSE;
+        } // if the MASTER does not know the CLIENT //
+        device->hops = i - 1;
+        device->max_hops = i - 1;
+
+        one_net_set_context(&ctx[i]);
+        if(!(device = (*get_sender_info)(
+          (const on_encoded_did_t*) &node_did[0])))
+        {
+            return FALSE;
+        } // if the CLIENT does not know the MASTER //
+        device->hops = i - 1;
+        device->max_hops = i - 1;
+    } // loop through the CLIENTs //
+
+    return TRUE;
+} // build_network //
+
+
+/*!
+    \brief Moves every device to a data rate on the network channel.
+
+    \param[in] data_rate The data rate
+
+    \return void
+*/
+static void set_data_rate(UInt8 data_rate)
+{
+    UInt16 i;
+
+    for(i = 0; i < num_nodes; i++)
+    {
+        one_net_set_context(&ctx[i]);
+        on_change_dr_channel(NULL, 0, BENCH_DORMANT_TIME,
+          on_base_param->channel, data_rate);
+        sim_wake_node(i);
+    } // loop through the devices //
+
+    sim_run(sim_time() + (uint64_t) BENCH_GAP * BENCH_TICKS_PER_MS);
+} // set_data_rate //
+
+
+/*!
+    \brief Waits until no device has a block or stream transfer going.
+
+    A device stays in a transfer for a while after it ends (the timeout
+    of the transfer), so it can answer the other side if its terminate
+    message was lost.  A new transfer would be turned down until then.
+
+    \return void
+*/
+static void wait_for_bs_idle(void)
+{
+    UInt16 i;
+
+    for(i = 0; i < num_nodes; i++)
+    {
+        one_net_set_context(&ctx[i]);
+        if(bs_msg.transfer_in_progress)
+        {
+            wait_node = i;
+            sim_run_until(sim_time() + (uint64_t) BENCH_BLOCK_TIMEOUT *
+              BENCH_TICKS_PER_MS, &bs_done);
+        } // if still in a transfer //
+    } // loop through the devices //
+} // wait_for_bs_idle //
+
+
+static void start_case(void)
+{
+    num_samples = 0;
+    failures = 0;
+    total_pkts = 0;
+    cpu_start = clock();
+} // start_case //
+
+
+static void add_sample(double sample)
+{
+    samples[num_samples++] = sample;
+} // add_sample //
+
+
+static int compare_samples(const void* a, const void* b)
+{
+    double diff = *(const double*) a - *(const double*) b;
+    return (diff > 0) - (diff < 0);
+} // compare_samples //
+
+
+/*!
+    \brief The nearest rank percentile of the (sorted) samples.
+
+    \param[in] pct The percentile
+
+    \return The sample
+*/
+static double percentile(UInt8 pct)
+{
+    UInt32 rank = (pct * num_samples + 99) / 100;
+    return samples[rank ? rank - 1 : 0];
+} // percentile //
+
+
+/*!
+    \brief Writes the results of one combination.
+
+    \param[in] bench_case What was measured.  Negative numbers are left out.
+    \param[in] unit The unit of the samples
+
+    \return void
+*/
+static void report(const bench_case_t* bench_case, const char* unit)
+{
+    UInt16 i;
+    double sum = 0;
+
+    fprintf(out, "{\"test\": \"%s\"", bench_case->test);
+    if(bench_case->direction)
+    {
+        fprintf(out, ", \"direction\": \"%s\"", bench_case->direction);
+    } // if it goes one way //
+    if(bench_case->data_rate >= 0)
+    {
+        fprintf(out, ", \"data_rate\": %d", bench_case->data_rate);
+    } // if it has a data rate //
+    if(bench_case->hops >= 0)
+    {
+        fprintf(out, ", \"hops\": %d", bench_case->hops);
+    } // if it has a hop count //
+    if(bench_case->frag_delay >= 0)
+    {
+        fprintf(out, ", \"frag_delay_ms\": %ld",
+          (long) bench_case->frag_delay);
+    } // if it has a fragment delay //
+    if(bench_case->chunk_pause >= 0)
+    {
+        fprintf(out, ", \"chunk_pause_ms\": %ld",
+          (long) bench_case->chunk_pause);
+    } // if it has a chunk pause //
+    if(bench_case->size)
+    {
+        fprintf(out, ", \"size\": %lu", (unsigned long) bench_case->size);
+    } // if it has a size //
+    if(loss_range[1])
+    {
+        fprintf(out, ", \"loss_pct\": [%u, %u]", loss_range[0] / 100,
+          loss_range[1] / 100);
+    } // if the links lose packets //
+    if(delay_range[1])
+    {
+        fprintf(out, ", \"delay_us\": [%u, %u]", delay_range[0],
+          delay_range[1]);
+    } // if the links delay packets //
+
+    fprintf(out, ", \"runs\": %u, \"failures\": %u, \"unit\": \"%s\"",
+      num_samples + failures, failures, unit);
+    if(num_samples)
+    {
+        qsort(samples, num_samples, sizeof(double), &compare_samples);
+        for(i = 0; i < num_samples; i++)
+        {
+            sum += samples[i];
+        } // loop through the samples //
+
+        fprintf(out, ", \"min\": %.3f, \"p50\": %.3f, \"p90\": %.3f, "
+          "\"p99\": %.3f, \"max\": %.3f, \"mean\": %.3f", samples[0],
+          percentile(50), percentile(90), percentile(99),
+          samples[num_samples - 1], sum / num_samples);
+        if(bench_case->size && !strcmp(unit, "ms"))
+        {
+            fprintf(out, ", \"bytes_per_s\": %.1f",
+              bench_case->size * 1000.0 / percentile(50));
+        } // if a transfer that was timed //
+        fprintf(out, ", \"pkts_per_run\": %.1f",
+          (double) total_pkts / num_samples);
+    } // if any run succeeded //
+
+    fprintf(out, ", \"cpu_ms\": %.1f}\n", (double) (clock() - cpu_start) *
+      1000.0 / CLOCKS_PER_SEC);
+    fflush(out);
+} // report //
+
+
+/*!
+    \brief Times how long it takes a CLIENT to join.
+
+    Each run is a new network with a MASTER and one CLIENT.  Where the MASTER
+    is and where the CLIENT starts looking are different each time.
+
+    \return void
+*/
+static void run_invite(void)
+{
+    bench_case_t bench_case = {"invite", NULL, -1, -1, -1, -1, 0};
+    UInt16 i;
+
+    start_case();
+    for(i = 0; i < runs; i++)
+    {
+        double join_ms;
+        UInt32 start_pkts;
+
+        free_network();
+        if(sim_init(2, seed + i) != ONS_SUCCESS || !add_master())
+        {
+            failures++;
+            continue;
+        } // if the MASTER could not be added //
+
+        sim_set_tx_hook(&tx_hook);
+        set_links(2);
+        start_pkts = tx_pkts;
+        if(add_client(1, &join_ms))
+        {
+            add_sample(join_ms);
+            total_pkts += tx_pkts - start_pkts;
+        } // if the CLIENT joined //
+        else
+        {
+            failures++;
+        } // else the CLIENT did not join //
+    } // loop through the runs //
+
+    free_network();
+    report(&bench_case, "ms");
+} // run_invite //
+
+
+/*!
+    \brief Times single data messages from the MASTER to the last CLIENT.
+
+    The first message is not counted.  It is the first the MASTER sends to
+    the CLIENT at this data rate, so it includes features being exchanged
+    and so on.
+
+    \param[in] data_rate The data rate
+    \param[in] hops The hops to the last CLIENT
+
+    \return void
+*/
+static void run_single(UInt8 data_rate, UInt8 hops)
+{
+    bench_case_t bench_case = {"single", "master_to_client", data_rate, hops,
+      -1, -1, ONA_SINGLE_PACKET_PAYLOAD_LEN};
+    UInt16 i;
+
+    set_data_rate(data_rate);
+    start_case();
+    for(i = 0; i <= runs; i++)
+    {
+        UInt8 pld[ONA_SINGLE_PACKET_PAYLOAD_LEN] = {0};
+        uint64_t start;
+        BOOL done;
+
+        set_links(num_nodes);
+        one_net_set_context(&ctx[0]);
+        if(!push_queue_element(ONE_NET_RAW_SINGLE_DATA, ON_APP_MSG, pld,
+          sizeof(pld), ONE_NET_HIGH_PRIORITY, NULL,
+          (const on_encoded_did_t*) &node_did[hops + 1]
+          #ifdef PEER
+          , FALSE, ONE_NET_DEV_UNIT
+          #endif
+          #if SINGLE_QUEUE_LEVEL > MIN_SINGLE_QUEUE_LEVEL
+          , 0
+          #endif
+          #if SINGLE_QUEUE_LEVEL > MED_SINGLE_QUEUE_LEVEL
+          , 0
+          #endif
+          ))
+        {
+            failures += (i > 0);
+            continue;
+        } // if the message could not be queued //
+
+        sim_wake_node(0);
+        start = sim_time();
+        tx_pkts = 0;
+        ack_node = hops + 1;
+        acks = 0;
+        wait_node = 0;
+        done = sim_run_until(start + (uint64_t) BENCH_SINGLE_TIMEOUT *
+          BENCH_TICKS_PER_MS, &single_done);
+
+        if(i > 0)
+        {
+            if(done && acks)
+            {
+                add_sample((double) (sim_time() - start) /
+                  BENCH_TICKS_PER_MS);
+                total_pkts += tx_pkts;
+            } // if the CLIENT got it //
+            else
+            {
+                failures++;
+            } // else it failed //
+        } // if not the first one //
+
+        ack_node = SIM_NO_NODE;
+        sim_run(sim_time() + (uint64_t) BENCH_GAP * BENCH_TICKS_PER_MS);
+    } // loop through the runs //
+
+    set_data_rate(ONE_NET_DATA_RATE_38_4);
+    report(&bench_case, "ms");
+} // run_single //
+
+
+/*!
+    \brief Fills in bs_msg the way the CLI block command does.
+
+    \param[in] src The node sending the block.  Its device is current.
+    \param[in] dst The node receiving the block
+    \param[in] data_rate The data rate
+    \param[in] frag_delay The fragment delay, or BENCH_DEFAULT_VALUE
+    \param[in] chunk_pause The chunk pause, or BENCH_DEFAULT_VALUE
+    \param[out] bench_case The fragment delay and chunk pause are filled in
+
+    \return TRUE if the block was started
+*/
+static BOOL setup_block(UInt16 src, UInt16 dst, UInt8 data_rate,
+  UInt16 frag_delay, UInt16 chunk_pause, bench_case_t* bench_case)
+{
+    on_ack_nack_t ack_nack;
+    UInt8 priority;
+    UInt16 default_chunk_pause;
+    on_nack_rsn_t nack_reason;
+
+    bs_msg.bs.block.transfer_size = block_size;
+    bs_msg.bs.block.byte_idx = 0;
+    if(!(bs_msg.dst = (*get_sender_info)(
+      (const on_encoded_did_t*) &node_did[dst])))
+    {
+        return FALSE;
+    } // if the sender does not know the receiver //
+
+    if(src == 0)
+    {
+        nack_reason = on_master_get_default_block_transfer_values(NULL,
+          client_info((const on_encoded_did_t*) &node_did[dst]), block_size,
+          &priority, &bs_msg.bs.block.chunk_size, &bs_msg.frag_dly,
+          &default_chunk_pause, &bs_msg.data_rate, &bs_msg.channel,
+          &bs_msg.timeout, &ack_nack);
+    } // if the MASTER is sending //
+    else
+    {
+        nack_reason = on_client_get_default_block_transfer_values(
+          (const on_encoded_did_t*) &(bs_msg.dst->did), block_size,
+          &priority, &bs_msg.bs.block.chunk_size, &bs_msg.frag_dly,
+          &default_chunk_pause, &bs_msg.data_rate, &bs_msg.channel,
+          &bs_msg.timeout, &ack_nack);
+    } // else a CLIENT is sending //
+
+    if(nack_reason != ON_NACK_RSN_NO_ERROR)
+    {
+        return FALSE;
+    } // if the defaults were refused //
+
+    bs_msg.data_rate = data_rate;
+    if(frag_delay != BENCH_DEFAULT_VALUE)
+    {
+        bs_msg.frag_dly = frag_delay;
+    } // if the fragment delay was given //
+    bs_msg.bs.block.chunk_pause = (chunk_pause != BENCH_DEFAULT_VALUE) ?
+      chunk_pause : default_chunk_pause;
+    bench_case->frag_delay = bs_msg.frag_dly;
+    bench_case->chunk_pause = bs_msg.bs.block.chunk_pause;
+
+    set_bs_priority(&bs_msg.flags, priority);
+    return ((src == 0 ? on_master_initiate_block_msg(&bs_msg, &ack_nack) :
+      on_client_initiate_block_msg(&bs_msg, &ack_nack)) ==
+      ON_NACK_RSN_NO_ERROR);
+} // setup_block //
+
+
+/*!
+    \brief Times blocks between the MASTER and the last CLIENT.
+
+    \param[in] src The node sending the blocks
+    \param[in] dst The node receiving the blocks
+    \param[in] data_rate The data rate
+    \param[in] hops The hops between them
+    \param[in] frag_delay The fragment delay, or BENCH_DEFAULT_VALUE
+    \param[in] chunk_pause The chunk pause, or BENCH_DEFAULT_VALUE
+
+    \return void
+*/
+static void run_block(UInt16 src, UInt16 dst, UInt8 data_rate, UInt8 hops,
+  UInt16 frag_delay, UInt16 chunk_pause)
+{
+    bench_case_t bench_case = {"block", src == 0 ? "master_to_client" :
+      "client_to_master", data_rate, hops, -1, -1, block_size};
+    UInt16 i;
+
+    start_case();
+    for(i = 0; i < runs; i++)
+    {
+        uint64_t start;
+
+        wait_for_bs_idle();
+        set_links(num_nodes);
+        one_net_set_context(&ctx[src]);
+        if(!setup_block(src, dst, data_rate, frag_delay, chunk_pause,
+          &bench_case))
+        {
+            failures++;
+            continue;
+        } // if the block could not be started //
+
+        sim_wake_node(src);
+        start = sim_time();
+        tx_pkts = 0;
+        wait_node = src;
+        if(sim_run_until(start + (uint64_t) BENCH_BLOCK_TIMEOUT *
+          BENCH_TICKS_PER_MS, &bs_done) &&
+          (UInt32) bs_msg.bs.block.byte_idx * ON_BS_DATA_PLD_SIZE >=
+          block_size)
+        {
+            add_sample((double) (sim_time() - start) / BENCH_TICKS_PER_MS);
+            total_pkts += tx_pkts;
+        } // if the block got there //
+        else
+        {
+            failures++;
+        } // else it failed //
+
+        sim_run(sim_time() + (uint64_t) BENCH_GAP * BENCH_TICKS_PER_MS);
+    } // loop through the runs //
+
+    report(&bench_case, "ms");
+} // run_block //
+
+
+/*!
+    \brief Measures how fast a stream from the MASTER gets to the last
+      CLIENT.
+
+    The bytes per second are the stream data packets the last CLIENT is sent
+    (by the MASTER, or the last repeater), from the start of the first to the
+    end of the last.
+
+    \param[in] data_rate The data rate
+    \param[in] hops The hops to the last CLIENT
+    \param[in] frag_delay The fragment delay, or BENCH_DEFAULT_VALUE
+
+    \return void
+*/
+static void run_stream(UInt8 data_rate, UInt8 hops, UInt16 frag_delay)
+{
+    bench_case_t bench_case = {"stream", "master_to_client", data_rate, hops,
+      -1, -1, 0};
+    UInt16 i;
+
+    start_case();
+    for(i = 0; i < runs; i++)
+    {
+        on_ack_nack_t ack_nack;
+        on_client_t* client;
+        UInt8 priority;
+        uint64_t start;
+        BOOL done;
+
+        wait_for_bs_idle();
+        set_links(num_nodes);
+        one_net_set_context(&ctx[0]);
+        bs_msg.time = stream_time;
+        client = client_info((const on_encoded_did_t*) &node_did[hops + 1]);
+        if(!client || !(bs_msg.dst = &client->device) ||
+          on_master_get_default_stream_transfer_values(NULL, client,
+          bs_msg.time, &priority, &bs_msg.frag_dly, &bs_msg.data_rate,
+          &bs_msg.channel, &bs_msg.timeout, &ack_nack) !=
+          ON_NACK_RSN_NO_ERROR)
+        {
+            failures++;
+            continue;
+        } // if the defaults were refused //
+
+        bs_msg.data_rate = data_rate;
+        if(frag_delay != BENCH_DEFAULT_VALUE)
+        {
+            bs_msg.frag_dly = frag_delay;
+        } // if the fragment delay was given //
+        bench_case.frag_delay = bs_msg.frag_dly;
+        set_bs_priority(&bs_msg.flags, priority);
+        if(on_master_initiate_stream_msg(&bs_msg, &ack_nack) !=
+          ON_NACK_RSN_NO_ERROR)
+        {
+            failures++;
+            continue;
+        } // if the stream could not be started //
+
+        sim_wake_node(0);
+        start = sim_time();
+        tx_pkts = 0;
+        stream_node = hops;
+        stream_pkts = 0;
+        wait_node = 0;
+        done = sim_run_until(start + ((uint64_t) stream_time +
+          BENCH_STREAM_OVERTIME) * BENCH_TICKS_PER_MS, &bs_done);
+        stream_node = SIM_NO_NODE;
+
+        if(done && stream_pkts && stream_end > stream_start)
+        {
+            add_sample((double) stream_pkts * ON_BS_DATA_PLD_SIZE *
+              1000000.0 / (stream_end - stream_start));
+            total_pkts += tx_pkts;
+        } // if the stream got there //
+        else
+        {
+            failures++;
+        } // else it failed //
+
+        sim_run(sim_time() + (uint64_t) BENCH_GAP * BENCH_TICKS_PER_MS);
+    } // loop through the runs //
+
+    report(&bench_case, "bytes/s");
+} // run_stream //
+
+
+//! @} BENCH_pri_func
+//                      PRIVATE FUNCTION IMPLEMENTATION END
+//==============================================================================
+
+//! @} BENCH
@@ -0,0 +1,302 @@
+#include "capture_columns.h"
+#include <limits>
+#include <algorithm>
+#include "packet_record.h"
+#include "filter.h"
+#include "xtea_key.h"
+using namespace std;
+
+
+
+const unsigned int capture_columns::WORD_BITS;
+
+
+
+// one bit for each of the num_pass packets, set if pass is
+static uint64_t pass_to_bits(const UInt8* pass, unsigned int num_pass)
+{
+    uint64_t bits = 0;
+    for(unsigned int i = 0; i < num_pass; i++)
+    {
+        bits |= ((uint64_t) (pass[i] & 1)) << i;
+    }
+    return bits;
+}
+
+
+capture_columns::capture_columns()
+{
+}
+
+
+void capture_columns::clear()
+{
+    timestamp.clear();
+    raw_nid.clear();
+    raw_pid.clear();
+    raw_src_did.clear();
+    raw_rptr_did.clear();
+    raw_dst_did.clear();
+    msg_id.clear();
+    key_index.clear();
+    hops.clear();
+    max_hops.clear();
+    msg_crc.clear();
+    pld_crc.clear();
+    pld_msg_type.clear();
+    admin_type.clear();
+    flags.clear();
+}
+
+
+void capture_columns::push_back(const packet_record& record)
+{
+    timestamp.push_back(record.timestamp / 1000);
+    raw_nid.push_back(record.raw_nid);
+    raw_pid.push_back(record.raw_pid);
+    raw_src_did.push_back(record.raw_src_did);
+    raw_rptr_did.push_back(record.raw_rptr_did);
+    raw_dst_did.push_back(record.raw_dst_did);
+    msg_id.push_back(record.msg_id);
+    key_index.push_back(record.key_index);
+    hops.push_back(record.hops);
+    max_hops.push_back(record.max_hops);
+    msg_crc.push_back(record.msg_crc);
+    pld_crc.push_back(record.pld_crc);
+    pld_msg_type.push_back(record.pld_msg_type);
+    admin_type.push_back(record.admin_type);
+    flags.push_back(record.flags);
+}
+
+
+unsigned int capture_columns::size() const
+{
+    return flags.size();
+}
+
+
+size_t capture_columns::get_bytes_used() const
+{
+    return size() * (2 * sizeof(uint64_t) + 6 * sizeof(UInt16) +
+        7 * sizeof(UInt8));
+}
+
+
+// Sets one bit in selected for each packet that gets through the filter, the
+// first packet in bit 0 of selected[0].
+void capture_columns::select(const filter& fltr, const vector<xtea_key>& keys,
+    vector<uint64_t>& selected) const
+{
+    unsigned int num_packets = size();
+    selected.assign((num_packets + WORD_BITS - 1) / WORD_BITS,
+        ~((uint64_t) 0));
+    if(num_packets % WORD_BITS)
+    {
+        selected.back() = (((uint64_t) 1) << (num_packets % WORD_BITS)) - 1;
+    }
+
+    const vector<filter_list>& lists = fltr.filters;
+    select_ranges(timestamp, lists[filter::FILTER_TIMESTAMP].get_ranges(), 0,
+        selected);
+    select_ranges(raw_src_did, lists[filter::FILTER_SRC_DID].get_ranges(), 0,
+        selected);
+    select_ranges(raw_dst_did, lists[filter::FILTER_DST_DID].get_ranges(), 0,
+        selected);
+    select_ranges(raw_rptr_did, lists[filter::FILTER_RPTR_DID].get_ranges(),
+        0, selected);
+    select_ranges(raw_nid, lists[filter::FILTER_NID].get_ranges(), 0,
+        selected);
+    select_ranges(raw_pid, lists[filter::FILTER_PID].get_ranges(), 0,
+        selected);
+    select_ranges(msg_id, lists[filter::FILTER_MSG_ID].get_ranges(),
+        packet_record::VALID_PLD_CRC, selected);
+    select_ranges(msg_crc, lists[filter::FILTER_MSG_CRC].get_ranges(), 0,
+        selected);
+    select_ranges(pld_crc, lists[filter::FILTER_PLD_CRC].get_ranges(),
+        packet_record::VALID_PLD_CRC, selected);
+    select_ranges(hops, lists[filter::FILTER_HOPS].get_ranges(), 0,
+        selected);
+    select_ranges(max_hops, lists[filter::FILTER_MAX_HOPS].get_ranges(), 0,
+        selected);
+    select_ranges(pld_msg_type, lists[filter::FILTER_PLD_MSG_TYPE].
+        get_ranges(), packet_record::HAS_PLD_MSG_TYPE, selected);
+    select_ranges(admin_type, lists[filter::FILTER_ADMIN_TYPE].get_ranges(),
+        packet_record::HAS_ADMIN_TYPE, selected);
+
+    select_match(packet_record::VALID_MSG_CRC, fltr.msg_crc_match, selected);
+    select_match(packet_record::VALID_PLD_CRC, fltr.pld_crc_match, selected);
+    select_match(packet_record::VALID, fltr.valid_match, selected);
+    select_match(packet_record::VALID_DECODE, fltr.valid_decode_match,
+        selected);
+
+    select_keys(fltr, keys, selected);
+}
+
+
+bool capture_columns::is_selected(const vector<uint64_t>& selected,
+    unsigned int index)
+{
+    return ((selected[index / WORD_BITS] >> (index % WORD_BITS)) & 1) != 0;
+}
+
+
+unsigned int capture_columns::count(const vector<uint64_t>& selected)
+{
+    unsigned int num_selected = 0;
+    for(unsigned int i = 0; i < selected.size(); i++)
+    {
+        for(uint64_t bits = selected[i]; bits; bits &= bits - 1)
+        {
+            num_selected++;
+        }
+    }
+    return num_selected;
+}
+
+
+// Clears the bits of the packets whose value is in none of the ranges.  An
+// empty list accepts everything.  If has_value_flag is not 0, packets without
+// that flag have no value for the filter type and are not tested.
+//
+// A range is tested as value - low <= high - low in the column's own type,
+// one compare for each packet, so the loop over a word's packets can be
+// vectorized.  Ranges that no value of the type can be in are left out.
+template <typename T>
+void capture_columns::select_ranges(const vector<T>& column,
+    const vector<filter_range>& ranges, UInt8 has_value_flag,
+    vector<uint64_t>& selected) const
+{
+    if(ranges.empty())
+    {
+        return;
+    }
+
+    const uint64_t MAX_VALUE = numeric_limits<T>::max();
+    vector<T> lows;
+    vector<T> widths;
+    for(unsigned int i = 0; i < ranges.size(); i++)
+    {
+        if(ranges[i].getlow() <= MAX_VALUE)
+        {
+            lows.push_back((T) ranges[i].getlow());
+            widths.push_back((T) (min(ranges[i].gethigh(), MAX_VALUE) -
+                ranges[i].getlow()));
+        }
+    }
+
+    unsigned int num_packets = column.size();
+    for(unsigned int word = 0; word < selected.size(); word++)
+    {
+        if(!selected[word])
+        {
+            continue;
+        }
+
+        unsigned int first = word * WORD_BITS;
+        unsigned int num_pass = min(WORD_BITS, num_packets - first);
+        const T* values = &column[first];
+        const UInt8* packet_flags = &flags[first];
+        UInt8 pass[WORD_BITS];
+
+        for(unsigned int i = 0; i < num_pass; i++)
+        {
+            pass[i] = ((packet_flags[i] & has_value_flag) != has_value_flag);
+        }
+        for(unsigned int r = 0; r < lows.size(); r++)
+        {
+            const T low = lows[r];
+            const T width = widths[r];
+            for(unsigned int i = 0; i < num_pass; i++)
+            {
+                pass[i] |= ((T) (values[i] - low) <= width);
+            }
+        }
+
+        selected[word] &= pass_to_bits(pass, num_pass);
+    }
+}
+
+
+// Clears the bits of the packets that fm does not accept, flag being the
+// match value.
+void capture_columns::select_match(UInt8 flag, filter::FILTER_MATCH fm,
+    vector<uint64_t>& selected) const
+{
+    if(fm == filter::WILDCARD)
+    {
+        return;
+    }
+
+    const UInt8 match = (fm == filter::MUST_MATCH ? flag : 0);
+    unsigned int num_packets = flags.size();
+    for(unsigned int word = 0; word < selected.size(); word++)
+    {
+        if(!selected[word])
+        {
+            continue;
+        }
+
+        unsigned int first = word * WORD_BITS;
+        unsigned int num_pass = min(WORD_BITS, num_packets - first);
+        const UInt8* packet_flags = &flags[first];
+        UInt8 pass[WORD_BITS];
+        for(unsigned int i = 0; i < num_pass; i++)
+        {
+            pass[i] = ((packet_flags[i] & flag) == match);
+        }
+
+        selected[word] &= pass_to_bits(pass, num_pass);
+    }
+}
+
+
+// Clears the bits of the packets decrypted with a key that is not in the
+// filter.  keys is the capture's list that key_index is an index into.  There
+// are only ever a few of them, so whether the filter has each one is worked
+// out once, for invites and for the others.
+void capture_columns::select_keys(const filter& fltr,
+    const vector<xtea_key>& keys, vector<uint64_t>& selected) const
+{
+    const unsigned int num_keys = keys.size();
+    vector<UInt8> accepted(2 * num_keys);
+    bool all_accepted = true;
+    for(unsigned int i = 0; i < num_keys; i++)
+    {
+        accepted[i] = (xtea_key::find_key(fltr.keys, keys[i]) >= 0);
+        accepted[num_keys + i] = (xtea_key::find_key(fltr.invite_keys,
+            keys[i]) >= 0);
+        all_accepted = all_accepted && accepted[i] && accepted[num_keys + i];
+    }
+    if(all_accepted)
+    {
+        return;
+    }
+
+    unsigned int num_packets = flags.size();
+    for(unsigned int word = 0; word < selected.size(); word++)
+    {
+        if(!selected[word])
+        {
+            continue;
+        }
+
+        unsigned int first = word * WORD_BITS;
+        unsigned int num_pass = min(WORD_BITS, num_packets - first);
+        UInt8 pass[WORD_BITS];
+        for(unsigned int i = 0; i < num_pass; i++)
+        {
+            UInt16 key = key_index[first + i];
+            if(key == packet_record::NO_KEY)
+            {
+                pass[i] = 1;
+            }
+            else
+            {
+                bool invite = (flags[first + i] & packet_record::IS_INVITE);
+                pass[i] = accepted[(invite ? num_keys : 0) + key];
+            }
+        }
+
+        selected[word] &= pass_to_bits(pass, num_pass);
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef CAPTURE_COLUMNS_H
+#define	CAPTURE_COLUMNS_H
+
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+#include "one_net_types.h"
+#include "packet_record.h"
+#include "filter.h"
+#include "xtea_key.h"
+using namespace std;
+
+
+// The fields of a capture's packets that filters test, with one array for
+// each field rather than one record for each packet.  A filter is run over
+// the whole capture one filter type at a time, each a tight loop over one
+// array, and the result is kept as one bit for each packet.  Packets already
+// rejected are skipped 64 at a time.  The same packets get through as with
+// packet::filter_packet.
+class capture_columns
+{
+public:
+    capture_columns();
+    void clear();
+    void push_back(const packet_record& record);
+    unsigned int size() const;
+    size_t get_bytes_used() const;
+    void select(const filter& fltr, const vector<xtea_key>& keys,
+        vector<uint64_t>& selected) const;
+    static bool is_selected(const vector<uint64_t>& selected,
+        unsigned int index);
+    static unsigned int count(const vector<uint64_t>& selected);
+
+    // packets to a word of selected
+    static const unsigned int WORD_BITS = 64;
+
+private:
+    template <typename T>
+    void select_ranges(const vector<T>& column,
+        const vector<filter_range>& ranges, UInt8 has_value_flag,
+        vector<uint64_t>& selected) const;
+    void select_match(UInt8 flag, filter::FILTER_MATCH fm,
+        vector<uint64_t>& selected) const;
+    void select_keys(const filter& fltr, const vector<xtea_key>& keys,
+        vector<uint64_t>& selected) const;
+
+    vector<uint64_t> timestamp;  // milliseconds, as the filter has it
+    vector<uint64_t> raw_nid;
+    vector<UInt16> raw_pid;
+    vector<UInt16> raw_src_did;
+    vector<UInt16> raw_rptr_did;
+    vector<UInt16> raw_dst_did;
+    vector<UInt16> msg_id;
+    vector<UInt16> key_index;
+    vector<UInt8> hops;
+    vector<UInt8> max_hops;
+    vector<UInt8> msg_crc;
+    vector<UInt8> pld_crc;
+    vector<UInt8> pld_msg_type;
+    vector<UInt8> admin_type;
+    vector<UInt8> flags;
+};
+
+
+#endif	/* CAPTURE_COLUMNS_H */
@@ -0,0 +1,572 @@
+#include "capture_file.h"
+#include <stdint.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <fstream>
+#include <istream>
+#include "packet.h"
+#include "packet_framer.h"
+#include "time_utils.h"
+using namespace std;
+
+
+extern "C"
+{
+    #include "one_net_packet.h"
+    #include "one_net_encode.h"
+    #include "one_net_port_specific.h"
+}
+
+
+static const char FILE_MAGIC[4] = {'O', 'N', 'C', 'P'};
+static const char TRAILER_MAGIC[4] = {'O', 'N', 'C', 'I'};
+static const UInt16 FILE_VERSION = 1;
+
+static const unsigned int FILE_HEADER_SIZE = 8;
+static const unsigned int RECORD_HEADER_SIZE = 16;
+static const unsigned int TIME_INDEX_ENTRY_SIZE = 24;
+static const unsigned int DID_INDEX_ENTRY_SIZE = 10;
+static const unsigned int TRAILER_SIZE = 48;
+
+
+static void put_uint16(UInt8* bytes, UInt16 value)
+{
+    bytes[0] = (UInt8) value;
+    bytes[1] = (UInt8) (value >> 8);
+}
+
+
+static void put_uint64(UInt8* bytes, uint64_t value)
+{
+    for(int i = 0; i < 8; i++)
+    {
+        bytes[i] = (UInt8) (value >> (8 * i));
+    }
+}
+
+
+static UInt16 get_uint16(const UInt8* bytes)
+{
+    return (UInt16) (bytes[0] | (bytes[1] << 8));
+}
+
+
+static uint64_t get_uint64(const UInt8* bytes)
+{
+    uint64_t value = 0;
+    for(int i = 7; i >= 0; i--)
+    {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+
+// the raw source did of a packet, packet::INVALID_DID if it does not decode
+static UInt16 decode_src_did(const UInt8* encoded_bytes)
+{
+    on_raw_did_t raw_did;
+    if(on_decode(raw_did, &encoded_bytes[ON_ENCODED_SRC_DID_IDX],
+      ON_ENCODED_DID_LEN) != ONS_SUCCESS)
+    {
+        return packet::INVALID_DID;
+    }
+    return did_to_u16(&raw_did);
+}
+
+
+capture_writer::capture_writer()
+{
+    offset = 0;
+    num_records = 0;
+}
+
+
+capture_writer::~capture_writer()
+{
+    close();
+}
+
+
+// Creates the file, replacing any file by that name.
+bool capture_writer::open(const string& file_name)
+{
+    close();
+    outs.open(file_name.c_str(), ios::out | ios::binary | ios::trunc);
+    if(!outs.is_open())
+    {
+        return false;
+    }
+
+    UInt8 header[FILE_HEADER_SIZE];
+    memcpy(header, FILE_MAGIC, sizeof(FILE_MAGIC));
+    put_uint16(&header[4], FILE_VERSION);
+    put_uint16(&header[6], RECORD_HEADER_SIZE);
+    outs.write((const char*) header, sizeof(header));
+
+    offset = FILE_HEADER_SIZE;
+    num_records = 0;
+    time_index.clear();
+    did_index.clear();
+    return outs.good();
+}
+
+
+// Adds a record to the end of the file.  The record's raw_src_did is set
+// from its bytes.
+bool capture_writer::write(capture_record& record)
+{
+    if(!outs.is_open() || record.num_bytes < ON_ENCODED_SRC_DID_IDX +
+        ON_ENCODED_DID_LEN || record.num_bytes > ON_MAX_ENCODED_PKT_SIZE)
+    {
+        return false;
+    }
+
+    record.raw_src_did = decode_src_did(record.bytes);
+
+    UInt8 header[RECORD_HEADER_SIZE];
+    memset(header, 0, sizeof(header));
+    put_uint64(&header[0], record.timestamp);
+    header[8] = record.channel;
+    header[9] = record.data_rate;
+    header[10] = (UInt8) record.rssi;
+    header[11] = record.num_bytes;
+    put_uint16(&header[12], record.raw_src_did);
+    outs.write((const char*) header, sizeof(header));
+    outs.write((const char*) record.bytes, record.num_bytes);
+    if(!outs.good())
+    {
+        return false;
+    }
+
+    if(num_records % TIME_INDEX_INTERVAL == 0)
+    {
+        time_index_entry entry;
+        entry.offset = offset;
+        entry.min_time = record.timestamp;
+        entry.max_time = record.timestamp;
+        time_index.push_back(entry);
+    }
+    else
+    {
+        time_index_entry& entry = time_index.back();
+        entry.min_time = min(entry.min_time, record.timestamp);
+        entry.max_time = max(entry.max_time, record.timestamp);
+    }
+
+    did_index.push_back(make_pair(record.raw_src_did, offset));
+    offset += RECORD_HEADER_SIZE + record.num_bytes;
+    num_records++;
+    return true;
+}
+
+
+// Writes the index and trailer and closes the file.
+bool capture_writer::close()
+{
+    if(!outs.is_open())
+    {
+        return true;
+    }
+
+    for(unsigned int i = 1; i < time_index.size(); i++)
+    {
+        time_index[i].max_time = max(time_index[i].max_time,
+            time_index[i - 1].max_time);
+    }
+    for(int i = (int) time_index.size() - 2; i >= 0; i--)
+    {
+        time_index[i].min_time = min(time_index[i].min_time,
+            time_index[i + 1].min_time);
+    }
+
+    // by did, and by offset for each did since the pairs were added in order
+    sort(did_index.begin(), did_index.end());
+
+    uint64_t time_index_offset = offset;
+    UInt8 entry[TIME_INDEX_ENTRY_SIZE];
+    for(unsigned int i = 0; i < time_index.size(); i++)
+    {
+        put_uint64(&entry[0], time_index[i].offset);
+        put_uint64(&entry[8], time_index[i].min_time);
+        put_uint64(&entry[16], time_index[i].max_time);
+        outs.write((const char*) entry, TIME_INDEX_ENTRY_SIZE);
+    }
+
+    uint64_t did_index_offset = time_index_offset + time_index.size() *
+        TIME_INDEX_ENTRY_SIZE;
+    for(unsigned int i = 0; i < did_index.size(); i++)
+    {
+        put_uint16(&entry[0], did_index[i].first);
+        put_uint64(&entry[2], did_index[i].second);
+        outs.write((const char*) entry, DID_INDEX_ENTRY_SIZE);
+    }
+
+    UInt8 trailer[TRAILER_SIZE];
+    memset(trailer, 0, sizeof(trailer));
+    put_uint64(&trailer[0], num_records);
+    put_uint64(&trailer[8], time_index_offset);
+    put_uint64(&trailer[16], time_index.size());
+    put_uint64(&trailer[24], did_index_offset);
+    put_uint64(&trailer[32], did_index.size());
+    memcpy(&trailer[44], TRAILER_MAGIC, sizeof(TRAILER_MAGIC));
+    outs.write((const char*) trailer, sizeof(trailer));
+
+    bool ok = outs.good();
+    outs.close();
+    time_index.clear();
+    did_index.clear();
+    return ok;
+}
+
+
+uint64_t capture_writer::get_num_records() const
+{
+    return num_records;
+}
+
+
+capture_reader::capture_reader()
+{
+    indexed = false;
+    num_records = 0;
+    records_end = 0;
+}
+
+
+capture_reader::~capture_reader()
+{
+    close();
+}
+
+
+// Opens a capture and reads its index, if it has one.  The next record read
+// is the first one.
+bool capture_reader::open(const string& file_name)
+{
+    close();
+    ins.open(file_name.c_str(), ios::in | ios::binary);
+    if(!ins.is_open())
+    {
+        return false;
+    }
+
+    UInt8 header[FILE_HEADER_SIZE];
+    if(!ins.read((char*) header, sizeof(header)) || memcmp(header, FILE_MAGIC,
+        sizeof(FILE_MAGIC)) != 0 || get_uint16(&header[4]) != FILE_VERSION ||
+        get_uint16(&header[6]) != RECORD_HEADER_SIZE)
+    {
+        close();
+        return false;
+    }
+
+    ins.seekg(0, ios::end);
+    uint64_t file_size = ins.tellg();
+    records_end = file_size;
+
+    UInt8 trailer[TRAILER_SIZE];
+    if(file_size >= FILE_HEADER_SIZE + TRAILER_SIZE &&
+        ins.seekg(file_size - TRAILER_SIZE) &&
+        ins.read((char*) trailer, sizeof(trailer)) &&
+        memcmp(&trailer[44], TRAILER_MAGIC, sizeof(TRAILER_MAGIC)) == 0)
+    {
+        uint64_t time_index_offset = get_uint64(&trailer[8]);
+        uint64_t num_time_entries = get_uint64(&trailer[16]);
+        uint64_t did_index_offset = get_uint64(&trailer[24]);
+        uint64_t num_did_entries = get_uint64(&trailer[32]);
+
+        if(time_index_offset >= FILE_HEADER_SIZE && did_index_offset ==
+            time_index_offset + num_time_entries * TIME_INDEX_ENTRY_SIZE &&
+            did_index_offset + num_did_entries * DID_INDEX_ENTRY_SIZE +
+            TRAILER_SIZE == file_size)
+        {
+            vector<UInt8> index(file_size - TRAILER_SIZE - time_index_offset);
+            ins.seekg(time_index_offset);
+            if(index.empty() || ins.read((char*) &index[0], index.size()))
+            {
+                time_index.resize(num_time_entries);
+                for(uint64_t i = 0; i < num_time_entries; i++)
+                {
+                    const UInt8* entry = &index[i * TIME_INDEX_ENTRY_SIZE];
+                    time_index[i].offset = get_uint64(&entry[0]);
+                    time_index[i].min_time = get_uint64(&entry[8]);
+                    time_index[i].max_time = get_uint64(&entry[16]);
+                }
+
+                did_index.resize(num_did_entries);
+                const UInt8* entries = &index[num_time_entries *
+                    TIME_INDEX_ENTRY_SIZE];
+                for(uint64_t i = 0; i < num_did_entries; i++)
+                {
+                    const UInt8* entry = &entries[i * DID_INDEX_ENTRY_SIZE];
+                    did_index[i] = make_pair(get_uint16(&entry[0]),
+                        get_uint64(&entry[2]));
+                }
+
+                num_records = get_uint64(&trailer[0]);
+                records_end = time_index_offset;
+                indexed = true;
+            }
+        }
+    }
+
+    ins.clear();
+    return rewind();
+}
+
+
+void capture_reader::close()
+{
+    if(ins.is_open())
+    {
+        ins.close();
+    }
+    ins.clear();
+    indexed = false;
+    num_records = 0;
+    records_end = 0;
+    time_index.clear();
+    did_index.clear();
+}
+
+
+bool capture_reader::is_open() const
+{
+    return ins.is_open();
+}
+
+
+bool capture_reader::has_index() const
+{
+    return indexed;
+}
+
+
+// 0 if the file has no index
+uint64_t capture_reader::get_num_records() const
+{
+    return num_records;
+}
+
+
+bool capture_reader::rewind()
+{
+    ins.clear();
+    return (bool) ins.seekg(FILE_HEADER_SIZE);
+}
+
+
+// the next record in the file.  False at the end of the records.
+bool capture_reader::read_record(capture_record& record)
+{
+    uint64_t record_offset = ins.tellg();
+    if(!ins || record_offset + RECORD_HEADER_SIZE > records_end)
+    {
+        return false;
+    }
+
+    UInt8 header[RECORD_HEADER_SIZE];
+    if(!ins.read((char*) header, sizeof(header)))
+    {
+        return false;
+    }
+
+    record.timestamp = get_uint64(&header[0]);
+    record.channel = header[8];
+    record.data_rate = header[9];
+    record.rssi = (SInt8) header[10];
+    record.num_bytes = header[11];
+    record.raw_src_did = get_uint16(&header[12]);
+    if(record.num_bytes > ON_MAX_ENCODED_PKT_SIZE || record_offset +
+        RECORD_HEADER_SIZE + record.num_bytes > records_end)
+    {
+        return false;
+    }
+
+    return (bool) ins.read((char*) record.bytes, record.num_bytes);
+}
+
+
+// The records from begin to end (microseconds, inclusive) in file order.
+// Without an index the whole file is read.
+bool capture_reader::read_time_window(uint64_t begin, uint64_t end,
+    vector<capture_record>& records)
+{
+    records.clear();
+    if(!is_open())
+    {
+        return false;
+    }
+
+    uint64_t first = FILE_HEADER_SIZE;
+    uint64_t last = records_end;
+    if(indexed)
+    {
+        // The first block that could hold a record at or after begin and
+        // the first block holding nothing at or before end.  Both are found
+        // with a binary search since max_time and min_time only go up.
+        unsigned int i, j;
+        unsigned int low = 0, high = time_index.size();
+        while(low < high)
+        {
+            unsigned int mid = (low + high) / 2;
+            if(time_index[mid].max_time < begin)
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+        i = low;
+
+        high = time_index.size();
+        while(low < high)
+        {
+            unsigned int mid = (low + high) / 2;
+            if(time_index[mid].min_time <= end)
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+        j = low;
+
+        if(i >= j)
+        {
+            return true;
+        }
+        first = time_index[i].offset;
+        if(j < time_index.size())
+        {
+            last = time_index[j].offset;
+        }
+    }
+
+    ins.clear();
+    if(!ins.seekg(first))
+    {
+        return false;
+    }
+
+    capture_record record;
+    while((uint64_t) ins.tellg() < last && read_record(record))
+    {
+        if(record.timestamp >= begin && record.timestamp <= end)
+        {
+            records.push_back(record);
+        }
+    }
+
+    return true;
+}
+
+
+// The records from a source did in file order.  Without an index the whole
+// file is read.
+bool capture_reader::read_device(UInt16 raw_src_did,
+    vector<capture_record>& records)
+{
+    records.clear();
+    if(!is_open())
+    {
+        return false;
+    }
+
+    capture_record record;
+    if(!indexed)
+    {
+        rewind();
+        while(read_record(record))
+        {
+            if(record.raw_src_did == raw_src_did)
+            {
+                records.push_back(record);
+            }
+        }
+        return true;
+    }
+
+    vector<pair<UInt16, uint64_t> >::const_iterator it = lower_bound(
+        did_index.begin(), did_index.end(), make_pair(raw_src_did,
+        (uint64_t) 0));
+    for(; it != did_index.end() && it->first == raw_src_did; it++)
+    {
+        if(!read_record_at(it->second, record))
+        {
+            return false;
+        }
+        records.push_back(record);
+    }
+
+    return true;
+}
+
+
+bool capture_reader::is_capture_file(const string& file_name)
+{
+    ifstream file(file_name.c_str(), ios::in | ios::binary);
+    char magic[sizeof(FILE_MAGIC)];
+    return (file.read(magic, sizeof(magic)) && memcmp(magic, FILE_MAGIC,
+        sizeof(FILE_MAGIC)) == 0);
+}
+
+
+bool capture_reader::read_record_at(uint64_t record_offset,
+    capture_record& record)
+{
+    ins.clear();
+    return (ins.seekg(record_offset) && read_record(record));
+}
+
+
+static bool write_framed_packet(const packet_framer& framer,
+    capture_record& record, capture_writer& writer)
+{
+    record.timestamp = struct_timeval_to_microseconds(framer.get_timestamp());
+    record.num_bytes = framer.get_num_bytes();
+    memcpy(record.bytes, framer.get_bytes(), record.num_bytes);
+    return writer.write(record);
+}
+
+
+// Writes the packets in a text capture to a binary one.  The text does not
+// say what channel, data rate or rssi a packet had, so they are unknown.
+bool convert_text_capture(istream& ins, capture_writer& writer)
+{
+    packet_framer framer;
+    capture_record record;
+    record.channel = CAPTURE_UNKNOWN_CHANNEL;
+    record.data_rate = CAPTURE_UNKNOWN_DATA_RATE;
+    record.rssi = CAPTURE_UNKNOWN_RSSI;
+
+    char buffer[65536];
+    while(ins.read(buffer, sizeof(buffer)) || ins.gcount() > 0)
+    {
+        size_t num_read = ins.gcount();
+        size_t used = 0;
+        while(used < num_read)
+        {
+            used += framer.add_bytes(&buffer[used], num_read - used);
+            if(framer.packet_ready() && !write_framed_packet(framer, record,
+                writer))
+            {
+                return false;
+            }
+        }
+    }
+
+    if(framer.end_of_input() && !write_framed_packet(framer, record, writer))
+    {
+        return false;
+    }
+
+    return !ins.bad();
+}
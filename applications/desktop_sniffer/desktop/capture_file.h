@@ -0,0 +1,120 @@
+#ifndef CAPTURE_FILE_H
+#define	CAPTURE_FILE_H
+
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <utility>
+#include <fstream>
+#include <istream>
+#include "one_net_types.h"
+#include "one_net_packet.h"
+using namespace std;
+
+
+// Binary captures.  The file is
+//
+//     file header   "ONCP", version, record header size
+//     records       a fixed size header (timestamp, channel, data rate, rssi,
+//                   length, source did) then the encoded packet bytes
+//     index         by time, then by source did (written on close)
+//     trailer       where the index is, ending in "ONCI"
+//
+// Numbers are little endian.  A file that was never closed has no index but
+// its records can still be read from the start.
+
+
+// channel, data rate or rssi not known (the text captures do not have them)
+const UInt8 CAPTURE_UNKNOWN_CHANNEL = 0xFF;
+const UInt8 CAPTURE_UNKNOWN_DATA_RATE = 0xFF;
+const SInt8 CAPTURE_UNKNOWN_RSSI = -128;
+
+
+struct capture_record
+{
+    uint64_t timestamp; // microseconds
+    UInt8 channel;
+    UInt8 data_rate;
+    SInt8 rssi;
+    UInt16 raw_src_did; // filled in by the writer
+    UInt8 num_bytes;
+    UInt8 bytes[ON_MAX_ENCODED_PKT_SIZE];
+};
+
+
+class capture_writer
+{
+public:
+    capture_writer();
+    ~capture_writer();
+    bool open(const string& file_name);
+    bool write(capture_record& record);
+    bool close();
+    uint64_t get_num_records() const;
+
+    // a time index entry is made every this many records
+    static const unsigned int TIME_INDEX_INTERVAL = 256;
+
+private:
+    capture_writer(const capture_writer&);
+    capture_writer& operator = (const capture_writer&);
+
+    // first record of a block of TIME_INDEX_INTERVAL records.  While
+    // writing, min_time / max_time are for the block only.  On close they
+    // become the earliest time from this block on and the latest time up to
+    // the end of this block, which only ever go up from one block to the next
+    // even if the records are not in time order.
+    struct time_index_entry
+    {
+        uint64_t offset;
+        uint64_t min_time;
+        uint64_t max_time;
+    };
+
+    ofstream outs;
+    uint64_t offset;
+    uint64_t num_records;
+    vector<time_index_entry> time_index;
+    vector<pair<UInt16, uint64_t> > did_index;
+
+    friend class capture_reader;
+};
+
+
+class capture_reader
+{
+public:
+    capture_reader();
+    ~capture_reader();
+    bool open(const string& file_name);
+    void close();
+    bool is_open() const;
+    bool has_index() const;
+    uint64_t get_num_records() const;
+    bool rewind();
+    bool read_record(capture_record& record);
+    bool read_time_window(uint64_t begin, uint64_t end,
+        vector<capture_record>& records);
+    bool read_device(UInt16 raw_src_did, vector<capture_record>& records);
+    static bool is_capture_file(const string& file_name);
+
+private:
+    capture_reader(const capture_reader&);
+    capture_reader& operator = (const capture_reader&);
+
+    bool read_record_at(uint64_t record_offset, capture_record& record);
+
+    ifstream ins;
+    bool indexed;
+    uint64_t num_records;
+    uint64_t records_end;
+    vector<capture_writer::time_index_entry> time_index;
+    vector<pair<UInt16, uint64_t> > did_index;
+};
+
+
+bool convert_text_capture(istream& ins, capture_writer& writer);
+
+
+#endif	/* CAPTURE_FILE_H */
@@ -0,0 +1,211 @@
+#include "capture_stream.h"
+#include <sys/time.h>
+#include <istream>
+#include <ostream>
+#include <string>
+#include "packet.h"
+#include "packet_framer.h"
+#include "filter.h"
+#include "attribute.h"
+#include "packet_store.h"
+#include "time_utils.h"
+using namespace std;
+
+
+capture_stream::capture_stream(istream& ins, const filter& fltr,
+    const attribute& att, ostream& outs, packet_store* store,
+    unsigned int reorder_window):
+    ins(ins), fltr(fltr), matcher(fltr), att(att), outs(outs), store(store),
+    reorder_window(reorder_window)
+{
+    done_reading = false;
+    stop = false;
+    started = false;
+    first_time = 0;
+    last_time = 0;
+    num_packets = 0;
+    num_late_packets = 0;
+}
+
+
+capture_stream::~capture_stream()
+{
+    stop_reading();
+}
+
+
+// true if the whole capture was read and displayed
+bool capture_stream::run()
+{
+    reader = thread(&capture_stream::read_lines, this);
+
+    string line;
+    packet pkt;
+    bool ok = true;
+    while(ok && pop_line(line))
+    {
+        framer.add_bytes(line.data(), line.length());
+        framer.add_bytes("\n", 1);
+        if(!packet::create_packet(framer, fltr, pkt))
+        {
+            continue;
+        }
+
+        // every packet is kept, not only those that get through the filter,
+        // as cli_read_capture_file does
+        if(store)
+        {
+            store->insert(pkt);
+        }
+        if(pkt.filter_packet(matcher))
+        {
+            ok = add_packet(pkt);
+        }
+    }
+
+    while(ok && !window.empty())
+    {
+        ok = display_packet(window.begin()->second);
+        window.erase(window.begin());
+    }
+
+    stop_reading();
+    outs << "\n\n# of packets : " << num_packets << "\n\n";
+    if(num_late_packets > 0)
+    {
+        outs << "# of packets displayed out of order : " << num_late_packets <<
+            "\n\n";
+    }
+
+    return ok && !ins.bad();
+}
+
+
+unsigned int capture_stream::get_num_packets() const
+{
+    return num_packets;
+}
+
+
+unsigned int capture_stream::get_num_late_packets() const
+{
+    return num_late_packets;
+}
+
+
+void capture_stream::read_lines()
+{
+    string line;
+    while(getline(ins, line, '\n'))
+    {
+        unique_lock<mutex> lock(queue_mutex);
+        while(!stop && lines.size() >= MAX_QUEUED_LINES)
+        {
+            queue_not_full.wait(lock);
+        }
+        if(stop)
+        {
+            break;
+        }
+
+        lines.push_back(line);
+        queue_not_empty.notify_one();
+    }
+
+    lock_guard<mutex> lock(queue_mutex);
+    done_reading = true;
+    queue_not_empty.notify_one();
+}
+
+
+// false once every line has been handed out
+bool capture_stream::pop_line(string& line)
+{
+    unique_lock<mutex> lock(queue_mutex);
+    while(lines.empty() && !done_reading)
+    {
+        queue_not_empty.wait(lock);
+    }
+    if(lines.empty())
+    {
+        return false;
+    }
+
+    line.swap(lines.front());
+    lines.pop_front();
+    queue_not_full.notify_one();
+    return true;
+}
+
+
+void capture_stream::stop_reading()
+{
+    {
+        lock_guard<mutex> lock(queue_mutex);
+        stop = true;
+        lines.clear();
+    }
+    queue_not_full.notify_one();
+
+    if(reader.joinable())
+    {
+        reader.join();
+    }
+}
+
+
+bool capture_stream::add_packet(const packet& pkt)
+{
+    uint64_t time = struct_timeval_to_microseconds(pkt.get_timestamp());
+
+    if(started && time <= last_time)
+    {
+        if(time == last_time)
+        {
+            return true;
+        }
+
+        // too far out of order to be put in its place
+        num_late_packets++;
+        packet late = pkt;
+        return display_packet(late);
+    }
+
+    if(!window.insert(make_pair(time, pkt)).second)
+    {
+        return true;
+    }
+
+    if(window.size() <= reorder_window)
+    {
+        return true;
+    }
+
+    bool ok = display_packet(window.begin()->second);
+    window.erase(window.begin());
+    return ok;
+}
+
+
+// Timestamps are displayed relative to the first packet, as
+// packet::adjust_timestamps does for a loaded capture.
+bool capture_stream::display_packet(packet& pkt)
+{
+    uint64_t time = struct_timeval_to_microseconds(pkt.get_timestamp());
+    if(!started)
+    {
+        started = true;
+        first_time = time;
+    }
+    if(time > last_time)
+    {
+        last_time = time;
+    }
+
+    pkt.set_timestamp(microseconds_to_struct_timeval(time > first_time ?
+        time - first_time : 0));
+    num_packets++;
+    outs << "\n\nPacket " << num_packets << "\n\n";
+    pkt.display(att, outs);
+    return outs.good();
+}
@@ -0,0 +1,87 @@
+#ifndef CAPTURE_STREAM_H
+#define	CAPTURE_STREAM_H
+
+
+#include <sys/time.h>
+#include <stdint.h>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <deque>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "packet.h"
+#include "packet_framer.h"
+#include "filter.h"
+#include "attribute.h"
+#include "packet_store.h"
+using namespace std;
+
+
+// Displays the packets in a capture as it is read instead of loading the
+// whole capture first.  A reader thread fills a bounded queue of lines (and
+// waits when it is full), the lines are parsed and filtered, and the packets
+// go through a small window that puts them in timestamp order before they
+// are displayed.  Memory use does not depend on the size of the capture
+// unless a store is given, in which case every packet read is also kept in
+// it with the timestamp it was captured at.
+class capture_stream
+{
+public:
+    capture_stream(istream& ins, const filter& fltr, const attribute& att,
+        ostream& outs, packet_store* store = NULL,
+        unsigned int reorder_window = REORDER_WINDOW);
+    ~capture_stream();
+    bool run();
+    unsigned int get_num_packets() const;
+    unsigned int get_num_late_packets() const;
+
+    // lines read ahead of the parser
+    static const unsigned int MAX_QUEUED_LINES = 4096;
+
+    // default number of packets held back to put them in timestamp order.
+    // A packet more than this many packets out of place is displayed late,
+    // where it was found.
+    static const unsigned int REORDER_WINDOW = 1024;
+
+private:
+    capture_stream(const capture_stream&);
+    capture_stream& operator = (const capture_stream&);
+
+    void read_lines();
+    bool pop_line(string& line);
+    void stop_reading();
+    bool add_packet(const packet& pkt);
+    bool display_packet(packet& pkt);
+
+    istream& ins;
+    const filter& fltr;
+    const filter_matcher matcher;
+    packet_framer framer;
+    const attribute& att;
+    ostream& outs;
+    packet_store* store;
+
+    thread reader;
+    mutex queue_mutex;
+    condition_variable queue_not_empty;
+    condition_variable queue_not_full;
+    deque<string> lines;
+    bool done_reading;
+    bool stop;
+
+    // keyed by timestamp in microseconds.  Packets with the same timestamp
+    // as one already seen are dropped, as packet_store::insert does.
+    map<uint64_t, packet> window;
+    unsigned int reorder_window;
+    bool started;
+    uint64_t first_time;
+    uint64_t last_time;
+    unsigned int num_packets;
+    unsigned int num_late_packets;
+};
+
+
+#endif	/* CAPTURE_STREAM_H */
@@ -4,13 +4,26 @@
 #include <iostream>
 #include <fcntl.h>
 #include <string>
+#include <string_view>
 #include <fstream>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/select.h>
+#ifdef __linux__
+    #include <sys/epoll.h>
+#endif
 using namespace std;
 
 
 
 chip_connection::chip_connection()
 {
+    chip_fd = -1;
+    epoll_fd = -1;
+    watched_fd = -1;
+    rx_begin = 0;
+    rx_end = 0;
 }
 
 
@@ -19,6 +32,13 @@ chip_connection::chip_connection(string device_name, speed_t baud_rate)
     int temp;
     this->device = device_name;
     this->baud_rate = baud_rate;
+    epoll_fd = -1;
+    watched_fd = -1;
+    rx_buffer.resize(RX_BUFFER_SIZE);
+    rx_begin = 0;
+    rx_end = 0;
+
+    // O_NDELAY makes reads non-blocking.  Waiting is done in wait_readable.
     chip_fd = open(device_name.c_str(), O_RDWR | O_NOCTTY | O_NDELAY);
     if (chip_fd < 0)
     {
@@ -60,11 +80,33 @@ chip_connection::chip_connection(string device_name, speed_t baud_rate)
     new_console.c_lflag |= ICANON;
     old_console.c_lflag |= ICANON;
     tcflush(chip_fd, TCIFLUSH);
+
+    #ifdef __linux__
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if(epoll_fd >= 0)
+    {
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.fd = chip_fd;
+        if(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, chip_fd, &event) < 0)
+        {
+            close(epoll_fd);
+            epoll_fd = -1;
+        }
+    }
+    #endif
 }
 
 
 chip_connection::chip_connection(const chip_connection& orig)
 {
+    chip_fd = -1;
+    epoll_fd = -1;
+    watched_fd = -1;
+    rx_begin = 0;
+    rx_end = 0;
+
     #ifdef COMPILE_WO_WARNINGS
     // meaningless code to avoid compile warnings
     if(sizeof(orig) == 12)
@@ -85,6 +127,11 @@ chip_connection::~chip_connection()
     tcsetattr(STDOUT_FILENO, TCSANOW, &old_console);
     tcsetattr(STDIN_FILENO, TCSANOW, &old_console);
     tcsetattr(chip_fd, TCSANOW, &old_sio);
+    if(epoll_fd >= 0)
+    {
+        close(epoll_fd);
+        epoll_fd = -1;
+    }
     close(chip_fd);
     chip_fd = -1;
 }
@@ -117,26 +164,199 @@ bool chip_connection::send_bytes_to_chip(string bytes, bool add_newline)
 }
 
 
+// Everything the chip sends in time_period, plus anything already received
+// and not consumed.
 string chip_connection::read_bytes(struct timeval time_period)
 {
-    string chip_bytes;
     struct timeval time_now;
     gettimeofday(&time_now, NULL);
     struct timeval expire_time = add_timeval(time_now, time_period);
-    char buffer[1000];
-    int bytes_read = 0;
+    string chip_bytes;
 
-    do
+    while(receive())
     {
-        bytes_read = read(chip_fd, buffer, sizeof(buffer) - 1);
-        if(bytes_read > 0)
+        string_view bytes = received();
+        chip_bytes.append(bytes.data(), bytes.size());
+        consume(bytes.size());
+
+        gettimeofday(&time_now, NULL);
+        if(timeval_compare(time_now, expire_time) >= 0)
         {
-            buffer[bytes_read] = 0;
-            chip_bytes += string(buffer);
+            break;
         }
 
-        gettimeofday(&time_now, NULL);
+        struct timeval time_left = subtract_timeval(expire_time, time_now);
+        int timeout_ms = time_left.tv_sec * 1000 + (time_left.tv_usec + 999) /
+            1000;
+        if(wait_readable(timeout_ms) <= 0)
+        {
+            break;
+        }
     }
-    while(bytes_read > 0 || timeval_compare(time_now, expire_time) < 0);
+
     return chip_bytes;
 }
+
+
+// Waits until the chip has sent something or other_fd (say STDIN_FILENO) can
+// be read, or until timeout_ms milliseconds go by (forever if timeout_ms is
+// negative).  Returns CHIP_READABLE and / or OTHER_READABLE, 0 on a timeout
+// and -1 on an error.  Bytes already received and not consumed count as
+// readable.
+int chip_connection::wait_readable(int timeout_ms, int other_fd)
+{
+    if(chip_fd < 0)
+    {
+        return -1;
+    }
+    if(rx_end > rx_begin)
+    {
+        timeout_ms = 0;
+    }
+
+    int ready = 0;
+    #ifdef __linux__
+    if(epoll_fd >= 0)
+    {
+        if(other_fd != watched_fd)
+        {
+            if(watched_fd >= 0)
+            {
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, watched_fd, NULL);
+                watched_fd = -1;
+            }
+
+            struct epoll_event event;
+            memset(&event, 0, sizeof(event));
+            event.events = EPOLLIN;
+            event.data.fd = other_fd;
+            if(other_fd >= 0 && epoll_ctl(epoll_fd, EPOLL_CTL_ADD, other_fd,
+                &event) < 0)
+            {
+                return -1;
+            }
+            watched_fd = other_fd;
+        }
+
+        struct epoll_event events[2];
+        int num_events = epoll_wait(epoll_fd, events, 2, timeout_ms);
+        if(num_events < 0)
+        {
+            return (errno == EINTR ? 0 : -1);
+        }
+
+        for(int i = 0; i < num_events; i++)
+        {
+            ready |= (events[i].data.fd == chip_fd ? CHIP_READABLE :
+                OTHER_READABLE);
+        }
+    }
+    else
+    #endif
+    {
+        fd_set set;
+        FD_ZERO(&set);
+        FD_SET(chip_fd, &set);
+        if(other_fd >= 0)
+        {
+            FD_SET(other_fd, &set);
+        }
+
+        struct timeval timeout = {timeout_ms / 1000, (timeout_ms % 1000) *
+            1000};
+        int rv = select((other_fd > chip_fd ? other_fd : chip_fd) + 1, &set,
+            NULL, NULL, timeout_ms < 0 ? NULL : &timeout);
+        if(rv < 0)
+        {
+            return (errno == EINTR ? 0 : -1);
+        }
+
+        if(FD_ISSET(chip_fd, &set))
+        {
+            ready |= CHIP_READABLE;
+        }
+        if(other_fd >= 0 && FD_ISSET(other_fd, &set))
+        {
+            ready |= OTHER_READABLE;
+        }
+    }
+
+    if(rx_end > rx_begin)
+    {
+        ready |= CHIP_READABLE;
+    }
+    return ready;
+}
+
+
+// Reads whatever the chip has sent into the receive buffer without waiting.
+// Returns false if the port could not be read or has been hung up.
+bool chip_connection::receive()
+{
+    if(chip_fd < 0)
+    {
+        return false;
+    }
+
+    // move the unconsumed bytes to the front when the end is reached
+    if(rx_end == rx_buffer.size() && rx_begin > 0)
+    {
+        memmove(&rx_buffer[0], &rx_buffer[rx_begin], rx_end - rx_begin);
+        rx_end -= rx_begin;
+        rx_begin = 0;
+    }
+
+    while(rx_end < rx_buffer.size())
+    {
+        ssize_t bytes_read = read(chip_fd, &rx_buffer[rx_end],
+            rx_buffer.size() - rx_end);
+        if(bytes_read > 0)
+        {
+            rx_end += bytes_read;
+        }
+        else if(bytes_read == 0)
+        {
+            // the port is non-blocking, so 0 is the end of the file, not
+            // "nothing yet"
+            return false;
+        }
+        else if(errno == EINTR)
+        {
+            continue;
+        }
+        else if(errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            return false;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    return true;
+}
+
+
+// The bytes received and not yet consumed.  The view is good until the next
+// call to receive or read_bytes.
+string_view chip_connection::received() const
+{
+    if(rx_end == rx_begin)
+    {
+        return string_view();
+    }
+    return string_view(&rx_buffer[rx_begin], rx_end - rx_begin);
+}
+
+
+void chip_connection::consume(size_t num_bytes)
+{
+    if(num_bytes >= rx_end - rx_begin)
+    {
+        rx_begin = rx_end = 0;
+        return;
+    }
+    rx_begin += num_bytes;
+}
+
@@ -3,11 +3,16 @@
 
 
 #include <string>
+#include <string_view>
+#include <vector>
 #include <fcntl.h>
 #include <termios.h>
 using namespace std;
 
 
+// The bytes from the chip go into a receive buffer and are handed out as
+// string_views into it.  The serial port is non-blocking and waiting for
+// bytes is done with epoll, so nothing spins while the chip is quiet.
 class chip_connection
 {
 public:
@@ -19,7 +24,22 @@ public:
     int get_chip_fd();
     bool send_bytes_to_chip(string bytes, bool add_newline);
     string read_bytes(struct timeval time_period);
+    int wait_readable(int timeout_ms, int other_fd = -1);
+    bool receive();
+    string_view received() const;
+    void consume(size_t num_bytes);
+
+    // returned by wait_readable
+    static const int CHIP_READABLE = 0x01;
+    static const int OTHER_READABLE = 0x02;
+
+    // bytes received from the chip and not yet consumed are kept in a buffer
+    // this big.  Nothing more is read from the chip while it is full.
+    static const size_t RX_BUFFER_SIZE = 16384;
+
 private:
+    chip_connection& operator = (const chip_connection&);
+
     string device;
     int chip_fd;
     speed_t baud_rate;
@@ -27,6 +47,14 @@ private:
     struct termios new_sio;
     struct termios old_console;
     struct termios new_console;
+
+    int epoll_fd;
+    int watched_fd;
+
+    // the unconsumed bytes are rx_buffer[rx_begin] to rx_buffer[rx_end - 1]
+    vector<char> rx_buffer;
+    size_t rx_begin;
+    size_t rx_end;
 };
 
 
@@ -5,6 +5,7 @@
 #include <sstream>
 #include <cctype>
 #include <fcntl.h>
+#include <unistd.h>
 #include "packet.h"
 #include "string_utils.h"
 #include "cli.h"
@@ -12,6 +13,9 @@
 #include "chip_connection.h"
 #include "attribute.h"
 #include "filter.h"
+#include "capture_stream.h"
+#include "packet_store.h"
+#include "capture_file.h"
 using namespace std;
 
 
@@ -25,7 +29,7 @@ const string DEFAULT_DEVICE = "/dev/ttyS0";
 speed_t serial_device_baud = DEFAULT_BAUD;
 string serial_device = DEFAULT_DEVICE;
 
-const int NUM_HELP_STRINGS = 46;
+const int NUM_HELP_STRINGS = 53;
 bool chip_cli_mode = false;
 chip_connection* chip_con = NULL;
 
@@ -44,7 +48,7 @@ string log_filename = "log.txt";
 filebuf log_buf;
 ostream* log_file = NULL;
 
-vector <packet> packets;
+packet_store packets;
 
 
 
@@ -52,8 +56,27 @@ static const char* const HELP_STRINGS[] =
 {
     "help -- explanation of commands.",
     "clear -- removes all packets from memory.",
-    "load a.txt -- loads packets from a.txt into memory.  Removes all existing "
-        "packets from memory.",
+    "load a.txt -- displays the packets in a.txt as they are read, without "
+        "keeping them, so any size of capture can be loaded.  Removes all "
+        "existing packets from memory.",
+    "load a.txt keep -- the same, but every packet in a.txt, including those "
+        "that do not get through the filter, replaces the packets in memory "
+        "(see show).  For a large capture, convert it and load a.cap instead.",
+    "load a.cap -- binary captures (see convert) are loaded the same way, "
+        "with the timestamps as they were captured, and are kept in memory "
+        "(see show).",
+    "load a.cap time 1000 2000 -- displays only the packets from 1000 to 2000 "
+        "ms in the binary capture a.cap.  The index is used to find them.",
+    "load a.cap src_did 003 -- displays only the packets from source DID 003 "
+        "in the binary capture a.cap.  The index is used to find them.",
+    "load a.cap b.cap -- loads the binary captures a.cap and b.cap into memory "
+        "together in timestamp order.  A packet with the same timestamp as "
+        "one in an earlier capture is dropped.",
+    "convert a.txt a.cap -- writes the packets in the text capture a.txt to "
+        "the binary capture a.cap, with an index by time and by source DID.",
+    "show -- displays the packets in memory that get through the filter.  The "
+        "filter can be changed and the packets shown again without loading "
+        "them again.",
     "remove a.txt -- removes all packets from a.txt from memory.",
     "add a.txt -- adds all packets from a.txt from memory.",
     "save a.txt -- saves all packets in memory to a.txt.",
@@ -121,6 +144,12 @@ void cli_print_error(ostream& outs)
 }
 
 
+void chip_cli_print_lost_connection(ostream& outs)
+{
+    outs << "\nLost the connection to the chip.  Back to the sniffer cli.\n";
+}
+
+
 bool open_log_file(bool append_mode)
 {
     if(log_file)
@@ -502,6 +531,148 @@ bool cli_execute_attribute(string command_line)
 }
 
 
+// Displays the packets in memory that get through the filter.
+void cli_display_packets(const filter& fltr)
+{
+    vector<uint64_t> selected;
+    packets.select(fltr, selected);
+    packets.display(fltr, att, selected, cout);
+}
+
+
+// Reads the whole of a binary capture into store, or with "time <begin ms>
+// <end ms>" or "src_did <did>" only the packets the index points to.  Every
+// packet is kept, not only those that get through the filter, so that they
+// can be shown again with another filter.
+bool cli_read_capture_file(const string& filename, string options,
+    const filter& fltr, packet_store& store)
+{
+    capture_reader reader;
+    if(!reader.open(filename))
+    {
+        return false;
+    }
+
+    string option, value1, value2;
+    split_string(options, option, options);
+    split_string(options, value1, value2);
+    str_tolower(option);
+
+    vector<capture_record> records;
+    uint64_t begin, end, did;
+    if(option == "time" && value2 != "" && string_to_uint64_t(value1, begin,
+        false) && string_to_uint64_t(value2, end, false))
+    {
+        reader.read_time_window(begin * 1000, end * 1000 + 999, records);
+    }
+    else if(option == "src_did" && value1 != "" && value2 == "" &&
+        string_to_uint64_t(value1, did, true) && did <= 0xFFFF)
+    {
+        reader.read_device((UInt16) did, records);
+    }
+    else if(option != "")
+    {
+        return false;
+    }
+
+    store.clear();
+    packet pkt;
+    if(option == "")
+    {
+        // the whole capture is not read in first, since the records are much
+        // smaller in the store
+        capture_record record;
+        while(reader.read_record(record))
+        {
+            if(packet::create_packet(record, fltr, pkt))
+            {
+                store.insert(pkt);
+            }
+        }
+    }
+
+    for(unsigned int i = 0; i < records.size(); i++)
+    {
+        if(packet::create_packet(records[i], fltr, pkt))
+        {
+            store.insert(pkt);
+        }
+    }
+
+    return true;
+}
+
+
+bool cli_load_capture_file(const string& filename, const string& options,
+    const filter& fltr)
+{
+    if(!cli_read_capture_file(filename, options, fltr, packets))
+    {
+        return false;
+    }
+
+    cli_display_packets(fltr);
+    return true;
+}
+
+
+// Loads several binary captures into memory in timestamp order.  Each one is
+// read on its own and merged into the ones before it, so a packet with the
+// same timestamp as one from an earlier capture is dropped.
+bool cli_load_capture_files(const vector<string>& filenames,
+    const filter& fltr)
+{
+    packet_store next;
+    vector<const packet_store*> sources;
+    sources.push_back(&packets);
+    sources.push_back(&next);
+
+    packets.clear();
+    for(unsigned int i = 0; i < filenames.size(); i++)
+    {
+        if(!cli_read_capture_file(filenames[i], "", fltr, next))
+        {
+            packets.clear();
+            return false;
+        }
+        packet_store::merge(sources, packets);
+    }
+
+    cli_display_packets(fltr);
+    return true;
+}
+
+
+// Writes the packets in a text capture to a binary capture.
+bool cli_execute_convert(string command_line)
+{
+    string text_filename, capture_filename, extra;
+    split_string(command_line, text_filename, capture_filename);
+    split_string(capture_filename, capture_filename, extra);
+    if(capture_filename == "" || extra != "")
+    {
+        return false;
+    }
+
+    ifstream ins(text_filename.c_str());
+    capture_writer writer;
+    if(!ins.is_open() || !writer.open(capture_filename))
+    {
+        return false;
+    }
+
+    bool converted = convert_text_capture(ins, writer);
+    uint64_t num_records = writer.get_num_records();
+    if(!writer.close() || !converted)
+    {
+        return false;
+    }
+
+    cout << "\n\n# of packets : " << num_records << "\n\n";
+    return true;
+}
+
+
 bool cli_execute_load(string command_line, const filter& fltr)
 {
     bool use_log_file = false;
@@ -523,7 +694,44 @@ bool cli_execute_load(string command_line, const filter& fltr)
         }
     }
 
-    packet pkt;
+    bool keep = false;
+    if(!use_log_file && !capture_reader::is_capture_file(filename))
+    {
+        string first, options;
+        split_string(command_line, first, options);
+        if(options != "" && capture_reader::is_capture_file(first))
+        {
+            string next, rest;
+            split_string(options, next, rest);
+            if(!capture_reader::is_capture_file(next))
+            {
+                return cli_load_capture_file(first, options, fltr);
+            }
+
+            vector<string> filenames(1, first);
+            while(options != "")
+            {
+                split_string(options, next, options);
+                if(!capture_reader::is_capture_file(next))
+                {
+                    return false;
+                }
+                filenames.push_back(next);
+            }
+            return cli_load_capture_files(filenames, fltr);
+        }
+
+        str_tolower(options);
+        if(options == "keep")
+        {
+            keep = true;
+            filename = first;
+        }
+    }
+    else if(!use_log_file)
+    {
+        return cli_load_capture_file(filename, "", fltr);
+    }
 
     ifstream ins;
     ins.open(filename.c_str());
@@ -534,27 +742,14 @@ bool cli_execute_load(string command_line, const filter& fltr)
     }
     else
     {
-        string line;
+        // packets are displayed as they are read.  With keep, all of them
+        // are kept for show, with timestamps relative to the first one.
         packets.clear();
-        while(ins)
-        {
-            getline(ins, line, '\n');
-            if(ins.good())
-            {
-                if(packet::create_packet(line, fltr, pkt))
-                {
-                    if(pkt.filter_packet(fltr))
-                    {
-                        packet::insert_packet(packets, pkt);
-                    }
-                }
-            }
-        }
-
+        capture_stream stream(ins, fltr, att, cout, keep ? &packets : NULL);
+        ret_value = stream.run();
         ins.close();
-        struct timeval start_time = {0,0};
-        packet::adjust_timestamps(packets, start_time);
-        packet::display(packets, att, cout);
+        struct timeval zero = {0, 0};
+        packets.adjust_timestamps(zero);
     }
 
     if(use_log_file)
@@ -761,6 +956,18 @@ bool cli_execute_command(string& command_line)
     {
         valid_parse = cli_execute_load(args, pkt_filter);
     }
+    else if(command.compare("convert") == 0)
+    {
+        valid_parse = cli_execute_convert(args);
+    }
+    else if(command.compare("show") == 0 && args == "")
+    {
+        cli_display_packets(pkt_filter);
+    }
+    else if(command.compare("clear") == 0 && args == "")
+    {
+        packets.clear();
+    }
     else if(command.compare("exit") == 0)
     {
         delete chip_con;
@@ -855,32 +1062,56 @@ bool cli()
 
         while(!newline_input_rcvd)
         {
-            struct timeval timeout = {0,0}; // poll, no pause
-            fd_set set;
-            FD_ZERO(&set);
-            FD_SET(STDIN_FILENO, &set);
+            // sleep until the chip or the keyboard has something
+            int ready = chip_con->wait_readable(-1, STDIN_FILENO);
+            bool chip_ok = (ready >= 0);
 
-
-            int rv = select(STDIN_FILENO + 1, &set, NULL, NULL, &timeout);
-            if(rv < -1)
+            if(chip_ok && (ready & chip_connection::CHIP_READABLE))
             {
-                continue; // Error.  Not sure what to do here.  Abort?
+                // get any output from the chip
+                chip_ok = chip_con->receive();
+                string_view chip_output = chip_con->received();
+                cout.write(chip_output.data(), chip_output.size());
+                cout.flush();
+                if(logging)
+                {
+                    log_file->write(chip_output.data(), chip_output.size());
+                }
+                chip_con->consume(chip_output.size());
             }
-            else if(rv == 0)
+
+            if(!chip_ok)
             {
-                // get any output from the chip
-                string chip_output = chip_con->read_bytes(timeout);
-                cout << chip_output;
+                // the port has gone away (say the chip was unplugged), so
+                // go back to the sniffer cli.  chip_cli opens it again.
+                chip_cli_print_lost_connection(cout);
                 if(logging)
                 {
-                    *log_file << chip_output;
+                    chip_cli_print_lost_connection(*log_file);
                 }
+                delete chip_con;
+                chip_con = NULL;
+                chip_cli_mode = false;
+                return true;
             }
-            else
+
+            if(ready & chip_connection::OTHER_READABLE)
             {
                 char byte;
                 int bytes_read = read(STDIN_FILENO, &byte, 1);
-                if(bytes_read)
+                if(bytes_read <= 0)
+                {
+                    // nothing more will come from the keyboard
+                    cout << "\nEnd of input.\n";
+                    if(logging)
+                    {
+                        *log_file << "\nEnd of input.\n";
+                    }
+                    delete chip_con;
+                    chip_con = NULL;
+                    return false;
+                }
+                else
                 {
                     write(STDOUT_FILENO, &byte, 1); // echo the byte
                     if(logging)
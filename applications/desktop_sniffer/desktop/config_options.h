@@ -172,6 +172,16 @@
         #endif
     #endif  
 
+    #ifdef BLOCK_MESSAGES_ENABLED
+        // Enable to send block transfers in sliding windows of up to 40
+        // packets.  The packets in a window are sent back to back, only the
+        // ones the receiver's bitmap reports missing are sent again, and the
+        // window and the pauses adapt to the loss seen.
+        #ifndef BLOCK_SLIDING_WINDOW
+            #define BLOCK_SLIDING_WINDOW
+        #endif
+    #endif
+
     #if defined(BLOCK_MESSAGES_ENABLED) && defined(ONE_NET_CLIENT)
         // Relevant only for clients initiating block / stream.  Enable if the
         // client has the ability to request permission from the master for
@@ -473,6 +483,12 @@
 		#define ENABLE_LIST_COMMAND
 	#endif
 
+	// ENABLE_RTT_COMMAND should be defined if you are implementing the "rtt" command option.
+	// ADAPTIVE_RESPONSE_TIMEOUT must be defined too.
+	#ifndef ENABLE_RTT_COMMAND
+		#define ENABLE_RTT_COMMAND
+	#endif
+
     // Master Only Commands
     #ifdef ONE_NET_MASTER
     
@@ -637,6 +653,87 @@
     #define ONE_NET_MEMORY
 #endif
 
+// Enable ONE_NET_MEMORY_POOL to have one_net_malloc and one_net_free hand out
+// fixed size blocks from a few size classes instead of searching the "heap".
+// Allocating and freeing then take the same short time no matter how the
+// memory has been used.  If ONE_NET_MEMORY_POOL is enabled, ONE_NET_MEMORY
+// must be enabled too and the ONE_NET_POOL_ size classes must be defined in
+// one_net_port_const.h.
+#ifndef ONE_NET_MEMORY_POOL
+//    #define ONE_NET_MEMORY_POOL
+#endif
+
+// Enable ADAPTIVE_RESPONSE_TIMEOUT to keep an estimate of how long single
+// data responses take to come back from each recent destination and to wait
+// only that long (plus a margin) before retrying instead of always waiting
+// the worst case.  ONE_NET_RTT_TABLE_SIZE and ONE_NET_RTT_MIN_MARGIN must be
+// defined in one_net_port_const.h.
+#ifndef ADAPTIVE_RESPONSE_TIMEOUT
+    #define ADAPTIVE_RESPONSE_TIMEOUT
+#endif
+
+
+// Enable ONE_NET_DEVICE_CONTEXT to run any number of devices in one process.
+// Each device's state is kept in an on_device_context_t which is passed to
+// one_net_master(), one_net_client() and one_net().  Needs gcc on an ELF
+// target (see one_net_context.h).  Leave it off for a single device.
+#ifndef ONE_NET_DEVICE_CONTEXT
+//    #define ONE_NET_DEVICE_CONTEXT
+#endif
+
+// Enable SIMULATED_TICK to stop the Linux tick count from following the
+// clock.  It then only moves when it is set, as the simulated transceiver
+// (transceivers/sim) does.
+#ifndef SIMULATED_TICK
+//    #define SIMULATED_TICK
+#endif
+
+
+// Enable CRC_LOOKUP_TABLE to compute the 8th order CRCs from a lookup table
+// (see one_net_crc_table.h) instead of bit by bit.  The table is 256 bytes
+// of ROM per row.  CRC_SLICE_BY is the number of bytes handled per step and
+// must be 1, 4, or 8.  It is also the number of rows in the table, so values
+// greater than 1 are generally only for desktop applications.
+#ifndef CRC_LOOKUP_TABLE
+    #define CRC_LOOKUP_TABLE
+#endif
+
+#ifdef CRC_LOOKUP_TABLE
+    #ifndef CRC_SLICE_BY
+        #define CRC_SLICE_BY 8
+    #endif
+#endif
+
+
+// Enable ENCODE_LOOKUP_TABLE to encode and decode 4 values at a time using a
+// combined 256 byte decode table instead of one value at a time.  Enable
+// ENCODE_SIMD as well to decode large arrays with SSSE3 / AVX2 when the
+// processor supports it (x86 only, ignored elsewhere).
+#ifndef ENCODE_LOOKUP_TABLE
+    #define ENCODE_LOOKUP_TABLE
+#endif
+
+#ifdef ENCODE_LOOKUP_TABLE
+    #ifndef ENCODE_SIMD
+        #define ENCODE_SIMD
+    #endif
+#endif
+
+
+// Enable XTEA_KEY_SCHEDULE to expand an XTEA key once and then encipher /
+// decipher any number of blocks with it (about 260 bytes of RAM per expanded
+// key).  Enable XTEA_SIMD as well to do 4 (SSE2) or 8 (AVX2) blocks side by
+// side (x86 only, ignored elsewhere).
+#ifndef XTEA_KEY_SCHEDULE
+    #define XTEA_KEY_SCHEDULE
+#endif
+
+#ifdef XTEA_KEY_SCHEDULE
+    #ifndef XTEA_SIMD
+        #define XTEA_SIMD
+    #endif
+#endif
+
 
 
 // Use this feature to override any random channel searching and select a
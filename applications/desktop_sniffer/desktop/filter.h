@@ -3,7 +3,6 @@
 
 
 #include <stdint.h>
-#include <list>
 #include <ostream>
 #include <vector>
 #include "xtea_key.h"
@@ -52,9 +51,13 @@ public:
     bool reject_range(uint64_t low, uint64_t high);
     void display(ostream& outs, bool hex, bool key, unsigned int width) const;
     void remove_all();
+    const vector<filter_range>& get_ranges() const;
 private:
     bool find_value(uint64_t value, int& index) const;
-    list<filter_range> accepted_values;
+
+    // sorted, with no two ranges overlapping or touching.  Empty accepts
+    // every value.
+    vector<filter_range> accepted_values;
 };
 
 
@@ -141,6 +144,10 @@ public:
 
 
 private:
+    friend class filter_matcher;
+    friend class capture_columns;
+    static bool match_accepted(FILTER_MATCH fm, bool value);
+
     vector<filter_list> filters;
     vector<xtea_key> keys;
     vector<xtea_key> invite_keys;
@@ -150,5 +157,51 @@ private:
     FILTER_MATCH valid_match;
 };
 
+
+// A filter made ready for testing a lot of packets.  Only the filters that
+// can reject a packet are kept, with the ranges of all of them in one array,
+// and every filter type is tested in one pass over them.  Changes made to the
+// filter after the matcher is made are not seen by it.
+class filter_matcher
+{
+public:
+    // the values a packet has for the filter types.  A range filter is tested
+    // only if has_value is set for it and the keys only if key is set.
+    struct packet_values
+    {
+        packet_values();
+
+        uint64_t value[filter::FILTER_MSG_CRC_MATCH];
+        bool has_value[filter::FILTER_MSG_CRC_MATCH];
+        bool match_value[filter::FILTER_INVITE_KEYS -
+            filter::FILTER_MSG_CRC_MATCH];
+        bool is_invite;
+        const xtea_key* key;
+    };
+
+    filter_matcher(const filter& fltr);
+    bool accepted(const packet_values& values) const;
+
+private:
+    // the ranges of filter type ft are ranges[begin] to ranges[end - 1]
+    struct range_test
+    {
+        filter::FILTER_TYPE ft;
+        unsigned int begin;
+        unsigned int end;
+    };
+
+    static bool in_ranges(const filter_range* begin, const filter_range* end,
+        uint64_t value);
+
+    vector<range_test> range_tests;
+    vector<filter_range> ranges;
+    vector<filter::FILTER_TYPE> match_tests;
+    filter::FILTER_MATCH match[filter::FILTER_INVITE_KEYS -
+        filter::FILTER_MSG_CRC_MATCH];
+    vector<xtea_key> keys;
+    vector<xtea_key> invite_keys;
+};
+
 #endif	/* FILTER_H */
 
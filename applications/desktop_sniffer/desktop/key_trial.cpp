@@ -0,0 +1,356 @@
+#include "key_trial.h"
+#include <climits>
+#include <cstring>
+#include "xtea_key.h"
+#include "one_net_types.h"
+#include "one_net_xtea.h"
+#include "one_net_packet.h"
+#include "one_net_message.h"
+using namespace std;
+
+
+// same as the round counts on_decrypt uses
+static const UInt8 XTEA_8_ROUNDS = 8;
+static const UInt8 XTEA_32_ROUNDS = 32;
+
+
+key_trial_engine::key_trial_engine()
+{
+    num_threads = thread::hardware_concurrency();
+    if(num_threads == 0)
+    {
+        num_threads = 1;
+    }
+    job = NULL;
+    job_generation = 0;
+    busy_threads = 0;
+    stopping = false;
+}
+
+
+key_trial_engine::~key_trial_engine()
+{
+    stop_threads();
+}
+
+
+// Returns the index in keys of the key that decrypts the payload (the crc
+// passes) and fills in decrypted, or -1 if no key works.  payload_len
+// includes the encryption type byte, as with on_decrypt.
+int key_trial_engine::find_key(uint64_t raw_nid, UInt16 raw_src_did,
+    UInt16 raw_pid, bool is_stream_pkt, const UInt8* encrypted,
+    UInt8 payload_len, const vector<xtea_key>& keys, UInt8* decrypted)
+{
+    lock_guard<mutex> lock(find_mutex);
+    UInt8 rounds;
+
+    if(!encrypted || !decrypted || keys.empty() ||
+        get_raw_payload_len(raw_pid) != payload_len ||
+        !get_rounds(is_stream_pkt, encrypted, payload_len, rounds))
+    {
+        return -1;
+    }
+
+    trial_job trial;
+    trial.raw_pid = raw_pid;
+    trial.is_stream_pkt = is_stream_pkt;
+    trial.encrypted = encrypted;
+    trial.payload_len = payload_len;
+    trial.keys = &keys;
+
+    pair<uint64_t, UInt16> device(raw_nid, raw_src_did);
+    map<pair<uint64_t, UInt16>, xtea_key>::const_iterator it =
+        device_keys.find(device);
+    if(it != device_keys.end())
+    {
+        int index = xtea_key::find_key(keys, it->second);
+        if(index >= 0 && try_key(trial, index, decrypted))
+        {
+            return index;
+        }
+    }
+
+    if(rounds == 0)
+    {
+        // not encrypted, so the key does not matter
+        return try_key(trial, 0, decrypted) ? 0 : -1;
+    }
+
+    #ifdef XTEA_KEY_SCHEDULE
+    trial.rounds = rounds;
+    trial.schedules = get_schedules(keys, rounds);
+    #endif
+    trial.num_chunks = (keys.size() + KEYS_PER_CHUNK - 1) / KEYS_PER_CHUNK;
+    trial.next_chunk = 0;
+    trial.found = INT_MAX;
+
+    if(num_threads > 1 && keys.size() >= MIN_KEYS_FOR_THREADS)
+    {
+        run_job_on_threads(trial);
+    }
+    else
+    {
+        run_job(trial);
+    }
+
+    int index = trial.found;
+    if(index == INT_MAX || !try_key(trial, index, decrypted))
+    {
+        return -1;
+    }
+
+    device_keys[device] = keys[index];
+    return index;
+}
+
+
+bool key_trial_engine::get_rounds(bool is_stream_pkt, const UInt8* encrypted,
+    UInt8 payload_len, UInt8& rounds)
+{
+    if(payload_len < ONE_NET_XTEA_BLOCK_SIZE + 1 ||
+        payload_len > ON_MAX_RAW_PLD_LEN_WITH_TECH ||
+        payload_len % ONE_NET_XTEA_BLOCK_SIZE != 1)
+    {
+        return false;
+    }
+
+    UInt8 encryption = encrypted[payload_len - 1];
+    #ifdef STREAM_MESSAGES_ENABLED
+    if(is_stream_pkt)
+    {
+        switch(encryption)
+        {
+            case ONE_NET_STREAM_ENCRYPT_NONE:
+                rounds = 0;
+                return true;
+            case ONE_NET_STREAM_ENCRYPT_XTEA8:
+                rounds = XTEA_8_ROUNDS;
+                return true;
+            default:
+                return false;
+        }
+    }
+    #endif
+
+    switch(encryption)
+    {
+        case ONE_NET_SINGLE_BLOCK_ENCRYPT_NONE:
+            rounds = 0;
+            return true;
+        case ONE_NET_SINGLE_BLOCK_ENCRYPT_XTEA32:
+            rounds = XTEA_32_ROUNDS;
+            return true;
+        default:
+            return false;
+    }
+}
+
+
+// decrypts with one key the same way the sniffer always has
+bool key_trial_engine::try_key(const trial_job& job, unsigned int index,
+    UInt8* decrypted)
+{
+    memcpy(decrypted, job.encrypted, job.payload_len);
+    #ifdef STREAM_MESSAGES_ENABLED
+    if(on_decrypt(job.is_stream_pkt, decrypted,
+        (const one_net_xtea_key_t*) job.keys->at(index).bytes,
+        job.payload_len) != ONS_SUCCESS)
+    #else
+    if(on_decrypt(decrypted,
+        (const one_net_xtea_key_t*) job.keys->at(index).bytes,
+        job.payload_len) != ONS_SUCCESS)
+    #endif
+    {
+        return false;
+    }
+
+    return verify_payload_crc(job.raw_pid, decrypted);
+}
+
+
+// returns the index of the first key in the chunk that works, -1 if none do
+int key_trial_engine::try_chunk(const trial_job& job, unsigned int chunk)
+{
+    unsigned int first = chunk * KEYS_PER_CHUNK;
+    unsigned int num_keys = job.keys->size() - first;
+    if(num_keys > KEYS_PER_CHUNK)
+    {
+        num_keys = KEYS_PER_CHUNK;
+    }
+
+    #ifdef XTEA_KEY_SCHEDULE
+    // every key's copy of the payload goes in one buffer so the keys can be
+    // run side by side
+    const UInt8 NUM_BLOCKS = (job.payload_len - 1) / ONE_NET_XTEA_BLOCK_SIZE;
+    const UInt8 PLD_SIZE = NUM_BLOCKS * ONE_NET_XTEA_BLOCK_SIZE;
+    UInt8 data[KEYS_PER_CHUNK * ON_MAX_RAW_PLD_LEN];
+    const one_net_xtea_key_schedule_t* lanes[KEYS_PER_CHUNK *
+        (ON_MAX_RAW_PLD_LEN / ONE_NET_XTEA_BLOCK_SIZE)];
+    schedule_cache& cache = *job.schedules;
+
+    for(unsigned int i = 0; i < num_keys; i++)
+    {
+        unsigned int index = first + i;
+        const xtea_key& key = job.keys->at(index);
+        if(cache.schedules[index].rounds != job.rounds ||
+            !cache.keys[index].equal(key))
+        {
+            cache.keys[index] = key;
+            one_net_xtea_key_schedule(&cache.schedules[index], job.rounds,
+                (const one_net_xtea_key_t*) key.bytes);
+        }
+
+        memcpy(&data[i * PLD_SIZE], job.encrypted, PLD_SIZE);
+        for(UInt8 j = 0; j < NUM_BLOCKS; j++)
+        {
+            lanes[i * NUM_BLOCKS + j] = &cache.schedules[index];
+        }
+    }
+
+    one_net_xtea_decipher_blocks_multi_key(lanes, data,
+        num_keys * NUM_BLOCKS);
+
+    for(unsigned int i = 0; i < num_keys; i++)
+    {
+        if(verify_payload_crc(job.raw_pid, &data[i * PLD_SIZE]))
+        {
+            return first + i;
+        }
+    }
+    #else
+    UInt8 decrypted[ON_MAX_RAW_PLD_LEN_WITH_TECH];
+
+    for(unsigned int i = 0; i < num_keys; i++)
+    {
+        if(try_key(job, first + i, decrypted))
+        {
+            return first + i;
+        }
+    }
+    #endif
+
+    return -1;
+}
+
+
+// Chunks are taken in order, so once a key has been found any chunk that
+// starts past it can be skipped.  Chunks before it are always finished, so
+// the lowest working index is what ends up in found.
+void key_trial_engine::run_job(trial_job& job)
+{
+    while(true)
+    {
+        unsigned int chunk = job.next_chunk++;
+        if(chunk >= job.num_chunks ||
+            (int) (chunk * KEYS_PER_CHUNK) > job.found)
+        {
+            return;
+        }
+
+        int index = try_chunk(job, chunk);
+        if(index < 0)
+        {
+            continue;
+        }
+
+        int found = job.found;
+        while(index < found && !job.found.compare_exchange_weak(found, index))
+        {
+        }
+    }
+}
+
+
+void key_trial_engine::run_job_on_threads(trial_job& trial)
+{
+    {
+        unique_lock<mutex> lock(job_mutex);
+        while(threads.size() < num_threads - 1)
+        {
+            threads.push_back(thread(&key_trial_engine::worker, this));
+        }
+        job = &trial;
+        job_generation++;
+    }
+    job_ready.notify_all();
+
+    run_job(trial);
+
+    // threads that have not picked the job up yet must not start it now
+    unique_lock<mutex> lock(job_mutex);
+    job = NULL;
+    while(busy_threads > 0)
+    {
+        job_done.wait(lock);
+    }
+}
+
+
+void key_trial_engine::worker()
+{
+    unique_lock<mutex> lock(job_mutex);
+    unsigned int generation = job_generation;
+
+    while(true)
+    {
+        while(!stopping && generation == job_generation)
+        {
+            job_ready.wait(lock);
+        }
+        if(stopping)
+        {
+            return;
+        }
+
+        generation = job_generation;
+        trial_job* current = job;
+        if(!current)
+        {
+            continue;
+        }
+
+        busy_threads++;
+        lock.unlock();
+        run_job(*current);
+        lock.lock();
+        if(--busy_threads == 0)
+        {
+            job_done.notify_all();
+        }
+    }
+}
+
+
+void key_trial_engine::stop_threads()
+{
+    {
+        lock_guard<mutex> lock(job_mutex);
+        stopping = true;
+    }
+    job_ready.notify_all();
+
+    for(unsigned int i = 0; i < threads.size(); i++)
+    {
+        threads[i].join();
+    }
+    threads.clear();
+    stopping = false;
+}
+
+
+#ifdef XTEA_KEY_SCHEDULE
+// Only makes room for the keys.  The chunks fill in the schedules, so keys
+// that are never reached are never expanded.
+key_trial_engine::schedule_cache* key_trial_engine::get_schedules(
+    const vector<xtea_key>& keys, UInt8 rounds)
+{
+    schedule_cache& cache = schedules[rounds];
+    if(cache.schedules.size() != keys.size())
+    {
+        cache.keys.resize(keys.size());
+        cache.schedules.resize(keys.size());
+    }
+
+    return &cache;
+}
+#endif
@@ -0,0 +1,102 @@
+#ifndef KEY_TRIAL_H
+#define	KEY_TRIAL_H
+
+
+#include <stdint.h>
+#include <map>
+#include <vector>
+#include <utility>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include "xtea_key.h"
+#include "one_net_types.h"
+#include "one_net_xtea.h"
+using namespace std;
+
+
+// Finds which key in a key set decrypts a payload.  The keys are tried in
+// chunks, spread over a pool of threads when there are enough of them, and
+// the search stops once a key passes the payload crc.  The lowest index that
+// passes is returned, same as trying the keys one after the other.  The key
+// that worked for a device (nid / source did) is tried first the next time.
+class key_trial_engine
+{
+public:
+    key_trial_engine();
+    ~key_trial_engine();
+    int find_key(uint64_t raw_nid, UInt16 raw_src_did, UInt16 raw_pid,
+        bool is_stream_pkt, const UInt8* encrypted, UInt8 payload_len,
+        const vector<xtea_key>& keys, UInt8* decrypted);
+
+    // keys are handed out to the threads this many at a time
+    static const unsigned int KEYS_PER_CHUNK = 64;
+
+    // smaller key sets are tried by the calling thread only
+    static const unsigned int MIN_KEYS_FOR_THREADS = 512;
+
+private:
+    key_trial_engine(const key_trial_engine&);
+    key_trial_engine& operator = (const key_trial_engine&);
+
+    #ifdef XTEA_KEY_SCHEDULE
+    // A key's schedule is made the first time the key is tried and is kept
+    // until a different key turns up at that index.
+    struct schedule_cache
+    {
+        vector<xtea_key> keys;
+        vector<one_net_xtea_key_schedule_t> schedules;
+    };
+    #endif
+
+    struct trial_job
+    {
+        UInt16 raw_pid;
+        bool is_stream_pkt;
+        const UInt8* encrypted;
+        UInt8 payload_len;
+        const vector<xtea_key>* keys;
+        #ifdef XTEA_KEY_SCHEDULE
+        UInt8 rounds;
+        schedule_cache* schedules;
+        #endif
+        unsigned int num_chunks;
+        atomic<unsigned int> next_chunk;
+        atomic<int> found;
+    };
+
+    static bool get_rounds(bool is_stream_pkt, const UInt8* encrypted,
+        UInt8 payload_len, UInt8& rounds);
+    static bool try_key(const trial_job& job, unsigned int index,
+        UInt8* decrypted);
+    static int try_chunk(const trial_job& job, unsigned int chunk);
+    static void run_job(trial_job& job);
+    void run_job_on_threads(trial_job& job);
+    void worker();
+    void stop_threads();
+    #ifdef XTEA_KEY_SCHEDULE
+    schedule_cache* get_schedules(const vector<xtea_key>& keys, UInt8 rounds);
+    #endif
+
+    mutex find_mutex;
+    map<pair<uint64_t, UInt16>, xtea_key> device_keys;
+
+    #ifdef XTEA_KEY_SCHEDULE
+    // by number of rounds
+    map<UInt8, schedule_cache> schedules;
+    #endif
+
+    unsigned int num_threads;
+    vector<thread> threads;
+    mutex job_mutex;
+    condition_variable job_ready;
+    condition_variable job_done;
+    trial_job* job;
+    unsigned int job_generation;
+    unsigned int busy_threads;
+    bool stopping;
+};
+
+
+#endif	/* KEY_TRIAL_H */
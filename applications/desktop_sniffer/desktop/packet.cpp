@@ -1,10 +1,14 @@
 #include "packet.h"
 #include <cstdio>
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <sys/time.h>
 #include <string>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
 #include <cstdio>
 #include "attribute.h"
 #include "filter.h"
@@ -117,6 +121,7 @@ string_int_struct admin_msg_type_strings[NUM_ADMIN_MSG_TYPES] =
 
 vector<xtea_key> packet::keys;
 vector<xtea_key> packet::invite_keys;
+key_trial_engine packet::key_engine;
 const UInt8 packet::INVALID_CRC = 0xFF;
 const UInt16 packet::INVALID_DID = 0xFFFF;
 const uint64_t packet::INVALID_NID = 0xFFFFFFFFFFFFll;
@@ -321,117 +326,92 @@ bool packet::parse_payload(UInt16 raw_pid, UInt8* decrypted_payload_bytes,
 }
 
 
+// Makes a matcher for the one packet.  When filtering a lot of packets, make
+// the filter_matcher once and call the other filter_packet.
 bool packet::filter_packet(const filter& fltr) const
 {
-cout << "p1\n";
-    // test timestamp
-    if(!fltr.value_accepted(filter::FILTER_TIMESTAMP,
-        struct_timeval_to_milliseconds(this->timestamp)))
-    {
-        return false;
-    }
-cout << "p2\n";
-
-    // test source did
-    if(!fltr.value_accepted(filter::FILTER_SRC_DID, raw_src_did))
-    {
-        return false;
-    }
-
-    // test repeater did
-    if(!fltr.value_accepted(filter::FILTER_RPTR_DID, raw_rptr_did))
-    {
-        return false;
-    }
-
-    // test nid
-    if(!fltr.value_accepted(filter::FILTER_NID, raw_nid))
-    {
-        return false;
-    }
-
-    // test pid
-    if(!fltr.value_accepted(filter::FILTER_PID, payload.raw_pid))
-    {
-        return false;
-    }
-
-    // test encryption key
-    if(!fltr.value_accepted(payload.is_invite_pkt ? filter::FILTER_INVITE_KEYS :
-        filter::FILTER_KEYS, key))
-    {
-        return false;
-    }
-
-    // test message crc
-    if(!fltr.value_accepted(filter::FILTER_MSG_CRC, msg_crc))
-    {
-        return false;
-    }
-    if(!fltr.match_value_accepted(filter::FILTER_MSG_CRC_MATCH, valid_msg_crc))
-    {
-        return false;
-    }
+    return filter_packet(filter_matcher(fltr));
+}
 
-    // test payload crc
-    if(!fltr.value_accepted(filter::FILTER_PLD_CRC, payload.payload_crc))
-    {
-        return false;
-    }
-    if(!fltr.match_value_accepted(filter::FILTER_PAYLOAD_CRC_MATCH,
-        payload.valid_payload_crc))
-    {
-        return false;
-    }
 
-    // test message id
-    if(!fltr.value_accepted(filter::FILTER_MSG_ID, payload.msg_id))
-    {
-        return false;
-    }
+bool packet::filter_packet(const filter_matcher& matcher) const
+{
+    filter_matcher::packet_values values;
+    values.value[filter::FILTER_TIMESTAMP] = struct_timeval_to_milliseconds(
+        this->timestamp);
+    values.value[filter::FILTER_SRC_DID] = raw_src_did;
+    values.value[filter::FILTER_RPTR_DID] = raw_rptr_did;
+    values.value[filter::FILTER_DST_DID] = raw_dst_did;
+    values.value[filter::FILTER_NID] = raw_nid;
+    values.value[filter::FILTER_PID] = payload.raw_pid;
+    values.value[filter::FILTER_MSG_CRC] = msg_crc;
+    values.value[filter::FILTER_HOPS] = hops;
+    values.value[filter::FILTER_MAX_HOPS] = max_hops;
+    values.has_value[filter::FILTER_TIMESTAMP] = true;
+    values.has_value[filter::FILTER_SRC_DID] = true;
+    values.has_value[filter::FILTER_RPTR_DID] = true;
+    values.has_value[filter::FILTER_DST_DID] = true;
+    values.has_value[filter::FILTER_NID] = true;
+    values.has_value[filter::FILTER_PID] = true;
+    values.has_value[filter::FILTER_MSG_CRC] = true;
+    values.has_value[filter::FILTER_HOPS] = true;
+    values.has_value[filter::FILTER_MAX_HOPS] = true;
+
+    // The payload values are whatever the last packet left if this one was
+    // not decrypted, so they are only tested if it was.
+    if(payload.valid_payload_crc)
+    {
+        values.value[filter::FILTER_PLD_CRC] = payload.payload_crc;
+        values.value[filter::FILTER_MSG_ID] = payload.msg_id;
+        values.has_value[filter::FILTER_PLD_CRC] = true;
+        values.has_value[filter::FILTER_MSG_ID] = true;
+    }
+
+    // payload message type
+    if(has_pld_msg_type())
+    {
+        values.value[filter::FILTER_PLD_MSG_TYPE] = payload.msg_type;
+        values.has_value[filter::FILTER_PLD_MSG_TYPE] = true;
+    }
+
+    // admin message type
+    if(has_admin_type())
+    {
+        values.value[filter::FILTER_ADMIN_TYPE] =
+            payload.admin_payload.admin_type;
+        values.has_value[filter::FILTER_ADMIN_TYPE] = true;
+    }
+
+    values.match_value[filter::FILTER_MSG_CRC_MATCH -
+        filter::FILTER_MSG_CRC_MATCH] = valid_msg_crc;
+    values.match_value[filter::FILTER_PAYLOAD_CRC_MATCH -
+        filter::FILTER_MSG_CRC_MATCH] = payload.valid_payload_crc;
+    values.match_value[filter::FILTER_VALID_MATCH -
+        filter::FILTER_MSG_CRC_MATCH] = valid;
+    values.match_value[filter::FILTER_VALID_DECODE_MATCH -
+        filter::FILTER_MSG_CRC_MATCH] = valid_decode;
+
+    // encryption key, which is only known if the payload was decrypted
+    values.is_invite = payload.is_invite_pkt;
+    values.key = (payload.valid_payload_crc ? &key : NULL);
+
+    return matcher.accepted(values);
+}
 
-    // test valid decode and valid
-    if(!fltr.match_value_accepted(filter::FILTER_VALID_DECODE_MATCH,
-        valid_decode))
-    {
-        return false;
-    }
-    if(!fltr.match_value_accepted(filter::FILTER_VALID_MATCH, valid))
-    {
-        return false;
-    }
 
-    // test hops and max hops
-    if(!fltr.value_accepted(filter::FILTER_HOPS, hops))
-    {
-        return false;
-    }
-    if(!fltr.value_accepted(filter::FILTER_MAX_HOPS, max_hops))
-    {
-        return false;
-    }
+bool packet::has_pld_msg_type() const
+{
+    return (payload.valid_payload_crc && is_data_pkt && is_single_pkt);
+}
 
-    // test admin message type
-    bool test_admin_type = false;
-    UInt8 admin_type;
-    if(is_data_pkt && is_single_pkt)
-    {
-        test_admin_type = true;
-        admin_type = payload.admin_payload.admin_type;
-    }
-    else if(this->is_response_pkt && payload.admin_payload.admin_type ==
-        ON_ACK_ADMIN_MSG)
-    {
-        test_admin_type = true;
-        admin_type = payload.admin_payload.admin_type;
-    }
-    if(test_admin_type && !fltr.value_accepted(filter::FILTER_ADMIN_TYPE,
-        admin_type))
-    {
-        return false;
-    }
 
-    return true;
+// Only admin messages have an admin type.  In any other payload the byte is
+// part of something else.
+bool packet::has_admin_type() const
+{
+    return (payload.valid_payload_crc && ((is_data_pkt && is_single_pkt &&
+        payload.is_admin_pkt) || (this->is_response_pkt &&
+        payload.admin_payload.admin_type == ON_ACK_ADMIN_MSG)));
 }
 
 
@@ -571,31 +551,18 @@ bool packet::fill_in_packet_values(struct timeval timestamp, UInt16 raw_pid,
 
     const vector<xtea_key>* keys = fltr.get_keys(packet_is_invite(raw_pid));
 
-    for(unsigned int i = 0; !valid_decrypt && i < keys->size(); i++)
+    int key_index = key_engine.find_key(raw_nid, raw_src_did, raw_pid,
+        is_stream_pkt, encrypted_payload_bytes, payload.num_payload_bytes + 1,
+        *keys, payload.decrypted_payload_bytes);
+    if(key_index >= 0)
     {
-        memmove(payload.decrypted_payload_bytes, encrypted_payload_bytes,
-            ON_MAX_ENCODED_PLD_LEN_WITH_TECH);
-        xtea_key key = keys->at(i);
-
-        if(on_decrypt(is_stream_pkt,
-          payload.decrypted_payload_bytes, (one_net_xtea_key_t*) key.bytes,
-          payload.num_payload_bytes + 1) != ONS_SUCCESS)
-        {
-            continue;
-        }
+        this->key = keys->at(key_index);
+        valid_decrypt = packet::parse_payload(raw_pid, NULL, payload);
 
+        // find_key has checked the crc
         payload.payload_crc = payload.decrypted_payload_bytes[0];
-        payload.calculated_payload_crc = 8;
-        payload.valid_payload_crc =
-            (payload.payload_crc == payload.calculated_payload_crc);
-
-
-        if(payload.valid_payload_crc && packet::parse_payload(raw_pid, NULL,
-            payload))
-        {
-            valid_decrypt = true;
-            this->key = key;
-        }
+        payload.calculated_payload_crc = payload.payload_crc;
+        payload.valid_payload_crc = true;
     }
 
     valid = (valid && valid_decrypt);
@@ -649,154 +616,189 @@ bool packet::create_packet(struct timeval timestamp, UInt16 raw_pid,
 }
 
 
-bool packet::create_packet(string line, const filter& fltr, packet& pkt)
+// Makes a packet from the one the framer has ready.  False if it has none or
+// the packet is not valid.
+bool packet::create_packet(const packet_framer& framer, const filter& fltr,
+    packet& pkt)
 {
-    static bool rcvd_num_bytes = false;
-    static int num_bytes_rcvd;
-    static int num_bytes_expected;
-    UInt32 timestamp_ms;
-    static UInt8 bytes[ON_MAX_ENCODED_PKT_SIZE];
-    static struct timeval timestamp;
-
-
-    if(!rcvd_num_bytes)
+    if(!framer.packet_ready())
     {
-        // first count
-        stringstream ss(line);
-        int num_strings = 0;
-        string tmp;
-        while(ss >> tmp)
-        {
-            num_strings++;
-        }
+        return false;
+    }
 
+    const UInt8* bytes = framer.get_bytes();
+    pkt.enc_pid = one_net_byte_stream_to_uint16(&bytes[ON_ENCODED_PID_IDX]);
+    pkt.raw_pid = framer.get_raw_pid();
+    pkt.payload.raw_pid = pkt.raw_pid;
+    return create_packet(framer.get_timestamp(), pkt.raw_pid,
+        framer.get_num_bytes(), bytes, fltr, pkt);
+}
 
-        if(num_strings != 4)
-        {
-            return false;
-        }
 
-        ss.clear();
-        ss.seekg(ios_base::beg);
-        ss >> timestamp_ms;
-        timestamp.tv_sec = timestamp_ms / 1000;
-        timestamp.tv_usec = (timestamp_ms % 1000) * 1000;
-        ss >> tmp;
-        if(tmp != "received" && tmp != "sending" && tmp != "sent")
-        {
-            return false;
-        }
-        ss >> num_bytes_expected;
+bool packet::create_packet(const capture_record& record, const filter& fltr,
+    packet& pkt)
+{
+    if(record.num_bytes < ON_ENCODED_PLD_IDX)
+    {
+        return false;
+    }
 
-        if(num_bytes_expected < ON_MIN_ENCODED_PKT_SIZE || num_bytes_expected >
-            ON_MAX_ENCODED_PKT_SIZE)
-        {
-            return false;
-        }
+    pkt.enc_pid = one_net_byte_stream_to_uint16(
+        &record.bytes[ON_ENCODED_PID_IDX]);
+    pkt.raw_pid = packet_framer::decode_raw_pid(record.bytes);
+    pkt.payload.raw_pid = pkt.raw_pid;
+    return create_packet(microseconds_to_struct_timeval(record.timestamp),
+        pkt.raw_pid, record.num_bytes, record.bytes, fltr, pkt);
+}
 
-        ss >> tmp;
-        if(tmp != "bytes:")
-        {
-            return false;
-        }
-        if(!ss)
-        {
-            return false;
-        }
-        num_bytes_rcvd = 0;
-        rcvd_num_bytes = true;
+
+// Makes the packet again from its record.  It is decrypted again, with the
+// keys in fltr.
+bool packet::create_packet(const packet_record& record, const filter& fltr,
+    packet& pkt)
+{
+    if(!record.bytes || record.num_bytes < ON_ENCODED_PLD_IDX)
+    {
         return false;
     }
 
-    string tmp;
-    stringstream ss(line);
-    while(ss >> tmp)
-    {
-        if(num_bytes_rcvd >= num_bytes_expected)
-        {
-            rcvd_num_bytes = false;
-            return false;
-        }
+    pkt.enc_pid = one_net_byte_stream_to_uint16(
+        &record.bytes[ON_ENCODED_PID_IDX]);
+    pkt.raw_pid = record.raw_pid;
+    pkt.payload.raw_pid = pkt.raw_pid;
+    return create_packet(microseconds_to_struct_timeval(record.timestamp),
+        pkt.raw_pid, record.num_bytes, record.bytes, fltr, pkt);
+}
 
-        if(!string_to_uint8(tmp, bytes[num_bytes_rcvd], true))
-        {
-            rcvd_num_bytes = 0;
-            return false;
-        }
 
-        if(num_bytes_rcvd == ON_ENCODED_PLD_IDX - 1)
-        {
-            pkt.enc_pid = one_net_byte_stream_to_uint16(
-              &bytes[ON_ENCODED_PID_IDX]);
-            UInt8 raw_pid_bytes[ON_ENCODED_PID_SIZE];
-            pkt.raw_pid = 0xFFFF; // just make it invalid
-            if(on_decode(raw_pid_bytes, &bytes[ON_ENCODED_PID_IDX],
-              ON_ENCODED_PID_SIZE) == ONS_SUCCESS)
-            {
-                pkt.raw_pid = (one_net_byte_stream_to_uint16(raw_pid_bytes)) >> 4;
-            }
+// Fills in the record for the packet.  Its bytes are the packet's own, so
+// copy them somewhere (a packet_arena) before the packet changes or goes
+// away.
+void packet::get_record(packet_record& record) const
+{
+    record.timestamp = struct_timeval_to_microseconds(timestamp);
+    record.raw_nid = raw_nid;
+    record.bytes = enc_pkt_bytes;
+    record.raw_pid = raw_pid;
+    record.raw_src_did = raw_src_did;
+    record.raw_rptr_did = raw_rptr_did;
+    record.raw_dst_did = raw_dst_did;
+    record.msg_id = payload.msg_id;
+    record.key_index = packet_record::NO_KEY;
+    record.num_bytes = num_bytes;
+    record.hops = hops;
+    record.max_hops = max_hops;
+    record.msg_crc = msg_crc;
+    record.pld_crc = payload.payload_crc;
+    record.pld_msg_type = payload.msg_type;
+    record.admin_type = payload.admin_payload.admin_type;
 
-            if(num_bytes_expected != (int) get_encoded_packet_len(pkt.raw_pid,
-              TRUE))
-            {
-                rcvd_num_bytes = false;
-                return false;
-            }
-            pkt.payload.raw_pid = pkt.raw_pid;
-        }
-        num_bytes_rcvd++;
+    // the same values filter_packet tests
+    record.flags = 0;
+    if(valid_decode)
+    {
+        record.flags |= packet_record::VALID_DECODE;
     }
-
-    if(num_bytes_rcvd < num_bytes_expected)
+    if(valid_msg_crc)
     {
-        return false;
+        record.flags |= packet_record::VALID_MSG_CRC;
+    }
+    if(payload.valid_payload_crc)
+    {
+        record.flags |= packet_record::VALID_PLD_CRC;
+    }
+    if(valid)
+    {
+        record.flags |= packet_record::VALID;
+    }
+    if(payload.is_invite_pkt)
+    {
+        record.flags |= packet_record::IS_INVITE;
+    }
+    if(has_pld_msg_type())
+    {
+        record.flags |= packet_record::HAS_PLD_MSG_TYPE;
+    }
+    if(has_admin_type())
+    {
+        record.flags |= packet_record::HAS_ADMIN_TYPE;
     }
-
-    rcvd_num_bytes = false; // packet bytes received.  Set false for next time
-    return create_packet(timestamp, pkt.raw_pid, (UInt8) num_bytes_rcvd,
-        bytes, fltr, pkt);
 }
 
 
+// Reads until a packet is made or the input ends.  The bytes are read one at
+// a time so that nothing after the packet is taken from fd.
 bool packet::create_packet(int fd, const filter& fltr, packet& pkt)
 {
-    #ifdef COMPILE_WO_WARNINGS
-    // meaningless code to avoid compile warnings
-    if(sizeof(fd) + sizeof(fltr) + sizeof(pkt) == 12)
+    packet_framer framer;
+    char byte;
+    ssize_t bytes_read;
+
+    while((bytes_read = read(fd, &byte, 1)) != 0)
     {
-        // do nothing
+        if(bytes_read < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+
+        framer.add_bytes(&byte, 1);
+        if(create_packet(framer, fltr, pkt))
+        {
+            return true;
+        }
     }
-    #endif
 
-    return false;
+    return (framer.end_of_input() && create_packet(framer, fltr, pkt));
 }
 
 
+// Reads until a packet is made or the file ends.  fgets stops at the end of
+// a line, and so does the framer once a packet is done, so nothing after the
+// packet is taken from the file.
 bool packet::create_packet(FILE* file, const filter& fltr, packet& pkt)
 {
-    #ifdef COMPILE_WO_WARNINGS
-    // meaningless code to avoid compile warnings
-    if(sizeof(file) + sizeof(fltr) + sizeof(pkt) == 12)
+    packet_framer framer;
+    char buffer[256];
+
+    while(fgets(buffer, sizeof(buffer), file))
     {
-        // do nothing
+        framer.add_bytes(buffer, strlen(buffer));
+        if(create_packet(framer, fltr, pkt))
+        {
+            return true;
+        }
     }
-    #endif
 
-    return false;
+    return (framer.end_of_input() && create_packet(framer, fltr, pkt));
 }
 
 
+// Reads until a packet is made or the stream ends.
 bool packet::create_packet(istream& is, const filter& fltr, packet& pkt)
 {
-    #ifdef COMPILE_WO_WARNINGS
-    // meaningless code to avoid compile warnings
-    if(sizeof(is) + sizeof(fltr) + sizeof(pkt) == 12)
+    packet_framer framer;
+    string line;
+
+    while(getline(is, line, '\n'))
     {
-        // do nothing
+        framer.add_bytes(line.data(), line.length());
+        if(is.eof())
+        {
+            break;
+        }
+
+        framer.add_bytes("\n", 1);
+        if(create_packet(framer, fltr, pkt))
+        {
+            return true;
+        }
     }
-    #endif
 
-    return false;
+    return (framer.end_of_input() && create_packet(framer, fltr, pkt));
 }
 
 
@@ -1516,41 +1518,6 @@ void packet::display(const vector<packet>& packets, const attribute& att,
 }
 
 
-bool packet::insert_packet(vector<packet>& packets, packet& new_packet)
-{
-    int num_packets = packets.size();
-
-    if(num_packets == 0 || timeval_compare(new_packet.timestamp,
-        packets.at(num_packets - 1).timestamp) > 0)
-    {
-        packets.push_back(new_packet);
-        return true;
-    }
-
-
-    vector<packet>::iterator it = packets.end();
-    it--;
-    while(1)
-    {
-        int comp = timeval_compare(new_packet.timestamp, it->timestamp);
-        if(comp == 0)
-        {
-            return false;
-        }
-        if(comp > 0)
-        {
-            packets.insert(it, new_packet);
-            return true;
-        }
-        if(it == packets.begin())
-        {
-            packets.insert(it, new_packet);
-            return true;
-        }
-    }
-}
-
-
 void packet::adjust_timestamps(vector<packet>& packets,
     struct timeval begin_time)
 {
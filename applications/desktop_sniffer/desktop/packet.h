@@ -8,6 +8,10 @@
 #include <cstdio>
 #include "filter.h"
 #include "xtea_key.h"
+#include "key_trial.h"
+#include "packet_framer.h"
+#include "capture_file.h"
+#include "packet_record.h"
 #include "attribute.h"
 #include "string_utils.h"
 using namespace std;
@@ -160,24 +164,33 @@ public:
     static bool parse_payload(UInt16 raw_pid, UInt8* decrypted_payload_bytes,
         payload_t& payload);
     bool filter_packet(const filter& fltr) const;
+    bool filter_packet(const filter_matcher& matcher) const;
     static bool create_packet(struct timeval timestamp, UInt16 raw_pid,
         UInt8 num_bytes, const UInt8* const bytes, const filter& fltr,
         packet& pkt);
-    static bool create_packet(string line, const filter& fltr, packet& pkt);
+    static bool create_packet(const packet_framer& framer, const filter& fltr,
+        packet& pkt);
+    static bool create_packet(const capture_record& record,
+        const filter& fltr, packet& pkt);
+    static bool create_packet(const packet_record& record,
+        const filter& fltr, packet& pkt);
     static bool create_packet(int fd, const filter& fltr, packet& pkt);
     static bool create_packet(FILE* file, const filter& fltr, packet& pkt);
     static bool create_packet(istream& is, const filter& fltr, packet& pkt);
     static string get_raw_pid_string(UInt16 raw_pid);
-    static bool insert_packet(vector<packet>& packets,
-        packet& new_packet);
     static void adjust_timestamps(vector<packet>& packets, struct timeval
         begin_time);
     bool display(const attribute& att, ostream& outs) const;
+    void get_record(packet_record& record) const;
+    struct timeval get_timestamp() const {return timestamp;}
+    const xtea_key& get_key() const {return key;}
+    void set_timestamp(struct timeval timestamp) {this->timestamp = timestamp;}
     static void display(const vector<packet>& packets, const attribute& att,
         ostream& outs);
 
     static vector<xtea_key> keys;
     static vector<xtea_key> invite_keys;
+    static key_trial_engine key_engine;
     static const UInt8 INVALID_CRC;
     static const UInt16 INVALID_DID;
     static const uint64_t INVALID_NID;
@@ -186,6 +199,8 @@ public:
 private:
     bool fill_in_packet_values(struct timeval timestamp, UInt16 raw_pid,
         UInt8 num_bytes, const UInt8* const bytes, const filter& fltr);
+    bool has_pld_msg_type() const;
+    bool has_admin_type() const;
 
 
     struct timeval timestamp;
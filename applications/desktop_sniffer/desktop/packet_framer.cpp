@@ -0,0 +1,280 @@
+#include "packet_framer.h"
+#include <sys/time.h>
+#include <stdint.h>
+#include <cstring>
+#include <cctype>
+using namespace std;
+
+
+extern "C"
+{
+    #include "one_net_packet.h"
+    #include "one_net_encode.h"
+    #include "one_net_port_specific.h"
+}
+
+
+packet_framer::packet_framer()
+{
+    reset();
+}
+
+
+// Takes bytes until a packet is complete or they run out and returns how
+// many were taken.  If packet_ready() is true afterwards, the packet must
+// be used before bytes are added again.
+size_t packet_framer::add_bytes(const char* bytes, size_t num_bytes)
+{
+    ready = false;
+    for(size_t i = 0; i < num_bytes; i++)
+    {
+        char c = bytes[i];
+        if(c == '\n')
+        {
+            end_line();
+            if(ready)
+            {
+                return i + 1;
+            }
+        }
+        else if(state == FRAMER_SKIP_LINE)
+        {
+            continue;
+        }
+        else if(isspace((unsigned char) c))
+        {
+            if(!end_token())
+            {
+                state = FRAMER_SKIP_LINE;
+            }
+        }
+        else if(token_len < MAX_TOKEN_LEN)
+        {
+            token[token_len++] = c;
+        }
+        else
+        {
+            token_too_long = true;
+        }
+    }
+
+    return num_bytes;
+}
+
+
+// The input ended without a newline at the end of the last line.  True if
+// that line finished a packet.
+bool packet_framer::end_of_input()
+{
+    ready = false;
+    end_line();
+    return ready;
+}
+
+
+bool packet_framer::packet_ready() const
+{
+    return ready;
+}
+
+
+void packet_framer::reset()
+{
+    state = FRAMER_HEADER;
+    ready = false;
+    token_len = 0;
+    token_too_long = false;
+    num_tokens = 0;
+    timestamp.tv_sec = 0;
+    timestamp.tv_usec = 0;
+    num_bytes_expected = 0;
+    num_bytes_rcvd = 0;
+    raw_pid = 0xFFFF;
+}
+
+
+struct timeval packet_framer::get_timestamp() const
+{
+    return timestamp;
+}
+
+
+UInt16 packet_framer::get_raw_pid() const
+{
+    return raw_pid;
+}
+
+
+UInt8 packet_framer::get_num_bytes() const
+{
+    return (UInt8) num_bytes_rcvd;
+}
+
+
+const UInt8* packet_framer::get_bytes() const
+{
+    return bytes;
+}
+
+
+// The raw pid of a packet from its encoded bytes, 0xFFFF if it does not
+// decode.  Only the bytes up to the pid are looked at.
+UInt16 packet_framer::decode_raw_pid(const UInt8* encoded_bytes)
+{
+    UInt8 raw_pid_bytes[ON_ENCODED_PID_SIZE];
+    if(on_decode(raw_pid_bytes, &encoded_bytes[ON_ENCODED_PID_IDX],
+      ON_ENCODED_PID_SIZE) != ONS_SUCCESS)
+    {
+        return 0xFFFF;
+    }
+
+    return (one_net_byte_stream_to_uint16(raw_pid_bytes)) >> 4;
+}
+
+
+// false if the token is not legal where it is
+bool packet_framer::end_token()
+{
+    if(token_len == 0 && !token_too_long)
+    {
+        return true;
+    }
+
+    bool ok = !token_too_long && (state == FRAMER_HEADER ? end_header_token() :
+        end_data_token());
+    num_tokens++;
+    token_len = 0;
+    token_too_long = false;
+    return ok;
+}
+
+
+bool packet_framer::end_header_token()
+{
+    unsigned int i;
+    uint64_t value = 0;
+
+    switch(num_tokens)
+    {
+        case 0:
+        case 2:
+            for(i = 0; i < token_len; i++)
+            {
+                if(!isdigit((unsigned char) token[i]))
+                {
+                    return false;
+                }
+                value = value * 10 + (token[i] - '0');
+            }
+            if(num_tokens == 2)
+            {
+                if(value < ON_MIN_ENCODED_PKT_SIZE || value >
+                    ON_MAX_ENCODED_PKT_SIZE)
+                {
+                    return false;
+                }
+                num_bytes_expected = (unsigned int) value;
+                return true;
+            }
+            if(value > 0xFFFFFFFF)
+            {
+                return false;
+            }
+            timestamp.tv_sec = value / 1000;
+            timestamp.tv_usec = (value % 1000) * 1000;
+            return true;
+        case 1:
+            return ((token_len == 8 && memcmp(token, "received", 8) == 0) ||
+              (token_len == 7 && memcmp(token, "sending", 7) == 0) ||
+              (token_len == 4 && memcmp(token, "sent", 4) == 0));
+        case 3:
+            return (token_len == 6 && memcmp(token, "bytes:", 6) == 0);
+        default:
+            return false;
+    }
+}
+
+
+bool packet_framer::end_data_token()
+{
+    if(num_bytes_rcvd >= num_bytes_expected)
+    {
+        abort_packet();
+        return false;
+    }
+
+    unsigned int value = 0;
+    for(unsigned int i = 0; i < token_len; i++)
+    {
+        char c = token[i];
+        if(!isxdigit((unsigned char) c))
+        {
+            abort_packet();
+            return false;
+        }
+        value = (value << 4) | (isdigit((unsigned char) c) ? c - '0' :
+            tolower((unsigned char) c) - 'a' + 10);
+        if(value > 0xFF)
+        {
+            abort_packet();
+            return false;
+        }
+    }
+    bytes[num_bytes_rcvd] = (UInt8) value;
+
+    // the pid tells how long the packet should be
+    if(num_bytes_rcvd == ON_ENCODED_PLD_IDX - 1)
+    {
+        raw_pid = decode_raw_pid(bytes);
+        if(num_bytes_expected != get_encoded_packet_len(raw_pid, TRUE))
+        {
+            abort_packet();
+            return false;
+        }
+    }
+
+    num_bytes_rcvd++;
+    return true;
+}
+
+
+void packet_framer::end_line()
+{
+    if(state != FRAMER_SKIP_LINE && !end_token())
+    {
+        state = FRAMER_SKIP_LINE;
+    }
+
+    switch(state)
+    {
+        case FRAMER_HEADER:
+            if(num_tokens == 4)
+            {
+                num_bytes_rcvd = 0;
+                state = FRAMER_DATA;
+            }
+            break;
+        case FRAMER_DATA:
+            if(num_bytes_rcvd >= num_bytes_expected)
+            {
+                ready = true;
+                state = FRAMER_HEADER;
+            }
+            break;
+        default:
+            // a bad header line, or a packet that was given up on
+            state = FRAMER_HEADER;
+    }
+
+    num_tokens = 0;
+    token_len = 0;
+    token_too_long = false;
+}
+
+
+// the rest of the line is ignored and the next line is tried as a header
+void packet_framer::abort_packet()
+{
+    num_bytes_rcvd = 0;
+    state = FRAMER_SKIP_LINE;
+}
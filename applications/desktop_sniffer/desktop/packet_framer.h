@@ -0,0 +1,70 @@
+#ifndef PACKET_FRAMER_H
+#define	PACKET_FRAMER_H
+
+
+#include <sys/time.h>
+#include <stddef.h>
+#include "one_net_types.h"
+#include "one_net_packet.h"
+using namespace std;
+
+
+// Pulls packets out of the text the sniffer writes, a header line
+//
+//     <ms> received <N> bytes:
+//
+// ("sending" and "sent" are taken too) followed by the N encoded bytes in
+// hex on as many lines as it takes.  The text can be handed over in chunks
+// of any size, split anywhere.  All the state is in the object and nothing
+// is allocated, so any number of framers can be run at once on different
+// threads.
+class packet_framer
+{
+public:
+    packet_framer();
+    size_t add_bytes(const char* bytes, size_t num_bytes);
+    bool end_of_input();
+    bool packet_ready() const;
+    void reset();
+    struct timeval get_timestamp() const;
+    UInt16 get_raw_pid() const;
+    UInt8 get_num_bytes() const;
+    const UInt8* get_bytes() const;
+    static UInt16 decode_raw_pid(const UInt8* encoded_bytes);
+
+private:
+    enum FRAMER_STATE
+    {
+        FRAMER_HEADER,     // looking for a header line
+        FRAMER_DATA,       // reading the packet bytes
+        FRAMER_SKIP_LINE   // the line is bad, ignore the rest of it
+    };
+
+    // tokens are at most this long.  Anything longer is not legal.
+    static const unsigned int MAX_TOKEN_LEN = 10;
+
+    bool end_token();
+    bool end_header_token();
+    bool end_data_token();
+    void end_line();
+    void abort_packet();
+
+    FRAMER_STATE state;
+    bool ready;
+
+    char token[MAX_TOKEN_LEN];
+    unsigned int token_len;
+    bool token_too_long;
+
+    // tokens on the current line
+    unsigned int num_tokens;
+
+    struct timeval timestamp;
+    unsigned int num_bytes_expected;
+    unsigned int num_bytes_rcvd;
+    UInt16 raw_pid;
+    UInt8 bytes[ON_MAX_ENCODED_PKT_SIZE];
+};
+
+
+#endif	/* PACKET_FRAMER_H */
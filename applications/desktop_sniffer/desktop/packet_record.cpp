@@ -0,0 +1,103 @@
+#include "packet_record.h"
+#include <cstring>
+#include <new>
+#include <algorithm>
+using namespace std;
+
+
+
+const UInt16 packet_record::NO_KEY;
+const size_t packet_arena::DEFAULT_BLOCK_SIZE;
+
+
+
+packet_arena::packet_arena(size_t block_size)
+{
+    this->block_size = (block_size > 0 ? block_size : DEFAULT_BLOCK_SIZE);
+    block_used = 0;
+    bytes_used = 0;
+    bytes_reserved = 0;
+}
+
+
+packet_arena::~packet_arena()
+{
+    clear();
+}
+
+
+// NULL if num_bytes is 0 or the memory could not be had
+UInt8* packet_arena::allocate(size_t num_bytes)
+{
+    if(num_bytes == 0)
+    {
+        return NULL;
+    }
+
+    if(blocks.empty() || block_used + num_bytes > block_size)
+    {
+        // Whatever is left of the last block is not used.  Something too big
+        // for a block gets a block of its own.
+        size_t size = max(block_size, num_bytes);
+        UInt8* block = new (nothrow) UInt8[size];
+        if(!block)
+        {
+            return NULL;
+        }
+        blocks.push_back(block);
+        block_used = 0;
+        bytes_reserved += size;
+    }
+
+    UInt8* ptr = blocks.back() + block_used;
+    block_used += num_bytes;
+    bytes_used += num_bytes;
+    return ptr;
+}
+
+
+const UInt8* packet_arena::copy(const UInt8* bytes, size_t num_bytes)
+{
+    UInt8* ptr = allocate(num_bytes);
+    if(ptr)
+    {
+        memcpy(ptr, bytes, num_bytes);
+    }
+    return ptr;
+}
+
+
+// Everything allocated from the arena is gone after this.
+void packet_arena::clear()
+{
+    for(unsigned int i = 0; i < blocks.size(); i++)
+    {
+        delete[] blocks[i];
+    }
+    blocks.clear();
+    block_used = 0;
+    bytes_used = 0;
+    bytes_reserved = 0;
+}
+
+
+void packet_arena::swap(packet_arena& that)
+{
+    blocks.swap(that.blocks);
+    std::swap(block_size, that.block_size);
+    std::swap(block_used, that.block_used);
+    std::swap(bytes_used, that.bytes_used);
+    std::swap(bytes_reserved, that.bytes_reserved);
+}
+
+
+size_t packet_arena::get_bytes_used() const
+{
+    return bytes_used;
+}
+
+
+size_t packet_arena::get_bytes_reserved() const
+{
+    return bytes_reserved;
+}
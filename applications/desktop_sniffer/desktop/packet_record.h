@@ -0,0 +1,83 @@
+#ifndef PACKET_RECORD_H
+#define	PACKET_RECORD_H
+
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+#include "one_net_types.h"
+using namespace std;
+
+
+// A packet kept in as little memory as it can be: the header fields and the
+// payload fields that packets are sorted and filtered by, decoded, and the
+// encoded bytes, which are all it takes to make the packet again.  It is
+// trivially copyable.  The bytes are not in the record but in the
+// packet_arena of the capture it came from, so it is only good for as long
+// as the arena is.
+struct packet_record
+{
+    enum
+    {
+        VALID_DECODE = 0x01,  // the header decoded
+        VALID_MSG_CRC = 0x02,
+        VALID_PLD_CRC = 0x04,  // decrypted, so msg_id and key_index are set
+        VALID = 0x08,
+        IS_INVITE = 0x10,
+        HAS_PLD_MSG_TYPE = 0x20,
+        HAS_ADMIN_TYPE = 0x40
+    };
+
+    // key_index when the payload was not decrypted
+    static const UInt16 NO_KEY = 0xFFFF;
+
+    uint64_t timestamp;       // microseconds
+    uint64_t raw_nid;
+    const UInt8* bytes;
+    UInt16 raw_pid;
+    UInt16 raw_src_did;
+    UInt16 raw_rptr_did;
+    UInt16 raw_dst_did;
+    UInt16 msg_id;
+    UInt16 key_index;         // in the key list of the capture it came from
+    UInt8 num_bytes;
+    UInt8 hops;
+    UInt8 max_hops;
+    UInt8 msg_crc;
+    UInt8 pld_crc;
+    UInt8 pld_msg_type;
+    UInt8 admin_type;
+    UInt8 flags;
+};
+
+
+// Memory for the bytes of the packets of a capture.  It is taken from large
+// blocks, one after another, and all given back at once by clear or when the
+// arena goes away.  There is no freeing of one allocation.
+class packet_arena
+{
+public:
+    packet_arena(size_t block_size = DEFAULT_BLOCK_SIZE);
+    ~packet_arena();
+    UInt8* allocate(size_t num_bytes);
+    const UInt8* copy(const UInt8* bytes, size_t num_bytes);
+    void clear();
+    void swap(packet_arena& that);
+    size_t get_bytes_used() const;
+    size_t get_bytes_reserved() const;
+
+    static const size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+private:
+    packet_arena(const packet_arena&);
+    packet_arena& operator = (const packet_arena&);
+
+    vector<UInt8*> blocks;
+    size_t block_size;
+    size_t block_used;   // in the last block
+    size_t bytes_used;
+    size_t bytes_reserved;
+};
+
+
+#endif	/* PACKET_RECORD_H */
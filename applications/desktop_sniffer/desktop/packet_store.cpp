@@ -0,0 +1,338 @@
+#include "packet_store.h"
+#include <sys/time.h>
+#include <algorithm>
+#include <queue>
+#include <utility>
+#include <stdexcept>
+#include "packet.h"
+#include "packet_record.h"
+#include "capture_columns.h"
+#include "xtea_key.h"
+#include "filter.h"
+#include "attribute.h"
+#include "time_utils.h"
+using namespace std;
+
+
+// orders records, or a record and a timestamp, by timestamp
+struct packet_time_less
+{
+    bool operator()(const packet_record& record, uint64_t time) const
+    {
+        return record.timestamp < time;
+    }
+
+
+    bool operator()(const vector<packet_record>& chunk, uint64_t time) const
+    {
+        return (*this)(chunk.back(), time);
+    }
+};
+
+
+packet_store::packet_store()
+{
+    num_packets = 0;
+    columns_current = false;
+}
+
+
+// true if the packet was added, false if one with the same timestamp is
+// already stored
+bool packet_store::insert(const packet& pkt)
+{
+    packet_record record;
+    pkt.get_record(record);
+    if(record.flags & packet_record::VALID_PLD_CRC)
+    {
+        record.key_index = add_key(pkt.get_key());
+    }
+    return insert(record);
+}
+
+
+// The record's bytes are copied into the store, so they need not outlast the
+// call.  Its key_index must be one of this store's (or NO_KEY).  False if a
+// packet with the same timestamp is already stored or there is no memory for
+// the bytes.
+bool packet_store::insert(const packet_record& record)
+{
+    uint64_t time = record.timestamp;
+    columns_current = false;
+
+    // captures are nearly in order, so most packets go on the end
+    if(chunks.empty() || chunks.back().back().timestamp < time)
+    {
+        packet_record stored = record;
+        if(!(stored.bytes = arena.copy(record.bytes, record.num_bytes)))
+        {
+            return false;
+        }
+        push_back(stored);
+        return true;
+    }
+
+    // the first chunk that ends at or after the packet
+    vector<vector<packet_record> >::iterator chunk = lower_bound(
+        chunks.begin(), chunks.end(), time, packet_time_less());
+    vector<packet_record>::iterator it = lower_bound(chunk->begin(),
+        chunk->end(), time, packet_time_less());
+    if(it->timestamp == time)
+    {
+        return false;
+    }
+
+    packet_record stored = record;
+    if(!(stored.bytes = arena.copy(record.bytes, record.num_bytes)))
+    {
+        return false;
+    }
+
+    if(chunk->size() >= CHUNK_SIZE)
+    {
+        // split the chunk and insert into whichever half the packet is in
+        unsigned int index = it - chunk->begin();
+        vector<packet_record> upper(chunk->begin() + CHUNK_SIZE / 2,
+            chunk->end());
+        chunk->resize(CHUNK_SIZE / 2);
+        chunk = chunks.insert(chunk + 1, upper) - 1;
+        if(index > CHUNK_SIZE / 2)
+        {
+            chunk++;
+            index -= CHUNK_SIZE / 2;
+        }
+        it = chunk->begin() + index;
+    }
+
+    chunk->insert(it, stored);
+    num_packets++;
+    return true;
+}
+
+
+// Merges any number of stores into merged, which is cleared first.  When the
+// same timestamp is in more than one source, the packet from the source that
+// comes first in sources is kept.  merged may be one of the sources.
+void packet_store::merge(const vector<const packet_store*>& sources,
+    packet_store& merged)
+{
+    // (time, source) of the next packet of each source, earliest on top
+    typedef pair<uint64_t, unsigned int> next_packet;
+    priority_queue<next_packet, vector<next_packet>, greater<next_packet> >
+        heap;
+    vector<pair<unsigned int, unsigned int> > position(sources.size(),
+        make_pair(0, 0));
+
+    packet_store result;
+    for(unsigned int i = 0; i < sources.size(); i++)
+    {
+        if(sources[i] && !sources[i]->empty())
+        {
+            heap.push(make_pair(sources[i]->chunks[0][0].timestamp, i));
+        }
+    }
+
+    while(!heap.empty())
+    {
+        unsigned int source = heap.top().second;
+        heap.pop();
+
+        const vector<vector<packet_record> >& chunks =
+            sources[source]->chunks;
+        unsigned int& chunk = position[source].first;
+        unsigned int& offset = position[source].second;
+        const packet_record& record = chunks[chunk][offset];
+
+        if(result.empty() || result.chunks.back().back().timestamp <
+            record.timestamp)
+        {
+            // the bytes go in the result's arena, since the sources' arenas
+            // may not be around for as long
+            packet_record stored = record;
+            if(record.key_index != packet_record::NO_KEY)
+            {
+                stored.key_index = result.add_key(
+                    sources[source]->keys[record.key_index]);
+            }
+            if((stored.bytes = result.arena.copy(record.bytes,
+                record.num_bytes)))
+            {
+                result.push_back(stored);
+            }
+        }
+
+        if(++offset >= chunks[chunk].size())
+        {
+            chunk++;
+            offset = 0;
+        }
+        if(chunk < chunks.size())
+        {
+            heap.push(make_pair(chunks[chunk][offset].timestamp, source));
+        }
+    }
+
+    merged.chunks.swap(result.chunks);
+    merged.num_packets = result.num_packets;
+    merged.arena.swap(result.arena);
+    merged.keys.swap(result.keys);
+    merged.columns_current = false;
+}
+
+
+unsigned int packet_store::size() const
+{
+    return num_packets;
+}
+
+
+bool packet_store::empty() const
+{
+    return num_packets == 0;
+}
+
+
+// The record's bytes are good until the store is cleared or goes away.
+const packet_record& packet_store::at(unsigned int index) const
+{
+    for(unsigned int i = 0; i < chunks.size(); i++)
+    {
+        if(index < chunks[i].size())
+        {
+            return chunks[i][index];
+        }
+        index -= chunks[i].size();
+    }
+
+    throw out_of_range("packet_store::at");
+}
+
+
+void packet_store::clear()
+{
+    chunks.clear();
+    num_packets = 0;
+    arena.clear();
+    keys.clear();
+    columns.clear();
+    columns_current = false;
+}
+
+
+// the memory taken by the records, their bytes and the columns
+size_t packet_store::get_bytes_used() const
+{
+    size_t bytes = arena.get_bytes_reserved() + columns.get_bytes_used();
+    for(unsigned int i = 0; i < chunks.size(); i++)
+    {
+        bytes += chunks[i].capacity() * sizeof(packet_record);
+    }
+    return bytes;
+}
+
+
+// Same as packet::adjust_timestamps.  Every packet moves by the same amount,
+// so the order does not change.
+void packet_store::adjust_timestamps(struct timeval begin_time)
+{
+    if(empty())
+    {
+        return;
+    }
+
+    uint64_t begin = struct_timeval_to_microseconds(begin_time);
+    uint64_t first = chunks[0][0].timestamp;
+    columns_current = false;
+
+    for(unsigned int i = 0; i < chunks.size(); i++)
+    {
+        for(unsigned int j = 0; j < chunks[i].size(); j++)
+        {
+            packet_record& record = chunks[i][j];
+            record.timestamp = record.timestamp - first + begin;
+        }
+    }
+}
+
+
+// Sets one bit in selected for each packet that gets through the filter, as
+// with capture_columns::select.  The columns are made first if the packets
+// have changed since the last time.
+void packet_store::select(const filter& fltr, vector<uint64_t>& selected)
+{
+    if(!columns_current)
+    {
+        columns.clear();
+        for(unsigned int i = 0; i < chunks.size(); i++)
+        {
+            for(unsigned int j = 0; j < chunks[i].size(); j++)
+            {
+                columns.push_back(chunks[i][j]);
+            }
+        }
+        columns_current = true;
+    }
+
+    columns.select(fltr, keys, selected);
+}
+
+
+// Displays the packets selected (see select).  They are made again from their
+// records, with the keys in fltr, to display them.
+void packet_store::display(const filter& fltr, const attribute& att,
+    const vector<uint64_t>& selected, ostream& outs) const
+{
+    unsigned int count = 0;
+    unsigned int index = 0;
+    packet pkt;
+    outs << "\n\n# of packets : " << capture_columns::count(selected) <<
+        "\n\n";
+    for(unsigned int i = 0; i < chunks.size(); i++)
+    {
+        for(unsigned int j = 0; j < chunks[i].size(); j++, index++)
+        {
+            if(!capture_columns::is_selected(selected, index))
+            {
+                continue;
+            }
+
+            outs << "\n\nPacket " << ++count << "\n\n";
+            if(packet::create_packet(chunks[i][j], fltr, pkt))
+            {
+                pkt.display(att, outs);
+            }
+        }
+    }
+}
+
+
+void packet_store::push_back(const packet_record& record)
+{
+    if(chunks.empty() || chunks.back().size() >= CHUNK_SIZE)
+    {
+        chunks.push_back(vector<packet_record>());
+        chunks.back().reserve(CHUNK_SIZE);
+    }
+
+    chunks.back().push_back(record);
+    num_packets++;
+}
+
+
+// The index of key in keys, added if it is not there.  NO_KEY if there is no
+// room for another.
+UInt16 packet_store::add_key(const xtea_key& key)
+{
+    int index = xtea_key::find_key(keys, key);
+    if(index >= 0)
+    {
+        return index;
+    }
+    if(keys.size() >= packet_record::NO_KEY)
+    {
+        return packet_record::NO_KEY;
+    }
+
+    keys.push_back(key);
+    return keys.size() - 1;
+}
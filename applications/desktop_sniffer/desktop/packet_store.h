@@ -0,0 +1,71 @@
+#ifndef PACKET_STORE_H
+#define	PACKET_STORE_H
+
+
+#include <stdint.h>
+#include <sys/time.h>
+#include <ostream>
+#include <vector>
+#include "packet.h"
+#include "packet_record.h"
+#include "capture_columns.h"
+#include "xtea_key.h"
+#include "filter.h"
+#include "attribute.h"
+using namespace std;
+
+
+// Packets kept in timestamp order.  The packets are stored in chunks of at
+// most CHUNK_SIZE packets, so finding where a packet goes is a binary search
+// and inserting it only moves the packets in one chunk.  packet_store::insert
+// rejects a packet with the same timestamp as one already stored.
+//
+// Each packet is kept as a packet_record, with its bytes in the store's own
+// packet_arena, so a packet costs the record and its bytes and no memory of
+// its own.  It is made into a packet again, and decrypted again, when it is
+// displayed.
+//
+// The packets can be filtered without making them again: select runs the
+// filter over a capture_columns made from the records, which is made again
+// only after the packets have changed.
+class packet_store
+{
+public:
+    packet_store();
+    bool insert(const packet& pkt);
+    bool insert(const packet_record& record);
+    static void merge(const vector<const packet_store*>& sources,
+        packet_store& merged);
+    unsigned int size() const;
+    bool empty() const;
+    const packet_record& at(unsigned int index) const;
+    void clear();
+    size_t get_bytes_used() const;
+    void adjust_timestamps(struct timeval begin_time);
+    void select(const filter& fltr, vector<uint64_t>& selected);
+    void display(const filter& fltr, const attribute& att,
+        const vector<uint64_t>& selected, ostream& outs) const;
+
+    static const unsigned int CHUNK_SIZE = 256;
+
+private:
+    packet_store(const packet_store&);
+    packet_store& operator = (const packet_store&);
+
+    void push_back(const packet_record& record);
+    UInt16 add_key(const xtea_key& key);
+
+    vector<vector<packet_record> > chunks;
+    unsigned int num_packets;
+    packet_arena arena;
+
+    // the keys the packets were decrypted with, which key_index is an index
+    // into
+    vector<xtea_key> keys;
+
+    capture_columns columns;
+    bool columns_current;
+};
+
+
+#endif	/* PACKET_STORE_H */
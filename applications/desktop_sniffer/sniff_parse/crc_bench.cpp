@@ -0,0 +1,170 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstdlib>
+#include <vector>
+#include "one_net_types.h"
+#include "one_net_crc.h"
+#include "on_crc.h"
+#include "sys/time.h"
+using namespace std;
+
+
+// Checks that every crc backend is bit-exact with the bit by bit reference,
+// then times each one over the same random buffers.
+
+
+void usage()
+{
+    cout << "Usage: ./crc_bench ---> Benchmarks the crc implementations over 24 byte buffers\n";
+    cout << "Usage: ./crc_bench 58 1000000 ---> Benchmarks the crc implementations over 1000000\n"
+            "       buffers of 58 bytes\n";
+}
+
+
+typedef UInt8 (*crc_func_t)(const UInt8* data, UInt8 len, UInt8 crc);
+
+
+static UInt8 crc_bitwise(const UInt8* data, UInt8 len, UInt8 crc)
+{
+    return (UInt8) one_net_compute_crc_bitwise(data, len, crc,
+      ON_PLD_CRC_ORDER);
+}
+
+
+static UInt8 crc_default(const UInt8* data, UInt8 len, UInt8 crc)
+{
+    return (UInt8) one_net_compute_crc(data, len, crc, ON_PLD_CRC_ORDER);
+}
+
+
+#ifdef CRC_LOOKUP_TABLE
+static UInt8 crc_table(const UInt8* data, UInt8 len, UInt8 crc)
+{
+    return one_net_compute_crc8_table(data, len, crc);
+}
+
+
+#if CRC_SLICE_BY > 1
+static UInt8 crc_slice(const UInt8* data, UInt8 len, UInt8 crc)
+{
+    return one_net_compute_crc8_slice(data, len, crc);
+}
+#endif
+#endif
+
+
+static UInt8 crc_constexpr(const UInt8* data, UInt8 len, UInt8 crc)
+{
+    return on_crc8(data, len, crc);
+}
+
+
+struct crc_backend
+{
+    const char* name;
+    crc_func_t func;
+};
+
+
+static const crc_backend BACKENDS[] =
+{
+    {"bitwise", crc_bitwise},
+    {"one_net_compute_crc", crc_default},
+    #ifdef CRC_LOOKUP_TABLE
+    {"table", crc_table},
+    #if CRC_SLICE_BY > 1
+    {"slice", crc_slice},
+    #endif
+    #endif
+    {"constexpr", crc_constexpr}
+};
+
+
+static const int NUM_BACKENDS = sizeof(BACKENDS) / sizeof(BACKENDS[0]);
+
+
+static double elapsed_seconds(const struct timeval& start,
+  const struct timeval& end)
+{
+    return (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+}
+
+
+int main(int argc, char* argv[])
+{
+    int buffer_len = 24;
+    int num_buffers = 1000000;
+
+    if(argc != 1 && argc != 3)
+    {
+        usage();
+        exit(0);
+    }
+
+    if(argc == 3)
+    {
+        buffer_len = atoi(argv[1]);
+        num_buffers = atoi(argv[2]);
+        if(buffer_len < 1 || buffer_len > 255 || num_buffers < 1)
+        {
+            usage();
+            exit(0);
+        }
+    }
+
+    // a few thousand distinct buffers so the data does not stay in registers
+    const int NUM_DISTINCT = 4096;
+    vector<UInt8> data(NUM_DISTINCT * buffer_len);
+    srand(1);
+    for(size_t i = 0; i < data.size(); i++)
+    {
+        data[i] = (UInt8) rand();
+    }
+
+    // every length and every starting crc must match the reference
+    for(int len = 0; len <= buffer_len; len++)
+    {
+        for(int start_crc = 0; start_crc < 256; start_crc++)
+        {
+            UInt8 expected = crc_bitwise(&data[0], len, start_crc);
+            for(int b = 1; b < NUM_BACKENDS; b++)
+            {
+                UInt8 actual = BACKENDS[b].func(&data[0], len, start_crc);
+                if(actual != expected)
+                {
+                    cout << BACKENDS[b].name << " does not match the reference"
+                      " crc.  Length = " << len << ", starting crc = 0x" <<
+                      hex << start_crc << endl;
+                    return 1;
+                }
+            }
+        }
+    }
+
+    cout << "All crc backends match the reference crc.\n";
+    cout << "Buffer length " << buffer_len << ", " << num_buffers <<
+      " buffers\n";
+
+    for(int b = 0; b < NUM_BACKENDS; b++)
+    {
+        struct timeval start, end;
+        UInt8 sink = 0;
+        gettimeofday(&start, NULL);
+        for(int i = 0; i < num_buffers; i++)
+        {
+            sink ^= BACKENDS[b].func(&data[(i % NUM_DISTINCT) * buffer_len],
+              buffer_len, ON_PLD_INIT_CRC);
+        }
+        gettimeofday(&end, NULL);
+
+        double seconds = elapsed_seconds(start, end);
+        double mb = (double) buffer_len * num_buffers / (1024.0 * 1024.0);
+        cout << setw(20) << left << BACKENDS[b].name << right << fixed <<
+          setprecision(3) << setw(10) << seconds << " s" << setw(12) <<
+          (seconds > 0 ? mb / seconds : 0) << " MB/s  (0x" << hex <<
+          (int) sink << dec << ")\n";
+    }
+
+    return 0;
+}
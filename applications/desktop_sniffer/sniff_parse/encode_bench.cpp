@@ -0,0 +1,164 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "one_net_types.h"
+#include "one_net_encode.h"
+#include "one_net_status_codes.h"
+#include "sys/time.h"
+using namespace std;
+
+
+// Differential check of on_encode / on_decode against the one value at a time
+// reference versions (on_encode_scalar / on_decode_scalar), then timing of
+// each.  Invalid encoded bytes are mixed in to make sure they are rejected the
+// same way.
+
+
+void usage()
+{
+    cout << "Usage: ./encode_bench ---> Checks and benchmarks encoding / decoding of 64 byte arrays\n";
+    cout << "Usage: ./encode_bench 1000 1000000 ---> Checks and benchmarks encoding / decoding of\n"
+            "       1000000 arrays of 1000 encoded bytes\n";
+}
+
+
+static double elapsed_seconds(const struct timeval& start,
+  const struct timeval& end)
+{
+    return (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+}
+
+
+static UInt16 raw_len(UInt16 encoded_len)
+{
+    return (encoded_len * ON_RAW_WORD_SIZE + ON_ENCODED_WORD_SIZE - 1) /
+      ON_ENCODED_WORD_SIZE;
+}
+
+
+static bool check(UInt16 max_encoded_len)
+{
+    vector<UInt8> raw(raw_len(max_encoded_len));
+    vector<UInt8> enc_ref(max_encoded_len), enc(max_encoded_len);
+    vector<UInt8> dec_ref(raw.size()), dec(raw.size());
+
+    for(UInt16 len = 1; len <= max_encoded_len; len++)
+    {
+        for(int trial = 0; trial < 8; trial++)
+        {
+            for(size_t i = 0; i < raw.size(); i++)
+            {
+                raw[i] = (UInt8) rand();
+            }
+
+            one_net_status_t s_ref = on_encode_scalar(&enc_ref[0], &raw[0],
+              len);
+            one_net_status_t s = on_encode(&enc[0], &raw[0], len);
+            if(s != s_ref || memcmp(&enc[0], &enc_ref[0], len) != 0)
+            {
+                cout << "on_encode does not match the reference.  Length = "
+                  << len << endl;
+                return false;
+            }
+
+            // odd trials get a bad byte somewhere
+            if(trial % 2)
+            {
+                enc[rand() % len] = (UInt8) (trial == 1 ? 0x00 : 0xFF);
+            }
+
+            s_ref = on_decode_scalar(&dec_ref[0], &enc[0], len);
+            s = on_decode(&dec[0], &enc[0], len);
+            if(s != s_ref || (s == ONS_SUCCESS && memcmp(&dec[0], &dec_ref[0],
+              raw_len(len)) != 0))
+            {
+                cout << "on_decode does not match the reference.  Length = "
+                  << len << ", status = " << (int) s << ", reference = " <<
+                  (int) s_ref << endl;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+typedef one_net_status_t (*codec_func_t)(UInt8* out, const UInt8* in,
+  const UInt16 ENCODED_SIZE);
+
+
+static void time_codec(const char* name, codec_func_t func, UInt8* out,
+  const UInt8* in, UInt16 encoded_len, int num_arrays, bool decode)
+{
+    struct timeval start, end;
+    UInt8 sink = 0;
+    gettimeofday(&start, NULL);
+    for(int i = 0; i < num_arrays; i++)
+    {
+        sink ^= (UInt8) func(out, in, encoded_len);
+        sink ^= out[i % (decode ? raw_len(encoded_len) : encoded_len)];
+    }
+    gettimeofday(&end, NULL);
+
+    double seconds = elapsed_seconds(start, end);
+    double mb = (double) encoded_len * num_arrays / (1024.0 * 1024.0);
+    cout << setw(20) << left << name << right << fixed << setprecision(3) <<
+      setw(10) << seconds << " s" << setw(12) << (seconds > 0 ? mb / seconds :
+      0) << " MB/s encoded  (0x" << hex << (int) sink << dec << ")\n";
+}
+
+
+int main(int argc, char* argv[])
+{
+    int encoded_len = 64;
+    int num_arrays = 1000000;
+
+    if(argc != 1 && argc != 3)
+    {
+        usage();
+        exit(0);
+    }
+
+    if(argc == 3)
+    {
+        encoded_len = atoi(argv[1]);
+        num_arrays = atoi(argv[2]);
+        if(encoded_len < 1 || encoded_len > 0xFFFF || num_arrays < 1)
+        {
+            usage();
+            exit(0);
+        }
+    }
+
+    srand(1);
+    if(!check(encoded_len < 300 ? 300 : encoded_len))
+    {
+        return 1;
+    }
+    cout << "on_encode and on_decode match the reference implementations.\n";
+    cout << "Encoded length " << encoded_len << ", " << num_arrays <<
+      " arrays\n";
+
+    vector<UInt8> raw(raw_len(encoded_len));
+    vector<UInt8> enc(encoded_len);
+    for(size_t i = 0; i < raw.size(); i++)
+    {
+        raw[i] = (UInt8) rand();
+    }
+    on_encode_scalar(&enc[0], &raw[0], encoded_len);
+
+    time_codec("on_encode_scalar", on_encode_scalar, &enc[0], &raw[0],
+      encoded_len, num_arrays, false);
+    time_codec("on_encode", on_encode, &enc[0], &raw[0], encoded_len,
+      num_arrays, false);
+    time_codec("on_decode_scalar", on_decode_scalar, &raw[0], &enc[0],
+      encoded_len, num_arrays, true);
+    time_codec("on_decode", on_decode, &raw[0], &enc[0], encoded_len,
+      num_arrays, true);
+
+    return 0;
+}
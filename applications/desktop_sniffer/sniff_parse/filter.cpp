@@ -3,7 +3,7 @@
 #include "packet.h"
 #include "string_utils.h"
 #include <string>
-#include <list>
+#include <vector>
 #include <ostream>
 #include <cstdio>
 #include <cstring>
@@ -180,6 +180,35 @@ bool filter_range::inside(const filter_range& fr, uint64_t value)
 }
 
 
+// orders ranges by their high end, for finding the range a value is in
+static bool range_below(const filter_range& fr, uint64_t value)
+{
+    return fr.gethigh() < value;
+}
+
+
+// orders ranges by their low end, for finding the first range past a value
+static bool range_above(uint64_t value, const filter_range& fr)
+{
+    return value < fr.getlow();
+}
+
+
+// true if the range ends before value - 1, so it neither holds value nor
+// touches it
+static bool range_apart_below(const filter_range& fr, uint64_t value)
+{
+    return value > 0 && fr.gethigh() < value - 1;
+}
+
+
+// true if the range starts after value + 1
+static bool range_apart_above(uint64_t value, const filter_range& fr)
+{
+    return value < numeric_limits<uint64_t>::max() && fr.getlow() > value + 1;
+}
+
+
 filter_list::filter_list()
 {
     this->accepted_values.clear();
@@ -188,28 +217,13 @@ filter_list::filter_list()
 
 filter_list::filter_list(const filter_list& orig)
 {
-    this->accepted_values.clear();
-    list<filter_range>::const_iterator it;
-    for(it = orig.accepted_values.begin(); it != orig.accepted_values.end();
-        it++)
-    {
-        this->accepted_values.push_back(filter_range(it->getlow(),
-            it->gethigh()));
-    }
+    this->accepted_values = orig.accepted_values;
 }
 
 
 filter_list& filter_list::operator = (const filter_list& that)
 {
-    this->accepted_values.clear();
-    list<filter_range>::const_iterator it;
-    for(it = that.accepted_values.begin(); it != that.accepted_values.end();
-        it++)
-    {
-        this->accepted_values.push_back(filter_range(it->getlow(),
-            it->gethigh()));
-    }
-
+    this->accepted_values = that.accepted_values;
     return *this;
 }
 
@@ -227,82 +241,19 @@ bool filter_list::value_accepted(uint64_t value) const
         return true;
     }
     int index;
-
-    cout << "k:" << accepted_values.size() << endl;
-
     return find_value(value, index);
 }
 
 
 void filter_list::accept_value(uint64_t value)
 {
-    if(accepted_values.empty())
-    {
-        filter_range fr(value);
-        accepted_values.push_back(fr);
-        return;
-    }
-
-
-    int index;
-    if(find_value(value, index))
-    {
-        return; // already in there.
-    }
-
-
-    bool index_1_less_found, index_1_more_found;
-    list<filter_range>::iterator it = accepted_values.begin();
-    advance(it, index);
-    // uint64_t low;   // TODO -- low apears not to be used anywhere, so
-                       // commenting out.  Is it supposed to be used?
-    uint64_t high;
-
-    if(value == 0)
-    {
-        index_1_less_found = false;
-    }
-    else
-    {
-        index_1_less_found = find_value(value - 1, index);
-    }
-
-    if(value == numeric_limits<uint64_t>::max())
-    {
-        index_1_more_found = false;
-    }
-    else
-    {
-        index_1_more_found = find_value(value + 1, index);
-    }
-
-
-    if(!index_1_less_found && !index_1_more_found)
-    {
-        filter_range fr(value);
-        accepted_values.insert(it, fr);
-    }
-    else if(index_1_less_found && index_1_more_found)
-    {
-        // we pulled an "inside straight", so combine these two ranges into one
-        high = it->gethigh();
-        accepted_values.erase(it);
-        it--;
-        it->sethigh(high);
-    }
-    else if(index_1_less_found && !index_1_more_found)
-    {
-        it--;
-        it->sethigh(value);
-        return;
-    }
-    else
-    {
-        it->setlow(value);
-    }
+    accept_range(value, value);
 }
 
 
+// The ranges are kept sorted, not overlapping and not touching, so the ranges
+// the new one overlaps or touches are all next to each other and are merged
+// with it into one.
 bool filter_list::accept_range(uint64_t low, uint64_t high)
 {
     if(low > high)
@@ -310,110 +261,21 @@ bool filter_list::accept_range(uint64_t low, uint64_t high)
         return false;
     }
 
-    if(accepted_values.empty())
-    {
-        filter_range fr(low, high);
-        accepted_values.push_front(fr);
-        return true;
-    }
+    vector<filter_range>::iterator first = lower_bound(accepted_values.begin(),
+        accepted_values.end(), low, range_apart_below);
+    vector<filter_range>::iterator last = upper_bound(first,
+        accepted_values.end(), high, range_apart_above);
 
-    int index_low_neighbor, index_high_neighbor, index_low, index_high;
-    bool found_low_neighbor = false;
-    bool found_high_neighbor = false;
-    bool found_low = find_value(low, index_low);
-    bool found_high = find_value(high, index_high);
-    list<filter_range>::iterator it1,it2;
-    it1 = it2 = accepted_values.begin();
-    advance(it1, index_low);
-    advance(it2, index_high);
-
-    if(found_low && found_high)
+    if(first == last)
     {
-        if(index_low == index_high)
-        {
-            return true; // nothing to do.
-        }
-
-        // merging.  erase anything in between
-        it1->sethigh(it2->gethigh());
-        accepted_values.erase(it1, it2);
+        accepted_values.insert(first, filter_range(low, high));
         return true;
     }
 
-    if(!found_low)
-    {
-        if(low > 0)
-        {
-            found_low_neighbor = find_value(low - 1, index_low_neighbor);
-        }
-        if(low < numeric_limits<uint64_t>::max())
-        {
-            found_high_neighbor = find_value(low + 1, index_high_neighbor);
-        }
-
-        if(!found_low_neighbor && !found_high_neighbor)
-        {
-            filter_range fr(low, low);
-            accepted_values.insert(it1, 1, fr);
-        }
-        else if(found_low_neighbor && found_high_neighbor)
-        {
-            // merge
-            uint64_t new_high = it1->gethigh();
-            it1--;
-            it1->sethigh(new_high);
-            it1++;
-            accepted_values.erase(it1);
-
-        }
-        else if(found_low_neighbor)
-        {
-            it1--;
-            it1->sethigh(low);
-        }
-        else
-        {
-            it1->setlow(low);
-        }
-    }
-    else
-    {
-        if(high > 0)
-        {
-            found_low_neighbor = find_value(high - 1, index_low_neighbor);
-        }
-        if(high < numeric_limits<uint64_t>::max())
-        {
-            found_high_neighbor = find_value(high + 1, index_high_neighbor);
-        }
-
-        if(!found_low_neighbor && !found_high_neighbor)
-        {
-            filter_range fr(high, high);
-            accepted_values.insert(it2, 1, fr);
-        }
-        else if(found_low_neighbor && found_high_neighbor)
-        {
-            // merge
-            uint64_t new_high = it2->gethigh();
-            it2--;
-            it2->sethigh(new_high);
-            it2++;
-            accepted_values.erase(it2);
-
-        }
-        else if(found_low_neighbor)
-        {
-            it2--;
-            it2->sethigh(high);
-        }
-        else
-        {
-            it2->setlow(high);
-        }
-    }
-
-    return accept_range(low, high);
+    first->setlow(min(first->getlow(), low));
+    first->sethigh(max((last - 1)->gethigh(), high));
+    accepted_values.erase(first + 1, last);
+    return true;
 }
 
 
@@ -436,7 +298,7 @@ bool filter_list::reject_range(uint64_t low, uint64_t high)
         if(low > 0)
         {
             filter_range fr_low(0, low - 1);
-            accepted_values.push_front(fr_low);
+            accepted_values.push_back(fr_low);
         }
 
         if(high < numeric_limits<uint64_t>::max())
@@ -447,69 +309,32 @@ bool filter_list::reject_range(uint64_t low, uint64_t high)
         return true;
     }
 
-    int index_low, index_high;
-    bool found_low, found_high;
-    found_low = find_value(low, index_low);
-    found_high = find_value(high, index_high);
-    list<filter_range>::iterator it1,it2;
-    it1 = it2 = accepted_values.begin();
-    advance(it1, index_low);
-    advance(it2, index_high);
+    // the ranges holding any of low to high
+    vector<filter_range>::iterator first = lower_bound(accepted_values.begin(),
+        accepted_values.end(), low, range_below);
+    vector<filter_range>::iterator last = upper_bound(first,
+        accepted_values.end(), high, range_above);
 
-    if(!found_low && !found_high)
+    if(first == last)
     {
-        if(index_low == index_high)
-        {
-            return true; // nothing to do.
-        }
-
-        // delete anything in between
-        accepted_values.erase(it1, it2);
+        return true; // nothing to do.
     }
-    else if(found_low)
+
+    // whatever is left of the first and last ones is put back
+    filter_range head = *first;
+    filter_range tail = *(last - 1);
+    vector<filter_range>::iterator it = accepted_values.erase(first, last);
+    if(tail.gethigh() > high)
     {
-        if(it1->getlow() == low && it1->gethigh() == low)
-        {
-            accepted_values.erase(it1);
-        }
-        else if(it1->getlow() == low)
-        {
-            it1->setlow(low + 1);
-        }
-        else if(it1->gethigh() == low)
-        {
-            it1->sethigh(low - 1);
-        }
-        else
-        {
-            it1->sethigh(low - 1);
-            filter_range new_fr(low + 1, it1->gethigh());
-            accepted_values.insert(it1, 1, new_fr);
-        }
+        it = accepted_values.insert(it, filter_range(high + 1,
+            tail.gethigh()));
     }
-    else
+    if(head.getlow() < low)
     {
-        if(it2->getlow() == high && it2->gethigh() == high)
-        {
-            accepted_values.erase(it2);
-        }
-        else if(it2->getlow() == high)
-        {
-            it2->setlow(high + 1);
-        }
-        else if(it1->gethigh() == high)
-        {
-            it2->sethigh(high - 1);
-        }
-        else
-        {
-            it2->sethigh(high - 1);
-            filter_range new_fr(high + 1, it2->gethigh());
-            accepted_values.insert(it2, 1, new_fr);
-        }
+        accepted_values.insert(it, filter_range(head.getlow(), low - 1));
     }
 
-    return reject_range(low, high);
+    return true;
 }
 
 
@@ -523,7 +348,7 @@ void filter_list::display(ostream& outs, bool hex, bool key,
     }
 
 
-    list<filter_range>::const_iterator it;
+    vector<filter_range>::const_iterator it;
     for(it = accepted_values.begin(); it != accepted_values.end(); it++)
     {
         it->display(outs, hex, key, width);
@@ -538,38 +363,20 @@ void filter_list::remove_all()
 }
 
 
-bool filter_list::find_value(uint64_t value, int& index) const
+const vector<filter_range>& filter_list::get_ranges() const
 {
-    list<filter_range>::const_iterator it;
-    const int num_ranges = accepted_values.size();
-
-    cout << "g:" << value << ":" << num_ranges << endl;
-
-
-    if(num_ranges == 0)
-    {
-        index = 0;
-        return false;
-    }
-
-    it = accepted_values.begin();
+    return accepted_values;
+}
 
 
-    for(index = 0; index < num_ranges; index++)
-    {
-cout << "gg:" << index << ":" << value << ":" << it->getlow() << ":" << it->gethigh() << endl;
-        if(value < it->getlow())
-        {
-            return false;
-        }
-        if(value <= it->gethigh())
-        {
-            return true;
-        }
-        it++;
-    }
-
-    return false;
+// index is set to the range holding the value or, if no range holds it, to
+// where a range holding it would be inserted.
+bool filter_list::find_value(uint64_t value, int& index) const
+{
+    vector<filter_range>::const_iterator it = lower_bound(
+        accepted_values.begin(), accepted_values.end(), value, range_below);
+    index = it - accepted_values.begin();
+    return (it != accepted_values.end() && value >= it->getlow());
 }
 
 
@@ -751,20 +558,7 @@ bool filter::match_value_accepted(FILTER_TYPE ft, bool value) const
             return false;
     }
 
-    if(fm == WILDCARD)
-    {
-        return true;
-    }
-    else if(value && fm == MUST_MATCH)
-    {
-        return true;
-    }
-    else if(!value && fm == MUST_NOT_MATCH)
-    {
-        return true;
-    }
-
-    return false;
+    return match_accepted(fm, value);
 }
 
 
@@ -1031,3 +825,113 @@ const vector<xtea_key>* filter::get_keys(bool invite) const
 {
     return (invite ? &invite_keys : &keys);
 }
+
+
+bool filter::match_accepted(FILTER_MATCH fm, bool value)
+{
+    if(fm == WILDCARD)
+    {
+        return true;
+    }
+    else if(value && fm == MUST_MATCH)
+    {
+        return true;
+    }
+    else if(!value && fm == MUST_NOT_MATCH)
+    {
+        return true;
+    }
+
+    return false;
+}
+
+
+filter_matcher::packet_values::packet_values()
+{
+    memset(has_value, 0, sizeof(has_value));
+    memset(match_value, 0, sizeof(match_value));
+    is_invite = false;
+    key = NULL;
+}
+
+
+filter_matcher::filter_matcher(const filter& fltr)
+{
+    // an empty list accepts everything, so it is left out
+    for(int i = 0; i < filter::NUM_RANGE_FILTERS; i++)
+    {
+        const vector<filter_range>& list_ranges = fltr.filters.at(i).
+            get_ranges();
+        if(list_ranges.empty())
+        {
+            continue;
+        }
+
+        range_test test;
+        test.ft = (filter::FILTER_TYPE) i;
+        test.begin = ranges.size();
+        ranges.insert(ranges.end(), list_ranges.begin(), list_ranges.end());
+        test.end = ranges.size();
+        range_tests.push_back(test);
+    }
+
+    match[filter::FILTER_MSG_CRC_MATCH - filter::FILTER_MSG_CRC_MATCH] =
+        fltr.msg_crc_match;
+    match[filter::FILTER_PAYLOAD_CRC_MATCH - filter::FILTER_MSG_CRC_MATCH] =
+        fltr.pld_crc_match;
+    match[filter::FILTER_VALID_MATCH - filter::FILTER_MSG_CRC_MATCH] =
+        fltr.valid_match;
+    match[filter::FILTER_VALID_DECODE_MATCH - filter::FILTER_MSG_CRC_MATCH] =
+        fltr.valid_decode_match;
+    for(int i = filter::FILTER_MSG_CRC_MATCH; i < filter::FILTER_INVITE_KEYS;
+        i++)
+    {
+        if(match[i - filter::FILTER_MSG_CRC_MATCH] != filter::WILDCARD)
+        {
+            match_tests.push_back((filter::FILTER_TYPE) i);
+        }
+    }
+
+    keys = xtea_key::copy_keys(fltr.keys, true);
+    invite_keys = xtea_key::copy_keys(fltr.invite_keys, true);
+}
+
+
+bool filter_matcher::accepted(const packet_values& values) const
+{
+    const filter_range* all_ranges = (ranges.empty() ? NULL : &ranges[0]);
+    for(vector<range_test>::const_iterator it = range_tests.begin();
+        it != range_tests.end(); it++)
+    {
+        if(values.has_value[it->ft] && !in_ranges(&all_ranges[it->begin],
+            &all_ranges[it->end], values.value[it->ft]))
+        {
+            return false;
+        }
+    }
+
+    for(vector<filter::FILTER_TYPE>::const_iterator it = match_tests.begin();
+        it != match_tests.end(); it++)
+    {
+        int index = *it - filter::FILTER_MSG_CRC_MATCH;
+        if(!filter::match_accepted(match[index], values.match_value[index]))
+        {
+            return false;
+        }
+    }
+
+    if(!values.key)
+    {
+        return true;
+    }
+    return (xtea_key::find_key(values.is_invite ? invite_keys : keys,
+        *values.key) >= 0);
+}
+
+
+bool filter_matcher::in_ranges(const filter_range* begin,
+    const filter_range* end, uint64_t value)
+{
+    const filter_range* fr = lower_bound(begin, end, value, range_below);
+    return (fr != end && value >= fr->getlow());
+}
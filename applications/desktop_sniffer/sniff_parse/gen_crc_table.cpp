@@ -0,0 +1,124 @@
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include "one_net_types.h"
+#include "one_net_crc.h"
+#include "on_crc.h"
+using namespace std;
+
+
+// Writes one_net/utility/one_net_crc_table.h to standard output.  The table is
+// computed with the bit by bit reference crc and checked against the
+// compile-time C++ table before anything is written.
+
+
+void usage()
+{
+    cout << "Usage: ./gen_crc_table > ../../../one_net/utility/one_net_crc_table.h"
+      " ---> Generates the 8th order crc lookup table header\n";
+}
+
+
+static UInt8 reference_row_entry(int row, int value)
+{
+    UInt8 bytes[ON_CRC8_TABLE_ROWS] = {0};
+    bytes[0] = (UInt8) value;
+    return (UInt8) one_net_compute_crc_bitwise(bytes, (UInt8)(row + 1), 0,
+      ON_PLD_CRC_ORDER);
+}
+
+
+static void write_row(int row)
+{
+    cout << "    {\n";
+    for(int i = 0; i < 256; i++)
+    {
+        if(i % 12 == 0)
+        {
+            cout << "        ";
+        }
+        cout << "0x" << hex << uppercase << setw(2) << setfill('0') <<
+          (int) reference_row_entry(row, i);
+        if(i != 255)
+        {
+            cout << ((i % 12 == 11) ? ",\n" : ", ");
+        }
+    }
+    cout << "\n    }";
+}
+
+
+int main(int argc, char*[])
+{
+    if(argc != 1)
+    {
+        usage();
+        exit(0);
+    }
+
+    for(int row = 0; row < ON_CRC8_TABLE_ROWS; row++)
+    {
+        for(int i = 0; i < 256; i++)
+        {
+            if(reference_row_entry(row, i) != ON_CRC8_TABLE.row[row][i])
+            {
+                cerr << "Reference crc does not match the C++ table at row " <<
+                  row << ", index " << i << endl;
+                return 1;
+            }
+        }
+    }
+
+    cout <<
+      "#ifndef ONE_NET_CRC_TABLE_H\n"
+      "#define ONE_NET_CRC_TABLE_H\n"
+      "\n"
+      "//! \\addtogroup one_net_crc\n"
+      "//! @{\n"
+      "\n"
+      "/*!\n"
+      "    \\file one_net_crc_table.h\n"
+      "    \\brief Lookup table for the 8th order (0xA6) crc.\n"
+      "\n"
+      "    GENERATED FILE -- DO NOT EDIT.  Generated by\n"
+      "    applications/desktop_sniffer/sniff_parse/gen_crc_table.\n"
+      "\n"
+      "    Row k is the crc of a byte followed by k zero bytes.  Only the first\n"
+      "    CRC_SLICE_BY rows are compiled in.  Include only from one_net_crc.c.\n"
+      "*/\n"
+      "\n"
+      "#include \"one_net_types.h\"\n"
+      "\n"
+      "\n"
+      "static const UInt8 on_crc8_table[CRC_SLICE_BY][256] =\n"
+      "{\n";
+
+    for(int row = 0; row < ON_CRC8_TABLE_ROWS; row++)
+    {
+        if(row == 1)
+        {
+            cout << "#if CRC_SLICE_BY > 1\n";
+        }
+        else if(row == 4)
+        {
+            cout << "#if CRC_SLICE_BY > 4\n";
+        }
+
+        write_row(row);
+        cout << ((row == ON_CRC8_TABLE_ROWS - 1) ? "\n" : ",\n");
+
+        if(row == 3 || row == ON_CRC8_TABLE_ROWS - 1)
+        {
+            cout << "#endif\n";
+        }
+    }
+
+    cout <<
+      "};\n"
+      "\n"
+      "//! @} one_net_crc\n"
+      "\n"
+      "#endif // ONE_NET_CRC_TABLE_H //\n";
+
+    return 0;
+}
@@ -0,0 +1,92 @@
+#ifndef ON_CRC_H
+#define	ON_CRC_H
+
+#include "one_net_types.h"
+#include <cstddef>
+
+
+// Compile-time generated tables for the 8th order (0xA6) ONE-NET crc.  Row k
+// of the table is the crc of a byte followed by k zero bytes, which is what the
+// slice-by-N crc needs.  Row 0 alone is the normal byte at a time table.  These
+// are bit-exact with one_net_compute_crc_bitwise (see gen_crc_table and
+// crc_bench).
+
+
+const UInt8 ON_CRC8_POLYNOMIAL = 0xA6;
+const int ON_CRC8_TABLE_ROWS = 8;
+
+
+struct on_crc8_table_t
+{
+    UInt8 row[ON_CRC8_TABLE_ROWS][256];
+};
+
+
+constexpr UInt8 on_crc8_bitwise_byte(UInt8 crc, UInt8 byte)
+{
+    for(int i = 0; i < 8; i++)
+    {
+        bool bit = ((crc ^ byte) & 0x80) != 0;
+        crc = (UInt8)(crc << 1);
+        byte = (UInt8)(byte << 1);
+        if(bit)
+        {
+            crc ^= ON_CRC8_POLYNOMIAL;
+        }
+    }
+
+    return crc;
+}
+
+
+constexpr on_crc8_table_t on_make_crc8_table()
+{
+    on_crc8_table_t table = {};
+    for(int i = 0; i < 256; i++)
+    {
+        table.row[0][i] = on_crc8_bitwise_byte(0, (UInt8) i);
+    }
+
+    for(int k = 1; k < ON_CRC8_TABLE_ROWS; k++)
+    {
+        for(int i = 0; i < 256; i++)
+        {
+            table.row[k][i] = table.row[0][table.row[k - 1][i]];
+        }
+    }
+
+    return table;
+}
+
+
+constexpr on_crc8_table_t ON_CRC8_TABLE = on_make_crc8_table();
+
+
+static_assert(ON_CRC8_TABLE.row[0][0] == 0, "crc8 table row 0");
+static_assert(ON_CRC8_TABLE.row[0][1] == ON_CRC8_POLYNOMIAL,
+  "crc8 table row 0");
+
+
+inline UInt8 on_crc8(const UInt8* data, size_t len, UInt8 crc)
+{
+    for(; len >= 8; len -= 8)
+    {
+        crc = ON_CRC8_TABLE.row[7][crc ^ data[0]] ^
+          ON_CRC8_TABLE.row[6][data[1]] ^ ON_CRC8_TABLE.row[5][data[2]] ^
+          ON_CRC8_TABLE.row[4][data[3]] ^ ON_CRC8_TABLE.row[3][data[4]] ^
+          ON_CRC8_TABLE.row[2][data[5]] ^ ON_CRC8_TABLE.row[1][data[6]] ^
+          ON_CRC8_TABLE.row[0][data[7]];
+        data += 8;
+    }
+
+    for(; len > 0; len--)
+    {
+        crc = ON_CRC8_TABLE.row[0][crc ^ *data++];
+    }
+
+    return crc;
+}
+
+
+
+#endif	/* ON_CRC_H */
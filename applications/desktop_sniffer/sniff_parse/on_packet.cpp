@@ -1324,11 +1324,17 @@ void on_admin_payload::parse_bytes(const UInt8* pld_bytes, UInt8 num_bytes)
               valid = false;
               error_message = "Unable to decode Terminating DID.";
           }
+          this->terminate_block_stream.status =
+              (on_message_status_t) bytes[ON_ENCODED_DID_LEN];
           this->terminate_block_stream.response_ack_nack.payload =
               (ack_nack_payload_t*) this->terminate_block_stream.ack_nack_payload_bytes;
+          // The ACK / NACK is sent as it is laid out in memory, not as a
+          // response packet: NACK reason, handle, then the payload.
+          this->terminate_block_stream.response_ack_nack.nack_reason =
+              (on_nack_rsn_t) bytes[ON_ENCODED_DID_LEN + 1];
+          this->terminate_block_stream.response_ack_nack.handle =
+              (on_ack_nack_handle_t) bytes[ON_ENCODED_DID_LEN + 2];
           memcpy(terminate_block_stream.ack_nack_payload_bytes, &bytes[5], 5);
-          valid = (on_parse_response_pkt(raw_pid, bytes, &terminate_block_stream.response_ack_nack) ==
-                  ONS_SUCCESS);
           break;
 
         default: /* Stick any other cases above.  Flag this one as invalid. */
@@ -2089,7 +2095,9 @@ display_on_stream_pay_func on_stream_payload::disp_stream_pay = &on_stream_paylo
 
 on_packet::on_packet()
 {
-
+    timestamp_ms = 0;
+    payload = NULL;
+    clear_parsed();
 }
 
 
@@ -2097,15 +2105,91 @@ on_packet::on_packet(std::string encoded_packet, std::string key)
 {
     this->encoded_packet = encoded_packet;
     strip_all_whitespace(this->encoded_packet);
-    this->valid = false;
-    this->valid_decode = false;
-    this->valid_digits = false;
-    this->valid_msg_crc = false;
-    this->valid_pid = false;
-    this->payload = NULL;
+    this->key = key;
     this->timestamp_ms = 0;
+    this->payload = NULL;
+    clear_parsed();
+}
+
+
+// A copy is decoded again when it is used rather than copying what has been
+// decoded so far.
+on_packet::on_packet(const on_packet& orig)
+{
+    timestamp_ms = orig.timestamp_ms;
+    encoded_packet = orig.encoded_packet;
+    key = orig.key;
+    payload = NULL;
+    clear_parsed();
+}
+
+
+on_packet& on_packet::operator = (const on_packet& that)
+{
+    if(this != &that)
+    {
+        timestamp_ms = that.timestamp_ms;
+        encoded_packet = that.encoded_packet;
+        key = that.key;
+        clear_parsed();
+    }
+    return *this;
+}
+
+
+on_packet::~on_packet()
+{
+    delete payload;
+}
+
+
+// Forgets everything decoded so far
+void on_packet::clear_parsed() const
+{
+    delete payload;
+    payload = NULL;
+    header_parsed = false;
+    payload_parsed = false;
+    valid = false;
+    valid_header = false;
+    valid_decode = false;
+    valid_digits = false;
+    valid_msg_crc = false;
+    valid_pid = false;
+    is_invite_pkt = false;
+    is_single_data_pkt = false;
+    is_response_pkt = false;
+    is_ack_pkt = false;
+    is_nack_pkt = false;
+    is_route_pkt = false;
+    is_block_pkt = false;
+    is_stream_pkt = false;
+    is_app_pkt = false;
+    is_admin_pkt = false;
+    is_features_pkt = false;
+    is_multihop_pkt = false;
+    is_stay_awake_pkt = false;
+    raw_src_did = 0;
+    raw_rptr_did = 0;
+    raw_dst_did = 0;
+    raw_nid = 0;
+    raw_pid = 0;
+    hops = 0;
+    max_hops = 0;
+    error_message = "";
+}
+
+
+// Decodes the header: everything up to the payload, and the hops field.  Does
+// nothing after the first time.
+void on_packet::parse_header() const
+{
+    if(header_parsed)
+    {
+        return;
+    }
+    header_parsed = true;
 
-    
     if(this->encoded_packet.length() < ON_MIN_ENCODED_PKT_SIZE * 2)
     {
         error_message = "Packet is too short.";
@@ -2254,8 +2338,28 @@ on_packet::on_packet(std::string encoded_packet, std::string key)
             return;
         }
     }
+    valid_header = true;
+}
+
+
+// Decodes, decrypts and parses the payload.  Does nothing after the first
+// time or if the header is not valid.
+void on_packet::parse_payload() const
+{
+    if(payload_parsed)
+    {
+        return;
+    }
+    payload_parsed = true;
+
+    parse_header();
+    if(!valid_header)
+    {
+        return;
+    }
+
     encoded_payload = this->encoded_packet.substr(2 * ON_ENCODED_PLD_IDX,
-      2 * pkt.payload_len);
+      2 * encoded_payload_len);
     encoded_payload_bytes = &encoded_packet_bytes[ON_ENCODED_PLD_IDX];
 
     if(on_decode(decoded_payload_bytes, encoded_payload_bytes,
@@ -2325,7 +2429,11 @@ on_packet::on_packet(std::string encoded_packet, std::string key)
         payload = new on_stream_payload(raw_pid, decoded_payload, key, true);
     }
 
-    if(!payload->get_valid())
+    if(payload == NULL)
+    {
+        error_message = "Unknown packet type.";
+    }
+    else if(!payload->get_valid())
     {
         error_message = payload->get_error_message();
     }
@@ -2336,120 +2444,38 @@ on_packet::on_packet(std::string encoded_packet, std::string key)
 }
 
 
-on_packet::on_packet(const on_packet& orig)
+// Tests the timestamp, the addresses, the PID and the hops against the
+// matcher's range filters without decrypting the payload.  Range filters on
+// anything else are not tested.  The match filters should be left as
+// wildcards, since the header has no values for them.  A packet whose header
+// does not decode is not accepted.
+bool on_packet::filter_header(const filter_matcher& matcher) const
 {
-    timestamp_ms = orig.timestamp_ms;
-    encoded_packet = orig.encoded_packet;
-    encoded_payload = orig.encoded_payload;
-    decoded_payload = orig.decoded_payload;
-    memcpy(encoded_packet_bytes, orig.encoded_packet_bytes,
-      sizeof(encoded_packet_bytes));
-    memcpy(encoded_payload_bytes, orig.encoded_payload_bytes,
-      sizeof(encoded_payload_bytes));
-    memcpy(decoded_payload_bytes, orig.decoded_payload_bytes,
-      sizeof(decoded_payload_bytes));
-    preamble_header = orig.preamble_header;
-    num_encoded_bytes = orig.num_encoded_bytes;
-    encoded_payload_len = orig.encoded_payload_len;
-    decoded_payload_len = orig.decoded_payload_len;
-    raw_src_did = orig.raw_src_did;
-    raw_rptr_did = orig.raw_rptr_did;
-    raw_dst_did = orig.raw_dst_did;
-    raw_nid = orig.raw_nid;
-    enc_src_did = orig.enc_src_did;
-    enc_rptr_did = orig.enc_rptr_did;
-    enc_dst_did = orig.enc_dst_did;
-    enc_nid = orig.enc_nid;
-    enc_pid = orig.enc_pid;
-    raw_pid = orig.raw_pid;
-    enc_msg_crc = orig.enc_msg_crc;
-    msg_crc = orig.msg_crc;
-    calculated_msg_crc = orig.calculated_msg_crc;
-    hops = orig.hops;
-    max_hops = orig.max_hops;
-    encoded_hops_field = orig.encoded_hops_field;
-    raw_hops_field = orig.raw_hops_field;
-    valid_digits = orig.valid_digits;
-    valid_msg_crc = orig.valid_msg_crc;
-    valid_decode = orig.valid_decode;
-    valid_pid = orig.valid_pid;
-    valid = orig.valid;
-    is_invite_pkt = orig.is_invite_pkt;
-    is_single_data_pkt = orig.is_single_data_pkt;
-    is_response_pkt = orig.is_response_pkt;
-    is_ack_pkt = orig.is_ack_pkt;
-    is_nack_pkt = orig.is_nack_pkt;
-    is_route_pkt = orig.is_route_pkt;
-    is_block_pkt = orig.is_block_pkt;
-    is_stream_pkt = orig.is_stream_pkt;
-    is_app_pkt = orig.is_app_pkt;
-    is_admin_pkt = orig.is_admin_pkt;
-    is_features_pkt = orig.is_features_pkt;
-    is_multihop_pkt = orig.is_multihop_pkt;
-    is_stay_awake_pkt = orig.is_stay_awake_pkt;
-    num_payload_blocks = orig.num_payload_blocks;
-    error_message = orig.error_message;
-
-    if(payload == NULL)
-    {
-        // should never get here?
-        return;
-    }
-
-    if(this->is_single_data_pkt)
-    {
-        if(is_app_pkt)
-        {
-            on_app_payload* oap = dynamic_cast<on_app_payload*>(orig.payload);
-            payload = new on_app_payload(*oap);
-        }
-        else if(is_admin_pkt)
-        {
-            on_admin_payload* oap = dynamic_cast<on_admin_payload*>(orig.payload);
-            payload = new on_admin_payload(*oap);
-        }
-        else if(is_features_pkt)
-        {
-            on_features_payload* ofp = dynamic_cast<on_features_payload*>(orig.payload);
-            payload = new on_features_payload(*ofp);
-        }
-        else if(is_route_pkt)
-        {
-            on_route_payload* orp = dynamic_cast<on_route_payload*>(orig.payload);
-            payload = new on_route_payload(*orp);
-        }
-        else
-        {
-            on_single_data_payload* osdp = dynamic_cast<on_single_data_payload*>(orig.payload);
-            payload = new on_single_data_payload(*osdp);
-        }
-    }
-    else if(this->is_invite_pkt)
-    {
-        on_invite_payload* oip = dynamic_cast<on_invite_payload*>(orig.payload);
-        payload = new on_invite_payload(*oip);
-    }
-    else if(this->is_response_pkt)
-    {
-        on_response_payload* orp = dynamic_cast<on_response_payload*>(orig.payload);
-        payload = new on_response_payload(*orp);
-    }
-    else if(this->is_block_pkt)
-    {
-        on_block_payload* obp = dynamic_cast<on_block_payload*>(orig.payload);
-        payload = new on_block_payload(*obp);
-    }
-    else if(this->is_stream_pkt)
+    parse_header();
+    if(!valid_header)
     {
-        on_stream_payload* osp = dynamic_cast<on_stream_payload*>(orig.payload);
-        payload = new on_stream_payload(*osp);
+        return false;
     }
-}
 
+    filter_matcher::packet_values values;
+    values.value[filter::FILTER_TIMESTAMP] = timestamp_ms;
+    values.value[filter::FILTER_SRC_DID] = raw_src_did;
+    values.value[filter::FILTER_RPTR_DID] = raw_rptr_did;
+    values.value[filter::FILTER_DST_DID] = raw_dst_did;
+    values.value[filter::FILTER_NID] = raw_nid;
+    values.value[filter::FILTER_PID] = raw_pid;
+    values.value[filter::FILTER_HOPS] = get_hops();
+    values.value[filter::FILTER_MAX_HOPS] = get_max_hops();
+    values.has_value[filter::FILTER_TIMESTAMP] = true;
+    values.has_value[filter::FILTER_SRC_DID] = true;
+    values.has_value[filter::FILTER_RPTR_DID] = true;
+    values.has_value[filter::FILTER_DST_DID] = true;
+    values.has_value[filter::FILTER_NID] = true;
+    values.has_value[filter::FILTER_PID] = true;
+    values.has_value[filter::FILTER_HOPS] = true;
+    values.has_value[filter::FILTER_MAX_HOPS] = true;
 
-on_packet::~on_packet()
-{
-    delete payload;
+    return matcher.accepted(values);
 }
 
 
@@ -2480,6 +2506,9 @@ void on_packet::default_display(const on_packet& obj, UInt8 verbosity,
         return;
     }
 
+    // everything is displayed, so decode everything
+    obj.parse_payload();
+
     bool need_comma = false;
     std::string str;
     bool ret;
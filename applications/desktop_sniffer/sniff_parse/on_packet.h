@@ -12,6 +12,7 @@
 #include "one_net_peer.h"
 #include "attribute.h"
 #include "string_utils.h"
+#include "filter.h"
 
 
 extern const unsigned int NUM_PIDS;
@@ -38,6 +39,7 @@ public:
     bool get_valid(){return valid;}
     bool get_valid_decrypt(){return valid_decrypt;}
     bool get_valid_crc(){return valid_crc;}
+    UInt16 get_msg_id() const {return msg_id;}
 protected:
     SInt8 num_bytes;
     std::string encrypted_payload;
@@ -153,6 +155,7 @@ public:
     static void set_display_on_response_pay_function(display_on_response_pay_func func);
     static UInt8 get_num_relevant_bytes_from_ack_nack_handle(
       const on_ack_nack_t& ack_nack, UInt8 num_xtea_blocks = 1);
+    const on_ack_nack_t& get_ack_nack() const {return ack_nack;}
 
 private:
     on_ack_nack_t ack_nack;
@@ -277,6 +280,9 @@ public:
     static void default_display(const on_admin_payload& obj, UInt8 verbosity,
       const attribute* att, ostream& outs = cout);
     static void set_display_on_admin_pay_function(display_on_admin_pay_func func);
+    UInt8 get_admin_type() const {return admin_type;}
+    const bs_transfer_request_t& get_bs_transfer_request() const {return bs_transfer_request;}
+    const terminate_block_stream_t& get_terminate_block_stream() const {return terminate_block_stream;}
 
 
 private:
@@ -405,6 +411,7 @@ public:
     static void default_display(const on_block_payload& obj, UInt8 verbosity,
       const attribute* att, ostream& outs = cout);
     static void set_display_on_block_pay_function(display_on_block_pay_func func);
+    const block_pkt_t& get_block_pkt() const {return block_pkt;}
 
 
 private:
@@ -432,6 +439,7 @@ public:
     static void default_display(const on_stream_payload& obj, UInt8 verbosity,
       const attribute* att, ostream& outs = cout);
     static void set_display_on_stream_pay_function(display_on_stream_pay_func func);
+    const stream_pkt_t& get_stream_pkt() const {return stream_pkt;}
 
 
 private:
@@ -446,12 +454,20 @@ private:
 class on_packet;
 typedef void(*display_on_packet_func)(const on_packet&, UInt8,
   const attribute* att, ostream&);
+
+// A packet from a capture.  Nothing is decoded when it is made.  The header
+// (addresses, PID, message CRC and hops) is decoded the first time one of
+// its fields is asked for, and the payload is decoded, decrypted and parsed
+// only when it, the packet's validity or something from it is asked for or
+// the packet is displayed.  Packets thrown out by their addresses or PID are
+// never decrypted.
 class on_packet
 {
 public:
     on_packet();
     on_packet(std::string encoded_bytes, std::string key);
     on_packet(const on_packet& orig);
+    on_packet& operator = (const on_packet& that);
     virtual ~on_packet();
 
     void display(UInt8 verbosity = 255, const attribute* att = NULL, ostream& outs = cout);
@@ -466,64 +482,94 @@ public:
     static one_net_status_t on_encode_nid(uint64_t* encoded_nid, uint64_t decoded_nid);
     static one_net_status_t on_decode_nid(uint64_t* decoded_nid, uint64_t encoded_nid);
 
-    std::string get_error_message(){return error_message;}
-    bool get_valid(){return valid;}
-    bool get_is_invite_pkt(){return is_invite_pkt;}
-    UInt32 get_timestamp_ms(){return timestamp_ms;}
+    // header fields.  These do not decrypt the payload.
+    bool get_valid_header() const {parse_header(); return valid_header;}
+    bool get_is_invite_pkt() const {parse_header(); return is_invite_pkt;}
+    UInt32 get_timestamp_ms() const {return timestamp_ms;}
     void set_timestamp_ms(UInt32 timestamp_ms){this->timestamp_ms = timestamp_ms;}
+    UInt16 get_raw_src_did() const {parse_header(); return raw_src_did;}
+    UInt16 get_raw_rptr_did() const {parse_header(); return raw_rptr_did;}
+    UInt16 get_raw_dst_did() const {parse_header(); return raw_dst_did;}
+    uint64_t get_raw_nid() const {parse_header(); return raw_nid;}
+    UInt16 get_raw_pid() const {parse_header(); return raw_pid;}
+    UInt8 get_hops() const {parse_header(); return is_multihop_pkt ? hops : 0;}
+    UInt8 get_max_hops() const {parse_header(); return is_multihop_pkt ? max_hops : 0;}
+    bool get_is_single_data_pkt() const {parse_header(); return is_single_data_pkt;}
+    bool get_is_response_pkt() const {parse_header(); return is_response_pkt;}
+    bool get_is_ack_pkt() const {parse_header(); return is_ack_pkt;}
+    bool get_is_block_pkt() const {parse_header(); return is_block_pkt;}
+    bool get_is_stream_pkt() const {parse_header(); return is_stream_pkt;}
+    bool filter_header(const filter_matcher& matcher) const;
+
+    // These decrypt and parse the payload.
+    std::string get_error_message() const {parse_payload(); return error_message;}
+    bool get_valid() const {parse_payload(); return valid;}
+    bool get_is_admin_pkt() const {parse_payload(); return is_admin_pkt;}
+    const on_payload* get_payload() const {parse_payload(); return payload;}
 
 private:
+    void parse_header() const;
+    void parse_payload() const;
+    void clear_parsed() const;
+
     UInt32 timestamp_ms;
     std::string encoded_packet;
-    std::string encoded_payload;
-    std::string decoded_payload;
-    UInt8 encoded_packet_bytes[ON_MAX_ENCODED_PKT_SIZE];
-    UInt8* encoded_payload_bytes;
-    UInt8 decoded_payload_bytes[ON_MAX_RAW_PLD_LEN_WITH_TECH];
-
+    std::string key;
 
-    std::string preamble_header;
-    UInt8 num_encoded_bytes;
-    UInt8 encoded_payload_len;
-    UInt8 decoded_payload_len;
-    UInt16 raw_src_did;
-    UInt16 raw_rptr_did;
-    UInt16 raw_dst_did;
-    uint64_t raw_nid;
-    UInt16 enc_src_did;
-    UInt16 enc_rptr_did;
-    UInt16 enc_dst_did;
-    uint64_t enc_nid;
-    UInt16 enc_pid;
-    UInt16 raw_pid;
-    UInt8 enc_msg_crc;
-    UInt8 msg_crc;
-    UInt8 calculated_msg_crc;
-    UInt8 hops;
-    UInt8 max_hops;
-    UInt8 encoded_hops_field;
-    UInt8 raw_hops_field;
-    bool valid_digits;
-    bool valid_msg_crc;
-    bool valid_decode;
-    bool valid_pid;
-    bool valid;
-    bool is_invite_pkt;
-    bool is_single_data_pkt;
-    bool is_response_pkt;
-    bool is_ack_pkt;
-    bool is_nack_pkt;
-    bool is_route_pkt;
-    bool is_block_pkt;
-    bool is_stream_pkt;
-    bool is_app_pkt;
-    bool is_admin_pkt;
-    bool is_features_pkt;
-    bool is_multihop_pkt;
-    bool is_stay_awake_pkt;
-    SInt8 num_payload_blocks;
-    std::string error_message;
-    on_payload* payload;
+    // Everything below is decoded from encoded_packet when it is first
+    // needed, by parse_header or parse_payload.
+    mutable bool header_parsed;
+    mutable bool payload_parsed;
+    mutable std::string encoded_payload;
+    mutable std::string decoded_payload;
+    mutable UInt8 encoded_packet_bytes[ON_MAX_ENCODED_PKT_SIZE];
+    mutable UInt8* encoded_payload_bytes;
+    mutable UInt8 decoded_payload_bytes[ON_MAX_RAW_PLD_LEN_WITH_TECH];
+
+
+    mutable std::string preamble_header;
+    mutable UInt8 num_encoded_bytes;
+    mutable UInt8 encoded_payload_len;
+    mutable UInt8 decoded_payload_len;
+    mutable UInt16 raw_src_did;
+    mutable UInt16 raw_rptr_did;
+    mutable UInt16 raw_dst_did;
+    mutable uint64_t raw_nid;
+    mutable UInt16 enc_src_did;
+    mutable UInt16 enc_rptr_did;
+    mutable UInt16 enc_dst_did;
+    mutable uint64_t enc_nid;
+    mutable UInt16 enc_pid;
+    mutable UInt16 raw_pid;
+    mutable UInt8 enc_msg_crc;
+    mutable UInt8 msg_crc;
+    mutable UInt8 calculated_msg_crc;
+    mutable UInt8 hops;
+    mutable UInt8 max_hops;
+    mutable UInt8 encoded_hops_field;
+    mutable UInt8 raw_hops_field;
+    mutable bool valid_digits;
+    mutable bool valid_msg_crc;
+    mutable bool valid_decode;
+    mutable bool valid_pid;
+    mutable bool valid_header;
+    mutable bool valid;
+    mutable bool is_invite_pkt;
+    mutable bool is_single_data_pkt;
+    mutable bool is_response_pkt;
+    mutable bool is_ack_pkt;
+    mutable bool is_nack_pkt;
+    mutable bool is_route_pkt;
+    mutable bool is_block_pkt;
+    mutable bool is_stream_pkt;
+    mutable bool is_app_pkt;
+    mutable bool is_admin_pkt;
+    mutable bool is_features_pkt;
+    mutable bool is_multihop_pkt;
+    mutable bool is_stay_awake_pkt;
+    mutable SInt8 num_payload_blocks;
+    mutable std::string error_message;
+    mutable on_payload* payload;
     static display_on_packet_func disp_pkt;
 };
 
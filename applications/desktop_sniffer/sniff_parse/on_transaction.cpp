@@ -0,0 +1,370 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include "on_transaction.h"
+#include "string_utils.h"
+
+
+
+const UInt32 on_transaction_tracker::DEFAULT_RESPONSE_TIMEOUT_MS;
+
+
+
+on_link_stats::on_link_stats()
+{
+    num_txns = 0;
+    num_acks = 0;
+    num_nacks = 0;
+    num_no_response = 0;
+    num_retries = 0;
+    num_relays = 0;
+    max_hops = 0;
+    min_latency_ms = 0;
+    max_latency_ms = 0;
+    total_latency_ms = 0;
+    total_rtt_ms = 0;
+}
+
+
+
+on_transaction_tracker::on_transaction_tracker(UInt32 response_timeout_ms)
+{
+    this->response_timeout_ms = response_timeout_ms;
+    next_expire_ms = 0;
+}
+
+
+uint32_t on_transaction_tracker::link_key(UInt16 raw_src_did,
+    UInt16 raw_dst_did)
+{
+    return ((uint32_t) raw_src_did << 16) | raw_dst_did;
+}
+
+
+UInt16 on_transaction_tracker::link_src_did(uint32_t key)
+{
+    return (UInt16) (key >> 16);
+}
+
+
+UInt16 on_transaction_tracker::link_dst_did(uint32_t key)
+{
+    return (UInt16) (key & 0xFFFF);
+}
+
+
+uint64_t on_transaction_tracker::txn_key(UInt16 raw_src_did,
+    UInt16 raw_dst_did, UInt16 msg_id)
+{
+    return ((uint64_t) raw_src_did << 32) | ((uint64_t) raw_dst_did << 16) |
+        msg_id;
+}
+
+
+// Invalid packets and packets that are not single data or responses are
+// ignored.  Packets must be added in the order they were heard.
+void on_transaction_tracker::add_packet(const on_packet& pkt)
+{
+    UInt32 now_ms = pkt.get_timestamp_ms();
+    if(now_ms >= next_expire_ms)
+    {
+        // a transaction may be left open for up to half a timeout too long,
+        // but the open transactions are only looked through now and then.
+        expire(now_ms);
+        next_expire_ms = now_ms + response_timeout_ms / 2;
+    }
+
+    // the type is in the header, so other packets are never decrypted
+    if(!pkt.get_is_single_data_pkt() && !pkt.get_is_response_pkt())
+    {
+        return;
+    }
+
+    const on_payload* pld = pkt.get_payload();
+    if(!pkt.get_valid() || !pld)
+    {
+        return;
+    }
+
+    if(pkt.get_is_single_data_pkt())
+    {
+        add_data_packet(pkt, pld->get_msg_id());
+    }
+    else if(pkt.get_is_response_pkt())
+    {
+        const on_response_payload* rsp =
+            dynamic_cast<const on_response_payload*>(pld);
+        if(rsp)
+        {
+            add_response_packet(pkt, pld->get_msg_id(), rsp->get_ack_nack());
+        }
+    }
+}
+
+
+void on_transaction_tracker::add_data_packet(const on_packet& pkt,
+    UInt16 msg_id)
+{
+    UInt32 now_ms = pkt.get_timestamp_ms();
+    bool relayed = (pkt.get_hops() > 0);
+    uint64_t key = txn_key(pkt.get_raw_src_did(), pkt.get_raw_dst_did(),
+        msg_id);
+    map<uint64_t, on_transaction>::iterator it = open_txns.find(key);
+
+    if(it != open_txns.end() &&
+        now_ms - it->second.last_heard_ms >= response_timeout_ms)
+    {
+        // the same message ID used again for a new transaction
+        finish_transaction(it->second);
+        open_txns.erase(it);
+        it = open_txns.end();
+    }
+
+    if(it == open_txns.end())
+    {
+        // If this is a relay, the source's own copy was not heard.  It is
+        // as close as we can get to when the transaction started.
+        on_transaction txn;
+        txn.raw_src_did = pkt.get_raw_src_did();
+        txn.raw_dst_did = pkt.get_raw_dst_did();
+        txn.msg_id = msg_id;
+        txn.raw_pid = pkt.get_raw_pid();
+        txn.max_hops = pkt.get_max_hops();
+        txn.first_tx_ms = now_ms;
+        txn.last_tx_ms = now_ms;
+        txn.last_heard_ms = now_ms;
+        txn.num_retries = 0;
+        txn.num_relays = (relayed ? 1 : 0);
+        txn.responded = false;
+        txn.ack = false;
+        txn.nack_reason = ON_NACK_RSN_NO_ERROR;
+        txn.response_ms = 0;
+        txn.rtt_ms = 0;
+        txn.last_response_ms = 0;
+        open_txns[key] = txn;
+        return;
+    }
+
+    on_transaction& txn = it->second;
+    txn.last_heard_ms = now_ms;
+    if(relayed)
+    {
+        txn.num_relays++;
+        return;
+    }
+
+    // sent again by the source, whether or not a response was heard.  The
+    // source may not have heard it.
+    if(txn.num_retries < 0xFF)
+    {
+        txn.num_retries++;
+    }
+    txn.last_tx_ms = now_ms;
+}
+
+
+// The first response sets the latency.  If the source sends the data packet
+// again and is answered again, the last answer is taken as the result.
+void on_transaction_tracker::add_response_packet(const on_packet& pkt,
+    UInt16 msg_id, const on_ack_nack_t& ack_nack)
+{
+    UInt32 now_ms = pkt.get_timestamp_ms();
+
+    // the response goes back the other way
+    map<uint64_t, on_transaction>::iterator it = open_txns.find(txn_key(
+        pkt.get_raw_dst_did(), pkt.get_raw_src_did(), msg_id));
+    if(it == open_txns.end() ||
+        now_ms - it->second.last_heard_ms >= response_timeout_ms)
+    {
+        // the data packet was not heard, or this is for an older one
+        return;
+    }
+
+    on_transaction& txn = it->second;
+    txn.last_heard_ms = now_ms;
+    if(!txn.responded)
+    {
+        txn.responded = true;
+        txn.response_ms = now_ms;
+        txn.rtt_ms = now_ms - txn.last_tx_ms;
+    }
+    else if(txn.last_response_ms >= txn.last_tx_ms)
+    {
+        // a relay of a response already heard
+        return;
+    }
+    txn.last_response_ms = now_ms;
+
+    txn.ack = pkt.get_is_ack_pkt();
+    txn.nack_reason = txn.ack ? ON_NACK_RSN_NO_ERROR : ack_nack.nack_reason;
+}
+
+
+// Finishes the transactions that have not been heard from for the response
+// timeout as of now_ms.
+void on_transaction_tracker::expire(UInt32 now_ms)
+{
+    map<uint64_t, on_transaction>::iterator it = open_txns.begin();
+    while(it != open_txns.end())
+    {
+        if(now_ms - it->second.last_heard_ms >= response_timeout_ms)
+        {
+            finish_transaction(it->second);
+            open_txns.erase(it++);
+        }
+        else
+        {
+            it++;
+        }
+    }
+}
+
+
+// Finishes every open transaction.  Call at the end of the capture.
+void on_transaction_tracker::finish()
+{
+    map<uint64_t, on_transaction>::iterator it;
+    for(it = open_txns.begin(); it != open_txns.end(); it++)
+    {
+        finish_transaction(it->second);
+    }
+    open_txns.clear();
+}
+
+
+bool on_transaction_tracker::pop_finished(on_transaction& txn)
+{
+    if(finished_txns.empty())
+    {
+        return false;
+    }
+    txn = finished_txns.front();
+    finished_txns.pop_front();
+    return true;
+}
+
+
+const map<uint32_t, on_link_stats>& on_transaction_tracker::get_links() const
+{
+    return links;
+}
+
+
+void on_transaction_tracker::finish_transaction(const on_transaction& txn)
+{
+    on_link_stats& link = links[link_key(txn.raw_src_did, txn.raw_dst_did)];
+
+    link.num_txns++;
+    link.num_retries += txn.num_retries;
+    link.num_relays += txn.num_relays;
+    if(txn.max_hops > link.max_hops)
+    {
+        link.max_hops = txn.max_hops;
+    }
+
+    if(!txn.responded)
+    {
+        link.num_no_response++;
+    }
+    else
+    {
+        UInt32 latency_ms = txn.response_ms - txn.first_tx_ms;
+        if(txn.ack)
+        {
+            link.num_acks++;
+        }
+        else
+        {
+            link.num_nacks++;
+            link.nack_reasons[(int) txn.nack_reason]++;
+        }
+
+        if(link.num_acks + link.num_nacks == 1 ||
+            latency_ms < link.min_latency_ms)
+        {
+            link.min_latency_ms = latency_ms;
+        }
+        if(latency_ms > link.max_latency_ms)
+        {
+            link.max_latency_ms = latency_ms;
+        }
+        link.total_latency_ms += latency_ms;
+        link.total_rtt_ms += txn.rtt_ms;
+    }
+
+    finished_txns.push_back(txn);
+}
+
+
+void on_transaction_tracker::display_transaction(const on_transaction& txn,
+    ostream& outs)
+{
+    std::string src, dst;
+    raw_did_to_string(txn.raw_src_did, src);
+    raw_did_to_string(txn.raw_dst_did, dst);
+
+    outs << dec << txn.first_tx_ms << " ms : " << src << " -> " << dst
+         << " Msg. ID 0x" << hex << uppercase << setfill('0') << setw(3)
+         << txn.msg_id << dec << setfill(' ') << " : ";
+    if(!txn.responded)
+    {
+        outs << "No response";
+    }
+    else
+    {
+        outs << (txn.ack ? "ACK" : "NACK") << " after "
+             << txn.response_ms - txn.first_tx_ms << " ms (RTT "
+             << txn.rtt_ms << " ms)";
+        if(!txn.ack)
+        {
+            outs << " -- " << on_response_payload::get_nack_reason_string(
+                txn.nack_reason);
+        }
+    }
+    outs << " -- Retries : " << (int) txn.num_retries << " -- Relays : "
+         << (int) txn.num_relays << "\n";
+}
+
+
+void on_transaction_tracker::display_links(ostream& outs) const
+{
+    outs << "Src.  Dest. Max Hops   Txns   ACKs  NACKs No Resp. Retries  "
+         << "Latency ms (min/avg/max)  Avg. RTT ms\n";
+
+    map<uint32_t, on_link_stats>::const_iterator it;
+    for(it = links.begin(); it != links.end(); it++)
+    {
+        const on_link_stats& link = it->second;
+        UInt32 num_responses = link.num_acks + link.num_nacks;
+        std::string src, dst;
+        raw_did_to_string(link_src_did(it->first), src);
+        raw_did_to_string(link_dst_did(it->first), dst);
+
+        outs << dec << src << " " << dst << " " << setw(8)
+             << (int) link.max_hops << " " << setw(6) << link.num_txns << " "
+             << setw(6) << link.num_acks << " " << setw(6) << link.num_nacks
+             << " " << setw(8) << link.num_no_response << " " << setw(7)
+             << link.num_retries << "  ";
+        if(num_responses == 0)
+        {
+            outs << setw(24) << "-" << "  " << setw(11) << "-" << "\n";
+        }
+        else
+        {
+            std::ostringstream latency;
+            latency << link.min_latency_ms << "/"
+                    << link.total_latency_ms / num_responses << "/"
+                    << link.max_latency_ms;
+            outs << setw(24) << latency.str() << "  " << setw(11)
+                 << link.total_rtt_ms / num_responses << "\n";
+        }
+
+        map<int, UInt32>::const_iterator rsn;
+        for(rsn = link.nack_reasons.begin(); rsn != link.nack_reasons.end();
+            rsn++)
+        {
+            outs << "    " << on_response_payload::get_nack_reason_string(
+                (on_nack_rsn_t) rsn->first) << " : " << rsn->second << "\n";
+        }
+    }
+}
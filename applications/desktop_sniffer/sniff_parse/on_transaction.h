@@ -0,0 +1,111 @@
+#ifndef ON_TRANSACTION_H
+#define	ON_TRANSACTION_H
+
+
+#include <stdint.h>
+#include <deque>
+#include <map>
+#include <ostream>
+#include "one_net_types.h"
+#include "one_net_acknowledge.h"
+#include "on_packet.h"
+using namespace std;
+
+
+// A single data transaction seen by the sniffer: a data packet and the
+// response to it.  The response comes from the data packet's destination,
+// goes to its source and has the same message ID.  Copies sent by the source
+// again are retries and copies sent by a repeater (hops above 0) are relays.
+struct on_transaction
+{
+    UInt16 raw_src_did;
+    UInt16 raw_dst_did;
+    UInt16 msg_id;
+    UInt16 raw_pid;
+    UInt8 max_hops;
+
+    UInt32 first_tx_ms;   // when the source first sent the data packet
+    UInt32 last_tx_ms;    // when the source last sent it
+    UInt32 last_heard_ms; // the last packet of this transaction, any kind
+    UInt8 num_retries;
+    UInt8 num_relays;
+
+    bool responded;
+    bool ack;
+    on_nack_rsn_t nack_reason;
+    UInt32 response_ms;   // when the first copy of the response was heard
+    UInt32 rtt_ms;        // from the last send before it to the response
+    UInt32 last_response_ms;
+};
+
+
+// The totals for the transactions from one DID to another.  Latency is from
+// the first time the data packet was sent to the response.  The round trip
+// time is from the last time it was sent before the response.
+struct on_link_stats
+{
+    on_link_stats();
+
+    UInt32 num_txns;
+    UInt32 num_acks;
+    UInt32 num_nacks;
+    UInt32 num_no_response;
+    UInt32 num_retries;
+    UInt32 num_relays;
+    UInt8 max_hops;
+
+    UInt32 min_latency_ms;
+    UInt32 max_latency_ms;
+    uint64_t total_latency_ms;
+    uint64_t total_rtt_ms;
+
+    // number of NACKs for each NACK reason
+    map<int, UInt32> nack_reasons;
+};
+
+
+// Pairs the single data packets in a capture with their responses as the
+// packets are read, so it can be run over a live capture.  A transaction is
+// finished once nothing has been heard for it for the response timeout, since
+// a response can be lost on its way back and the data packet sent again.
+// Finished transactions are added into the totals of their link and queued
+// for pop_finished.
+class on_transaction_tracker
+{
+public:
+    static const UInt32 DEFAULT_RESPONSE_TIMEOUT_MS = 3000;
+
+    on_transaction_tracker(UInt32 response_timeout_ms =
+        DEFAULT_RESPONSE_TIMEOUT_MS);
+    void add_packet(const on_packet& pkt);
+    void expire(UInt32 now_ms);
+    void finish();
+    bool pop_finished(on_transaction& txn);
+    const map<uint32_t, on_link_stats>& get_links() const;
+    void display_links(ostream& outs) const;
+    static void display_transaction(const on_transaction& txn, ostream& outs);
+
+    static uint32_t link_key(UInt16 raw_src_did, UInt16 raw_dst_did);
+    static UInt16 link_src_did(uint32_t key);
+    static UInt16 link_dst_did(uint32_t key);
+
+private:
+    static uint64_t txn_key(UInt16 raw_src_did, UInt16 raw_dst_did,
+        UInt16 msg_id);
+    void add_data_packet(const on_packet& pkt, UInt16 msg_id);
+    void add_response_packet(const on_packet& pkt, UInt16 msg_id,
+        const on_ack_nack_t& ack_nack);
+    void finish_transaction(const on_transaction& txn);
+
+    UInt32 response_timeout_ms;
+    UInt32 next_expire_ms;
+
+    // transactions that may still see packets, by source, destination and
+    // message ID
+    map<uint64_t, on_transaction> open_txns;
+    deque<on_transaction> finished_txns;
+    map<uint32_t, on_link_stats> links;
+};
+
+
+#endif	/* ON_TRANSACTION_H */
@@ -0,0 +1,574 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <cstring>
+#include "on_transfer.h"
+#include "one_net_message.h"
+#include "one_net_packet.h"
+#include "one_net_data_rate.h"
+#include "string_utils.h"
+
+
+
+const UInt32 on_transfer_tracker::DEFAULT_IDLE_TIMEOUT_MS;
+const UInt32 on_transfer_tracker::MAX_UNSIZED_PKTS;
+
+
+
+// The names of the statuses a transfer ends with
+static std::string message_status_string(on_message_status_t status)
+{
+    switch(status)
+    {
+        case ON_MSG_ABORT: return "Aborted";
+        case ON_MSG_SUCCESS: return "Success";
+        case ON_MSG_FAIL: return "Failure";
+        case ON_MSG_TIMEOUT: return "Timed Out";
+        case ON_MSG_TERMINATE: return "Terminated";
+        case ON_MSG_INTERNAL_ERR: return "Internal Error";
+        case ON_MSG_ROUTE_UNAVAILABLE: return "Route Unavailable";
+        default: return "";
+    }
+}
+
+
+
+on_transfer::on_transfer()
+{
+    raw_src_did = 0;
+    raw_dst_did = 0;
+    is_stream = false;
+    request_heard = false;
+    transfer_size = 0;
+    chunk_size = 0;
+    frag_delay_ms = 0;
+    chunk_pause_ms = 0;
+    data_rate = 0;
+    start_ms = 0;
+    first_data_ms = 0;
+    last_data_ms = 0;
+    last_heard_ms = 0;
+    num_data_pkts = 0;
+    num_retransmitted = 0;
+    num_relays = 0;
+    num_chunks = 0;
+    byte_idx = 0;
+    elapsed_time = 0;
+    num_air_bytes = 0;
+    terminated = false;
+    status = ON_MSG_STATUS_UNSET;
+    nack_reason = ON_NACK_RSN_NO_ERROR;
+}
+
+
+// The number of data packets in the transfer.  If the size of a block
+// transfer is not known, it is as far as the packets heard go.
+UInt32 on_transfer::get_num_pkts() const
+{
+    if(request_heard && !is_stream)
+    {
+        return (transfer_size + ON_BS_DATA_PLD_SIZE - 1) / ON_BS_DATA_PLD_SIZE;
+    }
+    return pkt_rcvd.size();
+}
+
+
+UInt32 on_transfer::get_num_missing_pkts() const
+{
+    UInt32 num_pkts = get_num_pkts();
+    UInt32 num_missing = 0;
+    for(UInt32 i = 0; i < num_pkts; i++)
+    {
+        if(i >= pkt_rcvd.size() || !pkt_rcvd[i])
+        {
+            num_missing++;
+        }
+    }
+    return num_missing;
+}
+
+
+UInt32 on_transfer::get_data_len() const
+{
+    if(request_heard && !is_stream)
+    {
+        return transfer_size;
+    }
+    return data.size();
+}
+
+
+
+on_transfer_tracker::on_transfer_tracker(UInt32 idle_timeout_ms)
+{
+    this->idle_timeout_ms = idle_timeout_ms;
+    next_expire_ms = 0;
+}
+
+
+uint32_t on_transfer_tracker::transfer_key(UInt16 raw_src_did,
+    UInt16 raw_dst_did)
+{
+    return ((uint32_t) raw_src_did << 16) | raw_dst_did;
+}
+
+
+UInt32 on_transfer_tracker::data_rate_bps(UInt8 data_rate)
+{
+    if(data_rate >= ONE_NET_DATA_RATE_LIMIT)
+    {
+        return 0;
+    }
+
+    // the data rates are all multiples of the base rate
+    return 38400 * (data_rate + 1);
+}
+
+
+// Invalid packets and packets that are not block, stream or block / stream
+// admin packets are ignored.  Packets must be added in the order they were
+// heard.
+void on_transfer_tracker::add_packet(const on_packet& pkt)
+{
+    UInt32 now_ms = pkt.get_timestamp_ms();
+    if(now_ms >= next_expire_ms)
+    {
+        expire(now_ms);
+        next_expire_ms = now_ms + idle_timeout_ms / 2;
+    }
+
+    // the type is in the header, so other packets are never decrypted.
+    // Admin messages are single data packets.
+    if(!pkt.get_is_block_pkt() && !pkt.get_is_stream_pkt() &&
+        !pkt.get_is_single_data_pkt())
+    {
+        return;
+    }
+
+    const on_payload* pld = pkt.get_payload();
+    if(!pkt.get_valid() || !pld)
+    {
+        return;
+    }
+
+    if(pkt.get_is_block_pkt())
+    {
+        const on_block_payload* block =
+            dynamic_cast<const on_block_payload*>(pld);
+        if(block)
+        {
+            add_block_packet(pkt, block->get_block_pkt());
+        }
+    }
+    else if(pkt.get_is_stream_pkt())
+    {
+        const on_stream_payload* stream =
+            dynamic_cast<const on_stream_payload*>(pld);
+        if(stream)
+        {
+            add_stream_packet(pkt, stream->get_stream_pkt());
+        }
+    }
+    else if(pkt.get_is_admin_pkt())
+    {
+        const on_admin_payload* admin =
+            dynamic_cast<const on_admin_payload*>(pld);
+        if(admin)
+        {
+            add_admin_packet(pkt, *admin);
+        }
+    }
+}
+
+
+// Gets the open transfer a data packet belongs to, starting one if there is
+// none.
+on_transfer& on_transfer_tracker::get_transfer(const on_packet& pkt,
+    bool is_stream)
+{
+    uint32_t key = transfer_key(pkt.get_raw_src_did(), pkt.get_raw_dst_did());
+    map<uint32_t, on_transfer>::iterator it = open_transfers.find(key);
+    if(it != open_transfers.end())
+    {
+        return it->second;
+    }
+
+    // the request was not heard
+    on_transfer& transfer = open_transfers[key];
+    transfer.raw_src_did = pkt.get_raw_src_did();
+    transfer.raw_dst_did = pkt.get_raw_dst_did();
+    transfer.is_stream = is_stream;
+    transfer.start_ms = pkt.get_timestamp_ms();
+    return transfer;
+}
+
+
+void on_transfer_tracker::add_admin_packet(const on_packet& pkt,
+    const on_admin_payload& admin)
+{
+    UInt32 now_ms = pkt.get_timestamp_ms();
+
+    if(admin.get_admin_type() == ON_REQUEST_BLOCK_STREAM)
+    {
+        const bs_transfer_request_t& request =
+            admin.get_bs_transfer_request();
+        uint32_t key = transfer_key(pkt.get_raw_src_did(),
+            request.raw_dst_did);
+        map<uint32_t, on_transfer>::iterator it = open_transfers.find(key);
+
+        if(it != open_transfers.end() && (it->second.num_data_pkts ||
+            it->second.num_relays))
+        {
+            // a new transfer between the same devices
+            finish_transfer(key);
+            it = open_transfers.end();
+        }
+
+        // If the request is sent again, start from the last copy.
+        on_transfer& transfer = open_transfers[key];
+        transfer = on_transfer();
+        transfer.raw_src_did = pkt.get_raw_src_did();
+        transfer.raw_dst_did = request.raw_dst_did;
+        transfer.is_stream = (get_bs_transfer_type(request.bs_flags) ==
+            ON_STREAM_TRANSFER);
+        transfer.request_heard = true;
+        transfer.transfer_size = request.transfer_size;
+        transfer.chunk_size = request.chunk_size;
+        transfer.frag_delay_ms = request.frag_delay_ms;
+        transfer.chunk_pause_ms = request.chunk_pause_ms;
+        transfer.data_rate = request.data_rate;
+        transfer.start_ms = now_ms;
+        transfer.last_heard_ms = now_ms;
+    }
+    else if(admin.get_admin_type() == ON_TERMINATE_BLOCK_STREAM)
+    {
+        // either end may terminate the transfer
+        const terminate_block_stream_t& terminate =
+            admin.get_terminate_block_stream();
+        uint32_t key = transfer_key(pkt.get_raw_src_did(),
+            pkt.get_raw_dst_did());
+        map<uint32_t, on_transfer>::iterator it = open_transfers.find(key);
+        if(it == open_transfers.end())
+        {
+            key = transfer_key(pkt.get_raw_dst_did(), pkt.get_raw_src_did());
+            it = open_transfers.find(key);
+        }
+        if(it == open_transfers.end())
+        {
+            return;
+        }
+
+        it->second.terminated = true;
+        it->second.status = terminate.status;
+        it->second.nack_reason = terminate.response_ack_nack.nack_reason;
+        it->second.last_heard_ms = now_ms;
+        finish_transfer(key);
+    }
+}
+
+
+void on_transfer_tracker::add_block_packet(const on_packet& pkt,
+    const block_pkt_t& block_pkt)
+{
+    on_transfer& transfer = get_transfer(pkt, false);
+    UInt32 now_ms = pkt.get_timestamp_ms();
+    UInt32 pkt_idx = block_pkt.byte_idx + block_pkt.chunk_idx;
+    UInt32 max_pkts = (transfer.request_heard ? transfer.get_num_pkts() :
+        MAX_UNSIZED_PKTS);
+
+    transfer.last_heard_ms = now_ms;
+    if(pkt_idx >= max_pkts)
+    {
+        return;
+    }
+
+    if(pkt.get_hops() > 0)
+    {
+        // The source's copy may have been missed, so keep the data.
+        transfer.num_relays++;
+    }
+    else
+    {
+        if(!transfer.num_data_pkts)
+        {
+            transfer.first_data_ms = now_ms;
+        }
+        if(!transfer.num_data_pkts || block_pkt.byte_idx != transfer.byte_idx)
+        {
+            transfer.num_chunks++;
+            transfer.byte_idx = block_pkt.byte_idx;
+        }
+        transfer.num_data_pkts++;
+        transfer.last_data_ms = now_ms;
+        transfer.num_air_bytes += get_encoded_packet_len(pkt.get_raw_pid(),
+            TRUE);
+        if(pkt_idx < transfer.pkt_rcvd.size() && transfer.pkt_rcvd[pkt_idx])
+        {
+            transfer.num_retransmitted++;
+        }
+    }
+
+    add_data(transfer, pkt_idx, block_pkt.data);
+}
+
+
+void on_transfer_tracker::add_stream_packet(const on_packet& pkt,
+    const stream_pkt_t& stream_pkt)
+{
+    on_transfer& transfer = get_transfer(pkt, true);
+    UInt32 now_ms = pkt.get_timestamp_ms();
+    bool copy = (!transfer.pkt_rcvd.empty() &&
+        stream_pkt.elapsed_time == transfer.elapsed_time);
+
+    transfer.last_heard_ms = now_ms;
+    if(pkt.get_hops() > 0)
+    {
+        transfer.num_relays++;
+    }
+    else
+    {
+        if(!transfer.num_data_pkts)
+        {
+            transfer.first_data_ms = now_ms;
+        }
+        transfer.num_data_pkts++;
+        transfer.last_data_ms = now_ms;
+        transfer.num_air_bytes += get_encoded_packet_len(pkt.get_raw_pid(),
+            TRUE);
+        if(copy)
+        {
+            transfer.num_retransmitted++;
+        }
+    }
+
+    if(!copy && transfer.pkt_rcvd.size() < MAX_UNSIZED_PKTS)
+    {
+        transfer.elapsed_time = stream_pkt.elapsed_time;
+        add_data(transfer, transfer.pkt_rcvd.size(), stream_pkt.data);
+    }
+}
+
+
+void on_transfer_tracker::add_data(on_transfer& transfer, UInt32 pkt_idx,
+    const UInt8* data)
+{
+    if(pkt_idx >= transfer.pkt_rcvd.size())
+    {
+        transfer.pkt_rcvd.resize(pkt_idx + 1, false);
+        transfer.data.resize((pkt_idx + 1) * ON_BS_DATA_PLD_SIZE, 0);
+    }
+    if(!transfer.pkt_rcvd[pkt_idx])
+    {
+        transfer.pkt_rcvd[pkt_idx] = true;
+        memcpy(&transfer.data[pkt_idx * ON_BS_DATA_PLD_SIZE], data,
+            ON_BS_DATA_PLD_SIZE);
+    }
+}
+
+
+// Finishes the transfers that have not been heard from for the idle timeout
+// as of now_ms.
+void on_transfer_tracker::expire(UInt32 now_ms)
+{
+    map<uint32_t, on_transfer>::iterator it = open_transfers.begin();
+    while(it != open_transfers.end())
+    {
+        uint32_t key = it->first;
+        bool idle = (now_ms - it->second.last_heard_ms >= idle_timeout_ms);
+        it++;
+        if(idle)
+        {
+            finish_transfer(key);
+        }
+    }
+}
+
+
+// Finishes every open transfer.  Call at the end of the capture.
+void on_transfer_tracker::finish()
+{
+    while(!open_transfers.empty())
+    {
+        finish_transfer(open_transfers.begin()->first);
+    }
+}
+
+
+bool on_transfer_tracker::pop_finished(on_transfer& transfer)
+{
+    if(finished_transfers.empty())
+    {
+        return false;
+    }
+    transfer = finished_transfers.front();
+    finished_transfers.pop_front();
+    return true;
+}
+
+
+void on_transfer_tracker::finish_transfer(uint32_t key)
+{
+    map<uint32_t, on_transfer>::iterator it = open_transfers.find(key);
+    if(it == open_transfers.end())
+    {
+        return;
+    }
+
+    // The data of a block transfer of known size is cut to that size.  The
+    // data of the last packet of any other transfer may be padding.
+    on_transfer& transfer = it->second;
+    if(transfer.request_heard && !transfer.is_stream)
+    {
+        transfer.data.resize(transfer.transfer_size, 0);
+    }
+
+    finished_transfers.push_back(transfer);
+    open_transfers.erase(it);
+}
+
+
+// Writes the data of a transfer to a file.  Packets that were not heard are
+// written as 0s.
+bool on_transfer_tracker::write_data(const on_transfer& transfer,
+    const std::string& filename)
+{
+    ofstream file(filename.c_str(), ios::out | ios::binary);
+    if(!file.good())
+    {
+        return false;
+    }
+    if(!transfer.data.empty())
+    {
+        file.write((const char*) &transfer.data[0], transfer.data.size());
+    }
+    return file.good();
+}
+
+
+void on_transfer_tracker::display_transfer(const on_transfer& transfer,
+    ostream& outs)
+{
+    std::string src, dst;
+    raw_did_to_string(transfer.raw_src_did, src);
+    raw_did_to_string(transfer.raw_dst_did, dst);
+
+    UInt32 num_pkts = transfer.get_num_pkts();
+    UInt32 num_missing = transfer.get_num_missing_pkts();
+    UInt32 data_len = transfer.get_data_len();
+    UInt32 rcvd_len = (num_pkts - num_missing) * ON_BS_DATA_PLD_SIZE;
+    if(rcvd_len > data_len)
+    {
+        rcvd_len = data_len;
+    }
+
+    outs << dec << transfer.start_ms << " ms : "
+         << (transfer.is_stream ? "Stream " : "Block ") << src << " -> "
+         << dst << " : " << rcvd_len << " of " << data_len << " bytes";
+    if(!transfer.request_heard)
+    {
+        outs << " (request not heard)";
+    }
+    outs << "\n";
+
+    // throughput over the whole transfer and over just the data packets
+    UInt32 total_ms = transfer.last_heard_ms - transfer.start_ms;
+    UInt32 data_ms = transfer.last_data_ms - transfer.first_data_ms;
+    outs << "  Time : " << total_ms << " ms (data " << data_ms << " ms)";
+    if(total_ms)
+    {
+        outs << " -- Throughput : " << (uint64_t) rcvd_len * 1000 / total_ms
+             << " bytes/s";
+    }
+    if(data_ms)
+    {
+        outs << " (data " << (uint64_t) rcvd_len * 1000 / data_ms
+             << " bytes/s)";
+    }
+    outs << "\n";
+
+    outs << "  Packets : " << transfer.num_data_pkts << " -- Retransmitted : "
+         << transfer.num_retransmitted << " -- Relays : "
+         << transfer.num_relays;
+    if(!transfer.is_stream)
+    {
+        outs << " -- Chunks : " << transfer.num_chunks << " -- Missing : "
+             << num_missing << " of " << num_pkts;
+    }
+    outs << "\n";
+
+    if(transfer.request_heard)
+    {
+        UInt32 bps = data_rate_bps(transfer.data_rate);
+        outs << "  Requested : Frag. Delay " << transfer.frag_delay_ms
+             << " ms -- ";
+        if(!transfer.is_stream)
+        {
+            // the rest of the request is not used for streams
+            outs << "Chunk Size " << (int) transfer.chunk_size << " -- "
+                 << "Chunk Pause " << transfer.chunk_pause_ms << " ms -- ";
+        }
+        outs << "Data Rate " << bps;
+
+        // How much of the time the data packets kept the air busy.  Low
+        // means the time goes to delays, pauses and responses.  The data
+        // time runs to the start of the last packet, so add one packet.
+        if(bps && transfer.num_data_pkts)
+        {
+            uint64_t air_us = (uint64_t) transfer.num_air_bytes * 8 *
+                1000000 / bps;
+            uint64_t span_us = (uint64_t) data_ms * 1000 + air_us /
+                transfer.num_data_pkts;
+            outs << " -- Air Time : " << air_us / 1000 << " ms ("
+                 << air_us * 100 / span_us << "% of data time)";
+        }
+        outs << "\n";
+    }
+
+    if(num_missing)
+    {
+        // the missing packets, as ranges
+        outs << "  Missing Packets :";
+        UInt32 i = 0;
+        while(i < num_pkts)
+        {
+            if(i < transfer.pkt_rcvd.size() && transfer.pkt_rcvd[i])
+            {
+                i++;
+                continue;
+            }
+            UInt32 first = i;
+            while(i < num_pkts && (i >= transfer.pkt_rcvd.size() ||
+                !transfer.pkt_rcvd[i]))
+            {
+                i++;
+            }
+            outs << " " << first;
+            if(i - 1 > first)
+            {
+                outs << "-" << i - 1;
+            }
+        }
+        outs << "\n";
+    }
+
+    outs << "  ";
+    if(transfer.terminated)
+    {
+        outs << "Terminated : Status " << (int) transfer.status;
+        std::string status_str = message_status_string(transfer.status);
+        if(status_str.length() > 0)
+        {
+            outs << " (" << status_str << ")";
+        }
+        if(transfer.nack_reason != ON_NACK_RSN_NO_ERROR)
+        {
+            outs << " -- " << on_response_payload::get_nack_reason_string(
+                transfer.nack_reason);
+        }
+    }
+    else
+    {
+        outs << "Not terminated";
+    }
+    outs << "\n";
+}
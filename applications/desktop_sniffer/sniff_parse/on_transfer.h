@@ -0,0 +1,111 @@
+#ifndef ON_TRANSFER_H
+#define	ON_TRANSFER_H
+
+
+#include <stdint.h>
+#include <deque>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "one_net_types.h"
+#include "one_net_acknowledge.h"
+#include "one_net_status_codes.h"
+#include "on_packet.h"
+using namespace std;
+
+
+// A block or stream transfer seen by the sniffer, from the ON_REQUEST_BLOCK_STREAM
+// admin message (if it was heard) to the ON_TERMINATE_BLOCK_STREAM admin
+// message or the last packet.  Block packets are put in place by their byte
+// index (the first packet of the chunk) and chunk index.  Stream packets have
+// no index, so they are appended in the order they were sent, and a packet
+// with the same elapsed time as the last one is taken as a copy of it.
+struct on_transfer
+{
+    on_transfer();
+
+    UInt16 raw_src_did;
+    UInt16 raw_dst_did;
+    bool is_stream;
+
+    // from the request, if it was heard
+    bool request_heard;
+    UInt32 transfer_size;
+    UInt8 chunk_size;
+    UInt16 frag_delay_ms;
+    UInt16 chunk_pause_ms;
+    UInt8 data_rate;
+
+    UInt32 start_ms;      // the request, or the first data packet
+    UInt32 first_data_ms;
+    UInt32 last_data_ms;
+    UInt32 last_heard_ms;
+
+    UInt32 num_data_pkts;  // sent by the source, retransmissions included
+    UInt32 num_retransmitted;
+    UInt32 num_relays;
+    UInt32 num_chunks;
+    UInt32 byte_idx;       // of the last block packet
+    UInt32 elapsed_time;   // of the last stream packet
+    UInt32 num_air_bytes;  // in the data packets sent by the source
+
+    bool terminated;
+    on_message_status_t status;
+    on_nack_rsn_t nack_reason;
+
+    // the data, with one flag for each data packet telling whether it was
+    // heard.  Data that was not heard is left 0.
+    vector<UInt8> data;
+    vector<bool> pkt_rcvd;
+
+    UInt32 get_num_pkts() const;
+    UInt32 get_num_missing_pkts() const;
+    UInt32 get_data_len() const;
+};
+
+
+// Puts block and stream transfers back together as the packets are read, so
+// it can be run over a live capture.  A transfer is finished by its terminate
+// message, by a new request between the same devices or once nothing has been
+// heard for it for the idle timeout.  Finished transfers are queued for
+// pop_finished.
+class on_transfer_tracker
+{
+public:
+    static const UInt32 DEFAULT_IDLE_TIMEOUT_MS = 10000;
+
+    // A transfer of unknown size can take up this many packets.
+    static const UInt32 MAX_UNSIZED_PKTS = 65536;
+
+    on_transfer_tracker(UInt32 idle_timeout_ms = DEFAULT_IDLE_TIMEOUT_MS);
+    void add_packet(const on_packet& pkt);
+    void expire(UInt32 now_ms);
+    void finish();
+    bool pop_finished(on_transfer& transfer);
+    static void display_transfer(const on_transfer& transfer, ostream& outs);
+    static bool write_data(const on_transfer& transfer,
+        const std::string& filename);
+    static UInt32 data_rate_bps(UInt8 data_rate);
+
+private:
+    static uint32_t transfer_key(UInt16 raw_src_did, UInt16 raw_dst_did);
+    on_transfer& get_transfer(const on_packet& pkt, bool is_stream);
+    void add_admin_packet(const on_packet& pkt, const on_admin_payload& admin);
+    void add_block_packet(const on_packet& pkt, const block_pkt_t& block_pkt);
+    void add_stream_packet(const on_packet& pkt,
+        const stream_pkt_t& stream_pkt);
+    static void add_data(on_transfer& transfer, UInt32 pkt_idx,
+        const UInt8* data);
+    void finish_transfer(uint32_t key);
+
+    UInt32 idle_timeout_ms;
+    UInt32 next_expire_ms;
+
+    // transfers in progress by source and destination
+    map<uint32_t, on_transfer> open_transfers;
+    deque<on_transfer> finished_transfers;
+};
+
+
+#endif	/* ON_TRANSFER_H */
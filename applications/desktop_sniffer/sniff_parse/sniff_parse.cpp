@@ -8,6 +8,9 @@
 #include "one_net_types.h"
 #include "one_net.h"
 #include "on_packet.h"
+#include "on_transaction.h"
+#include "on_transfer.h"
+#include "filter.h"
 #include "one_net_packet.h"
 #include "one_net_encode.h"
 using namespace std;
@@ -154,13 +157,153 @@ bool sniffer_file_to_hex_string(FILE* sniffer_file, std::string& packet_hex_stri
 
 void usage()
 {
-    cout << "usage: ./sniff_parse verbosity [valid/invalid/both] filename_of_sniffer_text_file [output_filename]\n";
+    cout << "usage: ./sniff_parse [-t] [-b] [-w prefix] [-s did] [-d did] [-n nid] verbosity [valid/invalid/both] filename_of_sniffer_text_file [output_filename]\n";
+    cout << "  -t : pair single data packets with their responses and list the\n"
+         << "       latency, retries and NACK reasons of each link instead of\n"
+         << "       the packets.  Each transaction is listed too if verbosity is\n"
+         << "       above 0.\n";
+    cout << "  -b : put block and stream transfers back together and list the\n"
+         << "       throughput, retransmitted packets and gaps of each one\n"
+         << "       instead of the packets.\n";
+    cout << "  -w : with -b, write the data of each transfer to\n"
+         << "       prefix_<source>_<destination>_<start ms>.bin.\n";
+    cout << "  -s, -d, -n : only take packets from this source DID, to this\n"
+         << "       destination DID or on this NID (raw, in hex).  Each can be\n"
+         << "       given more than once.  Other packets are not decrypted.\n";
     exit(0);
 }
 
 
+// Lists the transactions that have finished so far
+static void display_finished_transactions(on_transaction_tracker& tracker,
+    UInt8 verbosity, ostream& outs)
+{
+    on_transaction txn;
+    while(tracker.pop_finished(txn))
+    {
+        if(verbosity > 0)
+        {
+            on_transaction_tracker::display_transaction(txn, outs);
+        }
+    }
+}
+
+
+// Lists the block and stream transfers that have finished so far, writing
+// their data to files if there is a prefix for them.
+static void display_finished_transfers(on_transfer_tracker& tracker,
+    const std::string& data_prefix, ostream& outs)
+{
+    on_transfer transfer;
+    while(tracker.pop_finished(transfer))
+    {
+        on_transfer_tracker::display_transfer(transfer, outs);
+        if(data_prefix.length() > 0)
+        {
+            std::string src, dst;
+            raw_did_to_string(transfer.raw_src_did, src);
+            raw_did_to_string(transfer.raw_dst_did, dst);
+            ostringstream filename;
+            filename << data_prefix << "_" << src << "_" << dst << "_"
+                     << transfer.start_ms << ".bin";
+            if(on_transfer_tracker::write_data(transfer, filename.str()))
+            {
+                outs << "  Data written to " << filename.str() << "\n";
+            }
+            else
+            {
+                outs << "  Could not write data to " << filename.str()
+                     << "\n";
+            }
+        }
+        outs << "\n";
+    }
+}
+
+
+// Adds a value given in hex, with or without "0x", to the header filter
+static bool accept_header_value(filter& header_filter, filter::FILTER_TYPE ft,
+    std::string value_str)
+{
+    uint64_t value;
+    if(value_str.length() > 2 && (value_str.substr(0, 2) == "0x" ||
+        value_str.substr(0, 2) == "0X"))
+    {
+        value_str = value_str.substr(2);
+    }
+    if(!string_to_uint64_t(value_str, value, true))
+    {
+        return false;
+    }
+    return header_filter.accept_value(ft, value);
+}
+
+
 int main(int argc, char** argv)
 {
+    bool track_transactions = false;
+    bool track_transfers = false;
+    std::string data_prefix;
+    filter header_filter;
+    bool filter_headers = false;
+
+    // the header has nothing for the match filters to test
+    for(int i = filter::FILTER_MSG_CRC_MATCH; i < filter::FILTER_INVITE_KEYS;
+      i++)
+    {
+        header_filter.set_match_value((filter::FILTER_TYPE) i,
+          filter::WILDCARD);
+    }
+
+    while(argc > 1 && argv[1][0] == '-')
+    {
+        if(strcmp(argv[1], "-t") == 0)
+        {
+            track_transactions = true;
+        }
+        else if(strcmp(argv[1], "-b") == 0)
+        {
+            track_transfers = true;
+        }
+        else if(strcmp(argv[1], "-w") == 0 && argc > 2)
+        {
+            data_prefix = argv[2];
+            argc--;
+            argv++;
+        }
+        else if((strcmp(argv[1], "-s") == 0 || strcmp(argv[1], "-d") == 0 ||
+          strcmp(argv[1], "-n") == 0) && argc > 2)
+        {
+            filter::FILTER_TYPE ft = filter::FILTER_NID;
+            if(argv[1][1] == 's')
+            {
+                ft = filter::FILTER_SRC_DID;
+            }
+            else if(argv[1][1] == 'd')
+            {
+                ft = filter::FILTER_DST_DID;
+            }
+            if(!accept_header_value(header_filter, ft, argv[2]))
+            {
+                cout << "Could not convert " << argv[2] << " to a hex value.\n";
+                usage();
+            }
+            filter_headers = true;
+            argc--;
+            argv++;
+        }
+        else
+        {
+            usage();
+        }
+        argc--;
+        argv++;
+    }
+    if(data_prefix.length() > 0 && !track_transfers)
+    {
+        usage();
+    }
+
     if(argc != 4 && argc != 5)
     {
         usage();
@@ -223,48 +366,80 @@ int main(int argc, char** argv)
     UInt32 timestamp_ms;
     std::string invite_key = "32323232323232323232323232323232";
     std::string network_key = "000102030405060708090A0B0C0D0E0F";
+    on_transaction_tracker tracker;
+    on_transfer_tracker transfer_tracker;
+    filter_matcher header_matcher(header_filter);
 
     while(!feof(sniffer_file))
     {
         if(sniffer_file_to_hex_string(sniffer_file, packet_hex_string, timestamp_ms))
         {
-            on_packet new_invite_packet(packet_hex_string, invite_key);
-            on_packet new_non_invite_packet(packet_hex_string, network_key);
-            if(new_invite_packet.get_is_invite_pkt())
+            // Nothing is decrypted until it is needed, so the packet is
+            // made with the network key and made again if it turns out to
+            // be an invite.
+            on_packet pkt(packet_hex_string, network_key);
+            if(pkt.get_is_invite_pkt())
             {
-                new_invite_packet.set_timestamp_ms(timestamp_ms);
-
-                if(reject_valid && new_invite_packet.get_valid())
-                {
-                    continue;
-                }
-                if(reject_invalid && !new_invite_packet.get_valid())
+                if(track_transactions || track_transfers)
                 {
                     continue;
                 }
-
-                new_invite_packet.display(verbosity, NULL, argc == 5 ? outs : cout);
-                outs << "\n\n\n\n\n\n";
+                pkt = on_packet(packet_hex_string, invite_key);
             }
-            else
+            pkt.set_timestamp_ms(timestamp_ms);
+
+            if(filter_headers && !pkt.filter_header(header_matcher))
             {
-                new_non_invite_packet.set_timestamp_ms(timestamp_ms);
+                continue;
+            }
 
-                if(reject_valid && new_non_invite_packet.get_valid())
+            if(track_transactions || track_transfers)
+            {
+                if(track_transactions)
                 {
-                    continue;
+                    tracker.add_packet(pkt);
+                    display_finished_transactions(tracker, verbosity,
+                      argc == 5 ? outs : cout);
                 }
-                if(reject_invalid && !new_non_invite_packet.get_valid())
+                if(track_transfers)
                 {
-                    continue;
+                    transfer_tracker.add_packet(pkt);
+                    display_finished_transfers(transfer_tracker,
+                      data_prefix, argc == 5 ? outs : cout);
                 }
+                continue;
+            }
 
-                new_non_invite_packet.display(verbosity, NULL, argc == 5 ? outs : cout);
-                outs << "\n\n\n\n\n\n";
+            if(reject_valid && pkt.get_valid())
+            {
+                continue;
             }
+            if(reject_invalid && !pkt.get_valid())
+            {
+                continue;
+            }
+
+            pkt.display(verbosity, NULL, argc == 5 ? outs : cout);
+            outs << "\n\n\n\n\n\n";
         }
     }
 
+    if(track_transactions)
+    {
+        tracker.finish();
+        display_finished_transactions(tracker, verbosity,
+          argc == 5 ? outs : cout);
+        (argc == 5 ? outs : cout) << "\n";
+        tracker.display_links(argc == 5 ? outs : cout);
+    }
+
+    if(track_transfers)
+    {
+        transfer_tracker.finish();
+        display_finished_transfers(transfer_tracker, data_prefix,
+          argc == 5 ? outs : cout);
+    }
+
     if(argc == 5)
     {
         outs.close();
@@ -0,0 +1,296 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "one_net_types.h"
+#include "one_net_xtea.h"
+#include "sys/time.h"
+using namespace std;
+
+
+// Differential check of the batch cipher (one_net_xtea_encipher_blocks /
+// one_net_xtea_decipher_blocks and the *_multi_key versions, which use SIMD
+// when XTEA_SIMD is defined) against one_net_xtea_encipher /
+// one_net_xtea_decipher one block at a time, then timing of each.  Random
+// data and keys are used, with 8 and 32 rounds and with every number of
+// blocks up to 40 so that whole and partial SIMD groups are both covered.
+
+
+void usage()
+{
+    cout << "Usage: ./xtea_bench ---> Checks and benchmarks enciphering / deciphering of 64 blocks\n";
+    cout << "Usage: ./xtea_bench 1000 10000 ---> Checks and benchmarks enciphering / deciphering\n"
+            "       of 1000 blocks 10000 times\n";
+}
+
+
+static double elapsed_seconds(const struct timeval& start,
+  const struct timeval& end)
+{
+    return (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+}
+
+
+static void random_bytes(UInt8* bytes, size_t len)
+{
+    for(size_t i = 0; i < len; i++)
+    {
+        bytes[i] = (UInt8) rand();
+    }
+}
+
+
+#ifdef XTEA_KEY_SCHEDULE
+// keys tried for each number of blocks
+static const int NUM_KEYS = 8;
+
+
+// Runs the reference over data one block at a time, block i with keys[i].
+static void cipher_reference(bool encipher, const UInt8* rounds,
+  const one_net_xtea_key_t* const* keys, UInt8* data, int num_blocks)
+{
+    for(int i = 0; i < num_blocks; i++)
+    {
+        if(encipher)
+        {
+            one_net_xtea_encipher(rounds[i], &data[i * ONE_NET_XTEA_BLOCK_SIZE],
+              keys[i]);
+        }
+        else
+        {
+            one_net_xtea_decipher(rounds[i], &data[i * ONE_NET_XTEA_BLOCK_SIZE],
+              keys[i]);
+        }
+    }
+}
+
+
+static bool check(int max_blocks)
+{
+    const UInt8 ROUNDS[2] = {8, 32};
+    vector<one_net_xtea_key_t> keys(NUM_KEYS);
+    vector<one_net_xtea_key_schedule_t> schedules(NUM_KEYS);
+    vector<const one_net_xtea_key_t*> block_keys(max_blocks);
+    vector<const one_net_xtea_key_schedule_t*> block_schedules(max_blocks);
+    vector<UInt8> block_rounds(max_blocks);
+    vector<UInt8> plain(max_blocks * ONE_NET_XTEA_BLOCK_SIZE);
+    vector<UInt8> ref(plain.size()), data(plain.size());
+
+    for(int num_blocks = 1; num_blocks <= max_blocks; num_blocks++)
+    {
+        size_t len = num_blocks * ONE_NET_XTEA_BLOCK_SIZE;
+        for(int r = 0; r < 2; r++)
+        {
+            for(int k = 0; k < NUM_KEYS; k++)
+            {
+                random_bytes(keys[k], ONE_NET_XTEA_KEY_LEN);
+                one_net_xtea_key_schedule(&schedules[k], ROUNDS[r], &keys[k]);
+            }
+
+            // the same key for every block
+            for(int k = 0; k < NUM_KEYS; k++)
+            {
+                random_bytes(&plain[0], len);
+                for(int i = 0; i < num_blocks; i++)
+                {
+                    block_keys[i] = &keys[k];
+                    block_rounds[i] = ROUNDS[r];
+                }
+
+                memcpy(&ref[0], &plain[0], len);
+                cipher_reference(true, &block_rounds[0], &block_keys[0],
+                  &ref[0], num_blocks);
+                memcpy(&data[0], &plain[0], len);
+                one_net_xtea_encipher_blocks(&schedules[k], &data[0],
+                  num_blocks);
+                if(memcmp(&data[0], &ref[0], len) != 0)
+                {
+                    cout << "one_net_xtea_encipher_blocks does not match the "
+                      "reference.  Blocks = " << num_blocks << ", rounds = "
+                      << (int) ROUNDS[r] << endl;
+                    return false;
+                }
+
+                cipher_reference(false, &block_rounds[0], &block_keys[0],
+                  &ref[0], num_blocks);
+                one_net_xtea_decipher_blocks(&schedules[k], &data[0],
+                  num_blocks);
+                if(memcmp(&data[0], &ref[0], len) != 0 ||
+                  memcmp(&data[0], &plain[0], len) != 0)
+                {
+                    cout << "one_net_xtea_decipher_blocks does not match the "
+                      "reference.  Blocks = " << num_blocks << ", rounds = "
+                      << (int) ROUNDS[r] << endl;
+                    return false;
+                }
+            }
+
+            // a random key for each block.  Every other pass mixes the
+            // number of rounds too, so the lanes can not always be run
+            // together.
+            for(int pass = 0; pass < 2; pass++)
+            {
+                vector<one_net_xtea_key_schedule_t> other(NUM_KEYS);
+                for(int k = 0; k < NUM_KEYS; k++)
+                {
+                    one_net_xtea_key_schedule(&other[k], ROUNDS[1 - r],
+                      &keys[k]);
+                }
+
+                random_bytes(&plain[0], len);
+                for(int i = 0; i < num_blocks; i++)
+                {
+                    int k = rand() % NUM_KEYS;
+                    bool mixed = (pass == 1 && rand() % 4 == 0);
+                    block_keys[i] = &keys[k];
+                    block_schedules[i] = mixed ? &other[k] : &schedules[k];
+                    block_rounds[i] = block_schedules[i]->rounds;
+                }
+
+                memcpy(&ref[0], &plain[0], len);
+                cipher_reference(true, &block_rounds[0], &block_keys[0],
+                  &ref[0], num_blocks);
+                memcpy(&data[0], &plain[0], len);
+                one_net_xtea_encipher_blocks_multi_key(&block_schedules[0],
+                  &data[0], num_blocks);
+                if(memcmp(&data[0], &ref[0], len) != 0)
+                {
+                    cout << "one_net_xtea_encipher_blocks_multi_key does not "
+                      "match the reference.  Blocks = " << num_blocks <<
+                      ", rounds = " << (int) ROUNDS[r] << endl;
+                    return false;
+                }
+
+                cipher_reference(false, &block_rounds[0], &block_keys[0],
+                  &ref[0], num_blocks);
+                one_net_xtea_decipher_blocks_multi_key(&block_schedules[0],
+                  &data[0], num_blocks);
+                if(memcmp(&data[0], &ref[0], len) != 0 ||
+                  memcmp(&data[0], &plain[0], len) != 0)
+                {
+                    cout << "one_net_xtea_decipher_blocks_multi_key does not "
+                      "match the reference.  Blocks = " << num_blocks <<
+                      ", rounds = " << (int) ROUNDS[r] << endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+#endif
+
+
+static void print_time(const char* name, const struct timeval& start,
+  const struct timeval& end, int num_blocks, int num_runs, UInt8 sink)
+{
+    double seconds = elapsed_seconds(start, end);
+    double mb = (double) num_blocks * ONE_NET_XTEA_BLOCK_SIZE * num_runs /
+      (1024.0 * 1024.0);
+    cout << setw(24) << left << name << right << fixed << setprecision(3) <<
+      setw(10) << seconds << " s" << setw(12) << (seconds > 0 ? mb / seconds :
+      0) << " MB/s  (0x" << hex << (int) sink << dec << ")\n";
+}
+
+
+int main(int argc, char* argv[])
+{
+    int num_blocks = 64;
+    int num_runs = 100000;
+
+    if(argc != 1 && argc != 3)
+    {
+        usage();
+        exit(0);
+    }
+
+    if(argc == 3)
+    {
+        num_blocks = atoi(argv[1]);
+        num_runs = atoi(argv[2]);
+        if(num_blocks < 1 || num_blocks > 0xFFFF || num_runs < 1)
+        {
+            usage();
+            exit(0);
+        }
+    }
+
+    srand(1);
+    #ifdef XTEA_KEY_SCHEDULE
+    if(!check(40))
+    {
+        return 1;
+    }
+    cout << "The XTEA batch cipher matches one_net_xtea_encipher and "
+      "one_net_xtea_decipher.\n";
+    #else
+    cout << "XTEA_KEY_SCHEDULE is not defined, so there is no batch cipher to "
+      "check.\n";
+    #endif
+    cout << num_blocks << " blocks, " << num_runs << " runs, 32 rounds\n";
+
+    one_net_xtea_key_t key;
+    random_bytes(key, ONE_NET_XTEA_KEY_LEN);
+    vector<UInt8> data(num_blocks * ONE_NET_XTEA_BLOCK_SIZE);
+    random_bytes(&data[0], data.size());
+
+    struct timeval start, end;
+    UInt8 sink = 0;
+    gettimeofday(&start, NULL);
+    for(int run = 0; run < num_runs; run++)
+    {
+        for(int i = 0; i < num_blocks; i++)
+        {
+            one_net_xtea_encipher(32, &data[i * ONE_NET_XTEA_BLOCK_SIZE],
+              &key);
+        }
+        sink ^= data[run % data.size()];
+    }
+    gettimeofday(&end, NULL);
+    print_time("one_net_xtea_encipher", start, end, num_blocks, num_runs,
+      sink);
+
+    sink = 0;
+    gettimeofday(&start, NULL);
+    for(int run = 0; run < num_runs; run++)
+    {
+        for(int i = 0; i < num_blocks; i++)
+        {
+            one_net_xtea_decipher(32, &data[i * ONE_NET_XTEA_BLOCK_SIZE],
+              &key);
+        }
+        sink ^= data[run % data.size()];
+    }
+    gettimeofday(&end, NULL);
+    print_time("one_net_xtea_decipher", start, end, num_blocks, num_runs,
+      sink);
+
+    #ifdef XTEA_KEY_SCHEDULE
+    one_net_xtea_key_schedule_t schedule;
+    one_net_xtea_key_schedule(&schedule, 32, &key);
+    sink = 0;
+    gettimeofday(&start, NULL);
+    for(int run = 0; run < num_runs; run++)
+    {
+        one_net_xtea_encipher_blocks(&schedule, &data[0], num_blocks);
+        sink ^= data[run % data.size()];
+    }
+    gettimeofday(&end, NULL);
+    print_time("xtea_encipher_blocks", start, end, num_blocks, num_runs, sink);
+
+    sink = 0;
+    gettimeofday(&start, NULL);
+    for(int run = 0; run < num_runs; run++)
+    {
+        one_net_xtea_decipher_blocks(&schedule, &data[0], num_blocks);
+        sink ^= data[run % data.size()];
+    }
+    gettimeofday(&end, NULL);
+    print_time("xtea_decipher_blocks", start, end, num_blocks, num_runs, sink);
+    #endif
+
+    return 0;
+}
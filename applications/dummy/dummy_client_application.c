@@ -7,6 +7,7 @@
 #include "one_net_constants.h"
 #include "one_net_message.h"
 #include "one_net_acknowledge.h"
+#include "one_net.h"
 #ifdef COMPILE_WO_WARNINGS
 #include "one_net_port_specific.h"
 #endif
@@ -91,7 +92,7 @@ void one_net_client_invite_result(const on_raw_did_t * const RAW_DID,
     #ifdef COMPILE_WO_WARNINGS
     // mess around with the variables doing trivial things to avoid unused
     // variable warnings.
-    if(status != ONS_SUCCESS)
+    if(status != ONS_SUCCESS && RAW_DID)
     {
         UInt8* tmp = (UInt8*) *RAW_DID;
         *tmp = (*RAW_DID)[0];
@@ -200,6 +201,7 @@ on_message_status_t one_net_client_handle_single_pkt(const UInt8* const raw_pld,
   on_msg_hdr_t* const msg_hdr, const on_raw_did_t* const src_did,
   const on_raw_did_t* const repeater_did, on_ack_nack_t* const ack_nack,
   UInt8 hops, UInt8* const max_hops)
+#endif
 {
     #ifdef COMPILE_WO_WARNINGS
     // mess around with the variables doing trivial things to avoid unused
@@ -215,9 +217,11 @@ on_message_status_t one_net_client_handle_single_pkt(const UInt8* const raw_pld,
     }
     #endif
     #endif
-    return ON_MSG_SUCCESS;
+    // Accept everything and let ONE-NET send the ACK.
+    ack_nack->nack_reason = ON_NACK_RSN_NO_ERROR;
+    ack_nack->handle = ON_ACK;
+    return ON_MSG_CONTINUE;
 }
-#endif
 
 
 #ifdef STREAM_MESSAGES_ENABLED
@@ -244,7 +248,7 @@ on_message_status_t one_net_client_handle_stream_pkt(on_txn_t* txn,
         return ON_MSG_INTERNAL_ERR;
     }
     #endif
-    return ON_MSG_SUCCESS;
+    return ON_MSG_ACCEPT_PACKET;
 }
 #endif
 
@@ -273,7 +277,7 @@ on_message_status_t one_net_client_handle_block_pkt(on_txn_t* txn,
         return ON_MSG_INTERNAL_ERR;
     }
     #endif
-    return ON_MSG_SUCCESS;
+    return ON_MSG_ACCEPT_PACKET;
 }
 
 
@@ -301,7 +305,7 @@ on_message_status_t one_net_client_block_chunk_received(
         return ON_MSG_INTERNAL_ERR;
     }
     #endif
-    return ON_MSG_SUCCESS;
+    return ON_MSG_ACCEPT_CHUNK;
 }
 #endif
 
@@ -434,11 +438,15 @@ on_message_status_t one_net_client_handle_ack_nack_response(
 /*!
     \brief Returns a pointer to the invite key to use in for joining a network.
     
+    The dummy has no key of its own.  Until it joins, the CLIENT keeps the key
+    it was told to look for invites with (one_net_client_look_for_invite) as
+    its current key, so that one is used.
+    
     \return A pointer to the invite key to use.
 */
 one_net_xtea_key_t* one_net_client_get_invite_key(void)
 {
-    return NULL;
+    return &(on_base_param->current_key);
 }
 
 
@@ -127,6 +127,7 @@ on_message_status_t one_net_master_handle_single_pkt(const UInt8* const raw_pld,
   on_msg_hdr_t* const msg_hdr, const on_raw_did_t* const src_did,
   const on_raw_did_t* const repeater_did, on_ack_nack_t* const ack_nack,
   UInt8 hops, UInt8* const max_hops)
+#endif
 {
     #ifdef COMPILE_WO_WARNINGS
     // mess around with the variables doing trivial things to avoid unused
@@ -142,9 +143,11 @@ on_message_status_t one_net_master_handle_single_pkt(const UInt8* const raw_pld,
     }
     #endif
     #endif
-    return ON_MSG_SUCCESS;
+    // Accept everything and let ONE-NET send the ACK.
+    ack_nack->nack_reason = ON_NACK_RSN_NO_ERROR;
+    ack_nack->handle = ON_ACK;
+    return ON_MSG_CONTINUE;
 }
-#endif
 
 
 #ifdef STREAM_MESSAGES_ENABLED
@@ -171,7 +174,7 @@ on_message_status_t one_net_master_handle_stream_pkt(on_txn_t* txn,
         return ON_MSG_INTERNAL_ERR;
     }
     #endif
-    return ON_MSG_SUCCESS;
+    return ON_MSG_ACCEPT_PACKET;
 }
 #endif
 
@@ -200,7 +203,7 @@ on_message_status_t one_net_master_handle_block_pkt(on_txn_t* txn,
         return ON_MSG_INTERNAL_ERR;
     }
     #endif
-    return ON_MSG_SUCCESS;
+    return ON_MSG_ACCEPT_PACKET;
 }
 
 
@@ -228,7 +231,7 @@ on_message_status_t one_net_master_block_chunk_received(
         return ON_MSG_INTERNAL_ERR;
     }
     #endif
-    return ON_MSG_SUCCESS;
+    return ON_MSG_ACCEPT_CHUNK;
 }
 #endif
 
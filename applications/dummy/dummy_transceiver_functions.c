@@ -4,6 +4,7 @@
 #include "one_net_types.h"
 #include "one_net_features.h"
 #include "one_net_status_codes.h"
+#include "one_net_context.h"
 
 
 
@@ -16,10 +17,10 @@ June 3, 2012 -- Currently these functions have not been thoroughly tested.
 
 
 //! The current ONE-NET channel
-UInt8 current_channel = 0;
+ONE_NET_DEVICE_STATE UInt8 current_channel = 0;
 
 //! The current data rate
-UInt8 current_data_rate = ONE_NET_DATA_RATE_38_4;
+ONE_NET_DEVICE_STATE UInt8 current_data_rate = ONE_NET_DATA_RATE_38_4;
 
 
 
@@ -48,6 +48,7 @@
 #include "tick.h"
 #include "one_net_prand.h"
 #include "one_net_crc.h"
+#include "one_net_context.h"
 
 
 //==============================================================================
@@ -80,6 +81,33 @@ enum
 };
 
 
+#if SINGLE_QUEUE_LEVEL > NO_SINGLE_QUEUE_LEVEL
+//! The heaps the single data queue is scheduled with.  Each queued message is
+//! in the heap for its priority, ordered by send time then by the order it
+//! was pushed.  Messages that expire are also in the expire heap, ordered by
+//! expire time.
+enum
+{
+    ON_QUEUE_HIGH_HEAP,             //!< HIGH priority messages
+    ON_QUEUE_LOW_HEAP,              //!< all other messages
+    #if SINGLE_QUEUE_LEVEL > MED_SINGLE_QUEUE_LEVEL
+    ON_QUEUE_EXPIRE_HEAP,           //!< messages with an expire time
+    #endif
+    ON_QUEUE_NUM_HEAPS
+};
+
+
+enum
+{
+    //! No queue slot (end of a list, or not in a heap)
+    ON_QUEUE_NONE = 0xFFFF,
+
+    //! queue_slot_heap value for a slot that is not holding a message
+    ON_QUEUE_SLOT_FREE = 0xFF
+};
+#endif
+
+
 //! @} ONE-NET_MESSAGE_typedefs
 //                                  TYPEDEFS END
 //==============================================================================
@@ -92,6 +120,14 @@ enum
 //! \ingroup ONE-NET_MESSAGE
 //! @{
 
+#if SINGLE_QUEUE_LEVEL > NO_SINGLE_QUEUE_LEVEL
+static BOOL queue_before(UInt8 heap, UInt16 slot_a, UInt16 slot_b);
+static void queue_heap_place(UInt8 heap, UInt16 pos, UInt16 slot);
+static void queue_heap_sift(UInt8 heap, UInt16 pos);
+static void queue_heap_push(UInt8 heap, UInt16 slot);
+static void queue_heap_remove(UInt8 heap, UInt16 slot);
+static void compact_payload_buffer(void);
+#endif
 #if SINGLE_QUEUE_LEVEL > MED_SINGLE_QUEUE_LEVEL
 static void delete_expired_queue_elements(void);
 #endif
@@ -109,12 +145,49 @@ static void delete_expired_queue_elements(void);
 
 
 #if SINGLE_QUEUE_LEVEL > NO_SINGLE_QUEUE_LEVEL
-static UInt8 payload_buffer[SINGLE_DATA_QUEUE_PAYLOAD_BUFFER_SIZE];
-static on_single_data_queue_t single_data_queue[SINGLE_DATA_QUEUE_SIZE];
-static UInt16 pld_buffer_tail_idx = 0;
+static ONE_NET_DEVICE_STATE UInt8 payload_buffer[SINGLE_DATA_QUEUE_PAYLOAD_BUFFER_SIZE];
+
+//! The queued messages.  A message stays in the same slot until it is popped,
+//! and the slot number is the index handed out by
+//! single_data_queue_ready_to_send.
+static ONE_NET_DEVICE_STATE on_single_data_queue_t single_data_queue[SINGLE_DATA_QUEUE_SIZE];
+
+//! Index in payload_buffer just past the payload of the last message pushed
+static ONE_NET_DEVICE_STATE UInt16 pld_buffer_tail_idx = 0;
+
+//! The number of payload_buffer bytes the queued messages are using
+static ONE_NET_DEVICE_STATE UInt16 pld_buffer_bytes_used = 0;
+
+//! The heaps of queue slots (see ON_QUEUE_HIGH_HEAP)
+static ONE_NET_DEVICE_STATE UInt16 queue_heap[ON_QUEUE_NUM_HEAPS][SINGLE_DATA_QUEUE_SIZE];
+
+//! The number of slots in each heap
+static ONE_NET_DEVICE_STATE UInt16 queue_heap_size[ON_QUEUE_NUM_HEAPS];
+
+//! Where each slot is in each heap, ON_QUEUE_NONE if it is not in the heap
+static ONE_NET_DEVICE_STATE UInt16 queue_heap_pos[ON_QUEUE_NUM_HEAPS][SINGLE_DATA_QUEUE_SIZE];
+
+//! Which priority heap each slot is in, ON_QUEUE_SLOT_FREE if it is empty
+static ONE_NET_DEVICE_STATE UInt8 queue_slot_heap[SINGLE_DATA_QUEUE_SIZE];
+
+//! Orders the messages that have the same send time, oldest first
+static ONE_NET_DEVICE_STATE UInt32 queue_seq[SINGLE_DATA_QUEUE_SIZE];
+static ONE_NET_DEVICE_STATE UInt32 next_queue_seq = 0;
+
+//! The queued messages in the order their payloads are in payload_buffer
+static ONE_NET_DEVICE_STATE UInt16 queue_next[SINGLE_DATA_QUEUE_SIZE];
+static ONE_NET_DEVICE_STATE UInt16 queue_prev[SINGLE_DATA_QUEUE_SIZE];
+static ONE_NET_DEVICE_STATE UInt16 queue_first = ON_QUEUE_NONE;
+static ONE_NET_DEVICE_STATE UInt16 queue_last = ON_QUEUE_NONE;
+
+//! Slots that have been used and freed, and the number of slots ever used.
+//! A free slot is taken from queue_free first.
+static ONE_NET_DEVICE_STATE UInt16 queue_free[SINGLE_DATA_QUEUE_SIZE];
+static ONE_NET_DEVICE_STATE UInt16 queue_free_count = 0;
+static ONE_NET_DEVICE_STATE UInt16 queue_slots_touched = 0;
 #endif
 
-UInt8 single_data_queue_size = 0;
+ONE_NET_DEVICE_STATE UInt16 single_data_queue_size = 0;
 
 #ifdef ONE_NET_CLIENT
 extern BOOL device_is_master;
@@ -124,12 +197,12 @@ extern on_master_t * const master;
 
 
 //! The list of recipients to send to for THIS message
-on_recipient_list_t recipient_send_list;
+ONE_NET_DEVICE_STATE on_recipient_list_t recipient_send_list;
 
 //! Pointer to the list of recipients to send to for THIS message.  Generally
 //! will point either to NULL or recipient_send_list.  However, the user is
 //! allowed to provide their own recipient lists to override this list
-on_recipient_list_t* recipient_send_list_ptr = NULL;
+ONE_NET_DEVICE_STATE on_recipient_list_t* recipient_send_list_ptr = NULL;
 
 
 //! @} ONE-NET_MESSAGE_pri_var
@@ -146,7 +219,7 @@ on_recipient_list_t* recipient_send_list_ptr = NULL;
 #ifdef ONE_NET_CLIENT
 //! If true and sending a single response, this flag signifies that we
 // should instead send our features.
-BOOL features_override = FALSE;
+ONE_NET_DEVICE_STATE BOOL features_override = FALSE;
 #endif
 
 //! @} ONE-NET_MESSAGE_pub_var
@@ -945,6 +1018,19 @@ one_net_status_t on_encrypt(UInt8 * const data,
 
     if(rounds)
     {
+        #ifdef XTEA_KEY_SCHEDULE
+        one_net_xtea_key_schedule_t schedule;
+
+        if(!one_net_xtea_key_schedule(&schedule, rounds, KEY))
+        {
+            return ONS_INTERNAL_ERR;
+        } // if the key could not be expanded //
+
+        // -1 since we're not enciphering the byte that has the 2 bits for
+        // the encryption type used.
+        one_net_xtea_encipher_blocks(&schedule, data,
+          (payload_len - 1) / ONE_NET_XTEA_BLOCK_SIZE);
+        #else
         UInt8 i;
 
         // -1 since we're not enciphering the byte that has the 2 bits for
@@ -953,6 +1039,7 @@ one_net_status_t on_encrypt(UInt8 * const data,
         {
             one_net_xtea_encipher(rounds, &(data[i]), KEY);
         } // process 8 bytes at a time //
+        #endif
     } // if  rounds //
 
     return ONS_SUCCESS;
@@ -1045,6 +1132,19 @@ one_net_status_t on_decrypt(UInt8 * const data,
    
     if(rounds)
     {
+        #ifdef XTEA_KEY_SCHEDULE
+        one_net_xtea_key_schedule_t schedule;
+
+        if(!one_net_xtea_key_schedule(&schedule, rounds, KEY))
+        {
+            return ONS_INTERNAL_ERR;
+        } // if the key could not be expanded //
+
+        // -1 since we're not enciphering the byte that has the 2 bits for
+        // the encryption type used.
+        one_net_xtea_decipher_blocks(&schedule, data,
+          (payload_len - 1) / ONE_NET_XTEA_BLOCK_SIZE);
+        #else
         UInt8 i;
 
         // -1 since we're not enciphering the byte that has the 2 bits for
@@ -1053,6 +1153,7 @@ one_net_status_t on_decrypt(UInt8 * const data,
         {
             one_net_xtea_decipher(rounds, &(data[i]), KEY);
         } // process 8 bytes at a time //
+        #endif
     } // if  rounds //
 
     return ONS_SUCCESS;
@@ -1075,10 +1176,23 @@ one_net_status_t on_decrypt(UInt8 * const data,
 */
 void empty_queue(void)
 {
+    #if SINGLE_QUEUE_LEVEL > NO_SINGLE_QUEUE_LEVEL
+    UInt8 heap;
+    #endif
+
     single_data_queue_size = 0;
     single_msg_ptr = NULL;
     #if SINGLE_QUEUE_LEVEL > NO_SINGLE_QUEUE_LEVEL
     pld_buffer_tail_idx = 0;
+    pld_buffer_bytes_used = 0;
+    for(heap = 0; heap < ON_QUEUE_NUM_HEAPS; heap++)
+    {
+        queue_heap_size[heap] = 0;
+    }
+    queue_first = ON_QUEUE_NONE;
+    queue_last = ON_QUEUE_NONE;
+    queue_free_count = 0;
+    queue_slots_touched = 0;
     #endif
 }
 
@@ -1124,6 +1238,9 @@ on_single_data_queue_t* push_queue_element(UInt16 raw_pid,
   )
 {
     on_single_data_queue_t* element = NULL;
+    #if SINGLE_QUEUE_LEVEL > NO_SINGLE_QUEUE_LEVEL
+    UInt16 slot;
+    #endif
     
     #if SINGLE_QUEUE_LEVEL > MIN_SINGLE_QUEUE_LEVEL    
     tick_t time_now = get_tick_count();
@@ -1201,13 +1318,21 @@ on_single_data_queue_t* push_queue_element(UInt16 raw_pid,
     {
         return NULL; // no room in queue
     }
-    if((data_len + pld_buffer_tail_idx) >
+    if((data_len + pld_buffer_bytes_used) >
       SINGLE_DATA_QUEUE_PAYLOAD_BUFFER_SIZE)
     {
         return NULL; // no room in queue
     }
+    if((data_len + pld_buffer_tail_idx) >
+      SINGLE_DATA_QUEUE_PAYLOAD_BUFFER_SIZE)
+    {
+        // there is room, but not after the last payload
+        compact_payload_buffer();
+    }
 
-    element = &single_data_queue[single_data_queue_size];
+    slot = queue_free_count ? queue_free[--queue_free_count] :
+      queue_slots_touched++;
+    element = &single_data_queue[slot];
     #else
     if(single_msg_ptr || single_data_queue_size)
     {
@@ -1223,6 +1348,7 @@ on_single_data_queue_t* push_queue_element(UInt16 raw_pid,
     #if SINGLE_QUEUE_LEVEL > NO_SINGLE_QUEUE_LEVEL
     element->payload = &payload_buffer[pld_buffer_tail_idx];
     pld_buffer_tail_idx += data_len;
+    pld_buffer_bytes_used += data_len;
     #else
     element->payload = single_data_raw_pld;
     #endif
@@ -1265,6 +1391,34 @@ on_single_data_queue_t* push_queue_element(UInt16 raw_pid,
 	    element->expire_time = time_now + expire_time_from_now;
     }
     #endif
+
+    #if SINGLE_QUEUE_LEVEL > NO_SINGLE_QUEUE_LEVEL
+    // add it to the end of the payload order and schedule it
+    queue_seq[slot] = next_queue_seq++;
+    queue_next[slot] = ON_QUEUE_NONE;
+    queue_prev[slot] = queue_last;
+    if(queue_last == ON_QUEUE_NONE)
+    {
+        queue_first = slot;
+    }
+    else
+    {
+        queue_next[queue_last] = slot;
+    }
+    queue_last = slot;
+
+    queue_slot_heap[slot] = (priority == ONE_NET_HIGH_PRIORITY) ?
+      ON_QUEUE_HIGH_HEAP : ON_QUEUE_LOW_HEAP;
+    queue_heap_push(queue_slot_heap[slot], slot);
+    #if SINGLE_QUEUE_LEVEL > MED_SINGLE_QUEUE_LEVEL
+    queue_heap_pos[ON_QUEUE_EXPIRE_HEAP][slot] = ON_QUEUE_NONE;
+    if(element->expire_time)
+    {
+        queue_heap_push(ON_QUEUE_EXPIRE_HEAP, slot);
+    }
+    #endif
+    #endif
+
     single_data_queue_size++;
     return element;
 }
@@ -1273,63 +1427,64 @@ on_single_data_queue_t* push_queue_element(UInt16 raw_pid,
 #if SINGLE_QUEUE_LEVEL > NO_SINGLE_QUEUE_LEVEL
 // return true if an element was popped, false otherwise.
 BOOL pop_queue_element(on_single_data_queue_t* const element,
-    UInt8* const buffer, UInt8 index)
+    UInt8* const buffer, UInt16 index)
 #else
 BOOL pop_queue_element(void)
 #endif
 {
     #if SINGLE_QUEUE_LEVEL > NO_SINGLE_QUEUE_LEVEL
-    UInt8 i;
+    on_single_data_queue_t* popped;
 
-    if(index >= single_data_queue_size)
+    if(index >= queue_slots_touched ||
+      queue_slot_heap[index] == ON_QUEUE_SLOT_FREE)
     {
         // index out of range.
         return FALSE;
     }
+    popped = &single_data_queue[index];
     
     // we have a legitimate index.  Pop the element if the caller to the
     // function provided somewhere to store it.
     if(element != NULL && buffer != NULL)
     {
-        one_net_memmove(element, &single_data_queue[index],
-            sizeof(on_single_data_queue_t));
+        one_net_memmove(element, popped, sizeof(on_single_data_queue_t));
         element->payload = buffer;
-        one_net_memmove(element->payload, single_data_queue[index].payload,
-            single_data_queue[index].payload_size);
+        one_net_memmove(element->payload, popped->payload,
+            popped->payload_size);
     }
     
-    // now delete the element
-    
-    // first delete the payload memory it takes in the buffer.
-    // TODO - more range checking.  Unnecessaray if the queue is doing what
-    // it's supposed to
-    if(index < single_data_queue_size - 1)
+    // now delete the element.  Take it out of the heaps and out of the
+    // payload order.  Its payload bytes are left where they are until the
+    // buffer is compacted, unless it was the last one.
+    queue_heap_remove(queue_slot_heap[index], index);
+    #if SINGLE_QUEUE_LEVEL > MED_SINGLE_QUEUE_LEVEL
+    queue_heap_remove(ON_QUEUE_EXPIRE_HEAP, index);
+    #endif
+    queue_slot_heap[index] = ON_QUEUE_SLOT_FREE;
+
+    if(queue_prev[index] == ON_QUEUE_NONE)
     {
-        // we aren't popping the last element
-        UInt16 this_msg_buffer_start_idx = single_data_queue[index].payload -
-            &payload_buffer[0];
-        UInt16 next_msg_buffer_start_idx = this_msg_buffer_start_idx +
-            single_data_queue[index].payload_size;
-        UInt16 bytes_to_move = pld_buffer_tail_idx - next_msg_buffer_start_idx;
-        one_net_memmove(&payload_buffer[this_msg_buffer_start_idx],
-            &payload_buffer[next_msg_buffer_start_idx], bytes_to_move);
-            
-        // payloads have been moved.  Now adjust the payload pointers
-        for(i = index + 1; i < single_data_queue_size; i++)
-        {
-            single_data_queue[i].payload -= single_data_queue[index].payload_size;
-        }
+        queue_first = queue_next[index];
     }
-    
-    // adjust the tail index.
-    pld_buffer_tail_idx -= single_data_queue[index].payload_size;
-    
-    // payload(s) have been adjusted.  Now move the queue elements themselves
-    if(index < single_data_queue_size - 1)
+    else
+    {
+        queue_next[queue_prev[index]] = queue_next[index];
+    }
+
+    if(queue_next[index] == ON_QUEUE_NONE)
+    {
+        queue_last = queue_prev[index];
+        pld_buffer_tail_idx = (queue_last == ON_QUEUE_NONE) ? 0 :
+          (single_data_queue[queue_last].payload - payload_buffer) +
+          single_data_queue[queue_last].payload_size;
+    }
+    else
     {
-        one_net_memmove(&single_data_queue[index], &single_data_queue[index + 1],
-            (single_data_queue_size - index - 1) * sizeof(on_single_data_queue_t));
+        queue_prev[queue_next[index]] = queue_prev[index];
     }
+
+    pld_buffer_bytes_used -= popped->payload_size;
+    queue_free[queue_free_count++] = index;
     
     // finally adjust the queue size
     single_data_queue_size--;
@@ -1354,6 +1509,10 @@ BOOL pop_queue_element(void)
 	be placed into a transaction, it will be placed into the single transaction spot
 	
 	Any unsent packets that have expired will be deleted.
+
+    The HIGH priority message that is due soonest is checked first, then the
+    LOW priority one, so this does not depend on how many messages are
+    queued.
 	
 	\param[out] next_sleep_time The earliest time the queue might have something to pop.
                 If the value is 0 and the function returns -1, then the queue is empty and
@@ -1365,9 +1524,8 @@ BOOL pop_queue_element(void)
 #if SINGLE_QUEUE_LEVEL > MIN_SINGLE_QUEUE_LEVEL
 int single_data_queue_ready_to_send(tick_t* const next_pop_time)
 {
-	int i, j;
+    UInt8 heap;
     tick_t sleep_time;
-	UInt8 priority = ONE_NET_HIGH_PRIORITY;
 	tick_t cur_tick = get_tick_count();
 	*next_pop_time = 0;
         
@@ -1383,33 +1541,29 @@ int single_data_queue_ready_to_send(tick_t* const next_pop_time)
 	// note that send_time equals 0 means send immediately
 
 	
-	// Go through the list and see if any packets are ready.  Try high priority, then low priority.
-	// Note that priority started initialized as HIGH_PRIORITY.  Go through the list twice, once for
-	// each priority.  We'll change priority at the bottom of the outer loop.  If anything is ready
-    // to pop, pop it
-	for(j = 0; j < 2; j++)
+	// The top of each heap is the message due soonest for that priority.  Try
+    // high priority, then low priority.  If anything is ready to pop, pop it
+	for(heap = ON_QUEUE_HIGH_HEAP; heap <= ON_QUEUE_LOW_HEAP; heap++)
 	{
-	    for(i = 0; i < single_data_queue_size; i++)
+        on_single_data_queue_t* next;
+
+        if(queue_heap_size[heap] == 0)
+        {
+            continue;
+        }
+
+        next = &single_data_queue[queue_heap[heap][0]];
+	    if(next->send_time <= cur_tick)
 	    {
-            if(single_data_queue[i].priority != priority)
-            {
-                continue; // wrong priority
-            }
+            // we're ready to pop this element.
+            return queue_heap[heap][0];
+	    }
             
-		    if(single_data_queue[i].send_time <= cur_tick)
-		    {
-                // we're ready to pop this element.
-                return i;
-		    }
-            
-            sleep_time = single_data_queue[i].send_time - cur_tick;
-            if(*next_pop_time == 0 || sleep_time < *next_pop_time)
-            {
-                *next_pop_time = sleep_time;
-            }
-		}
-		 
-		priority = ONE_NET_LOW_PRIORITY;
+        sleep_time = next->send_time - cur_tick;
+        if(*next_pop_time == 0 || sleep_time < *next_pop_time)
+        {
+            *next_pop_time = sleep_time;
+        }
 	}
 	
 	return -1; // nothing ready to pop.
@@ -1422,23 +1576,12 @@ int single_data_queue_ready_to_send(void)
         return -1;
     }
     
-    #if SINGLE_QUEUE_LEVEL == MIN_SINGLE_QUEUE_LEVEL
-    if(single_data_queue[0].priority != ONE_NET_HIGH_PRIORITY)
+    // the oldest HIGH priority message, else the oldest message
+    if(queue_heap_size[ON_QUEUE_HIGH_HEAP])
     {
-        UInt8 i;
-        
-        // go throught the list.  If we have a HIGH priority message, return the index
-        for(i = 1; i < single_data_queue_size; i++)
-        {
-            if(single_data_queue[i].priority == ONE_NET_HIGH_PRIORITY)
-            {
-                return i;
-            }
-        }
+        return queue_heap[ON_QUEUE_HIGH_HEAP][0];
     }
-    #endif
-    
-    return 0;
+    return queue_heap[ON_QUEUE_LOW_HEAP][0];
 }
 #endif
 
@@ -1658,8 +1801,8 @@ on_single_data_queue_t* load_next_recipient(on_single_data_queue_t* msg,
 BOOL device_should_stay_awake(const on_encoded_did_t* const did)
 {
     #if SINGLE_QUEUE_LEVEL > NO_SINGLE_QUEUE_LEVEL
-    UInt8 i;
-    for(i = 0; i < single_data_queue_size; i++)
+    UInt16 i;
+    for(i = queue_first; i != ON_QUEUE_NONE; i = queue_next[i])
     {
         if(on_encoded_did_equal((const on_encoded_did_t* const)
           &(single_data_queue[i].dst_did), (const on_encoded_did_t* const) did))
@@ -1784,6 +1927,26 @@ void block_stream_msg_t_to_admin_msg(UInt8* msg, const block_stream_msg_t*
 
 UInt8 get_current_bs_chunk_size(const block_stream_msg_t* bs_msg)
 {
+    #ifdef BLOCK_SLIDING_WINDOW
+    UInt32 num_packets_total = (bs_msg->bs.block.transfer_size +
+      ON_BS_DATA_PLD_SIZE - 1) / ON_BS_DATA_PLD_SIZE;
+    UInt32 num_packets_left;
+    UInt8 window = bs_msg->bs.block.window;
+    
+    if(!window || window > bs_msg->bs.block.chunk_size)
+    {
+        window = bs_msg->bs.block.chunk_size;
+    }
+    
+    if(bs_msg->bs.block.byte_idx < 0 || !window ||
+      (UInt32) bs_msg->bs.block.byte_idx >= num_packets_total)
+    {
+        return 1;
+    }
+    
+    num_packets_left = num_packets_total - bs_msg->bs.block.byte_idx;
+    return (num_packets_left < window ? (UInt8) num_packets_left : window);
+    #else
     UInt32 num_packets_total = bs_msg->bs.block.transfer_size /
       ON_BS_DATA_PLD_SIZE;
     UInt32 num_packets_left;
@@ -1810,6 +1973,7 @@ UInt8 get_current_bs_chunk_size(const block_stream_msg_t* bs_msg)
     }
     
     return num_packets_left - 40;
+    #endif
 }
 
 
@@ -1876,6 +2040,105 @@ UInt32 block_get_bytes_remaining(UInt32 transfer_size, UInt32 byte_index,
     return (transfer_size < ON_BS_DATA_PLD_SIZE ? transfer_size :
       ON_BS_DATA_PLD_SIZE );
 }
+
+
+#ifdef BLOCK_SLIDING_WINDOW
+/*!
+    \brief Records the packets the receiver reported missing from the window
+
+    The worst report in a window is kept.  Later reports in the same window
+    only describe retransmissions.  A missing report (a timeout) counts as one
+    lost packet.
+
+    \param[in/out] bs_msg The block transfer being sent
+    \param[in] rcvd The receiver's bitmap of the packets it has or NULL if the
+      response timed out
+
+    \return void
+*/
+void block_record_window_loss(block_stream_msg_t* bs_msg, const UInt8 rcvd[5])
+{
+    UInt8 window = get_current_bs_chunk_size(bs_msg);
+    UInt8 lost = 0;
+    UInt8 i;
+    
+    if(!rcvd)
+    {
+        lost = 1;
+    }
+    else
+    {
+        for(i = 0; i < window; i++)
+        {
+            if(!block_get_index_sent(i, rcvd))
+            {
+                lost++;
+            }
+        }
+    }
+    
+    if(lost > bs_msg->bs.block.lost)
+    {
+        bs_msg->bs.block.lost = lost;
+    }
+}
+
+
+/*!
+    \brief Sizes and paces the next window from the loss in the last one
+
+    A clean window doubles the window, up to the negotiated chunk size, and
+    halves the back-off.  A window that lost more than 1 in
+    BLOCK_WINDOW_HEAVY_LOSS packets halves the window and doubles the
+    back-off.  Light loss changes neither since the selective
+    acknowledgement already recovered it cheaply.
+
+    Must be called before byte_idx moves on to the next window.
+
+    \param[in/out] bs_msg The block transfer being sent
+
+    \return void
+*/
+void block_adapt_window(block_stream_msg_t* bs_msg)
+{
+    block_msg_t* block = &(bs_msg->bs.block);
+    UInt8 window = get_current_bs_chunk_size(bs_msg);
+    
+    if(!block->lost)
+    {
+        block->window = (block->window > block->chunk_size / 2) ?
+          block->chunk_size : 2 * block->window;
+        block->backoff /= 2;
+    }
+    else if((UInt16) block->lost * BLOCK_WINDOW_HEAVY_LOSS > window)
+    {
+        block->window = (window > 1) ? window / 2 : 1;
+        block->backoff = (block->backoff ? 2 * block->backoff : 1);
+        if(block->backoff > BLOCK_WINDOW_MAX_BACKOFF)
+        {
+            block->backoff = BLOCK_WINDOW_MAX_BACKOFF;
+        }
+    }
+    
+    block->lost = 0;
+}
+
+
+/*!
+    \brief Returns the delay to use given the current back-off
+
+    \param[in] bs_msg The block transfer being sent
+    \param[in] max_ms The delay at full back-off, in milliseconds.  This is
+      the negotiated fragment delay or chunk pause.
+
+    \return The delay in milliseconds.  0 while no loss is being seen.
+*/
+UInt16 block_paced_delay(const block_stream_msg_t* bs_msg, UInt16 max_ms)
+{
+    return (UInt16) (((UInt32) max_ms * bs_msg->bs.block.backoff) /
+      BLOCK_WINDOW_MAX_BACKOFF);
+}
+#endif
 #endif
 
 
@@ -1893,18 +2156,172 @@ UInt32 block_get_bytes_remaining(UInt32 transfer_size, UInt32 byte_index,
 //! @{
     
     
+#if SINGLE_QUEUE_LEVEL > NO_SINGLE_QUEUE_LEVEL
+/*!
+    \brief Compares two queued messages for a heap.
+
+    \param[in] heap The heap the messages are in.
+    \param[in] slot_a The first message.
+    \param[in] slot_b The second message.
+
+    \return TRUE if slot_a belongs nearer the top of the heap than slot_b.
+            FALSE otherwise.
+*/
+static BOOL queue_before(UInt8 heap, UInt16 slot_a, UInt16 slot_b)
+{
+    #if SINGLE_QUEUE_LEVEL > MED_SINGLE_QUEUE_LEVEL
+    if(heap == ON_QUEUE_EXPIRE_HEAP)
+    {
+        if(single_data_queue[slot_a].expire_time !=
+          single_data_queue[slot_b].expire_time)
+        {
+            return single_data_queue[slot_a].expire_time <
+              single_data_queue[slot_b].expire_time;
+        }
+        return (SInt32)(queue_seq[slot_a] - queue_seq[slot_b]) < 0;
+    }
+    #endif
+
+    #if SINGLE_QUEUE_LEVEL > MIN_SINGLE_QUEUE_LEVEL
+    if(single_data_queue[slot_a].send_time !=
+      single_data_queue[slot_b].send_time)
+    {
+        return single_data_queue[slot_a].send_time <
+          single_data_queue[slot_b].send_time;
+    }
+    #endif
+
+    return (SInt32)(queue_seq[slot_a] - queue_seq[slot_b]) < 0;
+}
+
+
+/*!
+    \brief Puts a slot at a position in a heap.
+
+    \param[in] heap The heap.
+    \param[in] pos The position in the heap.
+    \param[in] slot The slot to put there.
+*/
+static void queue_heap_place(UInt8 heap, UInt16 pos, UInt16 slot)
+{
+    queue_heap[heap][pos] = slot;
+    queue_heap_pos[heap][slot] = pos;
+}
+
+
+/*!
+    \brief Moves the slot at a position in a heap up or down to where it
+      belongs.
+
+    \param[in] heap The heap.
+    \param[in] pos The position of the slot to move.
+*/
+static void queue_heap_sift(UInt8 heap, UInt16 pos)
+{
+    UInt16 slot = queue_heap[heap][pos];
+
+    while(pos > 0 && queue_before(heap, slot, queue_heap[heap][(pos - 1) / 2]))
+    {
+        queue_heap_place(heap, pos, queue_heap[heap][(pos - 1) / 2]);
+        pos = (pos - 1) / 2;
+    }
+
+    while(1)
+    {
+        UInt16 child = 2 * pos + 1;
+
+        if(child >= queue_heap_size[heap])
+        {
+            break;
+        }
+        if(child + 1 < queue_heap_size[heap] && queue_before(heap,
+          queue_heap[heap][child + 1], queue_heap[heap][child]))
+        {
+            child++;
+        }
+        if(!queue_before(heap, queue_heap[heap][child], slot))
+        {
+            break;
+        }
+        queue_heap_place(heap, pos, queue_heap[heap][child]);
+        pos = child;
+    }
+
+    queue_heap_place(heap, pos, slot);
+}
+
+
+/*!
+    \brief Adds a slot to a heap.
+
+    \param[in] heap The heap.
+    \param[in] slot The slot to add.
+*/
+static void queue_heap_push(UInt8 heap, UInt16 slot)
+{
+    queue_heap_place(heap, queue_heap_size[heap]++, slot);
+    queue_heap_sift(heap, queue_heap_size[heap] - 1);
+}
+
+
+/*!
+    \brief Removes a slot from a heap if it is in it.
+
+    \param[in] heap The heap.
+    \param[in] slot The slot to remove.
+*/
+static void queue_heap_remove(UInt8 heap, UInt16 slot)
+{
+    UInt16 pos = queue_heap_pos[heap][slot];
+
+    if(pos >= queue_heap_size[heap] || queue_heap[heap][pos] != slot)
+    {
+        return; // not in the heap
+    }
+
+    queue_heap_pos[heap][slot] = ON_QUEUE_NONE;
+    if(pos != --queue_heap_size[heap])
+    {
+        queue_heap_place(heap, pos, queue_heap[heap][queue_heap_size[heap]]);
+        queue_heap_sift(heap, pos);
+    }
+}
+
+
+/*!
+    \brief Moves the payloads of the queued messages to the front of
+      payload_buffer, closing up the space left by messages that were popped.
+*/
+static void compact_payload_buffer(void)
+{
+    UInt16 i;
+
+    pld_buffer_tail_idx = 0;
+    for(i = queue_first; i != ON_QUEUE_NONE; i = queue_next[i])
+    {
+        one_net_memmove(&payload_buffer[pld_buffer_tail_idx],
+          single_data_queue[i].payload, single_data_queue[i].payload_size);
+        single_data_queue[i].payload = &payload_buffer[pld_buffer_tail_idx];
+        pld_buffer_tail_idx += single_data_queue[i].payload_size;
+    }
+}
+#endif
+
+
 #if SINGLE_QUEUE_LEVEL > MED_SINGLE_QUEUE_LEVEL
+/*!
+    \brief Deletes the queued messages that have expired.
+
+    The message that expires first is at the top of the expire heap, so
+    nothing needs to be looked at unless something has expired.
+*/
 static void delete_expired_queue_elements(void)
 {
-    int i;
     tick_t cur_tick = get_tick_count();
-    for(i = single_data_queue_size - 1; i >= 0 ; i--)
+    while(queue_heap_size[ON_QUEUE_EXPIRE_HEAP] && single_data_queue[
+      queue_heap[ON_QUEUE_EXPIRE_HEAP][0]].expire_time < cur_tick)
     {
-        if(single_data_queue[i].expire_time > 0 &&
-          single_data_queue[i].expire_time < cur_tick)
-        {
-            pop_queue_element(NULL, NULL, i);
-        }
+        pop_queue_element(NULL, NULL, queue_heap[ON_QUEUE_EXPIRE_HEAP][0]);
     }
 }
 #endif    
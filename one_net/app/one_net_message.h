@@ -601,6 +601,16 @@ typedef enum
 
 #define MAX_CHUNK_SIZE 40
 
+#ifdef BLOCK_SLIDING_WINDOW
+//! The most a sliding window transfer will back off.  At this level the full
+//! fragment delay and chunk pause are used.
+#define BLOCK_WINDOW_MAX_BACKOFF 8
+
+//! A window that loses more than 1 in BLOCK_WINDOW_HEAVY_LOSS packets is
+//! shrunk and paced more slowly.
+#define BLOCK_WINDOW_HEAVY_LOSS 4
+#endif
+
 
 enum
 {
@@ -646,6 +656,12 @@ typedef struct
            // bitwise "boolean" array, with each bit representing whether a
            // certain packet within a chunk has been received.  0 means FALSE.
            // 1 means TRUE.
+    #ifdef BLOCK_SLIDING_WINDOW
+    UInt8 window; // packets in the current window.  Never more than
+                  // chunk_size.  Only used by the sender.
+    UInt8 backoff; // pacing in eighths of frag_dly and chunk_pause
+    UInt8 lost; // packets reported missing in the current window
+    #endif
 } block_msg_t;
 
 
@@ -727,7 +743,7 @@ typedef union
 //! \ingroup ONE-NET_MESSAGE
 //! @{
 
-extern UInt8 single_data_queue_size;
+extern UInt16 single_data_queue_size;
 
 
 //! The list of recipients to send to for THIS message
@@ -851,7 +867,7 @@ void empty_queue(void);
 #if SINGLE_QUEUE_LEVEL > NO_SINGLE_QUEUE_LEVEL
 // return true if an element was popped, false otherwise.
 BOOL pop_queue_element(on_single_data_queue_t* const element,
-    UInt8* const buffer, UInt8 index);
+    UInt8* const buffer, UInt16 index);
 #else
 BOOL pop_queue_element(void);
 #endif
@@ -961,8 +977,17 @@ UInt32 block_get_bytes_remaining(UInt32 transfer_size, UInt32 byte_index,
 
 
 // returns the chunk size to be used. For the first and last 40 packets,
-// the chunk size is 1.  Otherwise it is whatever is stored in the message
+// the chunk size is 1.  Otherwise it is whatever is stored in the message.
+// With BLOCK_SLIDING_WINDOW it is the current window, cut short only by the
+// end of the transfer.
 UInt8 get_current_bs_chunk_size(const block_stream_msg_t* bs_msg);
+
+#ifdef BLOCK_SLIDING_WINDOW
+void block_record_window_loss(block_stream_msg_t* bs_msg,
+  const UInt8 rcvd[5]);
+void block_adapt_window(block_stream_msg_t* bs_msg);
+UInt16 block_paced_delay(const block_stream_msg_t* bs_msg, UInt16 max_ms);
+#endif
 #endif
 
 
@@ -62,6 +62,9 @@
 #ifdef PEER
 #include "one_net_peer.h"
 #endif
+#ifdef ADAPTIVE_RESPONSE_TIMEOUT
+#include "one_net_rtt.h"
+#endif
 #include "one_net_timer.h"
 
 
@@ -500,6 +503,44 @@ oncli_status_t oncli_print_peer_list(void)
 #endif
 
 
+#if defined(ENABLE_RTT_COMMAND) && defined(ADAPTIVE_RESPONSE_TIMEOUT)
+/*!
+    \brief Prints the round trip time estimates kept for recent destinations
+    
+    The destinations are printed most recently heard from first.
+        
+    \return ONCLI_SUCCESS upon success, failure message otherwise
+*/
+oncli_status_t oncli_print_rtt_table(void)
+{
+    on_raw_did_t raw_did;
+    const on_rtt_t* entry;
+    UInt8 i;
+      
+    oncli_send_msg(ONCLI_RTT_TABLE_HEADING);
+    
+    for(i = 0; (entry = one_net_rtt_entry(i)) != NULL; i++)
+    {
+        if(on_decode(raw_did, entry->did, ON_RAW_DID_LEN) != ONS_SUCCESS)
+        {
+            return ONCLI_INVALID_DST;
+        }
+        
+        oncli_send_msg(ONCLI_RTT_FMT,
+          did_to_u16((const on_raw_did_t*) &raw_did), entry->hops,
+          entry->srtt >> 3, entry->rttvar >> 2,
+          one_net_rtt_entry_timeout(entry), entry->backoff);
+    }
+    
+    if(i == 0)
+    {
+        oncli_send_msg(ONCLI_RTT_NO_ENTRIES);
+    }
+    return ONCLI_SUCCESS;
+} // oncli_print_rtt_table //
+#endif
+
+
 /*!
     \brief Prints the features / capabilities of a device
     
@@ -164,6 +164,9 @@ oncli_status_t oncli_print_data_rates(on_features_t features);
 #if defined(ENABLE_LIST_COMMAND) && defined(PEER)
 oncli_status_t oncli_print_peer_list(void);
 #endif
+#if defined(ENABLE_RTT_COMMAND) && defined(ADAPTIVE_RESPONSE_TIMEOUT)
+oncli_status_t oncli_print_rtt_table(void);
+#endif
 oncli_status_t oncli_print_features(on_features_t features);
 oncli_status_t oncli_print_channel(UInt8 channel);
 #ifdef BLOCK_MESSAGES_ENABLED
@@ -246,6 +246,10 @@ int memory_len = 0;
 	static oncli_status_t list_cmd_hdlr(void);
 #endif
 
+#ifdef ENABLE_RTT_COMMAND
+	static oncli_status_t rtt_cmd_hdlr(void);
+#endif
+
 #ifdef ENABLE_ERASE_COMMAND
 	static oncli_status_t erase_cmd_hdlr(void);
 #endif
@@ -500,6 +504,20 @@ oncli_status_t oncli_parse_cmd(const char * const CMD, const char ** CMD_STR,
     } // else if the list command was received //
 	#endif
 
+	#ifdef ENABLE_RTT_COMMAND
+    else if(!strncmp(ONCLI_RTT_CMD_STR, CMD, strlen(ONCLI_RTT_CMD_STR)))
+    {
+        *CMD_STR = ONCLI_RTT_CMD_STR;
+
+        if(CMD[strlen(ONCLI_RTT_CMD_STR)] != '\n')
+        {
+            return ONCLI_PARSE_ERR;
+        } // if the end the command is not valid //
+
+        return rtt_cmd_hdlr();
+    } // else if the rtt command was received //
+	#endif
+
 	#ifdef ENABLE_ERASE_COMMAND
     else if(!strncmp(ONCLI_ERASE_CMD_STR, CMD, strlen(ONCLI_ERASE_CMD_STR)))
     {
@@ -1440,20 +1458,12 @@ static oncli_status_t list_cmd_hdlr(void)
     #ifdef ONE_NET_MASTER
     if(device_is_master)
     {
-        UInt16 index = 0;
+        on_client_t* client;
         // print the client list
         i = 0;
         oncli_send_msg("Client count: %d\n", master_param->client_count);
-        while(i < master_param->client_count)
+        while((client = client_in_did_order(i)) != NULL)
         {
-            on_client_t* client = &client_list[index];
-            index++;
-
-            if(is_broadcast_did((const on_encoded_did_t*) client->device.did))
-            {
-                continue;
-            }
-
             oncli_send_msg("\n\n\n  Client %d : ", i + 1);
             oncli_print_did((const on_encoded_did_t*) &(client->device.did));
             oncli_send_msg("\n\n");
@@ -1529,6 +1539,22 @@ static oncli_status_t list_cmd_hdlr(void)
 #endif
 
 
+#ifdef ENABLE_RTT_COMMAND
+/*!
+    \brief Prints the round trip time estimates used to time out single
+    data responses.
+
+    \param void
+
+    \return ONCLI_SUCCESS if the estimates were printed
+*/
+static oncli_status_t rtt_cmd_hdlr(void)
+{
+    return oncli_print_rtt_table();
+} // rtt_cmd_hdlr //
+#endif
+
+
 #ifdef ENABLE_ERASE_COMMAND
 /*!
     \brief Erases the settings from non-volatile memory
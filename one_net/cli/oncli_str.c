@@ -146,6 +146,21 @@ const char * const ONCLI_HIGH_STR = "high";
 #endif
 #endif
 
+#ifdef ENABLE_RTT_COMMAND
+	//! rtt command string
+	const char * const ONCLI_RTT_CMD_STR = "rtt";
+
+	//! Round trip time table heading string.
+	const char * const ONCLI_RTT_TABLE_HEADING =
+	  "Round trip times (ms):\n  DID Hops SRTT RTTVAR Timeout Backoff\n";
+
+	//! Format for printing an entry in the CLI rtt command
+	const char * const ONCLI_RTT_FMT = "  %03X %4u %4u %6u %7u %7u\n";
+
+	//! No destinations measured yet string.
+	const char * const ONCLI_RTT_NO_ENTRIES = "  No round trip times measured.\n";
+#endif
+
 #if defined(SNIFFER_MODE) && defined(ENABLE_SNIFF_COMMAND)
 //! sniff command string
 const char * const ONCLI_SNIFF_CMD_STR = "sniff";
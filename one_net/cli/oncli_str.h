@@ -119,6 +119,13 @@ extern const char * const ONCLI_LIST_NO_PEERS;
 #endif
 #endif
 
+#ifdef ENABLE_RTT_COMMAND
+extern const char * const ONCLI_RTT_CMD_STR;
+extern const char * const ONCLI_RTT_TABLE_HEADING;
+extern const char * const ONCLI_RTT_FMT;
+extern const char * const ONCLI_RTT_NO_ENTRIES;
+#endif
+
 #if defined(SNIFFER_MODE) && defined(ENABLE_SNIFF_COMMAND)
 extern const char * const ONCLI_SNIFF_CMD_STR;
 #endif
@@ -54,9 +54,13 @@
 #include "one_net_prand.h"
 #include "one_net_xtea.h"
 #include "one_net_acknowledge.h"
+#include "one_net_context.h"
 #ifdef PEER
 #include "one_net_peer.h"
 #endif
+#ifdef ADAPTIVE_RESPONSE_TIMEOUT
+#include "one_net_rtt.h"
+#endif
 #include "one_net_port_const.h"
 #ifdef ONE_NET_CLIENT
 #include "one_net_client_port_specific.h"
@@ -108,45 +112,45 @@ const on_encoded_did_t MASTER_ENCODED_DID = {0xB4, 0xBC};
 
 //! Contiguous block of memory to store parameters that are saved to
 //! non-volatile memory.  Parameters will point to locations in the array
-UInt8 nv_param[NV_PARAM_SIZE_BYTES];
+ONE_NET_DEVICE_STATE UInt8 nv_param[NV_PARAM_SIZE_BYTES];
 
 //! The base parameters for the device
 on_base_param_t* const on_base_param = (on_base_param_t* const) nv_param;
 
 
 //! The set of packet handlers
-on_pkt_hdlr_set_t pkt_hdlr;
+ONE_NET_DEVICE_STATE on_pkt_hdlr_set_t pkt_hdlr;
 
 //! a function to retrieve the sender information
-one_net_get_sender_info_func_t get_sender_info;
+ONE_NET_DEVICE_STATE one_net_get_sender_info_func_t get_sender_info;
 
 
 #ifndef ONE_NET_MULTI_HOP
 //! Used to send a response
-on_txn_t response_txn = {ON_RESPONSE, ONE_NET_NO_PRIORITY, 0,
+ONE_NET_DEVICE_STATE on_txn_t response_txn = {ON_RESPONSE, ONE_NET_NO_PRIORITY, 0,
   ONT_RESPONSE_TIMER, 0, 0, NULL, NULL, NULL};
 
 //! Used to send a single message
-on_txn_t single_txn = {ON_SINGLE, ONE_NET_NO_PRIORITY, 0, ONT_SINGLE_TIMER, 0,
-  0, NULL, NULL, NULL};
+ONE_NET_DEVICE_STATE on_txn_t single_txn = {ON_SINGLE, ONE_NET_NO_PRIORITY, 0,
+  ONT_SINGLE_TIMER, 0, 0, NULL, NULL, NULL};
 
 #ifdef BLOCK_MESSAGES_ENABLED
     //! The current block transaction
-    on_txn_t bs_txn = {ON_BLOCK, ONE_NET_NO_PRIORITY, 0,
+    ONE_NET_DEVICE_STATE on_txn_t bs_txn = {ON_BLOCK, ONE_NET_NO_PRIORITY, 0,
       ONT_BS_TIMER, 0, 0, NULL, NULL, NULL};
 #endif // if block messages are enabled //
 #else
 //! Used to send a response
-on_txn_t response_txn = {ON_RESPONSE, ONE_NET_NO_PRIORITY, 0,
+ONE_NET_DEVICE_STATE on_txn_t response_txn = {ON_RESPONSE, ONE_NET_NO_PRIORITY, 0,
   ONT_RESPONSE_TIMER, 0, 0, NULL, NULL, NULL, 0, 0};
 
 //! Used to send a single message
-on_txn_t single_txn = {ON_SINGLE, ONE_NET_NO_PRIORITY, 0, ONT_SINGLE_TIMER, 0,
-  0, NULL, NULL, NULL, 0, 0};
+ONE_NET_DEVICE_STATE on_txn_t single_txn = {ON_SINGLE, ONE_NET_NO_PRIORITY, 0,
+  ONT_SINGLE_TIMER, 0, 0, NULL, NULL, NULL, 0, 0};
 
 #ifdef BLOCK_MESSAGES_ENABLED
     //! The current block transaction
-    on_txn_t bs_txn = {ON_BLOCK, ONE_NET_NO_PRIORITY, 0,
+    ONE_NET_DEVICE_STATE on_txn_t bs_txn = {ON_BLOCK, ONE_NET_NO_PRIORITY, 0,
       ONT_BS_TIMER, 0, 0, NULL, NULL, NULL, 0, 0};
 #endif // if block messages are enabled //
 #endif
@@ -154,37 +158,37 @@ on_txn_t single_txn = {ON_SINGLE, ONE_NET_NO_PRIORITY, 0, ONT_SINGLE_TIMER, 0,
 
 //! true if device is functioning as a master, false otherwise
 #ifndef ONE_NET_MASTER
-BOOL device_is_master = FALSE;
+ONE_NET_DEVICE_STATE BOOL device_is_master = FALSE;
 #else
-BOOL device_is_master = TRUE; // if device cvan be master OR client, the
-                              // initialization code will need to set this
-                              // value
+ONE_NET_DEVICE_STATE BOOL device_is_master = TRUE; // if device cvan be master
+                              // OR client, the initialization code will need
+                              // to set this value
 #endif
 
 
 
 //! an on_pkt_t structure for data packets
-on_pkt_t data_pkt_ptrs;
+ONE_NET_DEVICE_STATE on_pkt_t data_pkt_ptrs;
 
 //! an on_pkt_t structure for response packets
-on_pkt_t response_pkt_ptrs;
+ONE_NET_DEVICE_STATE on_pkt_t response_pkt_ptrs;
 
 
 //! A place to store a single message with payload.
-on_single_data_queue_t single_msg;
+ONE_NET_DEVICE_STATE on_single_data_queue_t single_msg;
 
 //! A place to store the single message raw payload.
-UInt8 single_data_raw_pld[ONA_MAX_SINGLE_PACKET_PAYLOAD_LEN];
+ONE_NET_DEVICE_STATE UInt8 single_data_raw_pld[ONA_MAX_SINGLE_PACKET_PAYLOAD_LEN];
 
 //! Pointer to the current single message being sent.  If none, this will be
 //! NULL.  Generally this will point to single_msg.
-on_single_data_queue_t* single_msg_ptr = NULL;
+ONE_NET_DEVICE_STATE on_single_data_queue_t* single_msg_ptr = NULL;
 
 
 //! A place to store the raw packet bytes when encrypting, decrypting, etc.
 //! so that it will not have to be declared inside of functions and risk a
 //! overflow.
-UInt8 raw_payload_bytes[ON_MAX_RAW_PLD_LEN + 1];
+ONE_NET_DEVICE_STATE UInt8 raw_payload_bytes[ON_MAX_RAW_PLD_LEN + 1];
 
 #ifdef ONE_NET_CLIENT
 extern BOOL client_joined_network; // declared extern in one_net_client.h but
@@ -195,7 +199,7 @@ extern on_sending_dev_list_item_t sending_dev_list[];
 
 #ifndef ONE_NET_MULTI_HOP
 //! The current invite transaction
-on_txn_t invite_txn = {ON_INVITE, ONE_NET_NO_PRIORITY, 0,
+ONE_NET_DEVICE_STATE on_txn_t invite_txn = {ON_INVITE, ONE_NET_NO_PRIORITY, 0,
 #ifdef ONE_NET_MASTER
   ONT_INVITE_SEND_TIMER, 0, 0, encoded_pkt_bytes, NULL, NULL};
 #else
@@ -203,7 +207,7 @@ on_txn_t invite_txn = {ON_INVITE, ONE_NET_NO_PRIORITY, 0,
 #endif
 #else
 //! The current invite transaction
-on_txn_t invite_txn = {ON_INVITE, ONE_NET_NO_PRIORITY, 0,
+ONE_NET_DEVICE_STATE on_txn_t invite_txn = {ON_INVITE, ONE_NET_NO_PRIORITY, 0,
 #ifdef ONE_NET_MASTER
   ONT_INVITE_SEND_TIMER, 0, 0, encoded_pkt_bytes, NULL, NULL, 0, 0};
 #else
@@ -217,43 +221,43 @@ extern BOOL client_looking_for_invite;
 #endif
 
 //! A buffer containing all encoded bytes for transmitting and receiving
-UInt8 encoded_pkt_bytes[ENCODED_BYTES_BUFFER_LEN];
+ONE_NET_DEVICE_STATE UInt8 encoded_pkt_bytes[ENCODED_BYTES_BUFFER_LEN];
 
 //! The expected source of the next packet.
 //! TODO -- more can be done with this variable.  We need to have a way for
 //!         the application code to override the default.
-on_encoded_did_t expected_src_did; // broadcast
+ONE_NET_DEVICE_STATE on_encoded_did_t expected_src_did; // broadcast
 
 //! Denotes which key was used.  If true, the current key is being used.
-BOOL decrypt_using_current_key;
+ONE_NET_DEVICE_STATE BOOL decrypt_using_current_key;
 
 
 #ifdef NON_VOLATILE_MEMORY
-BOOL save = FALSE;
+ONE_NET_DEVICE_STATE BOOL save = FALSE;
 #endif
 
 #ifdef ROUTE
 //! variable denoting the start of a route message.
-tick_t route_start_time = 0;
+ONE_NET_DEVICE_STATE tick_t route_start_time = 0;
 #endif
 
 #ifdef BLOCK_MESSAGES_ENABLED
-block_stream_msg_t bs_msg;
+ONE_NET_DEVICE_STATE block_stream_msg_t bs_msg;
 #endif
 
 #ifdef DATA_RATE_CHANNEL
-dr_channel_stage_t dr_channel_stage = ON_DR_CHANNEL_NO_SCHEDULED_CHANGE;
-UInt16 dormant_data_rate_time_ms = 0;
-UInt8 alternate_data_rate = ONE_NET_DATA_RATE_38_4;
-UInt8 alternate_channel;
+ONE_NET_DEVICE_STATE dr_channel_stage_t dr_channel_stage = ON_DR_CHANNEL_NO_SCHEDULED_CHANGE;
+ONE_NET_DEVICE_STATE UInt16 dormant_data_rate_time_ms = 0;
+ONE_NET_DEVICE_STATE UInt8 alternate_data_rate = ONE_NET_DATA_RATE_38_4;
+ONE_NET_DEVICE_STATE UInt8 alternate_channel;
 #endif
 
 //! Boolean value denoting whether a key change should occur in the very
 //! near future
-BOOL key_change_requested = FALSE;
+ONE_NET_DEVICE_STATE BOOL key_change_requested = FALSE;
 
 //! Time of the last key change request
-tick_t key_change_request_time = 0;
+ONE_NET_DEVICE_STATE tick_t key_change_request_time = 0;
 
 
 #ifdef ONE_NET_CLIENT
@@ -264,10 +268,10 @@ extern BOOL features_override; // defined in one_net_message.c
 
 #ifdef PID_BLOCK
 //! Stores which PIDs are accepted.
-pid_block_t pid_block_info = {0xFFFF, PID_ACCEPT, PID_ACCEPT};
+ONE_NET_DEVICE_STATE pid_block_t pid_block_info = {0xFFFF, PID_ACCEPT, PID_ACCEPT};
 
 //! If true, filter pids.  If false, do not.
-BOOL pid_blocking_on = FALSE;
+ONE_NET_DEVICE_STATE BOOL pid_blocking_on = FALSE;
 #endif
 
 
@@ -284,22 +288,29 @@ BOOL pid_blocking_on = FALSE;
 
 
 //! The current state.
-on_state_t on_state = ON_INIT_STATE;
+ONE_NET_DEVICE_STATE on_state_t on_state = ON_INIT_STATE;
 
 
 #ifdef ONE_NET_MH_CLIENT_REPEATER
     // Transaction for forwarding on MH packets.
-    static on_txn_t mh_txn = {ON_NO_TXN, ONE_NET_NO_PRIORITY, 0,
+    static ONE_NET_DEVICE_STATE on_txn_t mh_txn = {ON_NO_TXN, ONE_NET_NO_PRIORITY, 0,
       ONT_MH_TIMER, 0, 0, encoded_pkt_bytes, NULL, NULL, 0, 0};
 #endif
 
 
 #ifdef RANGE_TESTING
 //! Stores the DIDs of the devices which are in range.
-static on_encoded_did_t range_test_did_array[RANGE_TESTING_ARRAY_SIZE];
+static ONE_NET_DEVICE_STATE on_encoded_did_t range_test_did_array[RANGE_TESTING_ARRAY_SIZE];
 
 //! If true, range test.  If false, do not.
-static BOOL range_testing_on = FALSE;
+static ONE_NET_DEVICE_STATE BOOL range_testing_on = FALSE;
+#endif
+
+
+#ifdef ADAPTIVE_RESPONSE_TIMEOUT
+//! When the current single data packet finished being written.  Used to
+//! measure the round trip time to the destination.
+static ONE_NET_DEVICE_STATE tick_t single_write_done_time = 0;
 #endif
 
 
@@ -367,6 +378,9 @@ void one_net_init(void)
     #ifdef RANGE_TESTING
     reset_range_test_did_array();
     #endif
+    #ifdef ADAPTIVE_RESPONSE_TIMEOUT
+    one_net_rtt_reset();
+    #endif
     #ifdef BLOCK_MESSAGES_ENABLED
     bs_msg.transfer_in_progress = FALSE;
     bs_msg.saved_ack_nack.payload = (ack_nack_payload_t*)
@@ -383,6 +397,8 @@ void one_net_init(void)
     This is the main state machine for ONE-NET.  It handles sending/receiving
     the various transactions.
 
+    \param[in] ctx If ONE_NET_DEVICE_CONTEXT is defined, the device to run.
+      It is made the current device.  Otherwise there is no such parameter.
     \param[in/out] txn The transaction currently being carried out
 
     \return TRUE if the current transaction is completed.  This should coincide
@@ -391,19 +407,27 @@ void one_net_init(void)
               one that just finished.
             FALSE if the current transaction is not complete.
 */
+#ifndef ONE_NET_DEVICE_CONTEXT
 void one_net(on_txn_t ** txn)
+#else
+void one_net(on_device_context_t* ctx, on_txn_t ** txn)
+#endif
 {
     one_net_status_t status;
     on_txn_t* this_txn;
     on_pkt_t* this_pkt_ptrs;
     #ifndef ONE_NET_SIMPLE_CLIENT
-    static BOOL at_least_one_response = FALSE;
+    static ONE_NET_DEVICE_STATE BOOL at_least_one_response = FALSE;
     #endif
     
     on_ack_nack_t ack_nack;
     ack_nack_payload_t ack_nack_payload;
     ack_nack.payload = &ack_nack_payload;
 
+    #ifdef ONE_NET_DEVICE_CONTEXT
+    one_net_set_context(ctx);
+    #endif
+
     #ifdef BLOCK_MESSAGES_ENABLED
     if(on_state <= ON_BS_COMMENCE || on_state >= ON_BS_CHUNK_PAUSE)
     {
@@ -498,7 +522,7 @@ void one_net(on_txn_t ** txn)
                     {
                         #if SINGLE_QUEUE_LEVEL > NO_SINGLE_QUEUE_LEVEL
                         if(pop_queue_element(&single_msg, single_data_raw_pld,
-                          (UInt8) index))
+                          (UInt16) index))
                         #else
                         if(pop_queue_element())
                         #endif
@@ -583,7 +607,11 @@ void one_net(on_txn_t ** txn)
                                 at_least_one_response = FALSE;
                                 #endif
                                 recipient_send_list_ptr->recipient_index = -1;
+                                #ifndef ONE_NET_DEVICE_CONTEXT
                                 one_net(txn);
+                                #else
+                                one_net(ctx, txn);
+                                #endif
                                 return; // we have a message. Send it through
                                         // one_net() again.
                             }
@@ -617,7 +645,7 @@ void one_net(on_txn_t ** txn)
                         if(!ont_get_timer(ONT_BS_TIMER) &&
                           single_data_queue_size == 0)
                         {
-                            static UInt8 rptr_idx;
+                            static ONE_NET_DEVICE_STATE UInt8 rptr_idx;
                             on_raw_did_t raw_did;
                             BOOL master_involved = (device_is_master ||
                               is_master_did((const on_encoded_did_t*)
@@ -824,6 +852,14 @@ void one_net(on_txn_t ** txn)
                                       MS_TO_TICK(bs_msg.timeout));
                                     one_net_memset(bs_msg.bs.block.sent, 0,
                                       sizeof(bs_msg.bs.block.sent));
+                                    #ifdef BLOCK_SLIDING_WINDOW
+                                    // start with the whole negotiated window
+                                    // sent back to back.
+                                    bs_msg.bs.block.window =
+                                      bs_msg.bs.block.chunk_size;
+                                    bs_msg.bs.block.backoff = 0;
+                                    bs_msg.bs.block.lost = 0;
+                                    #endif
                                     
                                     // we'll make fairly long process times.
                                     // Things will get corrected soon enough
@@ -1630,8 +1666,37 @@ void one_net(on_txn_t ** txn)
                         // TODO -- low priority.
                         // No response needed, so use the fragment
                         // delay as the pause.
+                        #ifdef BLOCK_SLIDING_WINDOW
+                        UInt16 gap_ms = bs_msg.frag_dly;
+                        #ifdef STREAM_MESSAGES_ENABLED
+                        if(get_bs_transfer_type(bs_msg.flags) ==
+                          ON_BLK_TRANSFER)
+                        #endif
+                        {
+                            #ifdef ONE_NET_MULTI_HOP
+                            // Packets only go back to back without
+                            // repeaters.  Each repeater has to finish
+                            // relaying this packet or the next one will
+                            // collide with it.
+                            UInt16 relay_ms = estimate_response_time(
+                              bs_txn.data_len, 0, get_bs_hops(bs_msg.flags),
+                              0, 10, bs_msg.data_rate);
+                            #endif
+                            
+                            gap_ms = block_paced_delay(&bs_msg,
+                              bs_msg.frag_dly);
+                            #ifdef ONE_NET_MULTI_HOP
+                            if(gap_ms < relay_ms)
+                            {
+                                gap_ms = relay_ms;
+                            }
+                            #endif
+                        }
+                        ont_set_timer(ONT_BS_TIMER, MS_TO_TICK(gap_ms));
+                        #else
                         ont_set_timer(ONT_BS_TIMER,
                           MS_TO_TICK(bs_msg.frag_dly));
+                        #endif
                         on_state = ON_BS_PREPARE_DATA_PACKET;
                         break;
                     }
@@ -1663,6 +1728,25 @@ void one_net(on_txn_t ** txn)
                 new_timeout_ms = (*txn)->response_timeout;
                 #endif
                 
+                #ifdef ADAPTIVE_RESPONSE_TIMEOUT
+                if(on_state == ON_SEND_SINGLE_DATA_WRITE_WAIT)
+                {
+                    // The above is the worst case.  Wait only as long as
+                    // the responses from this destination have been taking.
+                    #ifdef ONE_NET_MULTI_HOP
+                    UInt8 hops = (*txn)->max_hops;
+                    #else
+                    UInt8 hops = 0;
+                    #endif
+                    
+                    single_write_done_time = get_tick_count();
+                    new_timeout_ms = one_net_rtt_timeout(
+                      (const on_encoded_did_t*) &((*txn)->device->did), hops,
+                      (UInt16) (new_timeout_ms > 0xFFFF ? 0xFFFF :
+                      new_timeout_ms));
+                }
+                #endif
+                
                 if(on_state == ON_SEND_PKT_WRITE_WAIT || on_state ==
                   ON_SEND_SINGLE_DATA_RESP_WRITE_WAIT)
                 {
@@ -1671,8 +1755,8 @@ void one_net(on_txn_t ** txn)
                     // follow-up, so we are done.  Reset the transaction and
                     // return the state to ON_LISTEN_FOR_DATA.
                     (*txn)->priority = ONE_NET_NO_PRIORITY;
-                    *txn = NULL;
                     ont_stop_timer((*txn)->next_txn_timer);
+                    *txn = NULL;
                     on_state = ON_LISTEN_FOR_DATA;
                     return;
                 }
@@ -1750,6 +1834,15 @@ void one_net(on_txn_t ** txn)
                     {
                         // no response, so prepare the next packet, which may
                         // may or may not be this one.
+                        #ifdef BLOCK_SLIDING_WINDOW
+                        #ifdef STREAM_MESSAGES_ENABLED
+                        if(get_bs_transfer_type(bs_msg.flags) ==
+                          ON_BLK_TRANSFER)
+                        #endif
+                        {
+                            block_record_window_loss(&bs_msg, NULL);
+                        }
+                        #endif
                         on_state = ON_BS_PREPARE_DATA_PACKET;
                     }
                     
@@ -1760,6 +1853,19 @@ void one_net(on_txn_t ** txn)
                 response_msg_or_timeout = TRUE;
                 (*txn)->retry++;
                 
+                #ifdef ADAPTIVE_RESPONSE_TIMEOUT
+                if(on_state == ON_WAIT_FOR_SINGLE_DATA_RESP)
+                {
+                    #ifdef ONE_NET_MULTI_HOP
+                    one_net_rtt_timed_out((const on_encoded_did_t*)
+                      &((*txn)->device->did), (*txn)->max_hops);
+                    #else
+                    one_net_rtt_timed_out((const on_encoded_did_t*)
+                      &((*txn)->device->did), 0);
+                    #endif
+                }
+                #endif
+                
                 #ifndef ONE_NET_SIMPLE_CLIENT
                 msg_status = (*pkt_hdlr.single_ack_nack_hdlr)(&single_txn,
                   &data_pkt_ptrs, single_msg_ptr->payload,
@@ -1816,7 +1922,21 @@ void one_net(on_txn_t ** txn)
                 #endif
             
                 if(status == ONS_PKT_RCVD)
-                {                    
+                {
+                    #ifdef ADAPTIVE_RESPONSE_TIMEOUT
+                    // Only a response to a packet sent once tells how long
+                    // the round trip took.  Save what is needed now since
+                    // handling the response may change the transaction.
+                    BOOL measure_rtt = (on_state ==
+                      ON_WAIT_FOR_SINGLE_DATA_RESP && (*txn)->retry == 0);
+                    on_sending_device_t* rtt_device = (*txn)->device;
+                    #ifdef ONE_NET_MULTI_HOP
+                    UInt8 rtt_hops = (*txn)->max_hops;
+                    #else
+                    UInt8 rtt_hops = 0;
+                    #endif
+                    #endif
+                    
                     #ifdef BLOCK_MESSAGES_ENABLED
                     if(on_state == ON_BS_WAIT_FOR_DATA_RESP)
                     {
@@ -1848,6 +1968,15 @@ void one_net(on_txn_t ** txn)
                     response_msg_or_timeout = TRUE;
                     msg_status = rx_single_resp_pkt(txn, &this_txn,
                       this_pkt_ptrs, raw_payload_bytes, &ack_nack);
+                    
+                    #ifdef ADAPTIVE_RESPONSE_TIMEOUT
+                    if(measure_rtt && msg_status != ON_MSG_IGNORE)
+                    {
+                        one_net_rtt_sample((const on_encoded_did_t*)
+                          &(rtt_device->did), rtt_hops, (UInt16) TICK_TO_MS(
+                          get_tick_count() - single_write_done_time));
+                    }
+                    #endif
                       
                     switch(msg_status)
                     {
@@ -2020,9 +2149,13 @@ void one_net(on_txn_t ** txn)
                 {
                     on_state = ON_LISTEN_FOR_DATA;
                 }
+                #ifndef ONE_NET_DEVICE_CONTEXT
                 one_net(txn); // we may have another message to send.
                               // send it before going back to the master
                               // or client code.
+                #else
+                one_net(ctx, txn);
+                #endif
             }
             
             break;
@@ -2538,9 +2671,27 @@ static on_message_status_t rx_block_resp_pkt(on_txn_t* txn,
           pause_bs_msg(bs_msg, ack_nack->payload->nack_time_ms);
           break;
         case ON_ACK_BLK_PKTS_RCVD:
+        {
+          #ifdef BLOCK_SLIDING_WINDOW
+          SInt8 missing_idx;
+          
+          block_record_window_loss(bs_msg, ack_nack->payload->ack_payload);
+          #endif
           one_net_memmove(bs_msg->bs.block.sent, ack_nack->payload->ack_payload,
             sizeof(bs_msg->bs.block.sent));
+            
+          #ifdef BLOCK_SLIDING_WINDOW
+          // go straight to the first packet that is missing rather than
+          // sending the last one, which got through, again.
+          missing_idx = block_get_lowest_unsent_index(bs_msg->bs.block.sent,
+            get_current_bs_chunk_size(bs_msg));
+          if(missing_idx != -1)
+          {
+              bs_msg->bs.block.chunk_idx = missing_idx;
+          }
+          #endif
           return ON_MSG_CONTINUE;
+        }
         default:
         {
             switch(ack_nack->nack_reason)
@@ -2550,6 +2701,9 @@ static on_message_status_t rx_block_resp_pkt(on_txn_t* txn,
                       ack_nack->payload->nack_time_ms;
                     break;
                 case ON_NACK_RSN_INVALID_BYTE_INDEX:
+                    #ifdef BLOCK_SLIDING_WINDOW
+                    block_adapt_window(bs_msg);
+                    #endif
                     bs_msg->bs.block.byte_idx = ack_nack->payload->nack_value;
                     
                     // TODO -- why is one of these unsigned?
@@ -2568,7 +2722,22 @@ static on_message_status_t rx_block_resp_pkt(on_txn_t* txn,
                     
                     one_net_memset(bs_msg->bs.block.sent, 0,
                       sizeof(bs_msg->bs.block.sent));
+                    #ifdef BLOCK_SLIDING_WINDOW
+                    bs_msg->bs.block.chunk_idx = 0;
+                    {
+                        UInt16 pause_ms = block_paced_delay(bs_msg,
+                          bs_msg->bs.block.chunk_pause);
+                        if(!pause_ms)
+                        {
+                            // no loss lately, so start the next window
+                            // right away.
+                            return ON_MSG_CONTINUE;
+                        }
+                        pause_bs_msg(bs_msg, pause_ms);
+                    }
+                    #else
                     pause_bs_msg(bs_msg, bs_msg->bs.block.chunk_pause);
+                    #endif
                     break;
                 case ON_NACK_RSN_INVALID_FRAG_DELAY:
                     bs_msg->frag_dly = ack_nack->payload->nack_time_ms;
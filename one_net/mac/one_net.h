@@ -58,6 +58,7 @@
 #include "one_net_status_codes.h"
 #include "one_net_types.h"
 #include "one_net_xtea.h"
+#include "one_net_context.h"
 
 
 //==============================================================================
@@ -698,7 +699,11 @@ extern "C"
 void one_net_init(void);
 
 //! the main function
+#ifndef ONE_NET_DEVICE_CONTEXT
 void one_net(on_txn_t ** txn);
+#else
+void one_net(on_device_context_t* ctx, on_txn_t ** txn);
+#endif
 
 
 on_message_status_t rx_single_data(on_txn_t** txn, on_pkt_t* sing_pkt_ptr,
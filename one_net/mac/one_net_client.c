@@ -62,6 +62,7 @@
 #include "one_net_acknowledge.h"
 #include "one_net_timer.h"
 #include "one_net_crc.h"
+#include "one_net_context.h"
 #ifdef PEER
 #include "one_net_peer.h"
 #endif
@@ -105,21 +106,21 @@
 //! @{
 
 //! Flag to signify that this client is part of a network.
-BOOL client_joined_network = FALSE;
+ONE_NET_DEVICE_STATE BOOL client_joined_network = FALSE;
 
 //! Flag to signify that the client is not part of a network and is looking for
 //! an invitation.
-BOOL client_looking_for_invite = FALSE;
+ONE_NET_DEVICE_STATE BOOL client_looking_for_invite = FALSE;
 
 #ifdef ENHANCED_INVITE
     //! Flag to signify that an invitation attempt has expired without successfully
     //! joining a network.
-    BOOL client_invite_timed_out = FALSE;
+    ONE_NET_DEVICE_STATE BOOL client_invite_timed_out = FALSE;
 	
     //! Lowest channel to consider when looking for an invite
-	one_net_channel_t low_invite_channel;
+	ONE_NET_DEVICE_STATE one_net_channel_t low_invite_channel;
 	
-	one_net_channel_t high_invite_channel;	
+	ONE_NET_DEVICE_STATE one_net_channel_t high_invite_channel;	
 #endif
 
 
@@ -144,12 +145,12 @@ on_master_t * const master
 
 //! The ONE_NET_RX_FROM_DEVICE_COUNT devices that have most recently sent data
 //! to this device.
-on_sending_dev_list_item_t sending_dev_list[ONE_NET_RX_FROM_DEVICE_COUNT];
+ONE_NET_DEVICE_STATE on_sending_dev_list_item_t sending_dev_list[ONE_NET_RX_FROM_DEVICE_COUNT];
 
 //! Set to true upon being deleted from the network.  There will be a slight
 //! two second pause before this device actually removes itself to give any
 //! pending transactions to complete.
-static BOOL removed = FALSE;
+static ONE_NET_DEVICE_STATE BOOL removed = FALSE;
 
 
 
@@ -477,6 +478,9 @@ one_net_status_t one_net_client_init(const UInt8 * const param,
             return ONS_BAD_PARAM;
         }
         one_net_memmove(peer_storage, peer_param, PEER_STORAGE_SIZE_BYTES);
+        
+        // lists saved by older code may not be in order
+        one_net_sort_peers(NULL);
     }
     #endif
 
@@ -495,14 +499,19 @@ one_net_status_t one_net_client_init(const UInt8 * const param,
 /*!
     \brief The main function for the ONE-NET CLIENT.
 
-    \param void
+    \param[in] ctx If ONE_NET_DEVICE_CONTEXT is defined, the CLIENT to run.
+      It is made the current device.  Otherwise there is no parameter.
 
     \return The number of ticks the device can sleep for.
 */
+#ifndef ONE_NET_DEVICE_CONTEXT
 tick_t one_net_client(void)
+#else
+tick_t one_net_client(on_device_context_t* ctx)
+#endif
 {
     // The current transaction
-    static on_txn_t * txn = 0;
+    static ONE_NET_DEVICE_STATE on_txn_t * txn = 0;
     
     // The time the application can sleep for in ticks (as opposed to ms).
     // Probably relevant only for devices which sleep, but we'll let the
@@ -510,6 +519,9 @@ tick_t one_net_client(void)
     // regardless of whether the device sleeps.
     tick_t sleep_time = 0;
     
+    #ifdef ONE_NET_DEVICE_CONTEXT
+    one_net_set_context(ctx);
+    #endif
     
     if(!pkt_hdlr.single_data_hdlr)
     {
@@ -623,7 +635,11 @@ tick_t one_net_client(void)
         }
     }
 
+    #ifndef ONE_NET_DEVICE_CONTEXT
     one_net(&txn);
+    #else
+    one_net(ctx, &txn);
+    #endif
 
     // calculate the allowable sleep time for devices that sleep
     
@@ -634,12 +650,20 @@ tick_t one_net_client(void)
     }
     else
     {
+        tick_t timer_sleep_time;
         #if SINGLE_QUEUE_LEVEL > MIN_SINGLE_QUEUE_LEVEL
         tick_t queue_sleep_time;
         #endif
         
         // this will be the absolute maximum -- this may be overridden.
         sleep_time = ont_get_timer(ONT_KEEP_ALIVE_TIMER);
+        
+        // don't sleep through any other timer
+        if(ont_next_deadline(&timer_sleep_time) &&
+          timer_sleep_time < sleep_time)
+        {
+            sleep_time = timer_sleep_time;
+        }
     
         #if SINGLE_QUEUE_LEVEL > MIN_SINGLE_QUEUE_LEVEL
         if(single_data_queue_ready_to_send(&queue_sleep_time) == -1)
@@ -2244,7 +2268,8 @@ static BOOL look_for_invite(void)
             #endif
 		
             one_net_set_channel(on_base_param->channel);
-            ont_set_timer(ONT_GENERAL_TIMER, ONE_NET_SCAN_CHANNEL_TIME);
+            ont_set_timer(ONT_GENERAL_TIMER,
+              MS_TO_TICK(ONE_NET_SCAN_CHANNEL_TIME));
         } // if the timer expired //    
 
         return FALSE;
@@ -126,7 +126,11 @@ one_net_status_t one_net_client_init(const UInt8 * const param,
   const UInt16 peer_param_len);
 #endif
 
+#ifndef ONE_NET_DEVICE_CONTEXT
 tick_t one_net_client(void);
+#else
+tick_t one_net_client(on_device_context_t* ctx);
+#endif
 
 
 #ifndef PEER
@@ -66,6 +66,7 @@
 #include "one_net_prand.h"
 #include "one_net_crc.h"
 #include "one_net.h"
+#include "one_net_context.h"
 #ifdef PEER
 #include "one_net_peer.h"
 #endif
@@ -89,6 +90,17 @@
 #endif
 
 
+enum
+{
+    //! The number of entries in the CLIENT DID index.  It is kept at more than
+    //! twice the number of CLIENTs so the probe sequences stay short.
+    ON_CLIENT_INDEX_SIZE = 2 * ONE_NET_MASTER_MAX_CLIENTS + 1,
+
+    //! Marks an unused entry in the CLIENT DID index
+    ON_CLIENT_INDEX_EMPTY = 0xFFFF
+};
+
+
 //! @} ONE-NET_MASTER_const
 //                                  CONSTANTS END
 //==============================================================================
@@ -132,7 +144,7 @@ on_client_t * const client_list = (on_client_t * const)(&nv_param[0] +
   sizeof(on_base_param_t) + sizeof(on_master_param_t));
 
 //! Unique key of the device being invited into the network
-one_net_xtea_key_t invite_key;
+ONE_NET_DEVICE_STATE one_net_xtea_key_t invite_key;
 
 
 
@@ -154,46 +166,65 @@ one_net_xtea_key_t invite_key;
     The length of time in ticks that the channel must be clear for before
     determining that the channel is ok for the network to operate on.
 */
-static tick_t new_channel_clear_time_out = 0;
+static ONE_NET_DEVICE_STATE tick_t new_channel_clear_time_out = 0;
 
 //! Flag to denote that a key update is in progress.
-static BOOL key_update_in_progress = FALSE;
+static ONE_NET_DEVICE_STATE BOOL key_update_in_progress = FALSE;
 
 //! Flag to denote that a device has been removed and the master is in
 //! the process of informing all of the devices.
-static BOOL remove_device_update_in_progress = FALSE;
+static ONE_NET_DEVICE_STATE BOOL remove_device_update_in_progress = FALSE;
 
 //! Flag to denote that a device has been added and the master is in
 //! the process of informing all of the devices.
-static BOOL add_device_update_in_progress = FALSE;
+static ONE_NET_DEVICE_STATE BOOL add_device_update_in_progress = FALSE;
 
 //! Flag to denote the device that should next be notified of any updates,
 //! if any.  Generally denotes either the device being added or removed or
 //! a normally-sleeping device that has woken up and we thus want to move
 //! it to the head of the list.  If NULL, then no device takes precedence
-static on_client_t* device_to_update = NULL;
+static ONE_NET_DEVICE_STATE on_client_t* device_to_update = NULL;
 
 //! The did of the device being removed.  Irrelevant if broadcast
-static on_encoded_did_t remove_device_did = {0xB4, 0xB4};
+static ONE_NET_DEVICE_STATE on_encoded_did_t remove_device_did = {0xB4, 0xB4};
 
 //! The did of the device being removed.  Irrelevant if broadcast.
-static on_encoded_did_t add_device_did = {0xB4, 0xB4};
+static ONE_NET_DEVICE_STATE on_encoded_did_t add_device_did = {0xB4, 0xB4};
 
 //! Flag for whether the device being added has been notified of its
 //! settings / flags.
-static BOOL settings_sent;
+static ONE_NET_DEVICE_STATE BOOL settings_sent;
 
 #ifdef BLOCK_MESSAGES_ENABLED
 //! Flag for whether the device being added has been notified of its fragment
 //! delays.
-static BOOL fragment_delay_sent;
+static ONE_NET_DEVICE_STATE BOOL fragment_delay_sent;
 #endif
 
 //! The time that the remove device update started.
-static tick_t remove_device_start_time = 0;
+static ONE_NET_DEVICE_STATE tick_t remove_device_start_time = 0;
 
 //! The time that the add device update started.
-static tick_t add_device_start_time = 0;
+static ONE_NET_DEVICE_STATE tick_t add_device_start_time = 0;
+
+//! Open addressed hash of the encoded DIDs of the CLIENTs in client_list.
+//! Each entry is an index into client_list or ON_CLIENT_INDEX_EMPTY.
+static ONE_NET_DEVICE_STATE UInt16 client_index[ON_CLIENT_INDEX_SIZE];
+
+//! Indexes into client_list of the CLIENTs, sorted by raw DID
+static ONE_NET_DEVICE_STATE UInt16 client_order[ONE_NET_MASTER_MAX_CLIENTS];
+
+//! The number of CLIENTs in client_index and client_order
+static ONE_NET_DEVICE_STATE UInt16 indexed_client_count = 0;
+
+//! Bit n is set if the DID ONE_NET_INITIAL_CLIENT_DID +
+//! n * ON_CLIENT_DID_INCREMENT belongs to a CLIENT.  The lowest vacant DID is
+//! always one of the first ONE_NET_MASTER_MAX_CLIENTS DIDs.
+static ONE_NET_DEVICE_STATE UInt8 did_in_use[(ONE_NET_MASTER_MAX_CLIENTS + 7)
+  / 8];
+
+//! Index into client_list of the CLIENT being invited, -1 if none
+static ONE_NET_DEVICE_STATE SInt16 invite_client_index = -1;
 
 
 
@@ -249,11 +280,13 @@ static on_message_status_t on_master_stream_txn_hdlr(
 
 static one_net_status_t init_internal(void);
 static one_net_status_t rm_client(const on_encoded_did_t * const CLIENT_DID);
-// TODO -- June 2, 2012 - sort_client_list_by_encoded_did appears to not be
-// used anywhere.  Commenting out for a clean compile
-#if 0
-static void sort_client_list_by_encoded_did(void);
-#endif
+static void rebuild_client_index(void);
+static UInt16 client_index_hash(const on_encoded_did_t* const DID);
+static void index_client(UInt16 list_index);
+static void unindex_client(UInt16 list_index);
+static on_client_t* indexed_client(const on_encoded_did_t* const DID);
+static UInt16 client_raw_did(UInt16 list_index);
+static SInt16 did_in_use_bit(UInt16 raw_did);
 static UInt16 find_lowest_vacant_did(void);
 static SInt16 find_vacant_client_list_index(void);
 
@@ -345,6 +378,7 @@ void one_net_master_clear_client_memory(void)
 {
     master_param->next_client_did = ONE_NET_INITIAL_CLIENT_DID;
     master_param->client_count = 0;
+    invite_client_index = -1;
     one_net_master_condense_client_memory();
     #ifdef PEER
     one_net_reset_peers();
@@ -359,34 +393,48 @@ void one_net_master_clear_client_memory(void)
 
 void one_net_master_condense_client_memory(void)
 {
-    SInt16 i;
+    UInt16 i;
+    UInt16 num_slots_kept = 0;
     UInt16 num_clients_encountered = 0;
 
+    // Move the CLIENTs (and the device being invited, if any) to the front
+    // of the list in one pass.
     for(i = 0; i < ONE_NET_MASTER_MAX_CLIENTS; i++)
     {
-        if(num_clients_encountered >= master_param->client_count)
-        {
-            break;
-        }
         if(is_broadcast_did((const on_encoded_did_t*)
           client_list[i].device.did))
         {
-            // move everything up
-            one_net_memmove(&client_list[i], &client_list[i+1],
-              (ONE_NET_MASTER_MAX_CLIENTS - i - 1) * sizeof(on_client_t));
-            i--;
+            continue;
         }
-        else
+
+        if(i == invite_client_index)
+        {
+            invite_client_index = num_slots_kept;
+        }
+        else if(num_clients_encountered < master_param->client_count)
         {
             num_clients_encountered++;
         }
+        else
+        {
+            continue;
+        }
+
+        if(i != num_slots_kept)
+        {
+            one_net_memmove(&client_list[num_slots_kept], &client_list[i],
+              sizeof(on_client_t));
+        }
+        num_slots_kept++;
     }
 
-    for(i = master_param->client_count; i < ONE_NET_MASTER_MAX_CLIENTS; i++)
+    for(i = num_slots_kept; i < ONE_NET_MASTER_MAX_CLIENTS; i++)
     {
         one_net_memmove(client_list[i].device.did, ON_ENCODED_BROADCAST_DID,
           ON_ENCODED_DID_LEN);
     }
+
+    rebuild_client_index();
 }
 
 
@@ -419,14 +467,14 @@ one_net_status_t one_net_master_init(const UInt8 * PARAM, UInt16 PARAM_LEN,
   memory_type_t memory_type)
 #endif
 {
-    UInt8 i;
+    UInt16 i;
     one_net_status_t status;
 
     // The number of bytes in the non-volatile parameter buffer that have been
     // initialized so far.
-    static UInt16 nv_param_size_needed = MAX_MASTER_NV_PARAM_SIZE_BYTES;
+    static ONE_NET_DEVICE_STATE UInt16 nv_param_size_needed = MAX_MASTER_NV_PARAM_SIZE_BYTES;
     #ifdef PEER
-    static UInt8 peer_memory_size_needed = PEER_STORAGE_SIZE_BYTES;
+    static ONE_NET_DEVICE_STATE UInt8 peer_memory_size_needed = PEER_STORAGE_SIZE_BYTES;
     #endif
 
     // There are several options.  This function may be called with PARAM equal to NULL.
@@ -471,7 +519,7 @@ one_net_status_t one_net_master_init(const UInt8 * PARAM, UInt16 PARAM_LEN,
         {
             memory_type = MEMORY_PEER;
         }
-        else if(nv_param_size_needed <= nv_param_size_needed)
+        else if(PARAM_LEN <= nv_param_size_needed)
         {
             memory_type = MEMORY_NON_PEER;
         }
@@ -566,6 +614,11 @@ one_net_status_t one_net_master_init(const UInt8 * PARAM, UInt16 PARAM_LEN,
         return ONS_INVALID_DATA;
     }
 
+    #ifdef PEER
+    // lists saved by older code may not be in order
+    one_net_sort_peers(NULL);
+    #endif
+
     #ifdef ONE_NET_MULTI_HOP
     // check for repeater
     for(i = 0; i < master_param->client_count; i++)
@@ -596,7 +649,7 @@ one_net_status_t one_net_master_init(const UInt8 * PARAM, UInt16 PARAM_LEN,
 one_net_status_t one_net_master_change_key_fragment(
   const one_net_xtea_key_fragment_t key_fragment)
 {
-    UInt8 i;
+    UInt16 i;
     if(key_update_in_progress)
     {
         return ONS_ALREADY_IN_PROGRESS;
@@ -738,6 +791,7 @@ one_net_status_t one_net_master_invite(const one_net_xtea_key_t * const KEY,
 
     // now set up the next unused position in client_list for this client
     // 2-21-13 ///////////////
+    invite_client_index = vacant_index;
     client = &client_list[vacant_index];
     client->flags = ONE_NET_MASTER_SEND_TO_MASTER ? ON_SEND_TO_MASTER : 0;
     client->flags |= (ONE_NET_MASTER_REJECT_INVALID_MSG_ID ?
@@ -793,6 +847,21 @@ one_net_status_t one_net_master_invite(const one_net_xtea_key_t * const KEY,
 one_net_status_t one_net_master_cancel_invite(
   const one_net_xtea_key_t* const KEY)
 {
+    if(invite_client_index >= 0)
+    {
+        // free the slot the invite was holding unless the device has since
+        // been added
+        on_client_t* client = &client_list[invite_client_index];
+        if(is_invite_did((const on_encoded_did_t*) client->device.did) &&
+          indexed_client((const on_encoded_did_t*) client->device.did) !=
+          client)
+        {
+            one_net_memmove(client->device.did, ON_ENCODED_BROADCAST_DID,
+              ON_ENCODED_DID_LEN);
+        }
+        invite_client_index = -1;
+    }
+
     invite_txn.priority = ONE_NET_NO_PRIORITY;
     ont_stop_timer(invite_txn.next_txn_timer);
     ont_stop_timer(ONT_INVITE_TIMER);
@@ -822,7 +891,7 @@ one_net_status_t one_net_master_remove_device(
   const on_raw_did_t * const RAW_DID)
 {
     one_net_status_t status;
-    UInt8 i;
+    UInt16 i;
     on_client_t* client;
     UInt8 admin_pld[4];
 
@@ -989,33 +1058,37 @@ static BOOL is_invite_did(const on_encoded_did_t* const encoded_did)
 */
 static on_client_t* get_invite_client(void)
 {
-    UInt8 i;
-    for(i = 0; i < ONE_NET_MASTER_MAX_CLIENTS; i++)
+    if(invite_client_index < 0 || !is_invite_did((const on_encoded_did_t*)
+      client_list[invite_client_index].device.did))
     {
-        on_client_t* client = &client_list[i];
-        if(is_invite_did((const on_encoded_did_t* const)
-          client_list[i].device.did))
-        {
-            return client;
-        }
+        return NULL;
     }
-    return NULL;
+    return &client_list[invite_client_index];
 }
 
 
 /*!
     \brief The main function for the ONE-NET MASTER.
 
-    \param void
+    \param[in] ctx If ONE_NET_DEVICE_CONTEXT is defined, the MASTER to run.
+      It is made the current device.  Otherwise there is no parameter.
 
     \return void
 */
+#ifndef ONE_NET_DEVICE_CONTEXT
 void one_net_master(void)
+#else
+void one_net_master(on_device_context_t* ctx)
+#endif
 {
     // The current transaction
-    static on_txn_t * txn = 0;
+    static ONE_NET_DEVICE_STATE on_txn_t * txn = 0;
     tick_t queue_sleep_time;
 
+    #ifdef ONE_NET_DEVICE_CONTEXT
+    one_net_set_context(ctx);
+    #endif
+
 
     // Do the appropriate action for the state the device is in.
     switch(on_state)
@@ -1139,7 +1212,11 @@ void one_net_master(void)
 
         default:
         {
+            #ifndef ONE_NET_DEVICE_CONTEXT
             one_net(&txn);
+            #else
+            one_net(ctx, &txn);
+            #endif
             break;
         } // default case //
     } // switch(on_state) //
@@ -1255,6 +1332,7 @@ one_net_status_t one_net_master_add_client(const on_features_t features,
     #endif
     one_net_uint16_to_byte_stream(master_param->next_client_did, raw_did);
     on_encode(client->device.did, raw_did, ON_ENCODED_DID_LEN);
+    index_client(vacant_index);
 
 
     // if these are not NULL, the master is passing these parameters to the
@@ -1303,7 +1381,7 @@ one_net_status_t one_net_master_add_client(const on_features_t features,
 
     if(send_update_to_network)
     {
-        UInt8 i;
+        UInt16 i;
         add_device_update_in_progress = TRUE;
         add_device_did[0] = client->device.did[0];
         add_device_did[1] = client->device.did[1];
@@ -1368,32 +1446,67 @@ one_net_status_t one_net_master_add_client(const on_features_t features,
 one_net_status_t one_net_master_peer_assignment(const BOOL ASSIGN,
   const on_raw_did_t * const SRC_DID, const UInt8 SRC_UNIT,
   const on_raw_did_t * const PEER_DID, const UInt8 PEER_UNIT)
+{
+    return one_net_master_peer_assignments(ASSIGN, SRC_DID, SRC_UNIT,
+      PEER_DID, &PEER_UNIT, 1);
+} // one_net_master_peer_assignment //
+
+
+/*!
+    \brief (Un)Assigns several peers to one unit of a given client.
+
+    If the MASTER is the source, its peer list is changed in one go, and when
+    assigning, either all of the peers are assigned or none of them are.
+    Otherwise an admin message is queued for each peer, stopping at the first
+    one that cannot be queued.
+
+    \param[in] ASSIGN TRUE if the peers are being assigned
+                      FALSE if the peers are being unassigned
+    \param[in] SRC_DID The raw did of the device being (un)assigned the peers.
+    \param[in] SRC_UNIT The unit on the device that is having the peers
+    \param[in] PEER_DIDS The raw dids of the peers being (un)assigned to the
+      client.
+    \param[in] PEER_UNITS The unit on each peer device being (un)assigned to
+      the client.
+    \param[in] NUM_PEERS The number of peers.  At most
+      ONE_NET_MAX_PEER_PER_TXN.
+
+    \return ONS_SUCCESS if the operation was successful
+            ONS_BAD_PARAM if any of the parameters are invalid
+            ONS_INCORRECT_ADDR if the source or any of the peer devices are
+              not part of the network.
+            ONS_RSRC_FULL if the MASTER does not have room for the peers.
+            See send_admin_pkt for more return values.
+*/
+one_net_status_t one_net_master_peer_assignments(const BOOL ASSIGN,
+  const on_raw_did_t * const SRC_DID, const UInt8 SRC_UNIT,
+  const on_raw_did_t * const PEER_DIDS, const UInt8 * const PEER_UNITS,
+  const UInt8 NUM_PEERS)
 {
     on_encoded_did_t enc_src_did;
+    on_did_unit_t peers[ONE_NET_MAX_PEER_PER_TXN];
     UInt8 pld[ONA_SINGLE_PACKET_PAYLOAD_LEN - 1];
-    on_encoded_did_t* enc_dst_did = (on_encoded_did_t*)&pld[ON_PEER_DID_IDX];
+    one_net_status_t status = ONS_SUCCESS;
+    UInt8 i;
 
     // note -- broadcast peer did indicates wildcard
     BOOL src_is_master, dst_is_master, dst_is_broadcast;
 
 
-    if(!SRC_DID || !PEER_DID)
+    if(!SRC_DID || !PEER_DIDS || !PEER_UNITS || !NUM_PEERS ||
+      NUM_PEERS > ONE_NET_MAX_PEER_PER_TXN)
     {
         return ONS_BAD_PARAM;
     } // if parameters are invalid //
 
-    if(on_encode(enc_src_did, *SRC_DID, sizeof(enc_src_did)) != ONS_SUCCESS
-      || on_encode(*enc_dst_did, *PEER_DID, ON_ENCODED_DID_LEN)
-      != ONS_SUCCESS)
+    if(on_encode(enc_src_did, *SRC_DID, sizeof(enc_src_did)) != ONS_SUCCESS)
     {
         return ONS_INCORRECT_ADDR;
     } // if the encode failed //
 
     src_is_master = is_my_did((const on_encoded_did_t*) &enc_src_did);
-    dst_is_master = is_my_did((const on_encoded_did_t*) enc_dst_did);
-    dst_is_broadcast = is_broadcast_did((const on_encoded_did_t*) enc_dst_did);
 
-    // make sure that the devices are both part of the network and are
+    // make sure that the devices are all part of the network and are
     // not the same device
     if(!src_is_master && !client_info((const on_encoded_did_t*)
       &enc_src_did))
@@ -1401,24 +1514,39 @@ one_net_status_t one_net_master_peer_assignment(const BOOL ASSIGN,
         // source devices is in the network.
         return ONS_INCORRECT_ADDR;
     }
-    if(!dst_is_master && !dst_is_broadcast && !client_info(
-      (const on_encoded_did_t*) enc_dst_did))
-    {
-        // dest. device is not part of the network.
-        return ONS_INCORRECT_ADDR;
-    }
-    if(on_encoded_did_equal((const on_encoded_did_t* const) &enc_src_did,
-      (const on_encoded_did_t* const) enc_dst_did))
-    {
-        // devices are the same.
-        return ONS_INCORRECT_ADDR;
-    }
 
-    // one last check -- broadcast dids are valid for unassigning but not
-    // assigning
-    if(dst_is_broadcast && ASSIGN)
+    for(i = 0; i < NUM_PEERS; i++)
     {
-        return ONS_INCORRECT_ADDR;
+        if(on_encode(peers[i].did, PEER_DIDS[i], ON_ENCODED_DID_LEN)
+          != ONS_SUCCESS)
+        {
+            return ONS_INCORRECT_ADDR;
+        } // if the encode failed //
+        peers[i].unit = PEER_UNITS[i];
+
+        dst_is_master = is_my_did((const on_encoded_did_t*) peers[i].did);
+        dst_is_broadcast = is_broadcast_did((const on_encoded_did_t*)
+          peers[i].did);
+
+        if(!dst_is_master && !dst_is_broadcast && !client_info(
+          (const on_encoded_did_t*) peers[i].did))
+        {
+            // dest. device is not part of the network.
+            return ONS_INCORRECT_ADDR;
+        }
+        if(on_encoded_did_equal((const on_encoded_did_t* const) &enc_src_did,
+          (const on_encoded_did_t* const) peers[i].did))
+        {
+            // devices are the same.
+            return ONS_INCORRECT_ADDR;
+        }
+
+        // one last check -- broadcast dids are valid for unassigning but not
+        // assigning
+        if(dst_is_broadcast && ASSIGN)
+        {
+            return ONS_INCORRECT_ADDR;
+        }
     }
 
 
@@ -1428,27 +1556,46 @@ one_net_status_t one_net_master_peer_assignment(const BOOL ASSIGN,
     {
         if(ASSIGN)
         {
-            return one_net_add_peer_to_list(SRC_UNIT, NULL,
-              (const on_encoded_did_t* const) enc_dst_did, PEER_UNIT);
+            status = one_net_add_peers_to_list(SRC_UNIT, NULL, peers,
+              NUM_PEERS);
         }
         else
         {
-            return one_net_remove_peer_from_list(SRC_UNIT, NULL,
-              (const on_encoded_did_t* const) enc_dst_did, PEER_UNIT);
+            for(i = 0; i < NUM_PEERS; i++)
+            {
+                one_net_remove_peer_from_list(SRC_UNIT, NULL,
+                  (const on_encoded_did_t* const) peers[i].did,
+                  peers[i].unit);
+            }
         }
 
         #ifdef AUTO_SAVE
-        save = TRUE;
+        if(status == ONS_SUCCESS)
+        {
+            save = TRUE;
+        }
         #endif
+        return status;
     }
 
 
     pld[ON_PEER_SRC_UNIT_IDX] = SRC_UNIT;
-    pld[ON_PEER_PEER_UNIT_IDX] = PEER_UNIT;
+    for(i = 0; i < NUM_PEERS; i++)
+    {
+        one_net_memmove(&pld[ON_PEER_DID_IDX], peers[i].did,
+          ON_ENCODED_DID_LEN);
+        pld[ON_PEER_PEER_UNIT_IDX] = peers[i].unit;
 
-    return send_admin_pkt(ASSIGN ? ON_ASSIGN_PEER : ON_UNASSIGN_PEER,
-        (const on_encoded_did_t* const) &enc_src_did, pld, 0);
-} // one_net_master_peer_assignment //
+        if((status = send_admin_pkt(ASSIGN ? ON_ASSIGN_PEER :
+          ON_UNASSIGN_PEER, (const on_encoded_did_t* const) &enc_src_did,
+          pld, 0)) != ONS_SUCCESS)
+        {
+            break;
+        }
+    }
+
+    return status;
+} // one_net_master_peer_assignments //
 #endif
 
 
@@ -1675,33 +1822,50 @@ int master_nv_crc(const UInt8* param, const UInt8* peer_param)
 */
 on_client_t* client_info(const on_encoded_did_t* CLIENT_DID)
 {
-    UInt16 i;
+
+    on_client_t* client;
 
     if(!CLIENT_DID)
     {
         return 0;
     } // if the parameter is invalid //
 
-    for(i = 0; i < master_param->client_count; i++)
+    if((client = indexed_client(CLIENT_DID)) != NULL)
     {
-        if(on_encoded_did_equal(CLIENT_DID,
-          (const on_encoded_did_t * const)&client_list[i].device.did))
-        {
-            return &(client_list[i]);
-        } // if the CLIENT was found //
-    } // loop to find the CLIENT //
+        return client;
+    } // if the CLIENT was found //
 
     // check to see if this is a device currently accepting an invite.
     // If it is, then assign it the next DID
     if(is_invite_did(CLIENT_DID))
     {
-        return &client_list[master_param->client_count];
+        return get_invite_client();
     }
 
     return 0;
 } // client_info //
 
 
+/*!
+    \brief Returns the CLIENTs in order of their DIDs.
+
+    \param[in] index Which CLIENT to return, from 0 for the CLIENT with the
+      lowest DID up to one less than the number of CLIENTs.
+
+    \return The CLIENT information if there is a CLIENT at that position
+            0 If index is past the last CLIENT.
+*/
+on_client_t* client_in_did_order(UInt16 index)
+{
+    if(index >= indexed_client_count)
+    {
+        return 0;
+    } // if the parameter is invalid //
+
+    return &client_list[client_order[index]];
+} // client_in_did_order //
+
+
 #ifdef BLOCK_MESSAGES_ENABLED
 on_nack_rsn_t on_master_get_default_block_transfer_values(
   on_client_t* src_client, on_client_t* dst_client, UInt32 transfer_size,
@@ -1713,6 +1877,7 @@ on_nack_rsn_t on_master_get_default_block_transfer_values(
 
     *timeout = DEFAULT_BLOCK_STREAM_TIMEOUT;
     *chunk_size = DEFAULT_BS_CHUNK_SIZE;
+    *chunk_delay = DEFAULT_BS_CHUNK_DELAY;
 
     if(src_client == dst_client)
     {
@@ -2745,7 +2910,11 @@ static on_message_status_t on_master_stream_txn_hdlr(
 */
 static one_net_status_t init_internal(void)
 {
+    // the client list was just loaded or cleared, so no slot is being held
+    // for an invite any more
+    invite_client_index = -1;
     one_net_master_cancel_invite((const one_net_xtea_key_t* const) &invite_key);
+    rebuild_client_index();
     invite_txn.pkt = &encoded_pkt_bytes[2 * ON_MAX_ENCODED_DATA_PKT_SIZE];
     pkt_hdlr.single_data_hdlr = &on_master_single_data_hdlr;
     pkt_hdlr.single_ack_nack_hdlr =
@@ -2807,7 +2976,7 @@ static one_net_status_t rm_client(const on_encoded_did_t * const DID)
         return ONS_INVALID_DATA;
     } // if the parameter is invalid //
 
-    client = client_info(DID);
+    client = indexed_client(DID);
     if(!client)
     {
         return ONS_NOT_JOINED; // there's no client to delete.  This may be an
@@ -2817,6 +2986,7 @@ static one_net_status_t rm_client(const on_encoded_did_t * const DID)
 
 
     // make this slot vacant
+    unindex_client(client - client_list);
     one_net_memmove(client->device.did, ON_ENCODED_BROADCAST_DID,
       ON_ENCODED_DID_LEN);
 
@@ -2832,41 +3002,233 @@ static one_net_status_t rm_client(const on_encoded_did_t * const DID)
 } // rm_client //
 
 
-// TODO -- June 2, 2012 - sort_client_list_by_encoded_did appears to not be
-// used anywhere.  Commenting out for a clean compile
-#if 0
 /*!
-    \brief Sorts the client list by did for a cleaner printout.
+    \brief Rebuilds the CLIENT DID index, the DID order and the DIDs in use
+      from client_list.
+
+    Called whenever the CLIENTs may have moved or been loaded into
+    client_list from somewhere else.
 */
-static void sort_client_list_by_encoded_did(void)
+static void rebuild_client_index(void)
 {
     UInt16 i;
-    on_raw_did_t raw_did1;
-    on_raw_did_t raw_did2;
 
-    // the client list will almost always be in order already.  When it's not,
-    // generally only one element will be out of order, so instead of having a
-    // nested loop, if we ever find an element out of order, we'll just iterate
-    // through the whole list again.
-    for(i = 1; i < master_param->client_count; i++)
+    for(i = 0; i < ON_CLIENT_INDEX_SIZE; i++)
     {
-        on_decode(raw_did1, client_list[i-1].device.did,
-          ON_ENCODED_DID_LEN);
-        on_decode(raw_did2, client_list[i].device.did,
-          ON_ENCODED_DID_LEN);
+        client_index[i] = ON_CLIENT_INDEX_EMPTY;
+    }
+    one_net_memset(did_in_use, 0, sizeof(did_in_use));
+    indexed_client_count = 0;
 
-        if(one_net_byte_stream_to_uint16(raw_did1) >
-          one_net_byte_stream_to_uint16(raw_did2))
+    for(i = 0; i < ONE_NET_MASTER_MAX_CLIENTS &&
+      indexed_client_count < master_param->client_count; i++)
+    {
+        if(i == invite_client_index || is_broadcast_did(
+          (const on_encoded_did_t*) client_list[i].device.did))
         {
-            // swap.
-            on_client_t temp = client_list[i-1];
-            client_list[i-1] = client_list[i];
-            client_list[i] = temp;
-            i = 0; // make it 0, not 1 because the loop increments i.
+            continue;
         }
+        index_client(i);
+    }
+} // rebuild_client_index //
+
+
+/*!
+    \brief Returns where a DID starts probing in the CLIENT DID index.
+
+    \param[in] DID The encoded DID.
+
+    \return The entry in client_index to start looking from.
+*/
+static UInt16 client_index_hash(const on_encoded_did_t* const DID)
+{
+    return (((UInt16)(*DID)[0] << 8) | (*DID)[1]) % ON_CLIENT_INDEX_SIZE;
+} // client_index_hash //
+
+
+/*!
+    \brief Adds a CLIENT to the DID index, the DID order and the DIDs in use.
+
+    The CLIENT's DID must already be filled in.
+
+    \param[in] list_index Where the CLIENT is in client_list.
+*/
+static void index_client(UInt16 list_index)
+{
+    UInt16 i = client_index_hash((const on_encoded_did_t*)
+      client_list[list_index].device.did);
+    UInt16 raw_did = client_raw_did(list_index);
+    SInt16 bit;
+    UInt16 low = 0;
+    UInt16 high = indexed_client_count;
+
+    while(client_index[i] != ON_CLIENT_INDEX_EMPTY)
+    {
+        if(client_index[i] == list_index)
+        {
+            return; // already indexed
+        }
+        i = (i + 1) % ON_CLIENT_INDEX_SIZE;
+    }
+    client_index[i] = list_index;
+
+    if((bit = did_in_use_bit(raw_did)) >= 0)
+    {
+        did_in_use[bit >> 3] |= (1 << (bit & 0x07));
     }
-}
-#endif
+
+    // binary search for where it goes in the DID order.  New DIDs are
+    // usually the highest, so this is usually the end.
+    while(low < high)
+    {
+        UInt16 mid = (low + high) / 2;
+        if(client_raw_did(client_order[mid]) < raw_did)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    one_net_memmove(&client_order[low + 1], &client_order[low],
+      (indexed_client_count - low) * sizeof(client_order[0]));
+    client_order[low] = list_index;
+    indexed_client_count++;
+} // index_client //
+
+
+/*!
+    \brief Removes a CLIENT from the DID index, the DID order and the DIDs in
+      use.
+
+    Must be called before the CLIENT's DID is cleared.
+
+    \param[in] list_index Where the CLIENT is in client_list.
+*/
+static void unindex_client(UInt16 list_index)
+{
+    UInt16 i = client_index_hash((const on_encoded_did_t*)
+      client_list[list_index].device.did);
+    UInt16 j;
+    SInt16 bit;
+
+    while(client_index[i] != list_index)
+    {
+        if(client_index[i] == ON_CLIENT_INDEX_EMPTY)
+        {
+            return; // not indexed
+        }
+        i = (i + 1) % ON_CLIENT_INDEX_SIZE;
+    }
+
+    // Shift back any entry further along the probe sequence that could not
+    // have been placed before the hole, so no lookup stops short at it.
+    j = i;
+    while(1)
+    {
+        UInt16 home;
+
+        j = (j + 1) % ON_CLIENT_INDEX_SIZE;
+        if(client_index[j] == ON_CLIENT_INDEX_EMPTY)
+        {
+            break;
+        }
+
+        home = client_index_hash((const on_encoded_did_t*)
+          client_list[client_index[j]].device.did);
+        if((i < j) ? (home <= i || home > j) : (home <= i && home > j))
+        {
+            client_index[i] = client_index[j];
+            i = j;
+        }
+    }
+    client_index[i] = ON_CLIENT_INDEX_EMPTY;
+
+    if((bit = did_in_use_bit(client_raw_did(list_index))) >= 0)
+    {
+        did_in_use[bit >> 3] &= ~(1 << (bit & 0x07));
+    }
+
+    for(j = 0; j < indexed_client_count; j++)
+    {
+        if(client_order[j] == list_index)
+        {
+            one_net_memmove(&client_order[j], &client_order[j + 1],
+              (indexed_client_count - j - 1) * sizeof(client_order[0]));
+            indexed_client_count--;
+            break;
+        }
+    }
+} // unindex_client //
+
+
+/*!
+    \brief Looks a CLIENT up in the DID index.
+
+    Unlike client_info, this does not return the device being invited.
+
+    \param[in] DID The encoded DID of the CLIENT.
+
+    \return The CLIENT if it is in the network.
+            0 if it is not.
+*/
+static on_client_t* indexed_client(const on_encoded_did_t* const DID)
+{
+    UInt16 i = client_index_hash(DID);
+
+    while(client_index[i] != ON_CLIENT_INDEX_EMPTY)
+    {
+        on_client_t* client = &client_list[client_index[i]];
+        if(on_encoded_did_equal(DID,
+          (const on_encoded_did_t * const) &client->device.did))
+        {
+            return client;
+        }
+        i = (i + 1) % ON_CLIENT_INDEX_SIZE;
+    }
+
+    return 0;
+} // indexed_client //
+
+
+/*!
+    \brief Returns the raw DID of a CLIENT as a UInt16 (i.e. 0020, 0030, etc.)
+
+    \param[in] list_index Where the CLIENT is in client_list.
+
+    \return The raw DID.
+*/
+static UInt16 client_raw_did(UInt16 list_index)
+{
+    on_raw_did_t raw_did;
+
+    on_decode(raw_did, client_list[list_index].device.did, ON_ENCODED_DID_LEN);
+    return one_net_byte_stream_to_uint16(raw_did);
+} // client_raw_did //
+
+
+/*!
+    \brief Returns which bit of did_in_use is for a DID.
+
+    \param[in] raw_did The raw DID as a UInt16 (i.e. 0020, 0030, etc.)
+
+    \return The bit number.
+            -1 if the DID is not one the MASTER would hand out next.
+*/
+static SInt16 did_in_use_bit(UInt16 raw_did)
+{
+    UInt16 bit;
+
+    if(raw_did < ONE_NET_INITIAL_CLIENT_DID ||
+      (raw_did - ONE_NET_INITIAL_CLIENT_DID) % ON_CLIENT_DID_INCREMENT)
+    {
+        return -1;
+    }
+
+    bit = (raw_did - ONE_NET_INITIAL_CLIENT_DID) / ON_CLIENT_DID_INCREMENT;
+    return bit < ONE_NET_MASTER_MAX_CLIENTS ? (SInt16) bit : -1;
+} // did_in_use_bit //
 
 
 /*!
@@ -2879,31 +3241,33 @@ static void sort_client_list_by_encoded_did(void)
 static UInt16 find_lowest_vacant_did(void)
 {
     UInt16 i;
-    BOOL found;
-    on_raw_did_t raw_did;
-    UInt16 vacant_did = ONE_NET_INITIAL_CLIENT_DID;
+    UInt16 bit;
 
     if(master_param->client_count >= ONE_NET_MASTER_MAX_CLIENTS)
     {
         return 0; // list is full.
     }
 
-    do
+    for(i = 0; i < sizeof(did_in_use); i++)
     {
-        found = FALSE;
-        for(i = 0; i < ONE_NET_MASTER_MAX_CLIENTS; i++)
+        if(did_in_use[i] == 0xFF)
+        {
+            continue;
+        }
+
+        for(bit = 0; did_in_use[i] & (1 << bit); bit++)
         {
-            on_decode(raw_did, client_list[i].device.did, ON_ENCODED_DID_LEN);
-            if(one_net_byte_stream_to_uint16(raw_did) == vacant_did)
-            {
-                // this did is already taken, so increment
-                vacant_did += ON_CLIENT_DID_INCREMENT;
-                found = TRUE;
-            }
         }
-    } while(found);
 
-    return vacant_did;
+        bit += i * 8;
+        if(bit >= ONE_NET_MASTER_MAX_CLIENTS)
+        {
+            break;
+        }
+        return ONE_NET_INITIAL_CLIENT_DID + bit * ON_CLIENT_DID_INCREMENT;
+    }
+
+    return 0; // list is full.
 }
 
 
@@ -2953,7 +3317,7 @@ static on_sending_device_t * sender_info(const on_encoded_did_t * const DID)
 
 static void check_updates_in_progress(void)
 {
-    static tick_t last_send_time = 0;
+    static ONE_NET_DEVICE_STATE tick_t last_send_time = 0;
     tick_t time_now = get_tick_count();
     const tick_t SEND_INTERVAL = MS_TO_TICK(5000);
 
@@ -3824,7 +4188,7 @@ static void on_master_adjust_recipient_list(const on_single_data_queue_t*
             // internal error.  This message has been corrupted somehow.
             // Cancel any notifications.
             on_raw_did_t raw_did;
-            UInt8 i;
+            UInt16 i;
             on_ack_nack_t ack_nack;
             ack_nack.nack_reason = ON_NACK_RSN_INTERNAL_ERR;
 
@@ -4007,7 +4371,7 @@ static void on_master_adjust_recipient_list(const on_single_data_queue_t*
 
 static void check_clients_for_missed_check_ins(void)
 {
-    UInt8 i;
+    UInt16 i;
     tick_t time_now = get_tick_count();
     UInt8 pld[4];
     for(i = 0; i < master_param->client_count; i++)
@@ -197,7 +197,11 @@ one_net_status_t one_net_master_cancel_invite(
 one_net_status_t one_net_master_remove_device(
   const on_raw_did_t * const RAW_DID);
 
+#ifndef ONE_NET_DEVICE_CONTEXT
 void one_net_master(void);
+#else
+void one_net_master(on_device_context_t* ctx);
+#endif
 
 one_net_status_t one_net_master_add_client(const on_features_t features,
   on_base_param_t* out_base_param, on_master_t* out_master_param,
@@ -207,6 +211,10 @@ one_net_status_t one_net_master_add_client(const on_features_t features,
 one_net_status_t one_net_master_peer_assignment(const BOOL ASSIGN,
   const on_raw_did_t * const SRC_DID, const UInt8 SRC_UNIT,
   const on_raw_did_t * const PEER_DID, const UInt8 PEER_UNIT);
+one_net_status_t one_net_master_peer_assignments(const BOOL ASSIGN,
+  const on_raw_did_t * const SRC_DID, const UInt8 SRC_UNIT,
+  const on_raw_did_t * const PEER_DIDS, const UInt8 * const PEER_UNITS,
+  const UInt8 NUM_PEERS);
 #endif
   
 one_net_status_t one_net_master_change_client_keep_alive(
@@ -228,6 +236,7 @@ one_net_xtea_key_t* master_get_encryption_key(
   const on_encoded_did_t* const did);
   
 on_client_t* client_info(const on_encoded_did_t* CLIENT_DID);
+on_client_t* client_in_did_order(UInt16 index);
 
 #ifdef BLOCK_MESSAGES_ENABLED
 /*!
@@ -38,6 +38,10 @@
 
     Handles peer assignments functionality
     
+    A peer list is kept sorted by source unit, so the peers of each source unit
+    are together and can be found with a binary search.  Empty entries are all
+    at the end.
+    
     \note See one_net.h for the version of the ONE-NET source as a whole.  If
       any one file is modified, the version number in one_net.h will need to be
       updated.
@@ -54,6 +58,7 @@
 #include "one_net_constants.h"
 #include "one_net_status_codes.h"
 #include "one_net_message.h"
+#include "one_net_context.h"
 
 
 
@@ -86,6 +91,12 @@
 //! \ingroup ONE-NET_PEER
 //! @{
 
+
+//! What an unused peer list entry holds.
+static const on_peer_unit_t EMPTY_PEER = {{0xB4, 0xB4}, ONE_NET_DEV_UNIT,
+  ONE_NET_DEV_UNIT};
+
+
 //! @} ONE-NET_PEER_pri_var
 //                              PRIVATE VARIABLES END
 //==============================================================================
@@ -108,7 +119,7 @@ extern BOOL send_to_master;
 #endif
 
 
-UInt8 peer_storage[PEER_STORAGE_SIZE_BYTES];
+ONE_NET_DEVICE_STATE UInt8 peer_storage[PEER_STORAGE_SIZE_BYTES];
 
 on_peer_unit_t* const peer = (on_peer_unit_t* const) &peer_storage[0];
 
@@ -125,6 +136,14 @@ on_peer_unit_t* const peer = (on_peer_unit_t* const) &peer_storage[0];
 //! @{
 
 
+static UInt8 first_peer_of_unit(const on_peer_unit_t* const peer_list,
+  const UInt8 NUM_PEERS, const UInt8 SRC_UNIT);
+static UInt8 end_of_unit(const on_peer_unit_t* const peer_list,
+  const UInt8 NUM_PEERS, UInt8 index, const UInt8 SRC_UNIT);
+static BOOL peer_matches(const on_peer_unit_t* const ENTRY,
+  const on_encoded_did_t* const PEER_DID, const UInt8 PEER_UNIT);
+
+
 //! @} ONE-NET_PEER_pri_func
 //                      PRIVATE FUNCTION DECLARATIONS END
 //==============================================================================
@@ -147,38 +166,83 @@ on_peer_unit_t* const peer = (on_peer_unit_t* const) &peer_storage[0];
 */
 one_net_status_t one_net_reset_peers(void)
 {
-    on_peer_unit_t empty_peer = {{0xB4, 0xB4}, ONE_NET_DEV_UNIT,
-      ONE_NET_DEV_UNIT};
-    one_net_memset_block(peer, sizeof(empty_peer),
-      ONE_NET_MAX_PEER_UNIT, &empty_peer);
+    one_net_memset_block(peer, sizeof(EMPTY_PEER),
+      ONE_NET_MAX_PEER_UNIT, &EMPTY_PEER);
     return ONS_SUCCESS;
 } // one_net_reset_peers //
 
 
+/*!
+    \brief Puts a peer list in order.
+    
+    Lists saved before the lists were kept sorted by source unit may be in any
+    order, so this should be called whenever a peer list is loaded from
+    non-volatile memory.  The peers of a source unit keep their order.
+    
+    \param[in/out] peer_list The list to sort.  If NULL, the main list is
+      sorted.
+*/
+void one_net_sort_peers(on_peer_unit_t* peer_list)
+{
+    UInt8 i, j, num_peers;
+    on_peer_unit_t moving;
+
+    if(!peer_list)
+    {
+        peer_list = peer; // list not provided, so we use the main list
+    }
+    
+    num_peers = one_net_count_peers(peer_list);
+    
+    // insertion sort is stable, and the list is small and almost always
+    // sorted already
+    for(i = 1; i < num_peers; i++)
+    {
+        if(peer_list[i - 1].src_unit <= peer_list[i].src_unit)
+        {
+            continue;
+        }
+        
+        moving = peer_list[i];
+        for(j = i; j > 0 && peer_list[j - 1].src_unit > moving.src_unit; j--)
+        {
+            peer_list[j] = peer_list[j - 1];
+        }
+        peer_list[j] = moving;
+    }
+} // one_net_sort_peers //
+
+
 /*!
     \brief Counts the number of peers in a peer list.
     
-    Counts the number of peers in a peer list
+    Counts the number of peers in a peer list.  The empty entries are all at
+    the end, so the first one is found with a binary search.
     
     \return The number of peers in the peer list
 */
-// TODO -- Do we need/want this function?
 UInt8 one_net_count_peers(const on_peer_unit_t* peer_list)
 {
-    UInt8 i;
+    UInt8 low = 0, high = ONE_NET_MAX_PEER_UNIT, mid;
+
     if(!peer_list)
     {
         peer_list = peer; // list not provided, so we use the main list
     }
     
-    for(i = 0; i < ONE_NET_MAX_PEER_UNIT; i++)
+    while(low < high)
     {
-        if(peer_list[i].peer_unit == ONE_NET_DEV_UNIT)
+        mid = low + (high - low) / 2;
+        if(peer_list[mid].peer_unit == ONE_NET_DEV_UNIT)
+        {
+            high = mid;
+        }
+        else
         {
-            return i;
+            low = mid + 1;
         }
     }
-    return ONE_NET_MAX_PEER_UNIT;
+    return low;
 }
 
 
@@ -193,7 +257,7 @@ UInt8 one_net_count_peers(const on_peer_unit_t* peer_list)
 void add_peers_to_recipient_list(const on_single_data_queue_t*
   msg, on_recipient_list_t* send_list, const on_peer_unit_t* peer_list)
 {
-    UInt8 i;
+    UInt8 i, num_peers;
     on_did_unit_t dst_did_unit;
     
     if(msg->msg_type != ON_APP_MSG || !msg->send_to_peer_list)
@@ -201,21 +265,10 @@ void add_peers_to_recipient_list(const on_single_data_queue_t*
         return; // not sending to peer list
     }
 
-    for(i = 0; i < ONE_NET_MAX_PEER_PER_TXN; i++)
+    num_peers = one_net_count_peers(peer_list);
+    for(i = first_peer_of_unit(peer_list, num_peers, msg->src_unit);
+      i < num_peers && peer_list[i].src_unit == msg->src_unit; i++)
     {
-        // change to INVALID_PEER?
-        if(is_broadcast_did((const on_encoded_did_t*)
-          (&(peer_list[i].peer_did))))
-        {
-            break; // end of peer list reached.
-        }
-
-        if(peer_list[i].src_unit != msg->src_unit)
-        {
-            continue;
-        }
-        
-        // we have a match.
         one_net_memmove(dst_did_unit.did, peer_list[i].peer_did,
           ON_ENCODED_DID_LEN);
         dst_did_unit.unit = peer_list[i].peer_unit;
@@ -245,66 +298,135 @@ one_net_status_t one_net_add_peer_to_list(const UInt8 SRC_UNIT,
   on_peer_unit_t* peer_list, const on_encoded_did_t * const PEER_DID,
   const UInt8 PEER_UNIT)
 {
-    UInt8 vacant_index;
-    UInt8 num_peers_for_src = 0; // number of peers for this source
+    on_did_unit_t new_peer;
+    
+    if(!PEER_DID)
+    {
+        return ONS_BAD_PARAM;
+    }
+    
+    one_net_memmove(new_peer.did, *PEER_DID, ON_ENCODED_DID_LEN);
+    new_peer.unit = PEER_UNIT;
+    return one_net_add_peers_to_list(SRC_UNIT, peer_list, &new_peer, 1);
+} // one_net_add_peer_to_list //
+
+
+/*!
+    \brief Adds several peers of one source unit to the list
+    
+    Either all of the peers are added or none of them are.  Peers that are
+    already on the list are skipped.
+    
+    \param[in] SRC_UNIT The unit on this device being assigned the peers.
+    \param[in/out] The peer list to update
+    \param[in] PEERS The peer devices and units being assigned to this device.
+    \param[in] NUM_PEERS The number of peers in PEERS
+      
+    \return ONS_SUCCESS If the peers were successfully assigned
+            ONS_BAD_PARAM If the parameters are invalid
+            ONS_RSRC_FULL If the peers do not all fit on the list, or would
+              give SRC_UNIT more than ONE_NET_MAX_PEER_PER_TXN peers.
+*/
+one_net_status_t one_net_add_peers_to_list(const UInt8 SRC_UNIT,
+  on_peer_unit_t* peer_list, const on_did_unit_t* const PEERS,
+  const UInt8 NUM_PEERS)
+{
+    UInt8 i, j, num_peers, unit_start, unit_end, num_new = 0;
+    
+    // The peers are added to the end of the source unit's peers, which are
+    // all together, after moving the peers of the higher source units down.
+    
+    if(!PEERS || SRC_UNIT == ONE_NET_DEV_UNIT)
+    {
+        return ONS_BAD_PARAM;
+    }
     
     if(!peer_list)
     {
         peer_list = peer; // list notprovided, so we use the main list
     }
     
-    // There are a few possibilities
-    // 1.  Peer list is full.  If so, cannot add.  return ONS_RSRC_FULL.
-    // 2.  This peer assignment is already on the unit list.  If so, do nothing,
-	//     return ONS_SUCCESS.
-    // 3.  This peer assignment is not on the unit list, but the unit list is
-	//     full.  If so, do nothing and return ONS_RSRC_FULL.  Note that this is
-    //     a separate criteria than the one directly above, which looked to see
-    //     if the ENTIRE list was full.  This is a check of whether the UNIT
-    //     list is full.  Cannot add.  Return ONS_RSRC_FULL.
-    // 4.  This peer assignment is not on the unit list, and the unit list is
-	//     not full.  If so, proceed to step 5.	
-    // 5.  Insert the new peer assignment at the end of the peer list and
-    //     return ONS_SUCCESS.
-	
-
-    // find a spot to add the peer.  Empty spots should all be at the end and are
-    // represented by ONE_NET_DEV_UNIT.
-    for(vacant_index = 0; vacant_index < ONE_NET_MAX_PEER_UNIT; vacant_index++)
+    num_peers = one_net_count_peers(peer_list);
+    unit_start = first_peer_of_unit(peer_list, num_peers, SRC_UNIT);
+    unit_end = end_of_unit(peer_list, num_peers, unit_start, SRC_UNIT);
+    
+    for(i = 0; i < NUM_PEERS; i++)
     {
-        if(peer_list[vacant_index].peer_unit == ONE_NET_DEV_UNIT)
+        // the wildcards would read as the end of the list
+        if(PEERS[i].unit == ONE_NET_DEV_UNIT || on_encoded_did_equal(
+          (const on_encoded_did_t*) PEERS[i].did, &INVALID_PEER))
         {
-            // we have found our insertion point. Insert here.
-            peer_list[vacant_index].src_unit = SRC_UNIT;
-            peer_list[vacant_index].peer_unit = PEER_UNIT;
-            one_net_memmove(peer_list[vacant_index].peer_did,
-              *PEER_DID, ON_ENCODED_DID_LEN);
-            
+            return ONS_BAD_PARAM;
         }
         
-        if(peer_list[vacant_index].src_unit == SRC_UNIT)
+        for(j = unit_start; j < unit_end; j++)
         {
-            if(peer_list[vacant_index].peer_unit == PEER_UNIT &&
-              one_net_memcmp(peer_list[vacant_index].peer_did, *PEER_DID,
-              ON_ENCODED_DID_LEN) == 0)
+            if(peer_matches(&peer_list[j], (const on_encoded_did_t*)
+              PEERS[i].did, PEERS[i].unit))
             {
-                // Already on list.  Do not add.
-                return ONS_SUCCESS;
+                break; // Already on list.  Do not add.
             }
-            
-            // add one to the unit listand seeif we're outof room on the list
-            // for this particular unit.
-            num_peers_for_src++;
-            if(num_peers_for_src >= ONE_NET_MAX_PEER_PER_TXN)
+        }
+        if(j < unit_end)
+        {
+            continue;
+        }
+        
+        for(j = 0; j < i; j++)
+        {
+            if(PEERS[j].unit == PEERS[i].unit && on_encoded_did_equal(
+              (const on_encoded_did_t*) PEERS[j].did,
+              (const on_encoded_did_t*) PEERS[i].did))
             {
-                return ONS_RSRC_FULL;
+                break; // repeated in PEERS
             }
-        }      
-	}
-     
-    // if we got to here, then all spots are taken, so we cannot add.
-	return ONS_RSRC_FULL;
-} // one_net_add_peer_to_list //
+        }
+        if(j < i)
+        {
+            continue;
+        }
+        
+        num_new++;
+    }
+    
+    if(!num_new)
+    {
+        return ONS_SUCCESS;
+    }
+    
+    if(unit_end - unit_start + num_new > ONE_NET_MAX_PEER_PER_TXN
+      || num_peers + num_new > ONE_NET_MAX_PEER_UNIT)
+    {
+        return ONS_RSRC_FULL;
+    }
+    
+    one_net_memmove(&peer_list[unit_end + num_new], &peer_list[unit_end],
+      (num_peers - unit_end) * sizeof(on_peer_unit_t));
+    
+    for(i = 0; i < NUM_PEERS; i++)
+    {
+        for(j = unit_start; j < unit_end; j++)
+        {
+            if(peer_matches(&peer_list[j], (const on_encoded_did_t*)
+              PEERS[i].did, PEERS[i].unit))
+            {
+                break; // already on the list, or added earlier in this loop
+            }
+        }
+        if(j < unit_end)
+        {
+            continue;
+        }
+        
+        one_net_memmove(peer_list[unit_end].peer_did, PEERS[i].did,
+          ON_ENCODED_DID_LEN);
+        peer_list[unit_end].src_unit = SRC_UNIT;
+        peer_list[unit_end].peer_unit = PEERS[i].unit;
+        unit_end++;
+    }
+    
+    return ONS_SUCCESS;
+} // one_net_add_peers_to_list //
 
 
 /*!
@@ -329,63 +451,55 @@ one_net_status_t one_net_remove_peer_from_list(const UInt8 SRC_UNIT,
   const UInt8 PEER_UNIT)
 {
     // note : "Wildcards are units with value ONE_NET_DEV_UNIT and
-    // DIDs of INVALID_PEER_DID.  We go through the list and check each element
-    // to see if there is a match.  If so, we delete.
+    // DIDs of INVALID_PEER_DID.  We go through the source unit's peers, or
+    // the whole list if the source unit is a wildcard, keeping the ones that
+    // do not match, then move the rest of the list up in one go.
     
-    SInt8 i; // signed because this can be negative
+    UInt8 i, num_peers, start, end, kept;
     
     if(!peer_list)
     {
         peer_list = peer;
     }
 
+    num_peers = one_net_count_peers(peer_list);
+    if(SRC_UNIT == ONE_NET_DEV_UNIT)
+    {
+        start = 0;
+        end = num_peers;
+    }
+    else
+    {
+        start = first_peer_of_unit(peer_list, num_peers, SRC_UNIT);
+        end = end_of_unit(peer_list, num_peers, start, SRC_UNIT);
+    }
     
-    for(i = 0; i < ONE_NET_MAX_PEER_UNIT; i++)
+    for(i = start, kept = start; i < end; i++)
     {
-        // check to see if we are at the end of the list
-        if(peer_list[i].peer_unit == ONE_NET_DEV_UNIT)
+        if(peer_matches(&peer_list[i], PEER_DID, PEER_UNIT))
         {
-            // end of the list.
-            break;
-        }        
-        
-        // check the did criteria.
-        if(!on_encoded_did_equal(PEER_DID, &INVALID_PEER) &&
-           !on_encoded_did_equal(PEER_DID, (const on_encoded_did_t* const)
-           &(peer_list[i].peer_did)))
-        {
-            continue; // not a match or wildcard
+            continue; // this element should be removed
         }
         
-        // check the source unit
-        if(SRC_UNIT != ONE_NET_DEV_UNIT && SRC_UNIT != peer_list[i].src_unit)
-        {
-            continue; // not a match or wildcard
-        }      
-        
-        // check the peer unit
-        if(PEER_UNIT != ONE_NET_DEV_UNIT && PEER_UNIT !=
-           peer_list[i].peer_unit)
+        if(kept != i)
         {
-            continue; // not a match or wildcard
+            peer_list[kept] = peer_list[i];
         }
-
-        
-        // this element should be removed
-        
-        
-        // move everything after up one spot
-        one_net_memmove(&peer_list[i], &peer_list[i+1], (ONE_NET_MAX_PEER_UNIT
-           - i - 1) * sizeof(on_peer_unit_t));
-           
-        // now blank out the last spot if not already blanked out.
-        peer_list[ONE_NET_MAX_PEER_UNIT - 1].peer_unit = ONE_NET_DEV_UNIT;
-        
-        i--; // we just deleted and we're going to increment at the top of the
-             // loop, but since the indexes have changed, we want to keep our
-             // loop index the same, so decrement here to cancel things out.
+        kept++;
     }
     
+    if(kept == end)
+    {
+        return ONS_SUCCESS; // nothing removed
+    }
+    
+    one_net_memmove(&peer_list[kept], &peer_list[end], (num_peers - end) *
+      sizeof(on_peer_unit_t));
+    
+    // now blank out the spots that were freed up at the end.
+    one_net_memset_block(&peer_list[num_peers - (end - kept)],
+      sizeof(EMPTY_PEER), end - kept, &EMPTY_PEER);
+    
     return ONS_SUCCESS;
 }
 
@@ -404,6 +518,85 @@ one_net_status_t one_net_remove_peer_from_list(const UInt8 SRC_UNIT,
 //! @{
 
 
+/*!
+    \brief Finds where the peers of a source unit start in a sorted list.
+    
+    \param[in] peer_list The list
+    \param[in] NUM_PEERS The number of peers in the list
+    \param[in] SRC_UNIT The source unit
+    
+    \return The index of the first peer of SRC_UNIT.  If it has no peers,
+      where they would go.
+*/
+static UInt8 first_peer_of_unit(const on_peer_unit_t* const peer_list,
+  const UInt8 NUM_PEERS, const UInt8 SRC_UNIT)
+{
+    UInt8 low = 0, high = NUM_PEERS, mid;
+    
+    while(low < high)
+    {
+        mid = low + (high - low) / 2;
+        if(peer_list[mid].src_unit < SRC_UNIT)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    
+    return low;
+} // first_peer_of_unit //
+
+
+/*!
+    \brief Finds the end of a source unit's peers.
+    
+    \param[in] peer_list The list
+    \param[in] NUM_PEERS The number of peers in the list
+    \param[in] index The first peer of the source unit
+    \param[in] SRC_UNIT The source unit
+    
+    \return The index after the last peer of the source unit
+*/
+static UInt8 end_of_unit(const on_peer_unit_t* const peer_list,
+  const UInt8 NUM_PEERS, UInt8 index, const UInt8 SRC_UNIT)
+{
+    while(index < NUM_PEERS && peer_list[index].src_unit == SRC_UNIT)
+    {
+        index++;
+    }
+    
+    return index;
+} // end_of_unit //
+
+
+/*!
+    \brief Checks a peer list entry against a device and unit.
+    
+    \param[in] ENTRY The peer list entry
+    \param[in] PEER_DID The device.  INVALID_PEER is a wildcard.
+    \param[in] PEER_UNIT The unit in the device.  ONE_NET_DEV_UNIT is a
+      wildcard.
+    
+    \return TRUE if the entry matches
+            FALSE otherwise
+*/
+static BOOL peer_matches(const on_peer_unit_t* const ENTRY,
+  const on_encoded_did_t* const PEER_DID, const UInt8 PEER_UNIT)
+{
+    if(!on_encoded_did_equal(PEER_DID, &INVALID_PEER) &&
+      !on_encoded_did_equal(PEER_DID, (const on_encoded_did_t* const)
+      &(ENTRY->peer_did)))
+    {
+        return FALSE;
+    }
+    
+    return PEER_UNIT == ONE_NET_DEV_UNIT || PEER_UNIT == ENTRY->peer_unit;
+} // peer_matches //
+
+
 //! @} ONE-NET_PEER_pri_func
 //                      PRIVATE FUNCTION IMPLEMENTATION END
 //==============================================================================
@@ -131,12 +131,16 @@ extern on_peer_unit_t* const peer;
 
 
 one_net_status_t one_net_reset_peers(void);
+void one_net_sort_peers(on_peer_unit_t* peer_list);
 UInt8 one_net_count_peers(const on_peer_unit_t* peer_list);
 void add_peers_to_recipient_list(const on_single_data_queue_t*
   msg, on_recipient_list_t* send_list, const on_peer_unit_t* peer_list);
 one_net_status_t one_net_add_peer_to_list(const UInt8 SRC_UNIT,
   on_peer_unit_t* peer_list, const on_encoded_did_t * const PEER_DID,
   const UInt8 PEER_UNIT);
+one_net_status_t one_net_add_peers_to_list(const UInt8 SRC_UNIT,
+  on_peer_unit_t* peer_list, const on_did_unit_t* const PEERS,
+  const UInt8 NUM_PEERS);
 one_net_status_t one_net_remove_peer_from_list(const UInt8 SRC_UNIT,
   on_peer_unit_t* peer_list, const on_encoded_did_t * const PEER_DID,
   const UInt8 PEER_UNIT);
@@ -0,0 +1,359 @@
+//! \addtogroup ONE-NET_RTT ONE-NET round trip time estimates
+//! \ingroup ONE-NET_RTT
+//! @{
+
+/*
+    Copyright (c) 2012, Threshold Corporation
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+        * Redistributions of source code must retain the above copyright notice,
+          this list of conditions, and the following disclaimer.
+        * Redistributions in binary form must reproduce the above copyright
+          notice, this list of conditions and the following disclaimer in the
+          documentation and/or other materials provided with the distribution.
+        * Neither the name of Threshold Corporation (trustee of ONE-NET) nor the
+          names of its contributors may be used to endorse or promote products
+          derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+    CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+    INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+    BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+    OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+    BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHEWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*!
+    \file one_net_rtt.c
+    \brief ONE-NET round trip time estimator implementation.
+
+    The estimates are kept in a small table, most recently used first.  When
+    the table is full, a new destination replaces the least recently used
+    one.  The smoothed round trip time is kept in 1/8 ms and its variation in
+    1/4 ms so the usual gains of 1/8 and 1/4 are shifts.
+
+    \note See one_net.h for the version of the ONE-NET source as a whole.  If
+      any one file is modified, the version number in one_net.h will need to be
+      updated.
+*/
+
+#include "config_options.h"
+
+#ifdef ADAPTIVE_RESPONSE_TIMEOUT
+
+
+#include "one_net_rtt.h"
+#include "one_net_application.h"
+#include "one_net_port_specific.h"
+#include "one_net_context.h"
+
+
+
+//==============================================================================
+//                                  CONSTANTS
+//! \defgroup ONE-NET_RTT_const
+//! \ingroup ONE-NET_RTT
+//! @{
+
+
+//! The longest round trip time in ms that is measured.  Keeps the scaled
+//! estimates in 16 bits.
+#define MAX_RTT_SAMPLE_MS 4000
+
+
+//! @} ONE-NET_RTT_const
+//                                  CONSTANTS END
+//==============================================================================
+
+//==============================================================================
+//                              PRIVATE VARIABLES
+//! \defgroup ONE-NET_RTT_pri_var
+//! \ingroup ONE-NET_RTT
+//! @{
+
+
+//! The estimates, most recently used first
+static ONE_NET_DEVICE_STATE on_rtt_t rtt_table[ONE_NET_RTT_TABLE_SIZE];
+
+//! The number of estimates in rtt_table
+static ONE_NET_DEVICE_STATE UInt8 rtt_count = 0;
+
+
+//! @} ONE-NET_RTT_pri_var
+//                              PRIVATE VARIABLES END
+//==============================================================================
+
+//==============================================================================
+//                      PRIVATE FUNCTION DECLARATIONS
+//! \defgroup ONE-NET_RTT_pri_func
+//! \ingroup ONE-NET_RTT
+//! @{
+
+
+static on_rtt_t* find_rtt(const on_encoded_did_t* const DID,
+  const UInt8 HOPS, const BOOL ADD);
+
+
+//! @} ONE-NET_RTT_pri_func
+//                      PRIVATE FUNCTION DECLARATIONS END
+//==============================================================================
+
+//==============================================================================
+//                      PUBLIC FUNCTION IMPLEMENTATION
+//! \defgroup ONE-NET_RTT_pub_func
+//! \ingroup ONE-NET_RTT
+//! @{
+
+
+/*!
+    \brief Forgets all of the round trip time estimates.
+
+    \return void
+*/
+void one_net_rtt_reset(void)
+{
+    rtt_count = 0;
+} // one_net_rtt_reset //
+
+
+/*!
+    \brief Adds a measured round trip time to the estimate for a destination.
+
+    Only measure responses to packets that were sent once.  The response to
+    a retried packet could be to any of the tries.
+
+    \param[in] DID The destination the packet was sent to
+    \param[in] HOPS The number of hops the packet was sent with
+    \param[in] rtt_ms The time in ms from sending the packet to receiving
+      the response
+
+    \return void
+*/
+void one_net_rtt_sample(const on_encoded_did_t* const DID, const UInt8 HOPS,
+  UInt16 rtt_ms)
+{
+    on_rtt_t* entry = find_rtt(DID, HOPS, TRUE);
+    SInt32 delta;
+
+    if(!entry)
+    {
+        return;
+    } // if the table can't hold an estimate //
+
+    if(rtt_ms > MAX_RTT_SAMPLE_MS)
+    {
+        rtt_ms = MAX_RTT_SAMPLE_MS;
+    } // if the sample is too long //
+
+    entry->backoff = 0;
+    if(!entry->srtt)
+    {
+        // the first measurement.  The variation starts at half of it.
+        entry->srtt = rtt_ms << 3;
+        entry->rttvar = rtt_ms << 1;
+        if(!entry->srtt)
+        {
+            // keep 0 meaning "not measured"
+            entry->srtt = 1;
+        } // if the round trip was under a ms //
+        return;
+    } // if this is the first measurement //
+
+    // srtt += (rtt - srtt) / 8
+    delta = (SInt32) rtt_ms - (entry->srtt >> 3);
+    entry->srtt = (UInt16) ((SInt32) entry->srtt + delta);
+    if(!entry->srtt)
+    {
+        entry->srtt = 1;
+    } // if the smoothed time reached 0 //
+
+    // rttvar += (|rtt - srtt| - rttvar) / 4
+    if(delta < 0)
+    {
+        delta = -delta;
+    } // if the sample was shorter than the estimate //
+    delta -= (entry->rttvar >> 2);
+    entry->rttvar = (UInt16) ((SInt32) entry->rttvar + delta);
+} // one_net_rtt_sample //
+
+
+/*!
+    \brief Notes that a response from a destination timed out.
+
+    Doubles the response timeout for the destination until the next
+    measurement.
+
+    \param[in] DID The destination the packet was sent to
+    \param[in] HOPS The number of hops the packet was sent with
+
+    \return void
+*/
+void one_net_rtt_timed_out(const on_encoded_did_t* const DID,
+  const UInt8 HOPS)
+{
+    on_rtt_t* entry = find_rtt(DID, HOPS, FALSE);
+
+    if(entry && entry->backoff < ONE_NET_RTT_MAX_BACKOFF)
+    {
+        (entry->backoff)++;
+    } // if the timeout can still be doubled //
+} // one_net_rtt_timed_out //
+
+
+/*!
+    \brief Returns the response timeout to use for a destination.
+
+    \param[in] DID The destination the packet is being sent to
+    \param[in] HOPS The number of hops the packet is being sent with
+    \param[in] MAX_MS The worst case timeout in ms.  This is returned if
+      nothing has been measured for the destination, and the estimate never
+      goes past it.
+
+    \return The response timeout in ms.
+*/
+UInt16 one_net_rtt_timeout(const on_encoded_did_t* const DID,
+  const UInt8 HOPS, const UInt16 MAX_MS)
+{
+    on_rtt_t* entry = find_rtt(DID, HOPS, FALSE);
+    UInt16 timeout_ms;
+
+    if(!entry || !entry->srtt)
+    {
+        return MAX_MS;
+    } // if there is no estimate //
+
+    timeout_ms = one_net_rtt_entry_timeout(entry);
+    return (timeout_ms < MAX_MS ? timeout_ms : MAX_MS);
+} // one_net_rtt_timeout //
+
+
+/*!
+    \brief Returns one of the estimates, most recently used first.
+
+    \param[in] INDEX The index of the estimate
+
+    \return The estimate or NULL if INDEX is past the last one.
+*/
+const on_rtt_t* one_net_rtt_entry(const UInt8 INDEX)
+{
+    return (INDEX < rtt_count ? &rtt_table[INDEX] : NULL);
+} // one_net_rtt_entry //
+
+
+/*!
+    \brief Returns the response timeout an estimate gives.
+
+    The timeout is the smoothed round trip time plus four times its
+    variation, but at least ONE_NET_RTT_MIN_MARGIN more than the round trip
+    time, doubled for each timeout since the last measurement.  It is not
+    limited by the worst case timeout.
+
+    \param[in] ENTRY The estimate
+
+    \return The response timeout in ms.
+*/
+UInt16 one_net_rtt_entry_timeout(const on_rtt_t* const ENTRY)
+{
+    UInt32 timeout_ms;
+    
+    if(!ENTRY)
+    {
+        return 0;
+    } // if the parameter is invalid //
+
+    // srtt is kept as 8 * SRTT and rttvar as 4 * RTTVAR, so this is
+    // (SRTT + max(4 * RTTVAR, ONE_NET_RTT_MIN_MARGIN)) << backoff.
+    timeout_ms = ENTRY->rttvar > ONE_NET_RTT_MIN_MARGIN ? ENTRY->rttvar :
+      ONE_NET_RTT_MIN_MARGIN;
+    timeout_ms = ((ENTRY->srtt >> 3) + timeout_ms) << ENTRY->backoff;
+    return (timeout_ms > 0xFFFF ? 0xFFFF : (UInt16) timeout_ms);
+} // one_net_rtt_entry_timeout //
+
+
+//! @} ONE-NET_RTT_pub_func
+//                      PUBLIC FUNCTION IMPLEMENTATION END
+//==============================================================================
+
+//==============================================================================
+//                      PRIVATE FUNCTION IMPLEMENTATION
+//! \addtogroup ONE-NET_RTT_pri_func
+//! \ingroup ONE-NET_RTT
+//! @{
+
+
+/*!
+    \brief Finds the estimate for a destination and moves it to the front.
+
+    \param[in] DID The destination
+    \param[in] HOPS The number of hops
+    \param[in] ADD If TRUE and there is no estimate yet, an empty one is
+      added in front, replacing the least recently used one if the table is
+      full.
+
+    \return The estimate or NULL if there is none and ADD is FALSE.
+*/
+static on_rtt_t* find_rtt(const on_encoded_did_t* const DID,
+  const UInt8 HOPS, const BOOL ADD)
+{
+    on_rtt_t entry;
+    UInt8 i;
+
+    if(!DID)
+    {
+        return NULL;
+    } // if the parameter is invalid //
+
+    for(i = 0; i < rtt_count; i++)
+    {
+        if(rtt_table[i].hops == HOPS && on_encoded_did_equal(DID,
+          (const on_encoded_did_t* const) &(rtt_table[i].did)))
+        {
+            break;
+        } // if found //
+    } // loop through the estimates //
+
+    if(i < rtt_count)
+    {
+        entry = rtt_table[i];
+    } // if found //
+    else if(ADD)
+    {
+        one_net_memmove(entry.did, *DID, sizeof(entry.did));
+        entry.hops = HOPS;
+        entry.backoff = 0;
+        entry.srtt = 0;
+        entry.rttvar = 0;
+        if(rtt_count < ONE_NET_RTT_TABLE_SIZE)
+        {
+            rtt_count++;
+        } // if there is room //
+        i = rtt_count - 1;
+    } // else if it should be added //
+    else
+    {
+        return NULL;
+    } // else not found //
+
+    // move everything in front of it back one and put it in front
+    one_net_memmove(&rtt_table[1], &rtt_table[0], i * sizeof(on_rtt_t));
+    rtt_table[0] = entry;
+    return &rtt_table[0];
+} // find_rtt //
+
+
+//! @} ONE-NET_RTT_pri_func
+//                      PRIVATE FUNCTION IMPLEMENTATION END
+//==============================================================================
+
+#endif // if ADAPTIVE_RESPONSE_TIMEOUT is defined //
+
+//! @} ONE-NET_RTT
@@ -0,0 +1,146 @@
+#ifndef ONE_NET_RTT_H
+#define ONE_NET_RTT_H
+
+//! \defgroup ONE-NET_RTT ONE-NET round trip time estimates.
+//! \ingroup ONE-NET_RTT
+//! @{
+
+/*
+    Copyright (c) 2012, Threshold Corporation
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+        * Redistributions of source code must retain the above copyright notice,
+          this list of conditions, and the following disclaimer.
+        * Redistributions in binary form must reproduce the above copyright
+          notice, this list of conditions and the following disclaimer in the
+          documentation and/or other materials provided with the distribution.
+        * Neither the name of Threshold Corporation (trustee of ONE-NET) nor the
+          names of its contributors may be used to endorse or promote products
+          derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+    CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+    INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+    BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+    OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+    BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHEWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*!
+    \file one_net_rtt.h
+    \brief ONE-NET round trip time estimator declarations.
+
+    Keeps a smoothed round trip time and its variation for each destination
+    and hop count a single transaction is sent to, the same way TCP does
+    (RFC 6298), and turns them into the response timeout.  Only responses to
+    packets that were not retried are measured, and every timeout doubles
+    the next response timeout for that destination until a measurement gets
+    through.
+
+    \note See one_net.h for the version of the ONE-NET source as a whole.  If
+      any one file is modified, the version number in one_net.h will need to be
+      updated.
+*/
+
+#include "config_options.h"
+
+#ifdef ADAPTIVE_RESPONSE_TIMEOUT
+
+#include "one_net_types.h"
+#include "one_net_packet.h"
+#include "one_net_port_const.h"
+
+
+//==============================================================================
+//                                  CONSTANTS
+//! \defgroup ONE-NET_RTT_const
+//! \ingroup ONE-NET_RTT
+//! @{
+
+
+//! The most times in a row a response timeout is doubled
+#define ONE_NET_RTT_MAX_BACKOFF 4
+
+
+//! @} ONE-NET_RTT_const
+//                                  CONSTANTS END
+//==============================================================================
+
+//==============================================================================
+//                                  TYPEDEFS
+//! \defgroup ONE-NET_RTT_typedefs
+//! \ingroup ONE-NET_RTT
+//! @{
+
+
+/*!
+    \brief The round trip time estimate for one destination and hop count
+*/
+typedef struct
+{
+    //! The destination
+    on_encoded_did_t did;
+
+    //! The number of hops the packets were sent with
+    UInt8 hops;
+
+    //! How many times in a row the response timed out
+    UInt8 backoff;
+
+    //! Smoothed round trip time in 1/8 ms
+    UInt16 srtt;
+
+    //! Round trip time variation in 1/4 ms
+    UInt16 rttvar;
+} on_rtt_t;
+
+
+//! @} ONE-NET_RTT_typedefs
+//                                  TYPEDEFS END
+//==============================================================================
+
+//==============================================================================
+//                              PUBLIC VARIABLES
+//! \defgroup ONE-NET_RTT_pub_var
+//! \ingroup ONE-NET_RTT
+//! @{
+
+
+//! @} ONE-NET_RTT_pub_var
+//                              PUBLIC VARIABLES END
+//==============================================================================
+
+//==============================================================================
+//                      PUBLIC FUNCTION DECLARATIONS
+//! \defgroup ONE-NET_RTT_pub_func
+//! \ingroup ONE-NET_RTT
+//! @{
+
+
+void one_net_rtt_reset(void);
+void one_net_rtt_sample(const on_encoded_did_t* const DID, const UInt8 HOPS,
+  UInt16 rtt_ms);
+void one_net_rtt_timed_out(const on_encoded_did_t* const DID,
+  const UInt8 HOPS);
+UInt16 one_net_rtt_timeout(const on_encoded_did_t* const DID,
+  const UInt8 HOPS, const UInt16 MAX_MS);
+const on_rtt_t* one_net_rtt_entry(const UInt8 INDEX);
+UInt16 one_net_rtt_entry_timeout(const on_rtt_t* const ENTRY);
+
+
+//! @} ONE-NET_RTT_pub_func
+//                      PUBLIC FUNCTION DECLARATIONS END
+//==============================================================================
+
+//! @} ONE-NET_RTT
+#endif // ADAPTIVE_RESPONSE_TIMEOUT defined //
+#endif // ONE_NET_RTT_H //
@@ -0,0 +1,225 @@
+//! \addtogroup one_net_context
+//! @{
+
+/*
+    Copyright (c) 2012, Threshold Corporation
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+        * Redistributions of source code must retain the above copyright notice,
+          this list of conditions, and the following disclaimer.
+        * Redistributions in binary form must reproduce the above copyright
+          notice, this list of conditions and the following disclaimer in the
+          documentation and/or other materials provided with the distribution.
+        * Neither the name of Threshold Corporation (trustee of ONE-NET) nor the
+          names of its contributors may be used to endorse or promote products
+          derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+    CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+    INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+    BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+    OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+    BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHEWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*!
+    \file one_net_context.c
+    \brief Swapping the state of one device for another.
+
+    See one_net_context.h.  The ONE_NET_DEVICE_STATE variables are all in the
+    one_net_device_state section, which the linker brackets with
+    __start_one_net_device_state and __stop_one_net_device_state.  Making a
+    device current stores the live section in the context of the device that
+    was current, then loads the section from the new device's context.
+
+    \note See one_net.h for the version of the ONE-NET source as a whole.  If
+      any one file is modified, the version number in one_net.h will need to be
+      updated.
+*/
+
+#include "config_options.h"
+#include "one_net_types.h"
+#include "one_net_context.h"
+
+
+#ifdef ONE_NET_DEVICE_CONTEXT
+
+
+#include <stdlib.h>
+#include "one_net_port_specific.h"
+
+
+
+//==============================================================================
+//                              PRIVATE VARIABLES
+//! \defgroup one_net_context_pri_var
+//! \ingroup one_net_context
+//! @{
+
+
+//! Bounds of the device state, filled in by the linker
+extern UInt8 __start_one_net_device_state[];
+extern UInt8 __stop_one_net_device_state[];
+
+//! The device whose state is in the section, NULL if none
+static on_device_context_t* current_context = NULL;
+
+//! The section as it was before any device ran, which is what every new
+//! context starts from
+static UInt8* initial_state = NULL;
+
+
+//! @} one_net_context_pri_var
+//                              PRIVATE VARIABLES END
+//==============================================================================
+
+//=============================================================================
+//                      PUBLIC FUNCTION IMPLEMENTATION
+//! \defgroup one_net_context_pub_func
+//! \ingroup one_net_context
+//! @{
+
+
+/*!
+    \brief The number of bytes of state each device has.
+
+    \return The size of the ONE_NET_DEVICE_STATE variables in bytes.
+*/
+UInt32 one_net_context_size(void)
+{
+    return (UInt32)(__stop_one_net_device_state -
+      __start_one_net_device_state);
+} // one_net_context_size //
+
+
+/*!
+    \brief Sets up a context for a new device.
+
+    The device starts out in the state a device would be in at power up.  The
+    first context must be set up before any ONE-NET function has been called.
+
+    \param[out] ctx The context to set up
+
+    \return ONS_SUCCESS if the context was set up
+             ONS_BAD_PARAM if ctx is NULL
+             ONS_RSRC_FULL if there is not enough memory
+*/
+one_net_status_t one_net_context_init(on_device_context_t* ctx)
+{
+    UInt32 size = one_net_context_size();
+
+    if(!ctx)
+    {
+        return ONS_BAD_PARAM;
+    } // if the parameter is invalid //
+
+    if(!initial_state)
+    {
+        if(!(initial_state = malloc(size)))
+        {
+            return ONS_RSRC_FULL;
+        } // if out of memory //
+        one_net_memmove(initial_state, __start_one_net_device_state, size);
+    } // if this is the first context //
+
+    if(!(ctx->state = malloc(size)))
+    {
+        return ONS_RSRC_FULL;
+    } // if out of memory //
+
+    one_net_memmove(ctx->state, initial_state, size);
+    return ONS_SUCCESS;
+} // one_net_context_init //
+
+
+/*!
+    \brief Releases a context.
+
+    \param[in/out] ctx The context to release.  If it is current, no device
+      is current afterwards.
+
+    \return void
+*/
+void one_net_context_free(on_device_context_t* ctx)
+{
+    if(!ctx)
+    {
+        return;
+    } // if the parameter is invalid //
+
+    if(ctx == current_context)
+    {
+        current_context = NULL;
+    } // if freeing the current device //
+
+    free(ctx->state);
+    ctx->state = NULL;
+} // one_net_context_free //
+
+
+/*!
+    \brief Makes a device current.
+
+    Every ONE-NET function called afterwards works on this device.
+    one_net(), one_net_master(), and one_net_client() do this themselves, so
+    this only needs to be called before calling anything else (initializing
+    the device, queueing messages, the cli, etc.).  Switching to the device
+    that is already current costs nothing.
+
+    \param[in] ctx The device to make current.  It must have been set up by
+      one_net_context_init.
+
+    \return void
+*/
+void one_net_set_context(on_device_context_t* ctx)
+{
+    UInt32 size;
+
+    if(ctx == current_context || !ctx || !ctx->state)
+    {
+        return;
+    } // if nothing to do or the parameter is invalid //
+
+    size = one_net_context_size();
+    if(current_context)
+    {
+        one_net_memmove(current_context->state, __start_one_net_device_state,
+          size);
+    } // if a device was current //
+
+    one_net_memmove(__start_one_net_device_state, ctx->state, size);
+    current_context = ctx;
+} // one_net_set_context //
+
+
+/*!
+    \brief The current device.
+
+    Callbacks from ONE-NET (one_net_master_device_is_awake, etc.) can use
+    this to tell which device they are for.
+
+    \return The current device, NULL if none
+*/
+on_device_context_t* one_net_get_context(void)
+{
+    return current_context;
+} // one_net_get_context //
+
+
+//! @} one_net_context_pub_func
+//                      PUBLIC FUNCTION IMPLEMENTATION END
+//==============================================================================
+
+
+#endif // ONE_NET_DEVICE_CONTEXT //
+
+//! @} one_net_context
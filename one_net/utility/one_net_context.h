@@ -0,0 +1,141 @@
+#ifndef ONE_NET_CONTEXT_H
+#define ONE_NET_CONTEXT_H
+
+
+
+//! \defgroup one_net_context Per device state for hosting many devices
+//! @{
+
+/*
+    Copyright (c) 2012, Threshold Corporation
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+        * Redistributions of source code must retain the above copyright notice,
+          this list of conditions, and the following disclaimer.
+        * Redistributions in binary form must reproduce the above copyright
+          notice, this list of conditions and the following disclaimer in the
+          documentation and/or other materials provided with the distribution.
+        * Neither the name of Threshold Corporation (trustee of ONE-NET) nor the
+          names of its contributors may be used to endorse or promote products
+          derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+    CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+    INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+    BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+    OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+    BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHEWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*!
+    \file one_net_context.h
+    \brief Per device context declarations.
+
+    Normally a build of ONE-NET is one device and its state is in file scope
+    variables.  When ONE_NET_DEVICE_CONTEXT is defined, every variable that
+    belongs to a device is marked ONE_NET_DEVICE_STATE, which places it in
+    its own linker section.  Each device has a context holding its own copy
+    of that section, and the copy is swapped in when the device is made
+    current, so any number of MASTERs and CLIENTs can be run from one
+    process.  Pointers into the device state (the single data queue, the
+    heap, the transaction packet buffers, etc.) stay valid since every device
+    uses the variables at the same addresses.
+
+    The devices take turns.  Only one device can be current at a time, so
+    only one thread may run ONE-NET.
+
+    ONE_NET_DEVICE_CONTEXT needs gcc and an ELF linker.  It is meant for
+    desktop simulation and load testing, not for the embedded targets.
+
+    \note See one_net.h for the version of the ONE-NET source as a whole.  If
+      any one file is modified, the version number in one_net.h will need to be
+      updated.
+*/
+
+#include "config_options.h"
+#include "one_net_types.h"
+#include "one_net_status_codes.h"
+
+
+//==============================================================================
+//                                  CONSTANTS
+//! \defgroup one_net_context_const
+//! \ingroup one_net_context
+//! @{
+
+
+#ifdef ONE_NET_DEVICE_CONTEXT
+    #if !defined(__GNUC__) || !defined(__ELF__)
+        #error "ONE_NET_DEVICE_CONTEXT needs gcc and an ELF target"
+    #endif
+
+    //! Marks a variable that each device has its own copy of.
+    #define ONE_NET_DEVICE_STATE __attribute__((section("one_net_device_state")))
+#else
+    #define ONE_NET_DEVICE_STATE
+#endif
+
+
+//! @} one_net_context_const
+//                                  CONSTANTS END
+//==============================================================================
+
+
+#ifdef ONE_NET_DEVICE_CONTEXT
+
+
+//==============================================================================
+//                                  TYPEDEFS
+//! \defgroup one_net_context_typedefs
+//! \ingroup one_net_context
+//! @{
+
+
+//! The state of one device
+typedef struct
+{
+    //! This device's copy of the ONE_NET_DEVICE_STATE variables.  Only up to
+    //! date while the device is not current.
+    UInt8* state;
+} on_device_context_t;
+
+
+//! @} one_net_context_typedefs
+//                                  TYPEDEFS END
+//==============================================================================
+
+
+
+//==============================================================================
+//                      PUBLIC FUNCTION DECLARATIONS
+//! \defgroup one_net_context_pub_func
+//! \ingroup one_net_context
+//! @{
+
+
+UInt32 one_net_context_size(void);
+one_net_status_t one_net_context_init(on_device_context_t* ctx);
+void one_net_context_free(on_device_context_t* ctx);
+void one_net_set_context(on_device_context_t* ctx);
+on_device_context_t* one_net_get_context(void);
+
+
+//! @} one_net_context_pub_func
+//                      PUBLIC FUNCTION DECLARATIONS END
+//==============================================================================
+
+
+#endif // ONE_NET_DEVICE_CONTEXT //
+
+//! @} one_net_context
+
+#endif // ONE_NET_CONTEXT_H //
@@ -49,6 +49,11 @@
 #include "config_options.h"
 #include "one_net_port_specific.h"
 #include "one_net_xtea.h"
+#include "one_net_crc.h"
+
+#ifdef CRC_LOOKUP_TABLE
+    #include "one_net_crc_table.h"
+#endif
 
 
 // TODO -- this is a bit messy.  Find a better #define test.
@@ -103,6 +108,34 @@
 //! \ingroup one_net_crc
 //! @{
 
+/*!
+    \brief Computes CRCs for 16th order or less polynomials.
+
+    Uses the table driven implementation for the 8th order polynomial if
+    CRC_LOOKUP_TABLE is defined, otherwise goes bit by bit.  See
+    one_net_compute_crc_bitwise.
+
+    \param[in] DATA, byte stream of data to get CRC for
+    \param[in] LEN, length of given byte stream
+    \param[in] STARTING_CRC, the inital crc to use
+    \param[in] ORDER The order of the polynomial to compute
+   
+    \return an updated CRC (in a UInt16)
+*/
+UInt16 one_net_compute_crc(const UInt8 * const DATA, const UInt8 LEN, 
+  const UInt16 STARTING_CRC, const UInt8 ORDER)
+{
+    #ifdef CRC_LOOKUP_TABLE
+    if(DATA && ORDER == 8)
+    {
+        return one_net_compute_crc8(DATA, LEN, (UInt8) STARTING_CRC);
+    } // if 8th order crc //
+    #endif
+
+    return one_net_compute_crc_bitwise(DATA, LEN, STARTING_CRC, ORDER);
+} // one_net_compute_crc //
+
+
 /*
     \brief Computes CRCs for 16th order or less polynomials.
 
@@ -111,6 +144,9 @@
 
     Currently, only an 8th order polynomial is implemented.
 
+    This is the reference implementation.  The table driven versions below
+    must produce exactly the same result.
+
     \param[in] DATA, byte stream of data to get CRC for
     \param[in] LEN, length of given byte stream
     \param[in] STARTING_CRC, the inital crc to use
@@ -119,7 +155,7 @@
     \return an updated CRC (in a UInt16)
 
 */
-UInt16 one_net_compute_crc(const UInt8 * const DATA, const UInt8 LEN, 
+UInt16 one_net_compute_crc_bitwise(const UInt8 * const DATA, const UInt8 LEN, 
   const UInt16 STARTING_CRC, const UInt8 ORDER)
 {
     // bit by bit algorithm without augmented zero bytes.
@@ -174,7 +210,96 @@ UInt16 one_net_compute_crc(const UInt8 * const DATA, const UInt8 LEN,
     } // for LEN //
 
     return crc & mask;
-} // one_net_compute_crc //
+} // one_net_compute_crc_bitwise //
+
+
+#ifdef CRC_LOOKUP_TABLE
+/*!
+    \brief Computes the 8th order (0xA6) CRC one byte at a time.
+
+    Uses only the first row of the lookup table.  Bit-exact with
+    one_net_compute_crc_bitwise for ORDER 8.
+
+    \param[in] DATA, byte stream of data to get CRC for
+    \param[in] LEN, length of given byte stream
+    \param[in] STARTING_CRC, the inital crc to use
+
+    \return the updated CRC
+*/
+UInt8 one_net_compute_crc8_table(const UInt8 * const DATA, const UInt16 LEN,
+  const UInt8 STARTING_CRC)
+{
+    const UInt8 * p = DATA;
+    const UInt8 * const END = DATA + LEN;
+    UInt8 crc = STARTING_CRC;
+
+    if(!DATA)
+    {
+        return 0;
+    } // parameter was invalid //
+
+    while(p < END)
+    {
+        crc = on_crc8_table[0][crc ^ *p++];
+    } // while more bytes //
+
+    return crc;
+} // one_net_compute_crc8_table //
+
+
+#if CRC_SLICE_BY > 1
+/*!
+    \brief Computes the 8th order (0xA6) CRC CRC_SLICE_BY bytes at a time.
+
+    Since the crc is linear, the crc over a group of bytes is the xor of each
+    byte's contribution.  Row k of the table is the crc of a byte followed by
+    k zero bytes, so the first byte of a group (which has the running crc
+    folded into it) uses the last row, and the last byte uses row 0.  Any
+    bytes left over at the end are done one at a time.
+
+    \param[in] DATA, byte stream of data to get CRC for
+    \param[in] LEN, length of given byte stream
+    \param[in] STARTING_CRC, the inital crc to use
+
+    \return the updated CRC
+*/
+UInt8 one_net_compute_crc8_slice(const UInt8 * const DATA, const UInt16 LEN,
+  const UInt8 STARTING_CRC)
+{
+    const UInt8 * p = DATA;
+    UInt16 remaining = LEN;
+    UInt8 crc = STARTING_CRC;
+
+    if(!DATA)
+    {
+        return 0;
+    } // parameter was invalid //
+
+    while(remaining >= CRC_SLICE_BY)
+    {
+        #if CRC_SLICE_BY == 8
+        crc = on_crc8_table[7][crc ^ p[0]] ^ on_crc8_table[6][p[1]]
+          ^ on_crc8_table[5][p[2]] ^ on_crc8_table[4][p[3]]
+          ^ on_crc8_table[3][p[4]] ^ on_crc8_table[2][p[5]]
+          ^ on_crc8_table[1][p[6]] ^ on_crc8_table[0][p[7]];
+        #else
+        crc = on_crc8_table[3][crc ^ p[0]] ^ on_crc8_table[2][p[1]]
+          ^ on_crc8_table[1][p[2]] ^ on_crc8_table[0][p[3]];
+        #endif
+
+        p += CRC_SLICE_BY;
+        remaining -= CRC_SLICE_BY;
+    } // while a whole group is left //
+
+    while(remaining--)
+    {
+        crc = on_crc8_table[0][crc ^ *p++];
+    } // while more bytes //
+
+    return crc;
+} // one_net_compute_crc8_slice //
+#endif // if CRC_SLICE_BY > 1 //
+#endif // ifdef CRC_LOOKUP_TABLE //
 
 //! @} one_net_crc_pub_func
 //                      PUBLIC FUNCTION IMPLEMENTATION END
@@ -57,6 +57,25 @@
 //! \ingroup one_net_crc
 //! @{
 
+
+#ifdef CRC_LOOKUP_TABLE
+    #ifndef CRC_SLICE_BY
+        //! Number of bytes processed per step by the table driven crc.
+        #define CRC_SLICE_BY 1
+    #endif
+
+    #if CRC_SLICE_BY != 1 && CRC_SLICE_BY != 4 && CRC_SLICE_BY != 8
+        #error "CRC_SLICE_BY must be 1, 4, or 8"
+    #endif
+    
+    //! The table driven 8th order crc selected by CRC_SLICE_BY.
+    #if CRC_SLICE_BY > 1
+        #define one_net_compute_crc8 one_net_compute_crc8_slice
+    #else
+        #define one_net_compute_crc8 one_net_compute_crc8_table
+    #endif
+#endif
+
 //! @} one_net_crc_const
 //                                  CONSTANTS END
 //==============================================================================
@@ -117,6 +136,18 @@ enum
 
 UInt16 one_net_compute_crc(const UInt8 * const DATA, const UInt8 LEN, 
   const UInt16 STARTING_CRC, const UInt8 ORDER);
+UInt16 one_net_compute_crc_bitwise(const UInt8 * const DATA, const UInt8 LEN,
+  const UInt16 STARTING_CRC, const UInt8 ORDER);
+
+#ifdef CRC_LOOKUP_TABLE
+UInt8 one_net_compute_crc8_table(const UInt8 * const DATA, const UInt16 LEN,
+  const UInt8 STARTING_CRC);
+
+#if CRC_SLICE_BY > 1
+UInt8 one_net_compute_crc8_slice(const UInt8 * const DATA, const UInt16 LEN,
+  const UInt8 STARTING_CRC);
+#endif
+#endif
 
 //! @} one_net_crc_pub_func
 //                      PUBLIC FUNCTION DECLARATIONS END
@@ -0,0 +1,223 @@
+#ifndef ONE_NET_CRC_TABLE_H
+#define ONE_NET_CRC_TABLE_H
+
+//! \addtogroup one_net_crc
+//! @{
+
+/*!
+    \file one_net_crc_table.h
+    \brief Lookup table for the 8th order (0xA6) crc.
+
+    GENERATED FILE -- DO NOT EDIT.  Generated by
+    applications/desktop_sniffer/sniff_parse/gen_crc_table.
+
+    Row k is the crc of a byte followed by k zero bytes.  Only the first
+    CRC_SLICE_BY rows are compiled in.  Include only from one_net_crc.c.
+*/
+
+#include "one_net_types.h"
+
+
+static const UInt8 on_crc8_table[CRC_SLICE_BY][256] =
+{
+    {
+        0x00, 0xA6, 0xEA, 0x4C, 0x72, 0xD4, 0x98, 0x3E, 0xE4, 0x42, 0x0E, 0xA8,
+        0x96, 0x30, 0x7C, 0xDA, 0x6E, 0xC8, 0x84, 0x22, 0x1C, 0xBA, 0xF6, 0x50,
+        0x8A, 0x2C, 0x60, 0xC6, 0xF8, 0x5E, 0x12, 0xB4, 0xDC, 0x7A, 0x36, 0x90,
+        0xAE, 0x08, 0x44, 0xE2, 0x38, 0x9E, 0xD2, 0x74, 0x4A, 0xEC, 0xA0, 0x06,
+        0xB2, 0x14, 0x58, 0xFE, 0xC0, 0x66, 0x2A, 0x8C, 0x56, 0xF0, 0xBC, 0x1A,
+        0x24, 0x82, 0xCE, 0x68, 0x1E, 0xB8, 0xF4, 0x52, 0x6C, 0xCA, 0x86, 0x20,
+        0xFA, 0x5C, 0x10, 0xB6, 0x88, 0x2E, 0x62, 0xC4, 0x70, 0xD6, 0x9A, 0x3C,
+        0x02, 0xA4, 0xE8, 0x4E, 0x94, 0x32, 0x7E, 0xD8, 0xE6, 0x40, 0x0C, 0xAA,
+        0xC2, 0x64, 0x28, 0x8E, 0xB0, 0x16, 0x5A, 0xFC, 0x26, 0x80, 0xCC, 0x6A,
+        0x54, 0xF2, 0xBE, 0x18, 0xAC, 0x0A, 0x46, 0xE0, 0xDE, 0x78, 0x34, 0x92,
+        0x48, 0xEE, 0xA2, 0x04, 0x3A, 0x9C, 0xD0, 0x76, 0x3C, 0x9A, 0xD6, 0x70,
+        0x4E, 0xE8, 0xA4, 0x02, 0xD8, 0x7E, 0x32, 0x94, 0xAA, 0x0C, 0x40, 0xE6,
+        0x52, 0xF4, 0xB8, 0x1E, 0x20, 0x86, 0xCA, 0x6C, 0xB6, 0x10, 0x5C, 0xFA,
+        0xC4, 0x62, 0x2E, 0x88, 0xE0, 0x46, 0x0A, 0xAC, 0x92, 0x34, 0x78, 0xDE,
+        0x04, 0xA2, 0xEE, 0x48, 0x76, 0xD0, 0x9C, 0x3A, 0x8E, 0x28, 0x64, 0xC2,
+        0xFC, 0x5A, 0x16, 0xB0, 0x6A, 0xCC, 0x80, 0x26, 0x18, 0xBE, 0xF2, 0x54,
+        0x22, 0x84, 0xC8, 0x6E, 0x50, 0xF6, 0xBA, 0x1C, 0xC6, 0x60, 0x2C, 0x8A,
+        0xB4, 0x12, 0x5E, 0xF8, 0x4C, 0xEA, 0xA6, 0x00, 0x3E, 0x98, 0xD4, 0x72,
+        0xA8, 0x0E, 0x42, 0xE4, 0xDA, 0x7C, 0x30, 0x96, 0xFE, 0x58, 0x14, 0xB2,
+        0x8C, 0x2A, 0x66, 0xC0, 0x1A, 0xBC, 0xF0, 0x56, 0x68, 0xCE, 0x82, 0x24,
+        0x90, 0x36, 0x7A, 0xDC, 0xE2, 0x44, 0x08, 0xAE, 0x74, 0xD2, 0x9E, 0x38,
+        0x06, 0xA0, 0xEC, 0x4A
+    },
+#if CRC_SLICE_BY > 1
+    {
+        0x00, 0x78, 0xF0, 0x88, 0x46, 0x3E, 0xB6, 0xCE, 0x8C, 0xF4, 0x7C, 0x04,
+        0xCA, 0xB2, 0x3A, 0x42, 0xBE, 0xC6, 0x4E, 0x36, 0xF8, 0x80, 0x08, 0x70,
+        0x32, 0x4A, 0xC2, 0xBA, 0x74, 0x0C, 0x84, 0xFC, 0xDA, 0xA2, 0x2A, 0x52,
+        0x9C, 0xE4, 0x6C, 0x14, 0x56, 0x2E, 0xA6, 0xDE, 0x10, 0x68, 0xE0, 0x98,
+        0x64, 0x1C, 0x94, 0xEC, 0x22, 0x5A, 0xD2, 0xAA, 0xE8, 0x90, 0x18, 0x60,
+        0xAE, 0xD6, 0x5E, 0x26, 0x12, 0x6A, 0xE2, 0x9A, 0x54, 0x2C, 0xA4, 0xDC,
+        0x9E, 0xE6, 0x6E, 0x16, 0xD8, 0xA0, 0x28, 0x50, 0xAC, 0xD4, 0x5C, 0x24,
+        0xEA, 0x92, 0x1A, 0x62, 0x20, 0x58, 0xD0, 0xA8, 0x66, 0x1E, 0x96, 0xEE,
+        0xC8, 0xB0, 0x38, 0x40, 0x8E, 0xF6, 0x7E, 0x06, 0x44, 0x3C, 0xB4, 0xCC,
+        0x02, 0x7A, 0xF2, 0x8A, 0x76, 0x0E, 0x86, 0xFE, 0x30, 0x48, 0xC0, 0xB8,
+        0xFA, 0x82, 0x0A, 0x72, 0xBC, 0xC4, 0x4C, 0x34, 0x24, 0x5C, 0xD4, 0xAC,
+        0x62, 0x1A, 0x92, 0xEA, 0xA8, 0xD0, 0x58, 0x20, 0xEE, 0x96, 0x1E, 0x66,
+        0x9A, 0xE2, 0x6A, 0x12, 0xDC, 0xA4, 0x2C, 0x54, 0x16, 0x6E, 0xE6, 0x9E,
+        0x50, 0x28, 0xA0, 0xD8, 0xFE, 0x86, 0x0E, 0x76, 0xB8, 0xC0, 0x48, 0x30,
+        0x72, 0x0A, 0x82, 0xFA, 0x34, 0x4C, 0xC4, 0xBC, 0x40, 0x38, 0xB0, 0xC8,
+        0x06, 0x7E, 0xF6, 0x8E, 0xCC, 0xB4, 0x3C, 0x44, 0x8A, 0xF2, 0x7A, 0x02,
+        0x36, 0x4E, 0xC6, 0xBE, 0x70, 0x08, 0x80, 0xF8, 0xBA, 0xC2, 0x4A, 0x32,
+        0xFC, 0x84, 0x0C, 0x74, 0x88, 0xF0, 0x78, 0x00, 0xCE, 0xB6, 0x3E, 0x46,
+        0x04, 0x7C, 0xF4, 0x8C, 0x42, 0x3A, 0xB2, 0xCA, 0xEC, 0x94, 0x1C, 0x64,
+        0xAA, 0xD2, 0x5A, 0x22, 0x60, 0x18, 0x90, 0xE8, 0x26, 0x5E, 0xD6, 0xAE,
+        0x52, 0x2A, 0xA2, 0xDA, 0x14, 0x6C, 0xE4, 0x9C, 0xDE, 0xA6, 0x2E, 0x56,
+        0x98, 0xE0, 0x68, 0x10
+    },
+    {
+        0x00, 0x48, 0x90, 0xD8, 0x86, 0xCE, 0x16, 0x5E, 0xAA, 0xE2, 0x3A, 0x72,
+        0x2C, 0x64, 0xBC, 0xF4, 0xF2, 0xBA, 0x62, 0x2A, 0x74, 0x3C, 0xE4, 0xAC,
+        0x58, 0x10, 0xC8, 0x80, 0xDE, 0x96, 0x4E, 0x06, 0x42, 0x0A, 0xD2, 0x9A,
+        0xC4, 0x8C, 0x54, 0x1C, 0xE8, 0xA0, 0x78, 0x30, 0x6E, 0x26, 0xFE, 0xB6,
+        0xB0, 0xF8, 0x20, 0x68, 0x36, 0x7E, 0xA6, 0xEE, 0x1A, 0x52, 0x8A, 0xC2,
+        0x9C, 0xD4, 0x0C, 0x44, 0x84, 0xCC, 0x14, 0x5C, 0x02, 0x4A, 0x92, 0xDA,
+        0x2E, 0x66, 0xBE, 0xF6, 0xA8, 0xE0, 0x38, 0x70, 0x76, 0x3E, 0xE6, 0xAE,
+        0xF0, 0xB8, 0x60, 0x28, 0xDC, 0x94, 0x4C, 0x04, 0x5A, 0x12, 0xCA, 0x82,
+        0xC6, 0x8E, 0x56, 0x1E, 0x40, 0x08, 0xD0, 0x98, 0x6C, 0x24, 0xFC, 0xB4,
+        0xEA, 0xA2, 0x7A, 0x32, 0x34, 0x7C, 0xA4, 0xEC, 0xB2, 0xFA, 0x22, 0x6A,
+        0x9E, 0xD6, 0x0E, 0x46, 0x18, 0x50, 0x88, 0xC0, 0xAE, 0xE6, 0x3E, 0x76,
+        0x28, 0x60, 0xB8, 0xF0, 0x04, 0x4C, 0x94, 0xDC, 0x82, 0xCA, 0x12, 0x5A,
+        0x5C, 0x14, 0xCC, 0x84, 0xDA, 0x92, 0x4A, 0x02, 0xF6, 0xBE, 0x66, 0x2E,
+        0x70, 0x38, 0xE0, 0xA8, 0xEC, 0xA4, 0x7C, 0x34, 0x6A, 0x22, 0xFA, 0xB2,
+        0x46, 0x0E, 0xD6, 0x9E, 0xC0, 0x88, 0x50, 0x18, 0x1E, 0x56, 0x8E, 0xC6,
+        0x98, 0xD0, 0x08, 0x40, 0xB4, 0xFC, 0x24, 0x6C, 0x32, 0x7A, 0xA2, 0xEA,
+        0x2A, 0x62, 0xBA, 0xF2, 0xAC, 0xE4, 0x3C, 0x74, 0x80, 0xC8, 0x10, 0x58,
+        0x06, 0x4E, 0x96, 0xDE, 0xD8, 0x90, 0x48, 0x00, 0x5E, 0x16, 0xCE, 0x86,
+        0x72, 0x3A, 0xE2, 0xAA, 0xF4, 0xBC, 0x64, 0x2C, 0x68, 0x20, 0xF8, 0xB0,
+        0xEE, 0xA6, 0x7E, 0x36, 0xC2, 0x8A, 0x52, 0x1A, 0x44, 0x0C, 0xD4, 0x9C,
+        0x9A, 0xD2, 0x0A, 0x42, 0x1C, 0x54, 0x8C, 0xC4, 0x30, 0x78, 0xA0, 0xE8,
+        0xB6, 0xFE, 0x26, 0x6E
+    },
+    {
+        0x00, 0xFA, 0x52, 0xA8, 0xA4, 0x5E, 0xF6, 0x0C, 0xEE, 0x14, 0xBC, 0x46,
+        0x4A, 0xB0, 0x18, 0xE2, 0x7A, 0x80, 0x28, 0xD2, 0xDE, 0x24, 0x8C, 0x76,
+        0x94, 0x6E, 0xC6, 0x3C, 0x30, 0xCA, 0x62, 0x98, 0xF4, 0x0E, 0xA6, 0x5C,
+        0x50, 0xAA, 0x02, 0xF8, 0x1A, 0xE0, 0x48, 0xB2, 0xBE, 0x44, 0xEC, 0x16,
+        0x8E, 0x74, 0xDC, 0x26, 0x2A, 0xD0, 0x78, 0x82, 0x60, 0x9A, 0x32, 0xC8,
+        0xC4, 0x3E, 0x96, 0x6C, 0x4E, 0xB4, 0x1C, 0xE6, 0xEA, 0x10, 0xB8, 0x42,
+        0xA0, 0x5A, 0xF2, 0x08, 0x04, 0xFE, 0x56, 0xAC, 0x34, 0xCE, 0x66, 0x9C,
+        0x90, 0x6A, 0xC2, 0x38, 0xDA, 0x20, 0x88, 0x72, 0x7E, 0x84, 0x2C, 0xD6,
+        0xBA, 0x40, 0xE8, 0x12, 0x1E, 0xE4, 0x4C, 0xB6, 0x54, 0xAE, 0x06, 0xFC,
+        0xF0, 0x0A, 0xA2, 0x58, 0xC0, 0x3A, 0x92, 0x68, 0x64, 0x9E, 0x36, 0xCC,
+        0x2E, 0xD4, 0x7C, 0x86, 0x8A, 0x70, 0xD8, 0x22, 0x9C, 0x66, 0xCE, 0x34,
+        0x38, 0xC2, 0x6A, 0x90, 0x72, 0x88, 0x20, 0xDA, 0xD6, 0x2C, 0x84, 0x7E,
+        0xE6, 0x1C, 0xB4, 0x4E, 0x42, 0xB8, 0x10, 0xEA, 0x08, 0xF2, 0x5A, 0xA0,
+        0xAC, 0x56, 0xFE, 0x04, 0x68, 0x92, 0x3A, 0xC0, 0xCC, 0x36, 0x9E, 0x64,
+        0x86, 0x7C, 0xD4, 0x2E, 0x22, 0xD8, 0x70, 0x8A, 0x12, 0xE8, 0x40, 0xBA,
+        0xB6, 0x4C, 0xE4, 0x1E, 0xFC, 0x06, 0xAE, 0x54, 0x58, 0xA2, 0x0A, 0xF0,
+        0xD2, 0x28, 0x80, 0x7A, 0x76, 0x8C, 0x24, 0xDE, 0x3C, 0xC6, 0x6E, 0x94,
+        0x98, 0x62, 0xCA, 0x30, 0xA8, 0x52, 0xFA, 0x00, 0x0C, 0xF6, 0x5E, 0xA4,
+        0x46, 0xBC, 0x14, 0xEE, 0xE2, 0x18, 0xB0, 0x4A, 0x26, 0xDC, 0x74, 0x8E,
+        0x82, 0x78, 0xD0, 0x2A, 0xC8, 0x32, 0x9A, 0x60, 0x6C, 0x96, 0x3E, 0xC4,
+        0x5C, 0xA6, 0x0E, 0xF4, 0xF8, 0x02, 0xAA, 0x50, 0xB2, 0x48, 0xE0, 0x1A,
+        0x16, 0xEC, 0x44, 0xBE
+    },
+#endif
+#if CRC_SLICE_BY > 4
+    {
+        0x00, 0x9E, 0x9A, 0x04, 0x92, 0x0C, 0x08, 0x96, 0x82, 0x1C, 0x18, 0x86,
+        0x10, 0x8E, 0x8A, 0x14, 0xA2, 0x3C, 0x38, 0xA6, 0x30, 0xAE, 0xAA, 0x34,
+        0x20, 0xBE, 0xBA, 0x24, 0xB2, 0x2C, 0x28, 0xB6, 0xE2, 0x7C, 0x78, 0xE6,
+        0x70, 0xEE, 0xEA, 0x74, 0x60, 0xFE, 0xFA, 0x64, 0xF2, 0x6C, 0x68, 0xF6,
+        0x40, 0xDE, 0xDA, 0x44, 0xD2, 0x4C, 0x48, 0xD6, 0xC2, 0x5C, 0x58, 0xC6,
+        0x50, 0xCE, 0xCA, 0x54, 0x62, 0xFC, 0xF8, 0x66, 0xF0, 0x6E, 0x6A, 0xF4,
+        0xE0, 0x7E, 0x7A, 0xE4, 0x72, 0xEC, 0xE8, 0x76, 0xC0, 0x5E, 0x5A, 0xC4,
+        0x52, 0xCC, 0xC8, 0x56, 0x42, 0xDC, 0xD8, 0x46, 0xD0, 0x4E, 0x4A, 0xD4,
+        0x80, 0x1E, 0x1A, 0x84, 0x12, 0x8C, 0x88, 0x16, 0x02, 0x9C, 0x98, 0x06,
+        0x90, 0x0E, 0x0A, 0x94, 0x22, 0xBC, 0xB8, 0x26, 0xB0, 0x2E, 0x2A, 0xB4,
+        0xA0, 0x3E, 0x3A, 0xA4, 0x32, 0xAC, 0xA8, 0x36, 0xC4, 0x5A, 0x5E, 0xC0,
+        0x56, 0xC8, 0xCC, 0x52, 0x46, 0xD8, 0xDC, 0x42, 0xD4, 0x4A, 0x4E, 0xD0,
+        0x66, 0xF8, 0xFC, 0x62, 0xF4, 0x6A, 0x6E, 0xF0, 0xE4, 0x7A, 0x7E, 0xE0,
+        0x76, 0xE8, 0xEC, 0x72, 0x26, 0xB8, 0xBC, 0x22, 0xB4, 0x2A, 0x2E, 0xB0,
+        0xA4, 0x3A, 0x3E, 0xA0, 0x36, 0xA8, 0xAC, 0x32, 0x84, 0x1A, 0x1E, 0x80,
+        0x16, 0x88, 0x8C, 0x12, 0x06, 0x98, 0x9C, 0x02, 0x94, 0x0A, 0x0E, 0x90,
+        0xA6, 0x38, 0x3C, 0xA2, 0x34, 0xAA, 0xAE, 0x30, 0x24, 0xBA, 0xBE, 0x20,
+        0xB6, 0x28, 0x2C, 0xB2, 0x04, 0x9A, 0x9E, 0x00, 0x96, 0x08, 0x0C, 0x92,
+        0x86, 0x18, 0x1C, 0x82, 0x14, 0x8A, 0x8E, 0x10, 0x44, 0xDA, 0xDE, 0x40,
+        0xD6, 0x48, 0x4C, 0xD2, 0xC6, 0x58, 0x5C, 0xC2, 0x54, 0xCA, 0xCE, 0x50,
+        0xE6, 0x78, 0x7C, 0xE2, 0x74, 0xEA, 0xEE, 0x70, 0x64, 0xFA, 0xFE, 0x60,
+        0xF6, 0x68, 0x6C, 0xF2
+    },
+    {
+        0x00, 0x2E, 0x5C, 0x72, 0xB8, 0x96, 0xE4, 0xCA, 0xD6, 0xF8, 0x8A, 0xA4,
+        0x6E, 0x40, 0x32, 0x1C, 0x0A, 0x24, 0x56, 0x78, 0xB2, 0x9C, 0xEE, 0xC0,
+        0xDC, 0xF2, 0x80, 0xAE, 0x64, 0x4A, 0x38, 0x16, 0x14, 0x3A, 0x48, 0x66,
+        0xAC, 0x82, 0xF0, 0xDE, 0xC2, 0xEC, 0x9E, 0xB0, 0x7A, 0x54, 0x26, 0x08,
+        0x1E, 0x30, 0x42, 0x6C, 0xA6, 0x88, 0xFA, 0xD4, 0xC8, 0xE6, 0x94, 0xBA,
+        0x70, 0x5E, 0x2C, 0x02, 0x28, 0x06, 0x74, 0x5A, 0x90, 0xBE, 0xCC, 0xE2,
+        0xFE, 0xD0, 0xA2, 0x8C, 0x46, 0x68, 0x1A, 0x34, 0x22, 0x0C, 0x7E, 0x50,
+        0x9A, 0xB4, 0xC6, 0xE8, 0xF4, 0xDA, 0xA8, 0x86, 0x4C, 0x62, 0x10, 0x3E,
+        0x3C, 0x12, 0x60, 0x4E, 0x84, 0xAA, 0xD8, 0xF6, 0xEA, 0xC4, 0xB6, 0x98,
+        0x52, 0x7C, 0x0E, 0x20, 0x36, 0x18, 0x6A, 0x44, 0x8E, 0xA0, 0xD2, 0xFC,
+        0xE0, 0xCE, 0xBC, 0x92, 0x58, 0x76, 0x04, 0x2A, 0x50, 0x7E, 0x0C, 0x22,
+        0xE8, 0xC6, 0xB4, 0x9A, 0x86, 0xA8, 0xDA, 0xF4, 0x3E, 0x10, 0x62, 0x4C,
+        0x5A, 0x74, 0x06, 0x28, 0xE2, 0xCC, 0xBE, 0x90, 0x8C, 0xA2, 0xD0, 0xFE,
+        0x34, 0x1A, 0x68, 0x46, 0x44, 0x6A, 0x18, 0x36, 0xFC, 0xD2, 0xA0, 0x8E,
+        0x92, 0xBC, 0xCE, 0xE0, 0x2A, 0x04, 0x76, 0x58, 0x4E, 0x60, 0x12, 0x3C,
+        0xF6, 0xD8, 0xAA, 0x84, 0x98, 0xB6, 0xC4, 0xEA, 0x20, 0x0E, 0x7C, 0x52,
+        0x78, 0x56, 0x24, 0x0A, 0xC0, 0xEE, 0x9C, 0xB2, 0xAE, 0x80, 0xF2, 0xDC,
+        0x16, 0x38, 0x4A, 0x64, 0x72, 0x5C, 0x2E, 0x00, 0xCA, 0xE4, 0x96, 0xB8,
+        0xA4, 0x8A, 0xF8, 0xD6, 0x1C, 0x32, 0x40, 0x6E, 0x6C, 0x42, 0x30, 0x1E,
+        0xD4, 0xFA, 0x88, 0xA6, 0xBA, 0x94, 0xE6, 0xC8, 0x02, 0x2C, 0x5E, 0x70,
+        0x66, 0x48, 0x3A, 0x14, 0xDE, 0xF0, 0x82, 0xAC, 0xB0, 0x9E, 0xEC, 0xC2,
+        0x08, 0x26, 0x54, 0x7A
+    },
+    {
+        0x00, 0xA0, 0xE6, 0x46, 0x6A, 0xCA, 0x8C, 0x2C, 0xD4, 0x74, 0x32, 0x92,
+        0xBE, 0x1E, 0x58, 0xF8, 0x0E, 0xAE, 0xE8, 0x48, 0x64, 0xC4, 0x82, 0x22,
+        0xDA, 0x7A, 0x3C, 0x9C, 0xB0, 0x10, 0x56, 0xF6, 0x1C, 0xBC, 0xFA, 0x5A,
+        0x76, 0xD6, 0x90, 0x30, 0xC8, 0x68, 0x2E, 0x8E, 0xA2, 0x02, 0x44, 0xE4,
+        0x12, 0xB2, 0xF4, 0x54, 0x78, 0xD8, 0x9E, 0x3E, 0xC6, 0x66, 0x20, 0x80,
+        0xAC, 0x0C, 0x4A, 0xEA, 0x38, 0x98, 0xDE, 0x7E, 0x52, 0xF2, 0xB4, 0x14,
+        0xEC, 0x4C, 0x0A, 0xAA, 0x86, 0x26, 0x60, 0xC0, 0x36, 0x96, 0xD0, 0x70,
+        0x5C, 0xFC, 0xBA, 0x1A, 0xE2, 0x42, 0x04, 0xA4, 0x88, 0x28, 0x6E, 0xCE,
+        0x24, 0x84, 0xC2, 0x62, 0x4E, 0xEE, 0xA8, 0x08, 0xF0, 0x50, 0x16, 0xB6,
+        0x9A, 0x3A, 0x7C, 0xDC, 0x2A, 0x8A, 0xCC, 0x6C, 0x40, 0xE0, 0xA6, 0x06,
+        0xFE, 0x5E, 0x18, 0xB8, 0x94, 0x34, 0x72, 0xD2, 0x70, 0xD0, 0x96, 0x36,
+        0x1A, 0xBA, 0xFC, 0x5C, 0xA4, 0x04, 0x42, 0xE2, 0xCE, 0x6E, 0x28, 0x88,
+        0x7E, 0xDE, 0x98, 0x38, 0x14, 0xB4, 0xF2, 0x52, 0xAA, 0x0A, 0x4C, 0xEC,
+        0xC0, 0x60, 0x26, 0x86, 0x6C, 0xCC, 0x8A, 0x2A, 0x06, 0xA6, 0xE0, 0x40,
+        0xB8, 0x18, 0x5E, 0xFE, 0xD2, 0x72, 0x34, 0x94, 0x62, 0xC2, 0x84, 0x24,
+        0x08, 0xA8, 0xEE, 0x4E, 0xB6, 0x16, 0x50, 0xF0, 0xDC, 0x7C, 0x3A, 0x9A,
+        0x48, 0xE8, 0xAE, 0x0E, 0x22, 0x82, 0xC4, 0x64, 0x9C, 0x3C, 0x7A, 0xDA,
+        0xF6, 0x56, 0x10, 0xB0, 0x46, 0xE6, 0xA0, 0x00, 0x2C, 0x8C, 0xCA, 0x6A,
+        0x92, 0x32, 0x74, 0xD4, 0xF8, 0x58, 0x1E, 0xBE, 0x54, 0xF4, 0xB2, 0x12,
+        0x3E, 0x9E, 0xD8, 0x78, 0x80, 0x20, 0x66, 0xC6, 0xEA, 0x4A, 0x0C, 0xAC,
+        0x5A, 0xFA, 0xBC, 0x1C, 0x30, 0x90, 0xD6, 0x76, 0x8E, 0x2E, 0x68, 0xC8,
+        0xE4, 0x44, 0x02, 0xA2
+    },
+    {
+        0x00, 0xE0, 0x66, 0x86, 0xCC, 0x2C, 0xAA, 0x4A, 0x3E, 0xDE, 0x58, 0xB8,
+        0xF2, 0x12, 0x94, 0x74, 0x7C, 0x9C, 0x1A, 0xFA, 0xB0, 0x50, 0xD6, 0x36,
+        0x42, 0xA2, 0x24, 0xC4, 0x8E, 0x6E, 0xE8, 0x08, 0xF8, 0x18, 0x9E, 0x7E,
+        0x34, 0xD4, 0x52, 0xB2, 0xC6, 0x26, 0xA0, 0x40, 0x0A, 0xEA, 0x6C, 0x8C,
+        0x84, 0x64, 0xE2, 0x02, 0x48, 0xA8, 0x2E, 0xCE, 0xBA, 0x5A, 0xDC, 0x3C,
+        0x76, 0x96, 0x10, 0xF0, 0x56, 0xB6, 0x30, 0xD0, 0x9A, 0x7A, 0xFC, 0x1C,
+        0x68, 0x88, 0x0E, 0xEE, 0xA4, 0x44, 0xC2, 0x22, 0x2A, 0xCA, 0x4C, 0xAC,
+        0xE6, 0x06, 0x80, 0x60, 0x14, 0xF4, 0x72, 0x92, 0xD8, 0x38, 0xBE, 0x5E,
+        0xAE, 0x4E, 0xC8, 0x28, 0x62, 0x82, 0x04, 0xE4, 0x90, 0x70, 0xF6, 0x16,
+        0x5C, 0xBC, 0x3A, 0xDA, 0xD2, 0x32, 0xB4, 0x54, 0x1E, 0xFE, 0x78, 0x98,
+        0xEC, 0x0C, 0x8A, 0x6A, 0x20, 0xC0, 0x46, 0xA6, 0xAC, 0x4C, 0xCA, 0x2A,
+        0x60, 0x80, 0x06, 0xE6, 0x92, 0x72, 0xF4, 0x14, 0x5E, 0xBE, 0x38, 0xD8,
+        0xD0, 0x30, 0xB6, 0x56, 0x1C, 0xFC, 0x7A, 0x9A, 0xEE, 0x0E, 0x88, 0x68,
+        0x22, 0xC2, 0x44, 0xA4, 0x54, 0xB4, 0x32, 0xD2, 0x98, 0x78, 0xFE, 0x1E,
+        0x6A, 0x8A, 0x0C, 0xEC, 0xA6, 0x46, 0xC0, 0x20, 0x28, 0xC8, 0x4E, 0xAE,
+        0xE4, 0x04, 0x82, 0x62, 0x16, 0xF6, 0x70, 0x90, 0xDA, 0x3A, 0xBC, 0x5C,
+        0xFA, 0x1A, 0x9C, 0x7C, 0x36, 0xD6, 0x50, 0xB0, 0xC4, 0x24, 0xA2, 0x42,
+        0x08, 0xE8, 0x6E, 0x8E, 0x86, 0x66, 0xE0, 0x00, 0x4A, 0xAA, 0x2C, 0xCC,
+        0xB8, 0x58, 0xDE, 0x3E, 0x74, 0x94, 0x12, 0xF2, 0x02, 0xE2, 0x64, 0x84,
+        0xCE, 0x2E, 0xA8, 0x48, 0x3C, 0xDC, 0x5A, 0xBA, 0xF0, 0x10, 0x96, 0x76,
+        0x7E, 0x9E, 0x18, 0xF8, 0xB2, 0x52, 0xD4, 0x34, 0x40, 0xA0, 0x26, 0xC6,
+        0x8C, 0x6C, 0xEA, 0x0A
+    }
+#endif
+};
+
+//! @} one_net_crc
+
+#endif // ONE_NET_CRC_TABLE_H //
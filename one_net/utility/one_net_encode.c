@@ -44,6 +44,10 @@
 #include "one_net_encode.h"
 #include "one_net_types.h"
 
+#ifdef ENCODE_X86_SIMD
+    #include <immintrin.h>
+#endif
+
 // TODO -- this is a bit messy.  Find a better #define test.
 #if defined(_R8C_TINY) && !defined(QUAD_OUTPUT)
     #pragma section program program_high_rom
@@ -108,6 +112,52 @@ static const UInt8 ENCODED_TO_RAW_L_NIB[] =
      0x40, 0x05, 0x03, 0x40, 0x01, 0x40, 0x40, 0x40,
 };
 
+
+#ifdef ENCODE_LOOKUP_TABLE
+/*!
+    \brief Table to convert encoded values straight to raw values.
+
+    This is ENCODED_TO_RAW_H_NIB and ENCODED_TO_RAW_L_NIB combined into a
+    single lookup.  Invalid items are marked with 0x40 so that they can be
+    or'ed together and checked once at the end rather than after every byte.
+*/
+static const UInt8 ENCODED_TO_RAW[] =
+{
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x17, 0x12, 0x10, 0x14, 0x16, 0x40,
+    0x40, 0x15, 0x13, 0x40, 0x11, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x27, 0x22, 0x20, 0x24, 0x26, 0x40,
+    0x40, 0x25, 0x23, 0x40, 0x21, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x37, 0x32, 0x30, 0x34, 0x36, 0x40,
+    0x40, 0x35, 0x33, 0x40, 0x31, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x2F, 0x2A, 0x28, 0x2C, 0x2E, 0x40,
+    0x40, 0x2D, 0x2B, 0x40, 0x29, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x1F, 0x1A, 0x18, 0x1C, 0x1E, 0x40,
+    0x40, 0x1D, 0x1B, 0x40, 0x19, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x07, 0x02, 0x00, 0x04, 0x06, 0x40,
+    0x40, 0x05, 0x03, 0x40, 0x01, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x0F, 0x0A, 0x08, 0x0C, 0x0E, 0x40,
+    0x40, 0x0D, 0x0B, 0x40, 0x09, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x3F, 0x3A, 0x38, 0x3C, 0x3E, 0x40,
+    0x40, 0x3D, 0x3B, 0x40, 0x39, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40
+};
+#endif // ifdef ENCODE_LOOKUP_TABLE //
+
 //! @} ONE-NET_encode_const
 //                                  CONSTANTS END
 //==============================================================================
@@ -138,6 +188,13 @@ static const UInt8 ENCODED_TO_RAW_L_NIB[] =
 //! \ingroup ONE-NET_encode
 //! @{
 
+#ifdef ENCODE_X86_SIMD
+static UInt16 decode_ssse3(UInt8 * raw, const UInt8 * ENCODED,
+  const UInt16 ENCODED_SIZE, UInt8 * const bad);
+static UInt16 decode_avx2(UInt8 * raw, const UInt8 * ENCODED,
+  const UInt16 ENCODED_SIZE, UInt8 * const bad);
+#endif
+
 //! @} ONE-NET_encode_pri_func
 //                      PRIVATE FUNCTION DECLARATIONS END
 //==============================================================================
@@ -280,6 +337,8 @@ UInt8 decoded_to_encoded_byte(UInt8 decoded_byte, BOOL left_justify)
     \brief Encodes 6-bit data to 8-bit data.
 
     Takes in a bit stream and converts every 6 bits into an encoded 8-bit value.
+    Uses on_encode_table if ENCODE_LOOKUP_TABLE is defined, otherwise
+    on_encode_scalar.
 
     \param[out] encoded The encoded version of the raw data.
     \param[in] RAW The raw bit stream to encoded.
@@ -290,6 +349,55 @@ UInt8 decoded_to_encoded_byte(UInt8 decoded_byte, BOOL left_justify)
 */
 one_net_status_t on_encode(UInt8 * encoded, const UInt8 * RAW, 
   const UInt16 ENCODED_SIZE)
+{
+    #ifdef ENCODE_LOOKUP_TABLE
+    return on_encode_table(encoded, RAW, ENCODED_SIZE);
+    #else
+    return on_encode_scalar(encoded, RAW, ENCODED_SIZE);
+    #endif
+} // on_encode //
+
+
+/*!
+    \brief Decodes 8-bit data to 6-bit data.
+
+    Takes in a bit stream and converts every 8 bits into an decoded 6-bit value.
+    These decoded 6-bit values are returned as a bit stream.  Uses
+    on_decode_table if ENCODE_LOOKUP_TABLE is defined, otherwise
+    on_decode_scalar.
+
+    \param[out] raw The decoded version of the encoded data.
+    \param[in] ENCODED The encoded bit stream to decode.
+    \param[in] ENCODED_LEN The number of encoded blocks to decode.  raw must be
+      big enough to handle the data.
+    \return The status of the operation.
+*/
+one_net_status_t on_decode(UInt8 * raw, const UInt8 * ENCODED, 
+  const UInt16 ENCODED_SIZE)
+{
+    #ifdef ENCODE_LOOKUP_TABLE
+    return on_decode_table(raw, ENCODED, ENCODED_SIZE);
+    #else
+    return on_decode_scalar(raw, ENCODED, ENCODED_SIZE);
+    #endif
+} // on_decode //
+
+
+/*!
+    \brief Encodes 6-bit data to 8-bit data one 6-bit value at a time.
+
+    This is the reference implementation.  on_encode_table must produce
+    exactly the same output.
+
+    \param[out] encoded The encoded version of the raw data.
+    \param[in] RAW The raw bit stream to encoded.
+    \param[in] ENCODED_SIZE The size of encoded in bytes.  This is also the
+     number of 6 bit blocks to encoded.
+
+    \return The status of the operation.
+*/
+one_net_status_t on_encode_scalar(UInt8 * encoded, const UInt8 * RAW, 
+  const UInt16 ENCODED_SIZE)
 {
     UInt16 val, encoded_idx, raw_idx, step;
 
@@ -360,14 +468,14 @@ one_net_status_t on_encode(UInt8 * encoded, const UInt8 * RAW,
     } // loop to encoded raw data //
 
     return ONS_SUCCESS;
-} // on_encode //
+} // on_encode_scalar //
 
 
 /*!
-    \brief Decodes 8-bit data to 6-bit data.
+    \brief Decodes 8-bit data to 6-bit data one encoded byte at a time.
 
-    Takes in a bit stream and converts every 8 bits into an decoded 6-bit value.
-    These decoded 6-bit values are returned as a bit stream.
+    This is the reference implementation.  on_decode_table must produce
+    exactly the same output for valid input.
 
     \param[out] raw The decoded version of the encoded data.
     \param[in] ENCODED The encoded bit stream to decode.
@@ -375,7 +483,7 @@ one_net_status_t on_encode(UInt8 * encoded, const UInt8 * RAW,
       big enough to handle the data.
     \return The status of the operation.
 */
-one_net_status_t on_decode(UInt8 * raw, const UInt8 * ENCODED, 
+one_net_status_t on_decode_scalar(UInt8 * raw, const UInt8 * ENCODED, 
   const UInt16 ENCODED_SIZE)
 {
     UInt16 val, encoded_idx, raw_idx, step;
@@ -445,7 +553,145 @@ one_net_status_t on_decode(UInt8 * raw, const UInt8 * ENCODED,
     } // loop to decode data //
 
     return ONS_SUCCESS;
-} // on_decode //
+} // on_decode_scalar //
+
+
+#ifdef ENCODE_LOOKUP_TABLE
+/*!
+    \brief Encodes 6-bit data to 8-bit data 3 raw bytes at a time.
+
+    Every 3 raw bytes hold exactly 4 6-bit values, so they are read as one
+    24 bit word and converted with 4 straight lookups rather than stepping
+    through the 4 stages in on_encode_scalar.  Any 6-bit values left over at
+    the end are handed to on_encode_scalar.
+
+    \param[out] encoded The encoded version of the raw data.
+    \param[in] RAW The raw bit stream to encoded.
+    \param[in] ENCODED_SIZE The size of encoded in bytes.  This is also the
+     number of 6 bit blocks to encoded.
+
+    \return The status of the operation.
+*/
+one_net_status_t on_encode_table(UInt8 * encoded, const UInt8 * RAW, 
+  const UInt16 ENCODED_SIZE)
+{
+    UInt16 group;
+    UInt32 word;
+
+    if(!encoded || !RAW || !ENCODED_SIZE)
+    {
+        return ONS_BAD_PARAM;
+    } // if the parameters are invalid //
+
+    for(group = ENCODED_SIZE / 4; group > 0; group--)
+    {
+        word = ((UInt32)RAW[0] << 16) | ((UInt32)RAW[1] << 8) | RAW[2];
+        encoded[0] = RAW_TO_ENCODED[(word >> 18) & 0x3F];
+        encoded[1] = RAW_TO_ENCODED[(word >> 12) & 0x3F];
+        encoded[2] = RAW_TO_ENCODED[(word >> 6) & 0x3F];
+        encoded[3] = RAW_TO_ENCODED[word & 0x3F];
+
+        RAW += 3;
+        encoded += 4;
+    } // loop through the groups of 4 //
+
+    if(ENCODED_SIZE % 4)
+    {
+        return on_encode_scalar(encoded, RAW, ENCODED_SIZE % 4);
+    } // if there is a partial group //
+
+    return ONS_SUCCESS;
+} // on_encode_table //
+
+
+/*!
+    \brief Decodes 8-bit data to 6-bit data 4 encoded bytes at a time.
+
+    Each group of 4 encoded bytes is looked up in ENCODED_TO_RAW and written
+    out as 3 raw bytes.  Validity is not checked per byte.  Instead the
+    looked up values are or'ed together and checked once at the end, so an
+    invalid encoded byte does not stop the decode part way through like it
+    does in on_decode_scalar.  The contents of raw are undefined if
+    ONS_BAD_ENCODING is returned.
+    
+    If ENCODE_SIMD is defined and the processor supports it, the bulk of the
+    data is decoded 16 or 32 bytes at a time first.
+
+    \param[out] raw The decoded version of the encoded data.
+    \param[in] ENCODED The encoded bit stream to decode.
+    \param[in] ENCODED_LEN The number of encoded blocks to decode.  raw must be
+      big enough to handle the data.
+    \return The status of the operation.
+*/
+one_net_status_t on_decode_table(UInt8 * raw, const UInt8 * ENCODED, 
+  const UInt16 ENCODED_SIZE)
+{
+    UInt16 group, remaining;
+    UInt32 word;
+    UInt8 v0, v1, v2, v3;
+    UInt8 bad = 0;
+
+    if(!ENCODED || !raw || !ENCODED_SIZE)
+    {
+        return ONS_BAD_PARAM;
+    } // if parameters are not valid //
+
+    remaining = ENCODED_SIZE;
+
+    #ifdef ENCODE_X86_SIMD
+    {
+        UInt16 done;
+
+        if(__builtin_cpu_supports("avx2"))
+        {
+            done = decode_avx2(raw, ENCODED, remaining, &bad);
+        } // if avx2 //
+        else if(__builtin_cpu_supports("ssse3"))
+        {
+            done = decode_ssse3(raw, ENCODED, remaining, &bad);
+        } // else if ssse3 //
+        else
+        {
+            done = 0;
+        } // else no simd //
+
+        ENCODED += done;
+        raw += (done / 4) * 3;
+        remaining -= done;
+    }
+    #endif
+
+    for(group = remaining / 4; group > 0; group--)
+    {
+        v0 = ENCODED_TO_RAW[ENCODED[0]];
+        v1 = ENCODED_TO_RAW[ENCODED[1]];
+        v2 = ENCODED_TO_RAW[ENCODED[2]];
+        v3 = ENCODED_TO_RAW[ENCODED[3]];
+        bad |= v0 | v1 | v2 | v3;
+
+        word = ((UInt32)v0 << 18) | ((UInt32)v1 << 12) | ((UInt32)v2 << 6)
+          | v3;
+        raw[0] = (UInt8)(word >> 16);
+        raw[1] = (UInt8)(word >> 8);
+        raw[2] = (UInt8)word;
+
+        ENCODED += 4;
+        raw += 3;
+    } // loop through the groups of 4 //
+
+    if(bad & 0xC0)
+    {
+        return ONS_BAD_ENCODING;
+    } // if there was an invalid encoded value //
+
+    if(remaining % 4)
+    {
+        return on_decode_scalar(raw, ENCODED, remaining % 4);
+    } // if there is a partial group //
+
+    return ONS_SUCCESS;
+} // on_decode_table //
+#endif // ifdef ENCODE_LOOKUP_TABLE //
 
 
 /*!
@@ -517,6 +763,134 @@ one_net_status_t on_decode_uint16(UInt16* decoded, UInt16 encoded)
 //! \ingroup ONE-NET_encode
 //! @{
 
+#ifdef ENCODE_X86_SIMD
+/*!
+    \brief Decodes 16 encoded bytes at a time using SSSE3.
+
+    The nibble tables are exactly 16 entries each, so each one is a single
+    pshufb.  The 4 6-bit values in each 32 bit lane are then merged into a 24
+    bit value with two multiply-adds and the 12 good bytes are shuffled to
+    the front.  16 bytes are stored each time, so this stops while there is
+    still room at the end of raw for the 4 extra bytes.
+
+    \param[out] raw The decoded version of the encoded data.
+    \param[in] ENCODED The encoded bit stream to decode.
+    \param[in] ENCODED_SIZE The number of encoded bytes available.
+    \param[in/out] bad Or'ed with the looked up values.  Bits 6 and 7 are set
+      if any encoded byte was not valid.
+
+    \return The number of encoded bytes decoded.  Always a multiple of 4.
+*/
+__attribute__((target("ssse3")))
+static UInt16 decode_ssse3(UInt8 * raw, const UInt8 * ENCODED,
+  const UInt16 ENCODED_SIZE, UInt8 * const bad)
+{
+    const __m128i H_NIB = _mm_loadu_si128(
+      (const __m128i *)ENCODED_TO_RAW_H_NIB);
+    const __m128i L_NIB = _mm_loadu_si128(
+      (const __m128i *)ENCODED_TO_RAW_L_NIB);
+    const __m128i LOW_NIB_MASK = _mm_set1_epi8(0x0F);
+    const __m128i MERGE_PAIRS = _mm_set1_epi32(0x01400140);
+    const __m128i MERGE_WORDS = _mm_set1_epi32(0x00011000);
+    const __m128i PACK = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+      -1, -1, -1, -1);
+    __m128i all = _mm_setzero_si128();
+    UInt16 done = 0;
+    UInt8 all_bytes[16];
+    UInt8 i;
+
+    while(ENCODED_SIZE - done >= 24)
+    {
+        __m128i in = _mm_loadu_si128((const __m128i *)&ENCODED[done]);
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(in, 4), LOW_NIB_MASK);
+        __m128i lo = _mm_and_si128(in, LOW_NIB_MASK);
+        __m128i val = _mm_add_epi8(_mm_shuffle_epi8(H_NIB, hi),
+          _mm_shuffle_epi8(L_NIB, lo));
+
+        all = _mm_or_si128(all, val);
+        val = _mm_maddubs_epi16(val, MERGE_PAIRS);
+        val = _mm_madd_epi16(val, MERGE_WORDS);
+        _mm_storeu_si128((__m128i *)raw, _mm_shuffle_epi8(val, PACK));
+
+        raw += 12;
+        done += 16;
+    } // while there is room for a full store //
+
+    _mm_storeu_si128((__m128i *)all_bytes, all);
+    for(i = 0; i < sizeof(all_bytes); i++)
+    {
+        *bad |= all_bytes[i];
+    } // loop through the lanes //
+
+    return done;
+} // decode_ssse3 //
+
+
+/*!
+    \brief Decodes 32 encoded bytes at a time using AVX2.
+
+    Same as decode_ssse3, but each 128 bit half is done separately by the
+    shuffles, so the two groups of 12 good bytes are moved together with a
+    cross-lane permute before storing.
+
+    \param[out] raw The decoded version of the encoded data.
+    \param[in] ENCODED The encoded bit stream to decode.
+    \param[in] ENCODED_SIZE The number of encoded bytes available.
+    \param[in/out] bad Or'ed with the looked up values.  Bits 6 and 7 are set
+      if any encoded byte was not valid.
+
+    \return The number of encoded bytes decoded.  Always a multiple of 4.
+*/
+__attribute__((target("avx2")))
+static UInt16 decode_avx2(UInt8 * raw, const UInt8 * ENCODED,
+  const UInt16 ENCODED_SIZE, UInt8 * const bad)
+{
+    const __m256i H_NIB = _mm256_broadcastsi128_si256(_mm_loadu_si128(
+      (const __m128i *)ENCODED_TO_RAW_H_NIB));
+    const __m256i L_NIB = _mm256_broadcastsi128_si256(_mm_loadu_si128(
+      (const __m128i *)ENCODED_TO_RAW_L_NIB));
+    const __m256i LOW_NIB_MASK = _mm256_set1_epi8(0x0F);
+    const __m256i MERGE_PAIRS = _mm256_set1_epi32(0x01400140);
+    const __m256i MERGE_WORDS = _mm256_set1_epi32(0x00011000);
+    const __m256i PACK = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13,
+      12, -1, -1, -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1,
+      -1);
+    const __m256i JOIN = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+    __m256i all = _mm256_setzero_si256();
+    UInt16 done = 0;
+    UInt8 all_bytes[32];
+    UInt8 i;
+
+    while(ENCODED_SIZE - done >= 48)
+    {
+        __m256i in = _mm256_loadu_si256((const __m256i *)&ENCODED[done]);
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi16(in, 4),
+          LOW_NIB_MASK);
+        __m256i lo = _mm256_and_si256(in, LOW_NIB_MASK);
+        __m256i val = _mm256_add_epi8(_mm256_shuffle_epi8(H_NIB, hi),
+          _mm256_shuffle_epi8(L_NIB, lo));
+
+        all = _mm256_or_si256(all, val);
+        val = _mm256_maddubs_epi16(val, MERGE_PAIRS);
+        val = _mm256_madd_epi16(val, MERGE_WORDS);
+        val = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(val, PACK),
+          JOIN);
+        _mm256_storeu_si256((__m256i *)raw, val);
+
+        raw += 24;
+        done += 32;
+    } // while there is room for a full store //
+
+    _mm256_storeu_si256((__m256i *)all_bytes, all);
+    for(i = 0; i < sizeof(all_bytes); i++)
+    {
+        *bad |= all_bytes[i];
+    } // loop through the lanes //
+
+    return done;
+} // decode_avx2 //
+#endif // ifdef ENCODE_X86_SIMD //
+
 //! @} ONE-NET_encode_pri_func
 //                      PRIVATE FUNCTION IMPLEMENTATION END
 //==============================================================================
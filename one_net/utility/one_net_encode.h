@@ -66,6 +66,18 @@ enum
     //! the number of bits in an encoded word
     ON_ENCODED_WORD_SIZE = 8
 };
+
+
+#if defined(ENCODE_SIMD) && !defined(ENCODE_LOOKUP_TABLE)
+    #error "ENCODE_SIMD requires ENCODE_LOOKUP_TABLE"
+#endif
+
+//! The SIMD decode is only available on x86 with gcc style intrinsics.  It
+//! is chosen at run-time based on what the processor supports.
+#if defined(ENCODE_SIMD) && defined(__GNUC__) && (defined(__x86_64__) \
+  || defined(__i386__))
+    #define ENCODE_X86_SIMD
+#endif
     
 //! @} ONE-NET_encode_const
 //                                  CONSTANTS END
@@ -110,6 +122,17 @@ one_net_status_t on_encode(UInt8 * encoded, const UInt8 * RAW,
   const UInt16 ENCODED_SIZE);
 one_net_status_t on_decode(UInt8 * raw, const UInt8 * ENCODED, 
   const UInt16 ENCODED_SIZE);
+one_net_status_t on_encode_scalar(UInt8 * encoded, const UInt8 * RAW, 
+  const UInt16 ENCODED_SIZE);
+one_net_status_t on_decode_scalar(UInt8 * raw, const UInt8 * ENCODED, 
+  const UInt16 ENCODED_SIZE);
+
+#ifdef ENCODE_LOOKUP_TABLE
+one_net_status_t on_encode_table(UInt8 * encoded, const UInt8 * RAW, 
+  const UInt16 ENCODED_SIZE);
+one_net_status_t on_decode_table(UInt8 * raw, const UInt8 * ENCODED, 
+  const UInt16 ENCODED_SIZE);
+#endif
 one_net_status_t on_encode_uint16(UInt16* encoded, UInt16 decoded);
 one_net_status_t on_decode_uint16(UInt16* decoded, UInt16 encoded);
 
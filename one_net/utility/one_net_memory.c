@@ -51,6 +51,7 @@
 #include "one_net_port_const.h"
 #include "one_net_port_specific.h"
 #include "one_net_memory.h"
+#include "one_net_context.h"
 
 
 #ifdef ONE_NET_MEMORY
@@ -63,6 +64,28 @@
 //! \ingroup one_net_memory
 //! @{
 
+
+#ifdef ONE_NET_MEMORY_POOL
+enum
+{
+    //! The number of blocks in the pool
+    ONE_NET_POOL_NUM_BLOCKS = ONE_NET_POOL_SMALL_NUM_BLOCKS
+      + ONE_NET_POOL_MEDIUM_NUM_BLOCKS + ONE_NET_POOL_LARGE_NUM_BLOCKS,
+
+    //! The number of bytes in the pool
+    ONE_NET_POOL_SIZE = ONE_NET_POOL_SMALL_BLOCK_SIZE
+      * ONE_NET_POOL_SMALL_NUM_BLOCKS + ONE_NET_POOL_MEDIUM_BLOCK_SIZE
+      * ONE_NET_POOL_MEDIUM_NUM_BLOCKS + ONE_NET_POOL_LARGE_BLOCK_SIZE
+      * ONE_NET_POOL_LARGE_NUM_BLOCKS
+};
+
+
+//! Value of a free list link that does not lead to a block.  Links hold one
+//! more than the index of the block they lead to.
+#define POOL_NO_BLOCK 0
+#endif // ifdef ONE_NET_MEMORY_POOL //
+
+
 //! @} one_net_memory_const
 //                                  CONSTANTS END
 //==============================================================================
@@ -73,6 +96,30 @@
 //! \ingroup one_net_memory
 //! @{
 
+
+#ifdef ONE_NET_MEMORY_POOL
+/*!
+    \brief Where one size class of the pool is.
+*/
+typedef struct
+{
+    UInt8 block_size;       //!< The number of bytes in each block
+    UInt8 num_blocks;       //!< The number of blocks in the class
+    UInt8 first_block;      //!< The index of the class's first block
+    UInt16 offset;          //!< Where the class starts in pool_buffer
+} pool_class_t;
+
+
+//! The free list links and block indexes are UInt8 and the links hold one
+//! more than the index, so there can be at most 254 blocks, and the sizes in
+//! pool_block_used are UInt8 too.  The pool sizes are enums, which #if can't
+//! test, so an array with a negative size stops the build instead.
+typedef UInt8 pool_num_blocks_check_t[ONE_NET_POOL_NUM_BLOCKS <= 254 ? 1 : -1];
+typedef UInt8 pool_block_size_check_t[ONE_NET_POOL_LARGE_BLOCK_SIZE <= 255
+  ? 1 : -1];
+#endif // ifdef ONE_NET_MEMORY_POOL //
+
+
 //! @} one_net_memory_typedefs
 //                                  TYPEDEFS END
 //==============================================================================
@@ -84,14 +131,50 @@
 //! @{
 
 
-static UInt8 heap_buffer[ONE_NET_HEAP_SIZE];
+#ifdef ONE_NET_MEMORY_POOL
+//! The size classes, smallest first.
+static const pool_class_t pool_class[ONE_NET_POOL_NUM_CLASSES] =
+{
+    {ONE_NET_POOL_SMALL_BLOCK_SIZE, ONE_NET_POOL_SMALL_NUM_BLOCKS, 0, 0},
+    {ONE_NET_POOL_MEDIUM_BLOCK_SIZE, ONE_NET_POOL_MEDIUM_NUM_BLOCKS,
+      ONE_NET_POOL_SMALL_NUM_BLOCKS,
+      ONE_NET_POOL_SMALL_BLOCK_SIZE * ONE_NET_POOL_SMALL_NUM_BLOCKS},
+    {ONE_NET_POOL_LARGE_BLOCK_SIZE, ONE_NET_POOL_LARGE_NUM_BLOCKS,
+      ONE_NET_POOL_SMALL_NUM_BLOCKS + ONE_NET_POOL_MEDIUM_NUM_BLOCKS,
+      ONE_NET_POOL_SMALL_BLOCK_SIZE * ONE_NET_POOL_SMALL_NUM_BLOCKS
+      + ONE_NET_POOL_MEDIUM_BLOCK_SIZE * ONE_NET_POOL_MEDIUM_NUM_BLOCKS}
+};
+
+//! The memory the blocks are handed out from.
+static ONE_NET_DEVICE_STATE UInt8 pool_buffer[ONE_NET_POOL_SIZE];
+
+//! The number of bytes asked for in each block, 0 if it is free.
+static ONE_NET_DEVICE_STATE UInt8 pool_block_used[ONE_NET_POOL_NUM_BLOCKS];
+
+//! Link from each free block to the next free block in its class.
+static ONE_NET_DEVICE_STATE UInt8 pool_next_free[ONE_NET_POOL_NUM_BLOCKS];
+
+//! Link to the first free block of each class that has been freed.  Blocks
+//! that have never been handed out are not on the lists.
+static ONE_NET_DEVICE_STATE UInt8 pool_free_list[ONE_NET_POOL_NUM_CLASSES];
+
+//! The number of blocks of each class that have ever been handed out.  These
+//! are always the first blocks of the class.
+static ONE_NET_DEVICE_STATE UInt8 pool_blocks_touched[ONE_NET_POOL_NUM_CLASSES];
+
+//! How each class has been used.  The sizes are filled in when they are read.
+static ONE_NET_DEVICE_STATE one_net_pool_stats_t pool_stats[
+  ONE_NET_POOL_NUM_CLASSES];
+#else
+static ONE_NET_DEVICE_STATE UInt8 heap_buffer[ONE_NET_HEAP_SIZE];
 
 // TODO -- experiment with removing the initializer.  Since this is a static
 // variable, if the initializer is left off, it will still initialize to all 0,
 // I think.  Need to confirm this with the standard to be positive.  There have
 // been reports that using the initializer versus not using it can cause a
 // difference in code space.
-static heap_entry_t heap_entry[ONE_NET_HEAP_NUM_ENTRIES] = {{0,0}};
+static ONE_NET_DEVICE_STATE heap_entry_t heap_entry[ONE_NET_HEAP_NUM_ENTRIES] = {{0,0}};
+#endif // else ONE_NET_MEMORY_POOL is not defined //
 
 
 //! @} one_net_memory_pub_var
@@ -104,6 +187,13 @@ static heap_entry_t heap_entry[ONE_NET_HEAP_NUM_ENTRIES] = {{0,0}};
 //! \ingroup one_net_memory
 //! @{
 
+
+#ifdef ONE_NET_MEMORY_POOL
+static SInt16 pool_block(const void* const ptr, UInt8* const class_index);
+static UInt8* pool_block_ptr(const UInt8 CLASS_INDEX, const UInt8 BLOCK);
+#endif
+
+
 //! @} one_net_memory_pri_func
 //                      PRIVATE FUNCTION DECLARATIONS END
 //=============================================================================
@@ -114,6 +204,83 @@ static heap_entry_t heap_entry[ONE_NET_HEAP_NUM_ENTRIES] = {{0,0}};
 //! \ingroup one_net_memory
 //! @{
 
+#ifdef ONE_NET_MEMORY_POOL
+/*
+    \brief Allocates memory
+
+    Allocates a block of size bytes of memory, returning a pointer to the
+    beginning of the block.  The content of the newly allocated block of
+    memory is not initialized,remaining with indeterminate values.
+    
+    The block comes from the smallest size class the request fits in that has
+    a free block, so this takes the same time however the pool has been used.
+
+
+    \param[in] size Size of the requested memory block, in bytes.
+   
+    \return On success, a pointer to the memory block allocated by the function.
+            The type of this pointer is always void*, which can be cast to the
+            desired type of data pointer in order to be dereferenceable.  If the
+            function failed to allocate the requested block of memory, a null
+            pointer is returned.
+
+*/
+void* one_net_malloc(UInt8 size)
+{
+    UInt8 i, block;
+    SInt8 fits = -1;
+
+    if(size == 0)
+    {
+        return NULL;
+    }
+    
+    for(i = 0; i < ONE_NET_POOL_NUM_CLASSES; i++)
+    {
+        if(size > pool_class[i].block_size)
+        {
+            continue; // too small
+        }
+        
+        if(fits == -1)
+        {
+            fits = i;
+        }
+        
+        if(pool_free_list[i] != POOL_NO_BLOCK)
+        {
+            block = pool_free_list[i] - 1;
+            pool_free_list[i] = pool_next_free[block];
+        }
+        else if(pool_blocks_touched[i] < pool_class[i].num_blocks)
+        {
+            block = pool_class[i].first_block + pool_blocks_touched[i];
+            pool_blocks_touched[i]++;
+        }
+        else
+        {
+            continue; // all blocks taken
+        }
+        
+        pool_block_used[block] = size;
+        pool_stats[i].in_use++;
+        pool_stats[i].bytes_requested += size;
+        if(pool_stats[i].in_use > pool_stats[i].high_water)
+        {
+            pool_stats[i].high_water = pool_stats[i].in_use;
+        }
+        
+        return pool_block_ptr(i, block);
+    }
+    
+    if(fits != -1)
+    {
+        pool_stats[fits].failures++;
+    }
+    
+    return NULL; // too big or all blocks it fits in are taken
+}
+#else
 /*
     \brief Allocates memory
 
@@ -205,6 +372,7 @@ void* one_net_malloc(UInt8 size)
     // should never get here?
     return NULL;
 }
+#endif // else ONE_NET_MEMORY_POOL is not defined //
 
 
 /*
@@ -245,6 +413,144 @@ void* one_net_calloc(UInt8 size, UInt8 value)
 }
 
 
+#ifdef ONE_NET_MEMORY_POOL
+/*
+    \brief Reallocate memory block
+
+    The size of the memory block pointed to by the ptr parameter is changed to
+    the size bytes, expanding or reducing the amount of memory available in the
+    block.
+
+    The function may move the memory block to a new location, in which case the
+    new location is returned. The content of the memory block is preserved up to
+    the lesser of the new and old sizes, even if the block is moved. If the new
+    size is larger, the value of the newly allocated portion is indeterminate.
+    The block is only moved if the new size does not fit in it.
+
+    In case that ptr is NULL, the function behaves exactly as malloc, assigning
+    a new block of size bytes and returning a pointer to the beginning of it.
+
+    In case that the size is 0, the memory previously allocated in ptr is
+    deallocated as if a call to free was made, and a NULL pointer is returned.
+
+
+    \param[in] ptr Pointer to a memory block previously allocated with malloc,
+      calloc or realloc to be reallocated.  If this is NULL, a new block is
+      allocated and a pointer to it is returned by the function.  If ptr is
+      NOT NULL and does NOT point to a memory block, NULL is returned.
+      
+    \param[in] size New size for the memory block, in bytes.
+      If it is 0 and ptr points to an existing block of memory, the memory
+      block pointed by ptr is deallocated and a NULL pointer is returned.
+   
+    \return A pointer to the reallocated memory block, which may be either the
+    same as the ptr argument or a new location.  The type of this pointer is
+    void*, which can be cast to the desired type of data pointer in order to be
+    dereferenceable.
+
+    If the function failed to allocate the requested block of memory, a NULL
+    pointer is returned, and the memory block pointed to by argument ptr is
+    left unchanged.
+*/
+void* one_net_realloc(void* ptr, UInt8 size)
+{
+    SInt16 block;
+    UInt8 class_index;
+    void* new_ptr;
+    
+    if(ptr == NULL)
+    {
+        return one_net_malloc(size);
+    }
+    
+    if((block = pool_block(ptr, &class_index)) == -1)
+    {
+        return NULL; // bad pointer
+    }
+    
+    if(size == 0)
+    {
+        one_net_free(ptr);
+        return NULL;
+    }
+    
+    if(size <= pool_class[class_index].block_size)
+    {
+        pool_stats[class_index].bytes_requested += size;
+        pool_stats[class_index].bytes_requested -= pool_block_used[block];
+        pool_block_used[block] = size;
+        return ptr;
+    } // if it still fits //
+    
+    if((new_ptr = one_net_malloc(size)) == NULL)
+    {
+        return NULL;
+    }
+    
+    one_net_memmove(new_ptr, ptr, pool_block_used[block]);
+    one_net_free(ptr);
+    return new_ptr;
+}
+
+
+/*
+    \brief Deallocate space in memory
+
+    A block of memory previously allocated using a call to one_net_malloc,
+    one_net_calloc or one_net_realloc is deallocated, making it available
+    again for further allocations.  Notice that this function leaves the value
+    of ptr unchanged, hence it still points to the same (now invalid) location,
+    and not to the null pointer.
+
+
+    \param[in] ptr Pointer to a memory block previously allocated with
+                   one_net_malloc, one_net_calloc or one_net_realloc to
+                   be deallocated.  If a null pointer is passed as argument,
+                   or ptr is not an allocated block, no action occurs.
+   
+    \return none
+*/
+void one_net_free(void* ptr)
+{
+    SInt16 block;
+    UInt8 class_index;
+    
+    if(!ptr || (block = pool_block(ptr, &class_index)) == -1)
+    {
+        return;
+    }
+    
+    pool_stats[class_index].in_use--;
+    pool_stats[class_index].bytes_requested -= pool_block_used[block];
+    pool_block_used[block] = 0;
+    
+    pool_next_free[block] = pool_free_list[class_index];
+    pool_free_list[class_index] = block + 1;
+} // one_net_free //
+
+
+/*!
+    \brief Reports how one size class of the pool has been used.
+
+    \param[in] class_index The size class (ONE_NET_POOL_SMALL, ...)
+    \param[out] stats The use of the class
+   
+    \return TRUE if the stats were filled in
+            FALSE if class_index is not a size class
+*/
+BOOL one_net_pool_stats(UInt8 class_index, one_net_pool_stats_t* stats)
+{
+    if(class_index >= ONE_NET_POOL_NUM_CLASSES || !stats)
+    {
+        return FALSE;
+    }
+    
+    *stats = pool_stats[class_index];
+    stats->block_size = pool_class[class_index].block_size;
+    stats->num_blocks = pool_class[class_index].num_blocks;
+    return TRUE;
+} // one_net_pool_stats //
+#else
 /*
     \brief Reallocate memory block
 
@@ -360,6 +666,7 @@ void one_net_free(void* ptr)
         }
     }
 } // one_net_free //
+#endif // else ONE_NET_MEMORY_POOL is not defined //
 
 
 
@@ -368,6 +675,30 @@ void one_net_free(void* ptr)
 // temporary debugging
 #ifdef DEBUGGING_TOOLS
 #include "oncli.h"
+#ifdef ONE_NET_MEMORY_POOL
+void print_mem(void)
+{
+    UInt8 i;
+    one_net_pool_stats_t stats;
+    
+    oncli_send_msg("Class\tSize\tBlocks\tUsed\tMost\tWasted\tFailed\n");
+    for(i = 0; i < ONE_NET_POOL_NUM_CLASSES; i++)
+    {
+        one_net_pool_stats(i, &stats);
+        oncli_send_msg("%d\t%d\t%d\t%d\t%d\t%d\t%d\n", i,
+          stats.block_size, stats.num_blocks, stats.in_use,
+          stats.high_water, stats.in_use * stats.block_size -
+          stats.bytes_requested, stats.failures);
+        delay_ms(10);
+    }
+    oncli_send_msg("Pool Buffer\n");
+    xdump((UInt8*) &pool_buffer[0], ONE_NET_POOL_SIZE);
+}
+UInt8* get_loc(UInt8 index)
+{
+    return &pool_buffer[index];
+}
+#else
 void print_mem(void)
 {
     oncli_send_msg("Heap Entry\n");
@@ -379,6 +710,7 @@ UInt8* get_loc(UInt8 index)
 {
     return &heap_buffer[index];
 }
+#endif // else ONE_NET_MEMORY_POOL is not defined //
 #endif
 
 
@@ -396,6 +728,76 @@ UInt8* get_loc(UInt8 index)
 //! \ingroup one_net_memory
 //! @{
 
+
+#ifdef ONE_NET_MEMORY_POOL
+/*!
+    \brief Finds the allocated block a pointer points to.
+
+    \param[in] ptr The pointer
+    \param[out] class_index The size class of the block
+   
+    \return The index of the block.  -1 if ptr is not the start of an
+      allocated block.
+*/
+static SInt16 pool_block(const void* const ptr, UInt8* const class_index)
+{
+    const UInt8* const PTR = (const UInt8*) ptr;
+    UInt16 offset, end;
+    UInt8 i;
+    
+    if(PTR < pool_buffer || PTR >= &pool_buffer[ONE_NET_POOL_SIZE])
+    {
+        return -1;
+    }
+    
+    offset = (UInt16)(PTR - pool_buffer);
+    for(i = 0; i < ONE_NET_POOL_NUM_CLASSES; i++)
+    {
+        end = pool_class[i].offset
+          + pool_class[i].block_size * pool_class[i].num_blocks;
+        if(offset < end)
+        {
+            UInt8 block;
+
+            offset -= pool_class[i].offset;
+            if(offset % pool_class[i].block_size)
+            {
+                return -1; // not the start of a block
+            }
+            
+            block = pool_class[i].first_block
+              + offset / pool_class[i].block_size;
+            if(!pool_block_used[block])
+            {
+                return -1; // not allocated
+            }
+            
+            *class_index = i;
+            return block;
+        }
+    }
+    
+    return -1;
+} // pool_block //
+
+
+/*!
+    \brief Returns the start of a block.
+
+    \param[in] CLASS_INDEX The size class of the block
+    \param[in] BLOCK The index of the block
+   
+    \return The start of the block in pool_buffer
+*/
+static UInt8* pool_block_ptr(const UInt8 CLASS_INDEX, const UInt8 BLOCK)
+{
+    return &pool_buffer[pool_class[CLASS_INDEX].offset
+      + (UInt16)(BLOCK - pool_class[CLASS_INDEX].first_block)
+      * pool_class[CLASS_INDEX].block_size];
+} // pool_block_ptr //
+#endif // ifdef ONE_NET_MEMORY_POOL //
+
+
 //! @} one_net_memory_pri_func
 //                      PRIVATE FUNCTION IMPLEMENTATION END
 //==============================================================================
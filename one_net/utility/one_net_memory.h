@@ -71,11 +71,42 @@
 //! @{
 
 
+#ifdef ONE_NET_MEMORY_POOL
+//! The pool's size classes, smallest first
+enum
+{
+    ONE_NET_POOL_SMALL,
+    ONE_NET_POOL_MEDIUM,
+    ONE_NET_POOL_LARGE,
+    ONE_NET_POOL_NUM_CLASSES
+};
+
+
+/*!
+    \brief How one size class of the pool has been used.
+*/
+typedef struct
+{
+    UInt8 block_size;       //!< The number of bytes in each block
+    UInt8 num_blocks;       //!< The number of blocks in the class
+    UInt8 in_use;           //!< The number of blocks allocated now
+    UInt8 high_water;       //!< The most blocks that have been allocated
+    
+    //! The number of bytes asked for in the blocks allocated now.  The rest
+    //! of the bytes in those blocks are wasted.
+    UInt16 bytes_requested;
+    
+    //! The number of requests this was the smallest class for that could not
+    //! be given a block from this class or a larger one.
+    UInt16 failures;
+} one_net_pool_stats_t;
+#else
 typedef struct
 {
     UInt8 index;
     UInt8 size;
 } heap_entry_t;
+#endif // else ONE_NET_MEMORY_POOL is not defined //
 
 
 //! @} one_net_memory_typedefs
@@ -96,6 +127,10 @@ void* one_net_calloc(UInt8 size, UInt8 value);
 void* one_net_realloc(void* ptr, UInt8 size);
 void one_net_free(void* ptr);
 
+#ifdef ONE_NET_MEMORY_POOL
+BOOL one_net_pool_stats(UInt8 class_index, one_net_pool_stats_t* stats);
+#endif
+
 // temporary debugging --  will be deleted
 #ifdef DEBUGGING_TOOLS
 void print_mem(void);
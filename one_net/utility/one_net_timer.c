@@ -35,10 +35,13 @@
     \file one_net_timer.c
     \brief Timer Implementation used by ONE-NET.
     
-    The module keeps track of the last time that it checked the tick count and
-    decrements the difference between then and now from ALL the timers whenever
-    any timer is checked.  Timers are countdown timers.  This module handles
-    overflow of the tick timer.
+    Timers are countdown timers.  A running timer holds the tick it expires
+    at, and the running timers are kept in a min-heap ordered by how far away
+    that tick is, so checking the timers only has to look at the top of the
+    heap instead of adjusting every timer whenever any timer is checked.  The
+    top of the heap is also the next time anything is due, which is what a
+    device that wants to sleep needs to know (see ont_next_deadline).  This
+    module handles overflow of the tick timer.
     
     \note See one_net.h for the version of the ONE-NET source as a whole.  If
       any one file is modified, the version number in one_net.h will need to be
@@ -55,6 +58,7 @@
 #include "one_net_timer_port_const.h"
 #include "one_net_port_specific.h"
 #include "config_options.h"
+#include "one_net_context.h"
 
 // TODO -- this is a bit messy.  Find a better #define test.
 #if defined(_R8C_TINY) && !defined(QUAD_OUTPUT)
@@ -68,6 +72,9 @@
 //! \ingroup ONE-NET_TIMER
 //! @{
 
+//! Value of timer_heap_pos for a timer that is not running.
+#define ONT_NOT_RUNNING 0
+
 //! @} ONE-NET_TIMER_const
 //                                  CONSTANTS END
 //==============================================================================
@@ -92,7 +99,7 @@
 
 
 //! Array to keep track of the timers.
-ont_timer_t timer[ONT_NUM_TIMERS] = {{FALSE, 0}};
+ONE_NET_DEVICE_STATE ont_timer_t timer[ONT_NUM_TIMERS] = {{FALSE, 0}};
 
 
 
@@ -101,11 +108,11 @@ ont_timer_t timer[ONT_NUM_TIMERS] = {{FALSE, 0}};
 #include "one_net_master_port_const.h"
 
 
-UInt32 one_net_response_time_out = ONE_NET_RESPONSE_TIME_OUT;
-UInt32 write_pause = 0;
-UInt32 one_net_master_invite_send_time = ONE_NET_MASTER_INVITE_SEND_TIME;
-tick_t one_net_master_channel_scan_time = ONE_NET_MASTER_CHANNEL_SCAN_TIME;
-UInt32 invite_transaction_timeout = INVITE_TRANSACTION_TIMEOUT;
+ONE_NET_DEVICE_STATE UInt32 one_net_response_time_out = ONE_NET_RESPONSE_TIME_OUT;
+ONE_NET_DEVICE_STATE UInt32 write_pause = 0;
+ONE_NET_DEVICE_STATE UInt32 one_net_master_invite_send_time = ONE_NET_MASTER_INVITE_SEND_TIME;
+ONE_NET_DEVICE_STATE tick_t one_net_master_channel_scan_time = ONE_NET_MASTER_CHANNEL_SCAN_TIME;
+ONE_NET_DEVICE_STATE UInt32 invite_transaction_timeout = INVITE_TRANSACTION_TIMEOUT;
 
 
 
@@ -136,10 +143,10 @@ const char* const debug_interval_strs[NUM_DEBUG_INTERVALS] =
 
 
 
-BOOL pause = FALSE;
-BOOL proceed = FALSE;
-BOOL ratchet = FALSE;
-BOOL pausing = FALSE;
+ONE_NET_DEVICE_STATE BOOL pause = FALSE;
+ONE_NET_DEVICE_STATE BOOL proceed = FALSE;
+ONE_NET_DEVICE_STATE BOOL ratchet = FALSE;
+ONE_NET_DEVICE_STATE BOOL pausing = FALSE;
 #endif
 
 
@@ -159,7 +166,17 @@ BOOL pausing = FALSE;
 
 
 //! The last time the tick count was read and the timers were updated.
-static tick_t last_tick = 0;
+static ONE_NET_DEVICE_STATE tick_t last_tick = 0;
+
+//! Min-heap of the running timers, ordered by the number of ticks from
+//! last_tick to when they expire.
+static ONE_NET_DEVICE_STATE UInt8 timer_heap[ONT_NUM_TIMERS];
+
+//! The number of timers in timer_heap.
+static ONE_NET_DEVICE_STATE UInt8 timer_heap_size = 0;
+
+//! One more than the index of each timer in timer_heap, or ONT_NOT_RUNNING.
+static ONE_NET_DEVICE_STATE UInt8 timer_heap_pos[ONT_NUM_TIMERS];
 
 
 //! @} ONE-NET_TIMER_pri_var
@@ -173,6 +190,16 @@ static tick_t last_tick = 0;
 //! @{
 
 static void update_timers(void);
+static tick_t time_left(const UInt8 TIMER);
+static BOOL timer_earlier(const UInt8 LHS, const UInt8 RHS);
+static void place_timer(UInt8 index, const UInt8 TIMER);
+static void sift_timer_up(UInt8 index);
+static void sift_timer_down(UInt8 index);
+static void start_timer(const UInt8 TIMER, const tick_t DURATION);
+static tick_t halt_timer(const UInt8 TIMER);
+#ifdef DEBUGGING_TOOLS
+static void freeze_timers(const tick_t TICK_DIFF, const BOOL ALL);
+#endif
 
 //! @} ONE-NET_TIMER_pri_func
 //                      PRIVATE FUNCTION DECLARATIONS END
@@ -201,9 +228,10 @@ BOOL ont_set_timer(const UInt8 TIMER, const tick_t DURATION)
     } // if the timer is invalid //
 
     update_timers();
+    halt_timer(TIMER);
     
     timer[TIMER].active = TRUE;
-    timer[TIMER].tick = DURATION;
+    start_timer(TIMER, DURATION);
     
     return TRUE;
 } // ont_set_timer //
@@ -226,7 +254,7 @@ tick_t ont_get_timer(const UInt8 TIMER)
     
     update_timers();
 
-    return timer[TIMER].tick;
+    return time_left(TIMER);
 } // ont_get_timer //
 
 
@@ -245,6 +273,7 @@ BOOL ont_stop_timer(const UInt8 TIMER)
         return FALSE;
     } // if the timer is invalid //
     
+    halt_timer(TIMER);
     timer[TIMER].active = FALSE;
     timer[TIMER].tick = 0;
     
@@ -291,12 +320,13 @@ BOOL ont_expired(const UInt8 TIMER)
     
     update_timers();
     
-    if(timer[TIMER].tick == 0)
+    if(timer_heap_pos[TIMER] != ONT_NOT_RUNNING)
     {
-        timer[TIMER].active = FALSE;
-    } // if the timer has expired //
+        return FALSE;
+    } // if the timer has not expired //
     
-    return timer[TIMER].tick == 0;
+    timer[TIMER].active = FALSE;
+    return TRUE;
 } // ont_expired //
 
 
@@ -318,7 +348,7 @@ BOOL ont_inactive_or_expired(const UInt8 TIMER)
     
     update_timers();
     
-    if(timer[TIMER].tick == 0)
+    if(timer_heap_pos[TIMER] == ONT_NOT_RUNNING && timer[TIMER].tick == 0)
     {
         timer[TIMER].active = FALSE;
     } // if the timer has expired //
@@ -329,6 +359,34 @@ BOOL ont_inactive_or_expired(const UInt8 TIMER)
 } // ont_inactive_or_expired //
 
 
+/*!
+    \brief Returns the time until the next running timer expires.
+    
+    Timers that have already expired but have not been checked yet are not
+    counted since they are waiting on whoever checks them, as are paused
+    timers.  This is how long a device can sleep before one of its timers
+    needs attention.
+    
+    \param[out] ticks The number of ticks until the first running timer
+      expires.  Not changed if no timers are running.
+    
+    \return TRUE if a timer is running and ticks was set.
+            FALSE if no timers are running.
+*/
+BOOL ont_next_deadline(tick_t* const ticks)
+{
+    update_timers();
+    
+    if(!timer_heap_size)
+    {
+        return FALSE;
+    } // if nothing is running //
+    
+    *ticks = time_left(timer_heap[0]);
+    return TRUE;
+} // ont_next_deadline //
+
+
 #ifdef DEBUGGING_TOOLS
 #include "oncli.h"
 void print_intervals(void)
@@ -352,7 +410,7 @@ void print_timers(void)
     {
         const char* const state_str = timer[i].active ? active_state_str :
             inactive_state_str;
-        oncli_send_msg("Timer %d:\t%s\t%ld\n", i, state_str, timer[i].tick);
+        oncli_send_msg("Timer %d:\t%s\t%ld\n", i, state_str, time_left(i));
         delay_ms(10);
     }
 }
@@ -360,7 +418,11 @@ void print_timers(void)
 
 void synchronize_last_tick(void)
 {
-    last_tick = get_tick_count();
+    tick_t tick_now = get_tick_count();
+
+    // the time since the timers were last updated does not count
+    freeze_timers(tick_now - last_tick, TRUE);
+    last_tick = tick_now;
 }
 #endif
 
@@ -378,6 +440,9 @@ void synchronize_last_tick(void)
 /*!
     \brief Updates the timers
     
+    Running timers whose time has come are taken out of the heap.  They stay
+    active with no ticks remaining until they are checked.
+    
     \param void
     
     \return void
@@ -385,56 +450,248 @@ void synchronize_last_tick(void)
 static void update_timers(void)
 {
     tick_t tick_diff, tick_now;
-
-    UInt8 i;
+    UInt8 expired;
     
     tick_now = get_tick_count();
     
-    if(tick_now < last_tick)
-    {
-        // Subtract from 0 since going from all 1s to 0 takes a tick
-        tick_diff = ((tick_t)0 - last_tick) + tick_now;
-    } // if rollover has occurred //
-    else
-    {
-        tick_diff = tick_now - last_tick;
-    } // else rollover has not occured //
+    // unsigned subtraction handles rollover since going from all 1s to 0
+    // takes a tick
+    tick_diff = tick_now - last_tick;
     
     if(!tick_diff)
     {
         return;
     } // if the time hasn't changed //
     
+    #ifdef DEBUGGING_TOOLS
+    if(pausing)
+    {
+        // pausing everything but the APP timers
+        freeze_timers(tick_diff, FALSE);
+    } // if pausing //
+    #endif
+    
+    while(timer_heap_size &&
+      (tick_t)(timer[timer_heap[0]].tick - last_tick) <= tick_diff)
+    {
+        expired = timer_heap[0];
+        halt_timer(expired);
+        timer[expired].tick = 0;
+    } // loop to expire the timers that are due //
+    
     last_tick = tick_now;
+} // update_timers //
+
+
+/*!
+    \brief Returns the number of ticks a timer has left as of last_tick.
     
-    for(i = 0; i < ONT_NUM_TIMERS; i++)
+    \param[in] TIMER The timer
+    
+    \return The ticks remaining.  For a timer that is not running, this is the
+      time it had left when it was paused, or 0.
+*/
+static tick_t time_left(const UInt8 TIMER)
+{
+    if(timer_heap_pos[TIMER] == ONT_NOT_RUNNING)
+    {
+        return timer[TIMER].tick;
+    } // if the timer is not running //
+    
+    return (tick_t)(timer[TIMER].tick - last_tick);
+} // time_left //
+
+
+/*!
+    \brief Returns whether one running timer expires before another.
+    
+    \param[in] LHS The first timer
+    \param[in] RHS The second timer
+    
+    \return TRUE if LHS expires before RHS
+            FALSE otherwise
+*/
+static BOOL timer_earlier(const UInt8 LHS, const UInt8 RHS)
+{
+    return (tick_t)(timer[LHS].tick - last_tick) <
+      (tick_t)(timer[RHS].tick - last_tick);
+} // timer_earlier //
+
+
+/*!
+    \brief Puts a timer at a location in the heap.
+    
+    \param[in] index The location in the heap
+    \param[in] TIMER The timer to put there
+    
+    \return void
+*/
+static void place_timer(UInt8 index, const UInt8 TIMER)
+{
+    timer_heap[index] = TIMER;
+    timer_heap_pos[TIMER] = index + 1;
+} // place_timer //
+
+
+/*!
+    \brief Moves the timer at a location in the heap towards the top until
+      its parent expires before it does.
+    
+    \param[in] index The location in the heap
+    
+    \return void
+*/
+static void sift_timer_up(UInt8 index)
+{
+    UInt8 parent;
+    const UInt8 TIMER = timer_heap[index];
+    
+    while(index)
     {
-        #ifdef DEBUGGING_TOOLS
-        if(pausing && i != WRITE_PAUSE_TIMER && i >= ONT_NUM_APP_TIMERS)
+        parent = (index - 1) / 2;
+        if(!timer_earlier(TIMER, timer_heap[parent]))
         {
-            // pausing everything but the APP timers
-            continue;
-        }
-        #endif
+            break;
+        } // if the parent expires first //
         
-        if(timer[i].active)
+        place_timer(index, timer_heap[parent]);
+        index = parent;
+    } // loop to move the timer up //
+    
+    place_timer(index, TIMER);
+} // sift_timer_up //
+
+
+/*!
+    \brief Moves the timer at a location in the heap towards the bottom until
+      it expires before its children.
+    
+    \param[in] index The location in the heap
+    
+    \return void
+*/
+static void sift_timer_down(UInt8 index)
+{
+    UInt8 child;
+    const UInt8 TIMER = timer_heap[index];
+    
+    while((child = 2 * index + 1) < timer_heap_size)
+    {
+        if(child + 1 < timer_heap_size &&
+          timer_earlier(timer_heap[child + 1], timer_heap[child]))
         {
-            if(timer[i].tick > tick_diff)
-            {
-                timer[i].tick -= tick_diff;
-            } // if more time remains //
-            else
-            {
-                timer[i].tick = 0;
-            } // else the timer has expired //
-        } // if the timer is active //
-    } // loop to adjust the timers //
-} // update_timers //
+            child++;
+        } // if the right child expires first //
+        
+        if(!timer_earlier(timer_heap[child], TIMER))
+        {
+            break;
+        } // if the timer expires first //
+        
+        place_timer(index, timer_heap[child]);
+        index = child;
+    } // loop to move the timer down //
+    
+    place_timer(index, TIMER);
+} // sift_timer_down //
+
+
+/*!
+    \brief Starts a timer that is not running counting down from last_tick.
+    
+    \param[in] TIMER The timer
+    \param[in] DURATION The number of ticks until it expires.  If 0, the timer
+      is expired and is not put in the heap.
+    
+    \return void
+*/
+static void start_timer(const UInt8 TIMER, const tick_t DURATION)
+{
+    if(!DURATION)
+    {
+        timer[TIMER].tick = 0;
+        return;
+    } // if the timer has already expired //
+    
+    timer[TIMER].tick = last_tick + DURATION;
+    place_timer(timer_heap_size, TIMER);
+    timer_heap_size++;
+    sift_timer_up(timer_heap_size - 1);
+} // start_timer //
+
+
+/*!
+    \brief Takes a timer out of the heap.
+    
+    \param[in] TIMER The timer
+    
+    \return The number of ticks it had left, which is also left in its tick
+      field.  0 if it was not running.
+*/
+static tick_t halt_timer(const UInt8 TIMER)
+{
+    UInt8 index;
+    
+    if(timer_heap_pos[TIMER] == ONT_NOT_RUNNING)
+    {
+        return 0;
+    } // if the timer is not running //
+    
+    index = timer_heap_pos[TIMER] - 1;
+    timer[TIMER].tick = time_left(TIMER);
+    timer_heap_pos[TIMER] = ONT_NOT_RUNNING;
+    
+    timer_heap_size--;
+    if(index < timer_heap_size)
+    {
+        place_timer(index, timer_heap[timer_heap_size]);
+        sift_timer_up(index);
+        sift_timer_down(timer_heap_pos[timer_heap[timer_heap_size]] - 1);
+    } // if the last timer in the heap needs to fill the hole //
+    
+    return timer[TIMER].tick;
+} // halt_timer //
+
+
+#ifdef DEBUGGING_TOOLS
+/*!
+    \brief Keeps running timers from counting down for some ticks.
+    
+    This is only done while debugging, so it is fine that it touches every
+    timer.
+    
+    \param[in] TICK_DIFF The number of ticks not to count.
+    \param[in] ALL TRUE if all timers are frozen.  FALSE if the APP timers
+      and the write pause timer keep counting.
+    
+    \return void
+*/
+static void freeze_timers(const tick_t TICK_DIFF, const BOOL ALL)
+{
+    UInt8 i;
+    
+    for(i = 0; i < ONT_NUM_TIMERS; i++)
+    {
+        if(timer_heap_pos[i] != ONT_NOT_RUNNING &&
+          (ALL || (i != WRITE_PAUSE_TIMER && i >= ONT_NUM_APP_TIMERS)))
+        {
+            timer[i].tick += TICK_DIFF;
+        } // if the timer is frozen //
+    } // loop through the timers //
+    
+    // the frozen timers moved relative to the others, so rebuild the heap
+    for(i = timer_heap_size / 2; i > 0; i--)
+    {
+        sift_timer_down(i - 1);
+    } // loop to rebuild the heap //
+} // freeze_timers //
+#endif
 
 
 void pause_timer(UInt8 TIMER)
 {
     update_timers();
+    halt_timer(TIMER);
     timer[TIMER].active = FALSE;
 }
 
@@ -442,7 +699,11 @@ void pause_timer(UInt8 TIMER)
 void unpause_timer(UInt8 TIMER)
 {
     update_timers();
-    timer[TIMER].active = TRUE;
+    if(!timer[TIMER].active)
+    {
+        timer[TIMER].active = TRUE;
+        start_timer(TIMER, timer[TIMER].tick);
+    } // if the timer was paused //
 }
 
 
@@ -168,7 +168,9 @@ enum
 typedef struct
 {
     BOOL active;                    //!< Flag to indicate if active(TRUE).
-    tick_t tick;                    //!< number of ticks remaining
+    //! The tick the timer expires at while it is running, otherwise the
+    //! number of ticks remaining
+    tick_t tick;
 } ont_timer_t;
 
     
@@ -242,6 +244,8 @@ BOOL ont_active(const UInt8 TIMER);
 BOOL ont_expired(const UInt8 TIMER);
 BOOL ont_inactive_or_expired(const UInt8 TIMER);
 
+BOOL ont_next_deadline(tick_t* const ticks);
+
 
 void pause_timer(UInt8 TIMER);
 void unpause_timer(UInt8 TIMER);
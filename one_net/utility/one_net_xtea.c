@@ -44,6 +44,10 @@
 #include "one_net_xtea.h"
 #include "one_net_port_specific.h"
 
+#ifdef XTEA_X86_SIMD
+    #include <immintrin.h>
+#endif
+
 // TODO -- this is a bit messy.  Find a better #define test.
 #if defined(_R8C_TINY) && !defined(QUAD_OUTPUT)
     #pragma section program program_high_rom
@@ -89,6 +93,24 @@ static const UInt32 DELTA = 0x9E3779B9;
 //! \ingroup one_net_xtea
 //! @{
 
+#ifdef XTEA_KEY_SCHEDULE
+static void cipher_blocks(const BOOL ENCIPHER,
+  const one_net_xtea_key_schedule_t * const * const SCHEDULES,
+  const one_net_xtea_key_schedule_t * const SCHEDULE, UInt8 * data,
+  const UInt16 NUM_BLOCKS);
+static void cipher_block(const BOOL ENCIPHER,
+  const one_net_xtea_key_schedule_t * const SCHEDULE, UInt8 * const data);
+
+#ifdef XTEA_X86_SIMD
+static void cipher_4_blocks_sse2(const BOOL ENCIPHER,
+  const one_net_xtea_key_schedule_t * const * const SCHEDULES,
+  UInt8 * const data);
+static void cipher_8_blocks_avx2(const BOOL ENCIPHER,
+  const one_net_xtea_key_schedule_t * const * const SCHEDULES,
+  UInt8 * const data);
+#endif
+#endif
+
 //! @} one_net_xtea_pri_func
 //                      PRIVATE FUNCTION DECLARATIONS END
 //==============================================================================
@@ -182,6 +204,133 @@ void one_net_xtea_decipher(const UInt8 ROUNDS, UInt8 * data,
     one_net_uint32_to_byte_stream(v[1], data + sizeof(v[0]));
 } // one_net_xtea_decipher //
 
+
+#ifdef XTEA_KEY_SCHEDULE
+/*!
+    \brief Expands a key for the given number of rounds.
+
+    The schedule can then be used for any number of blocks with the
+    one_net_xtea_*_blocks functions, which give the same results as
+    one_net_xtea_encipher / one_net_xtea_decipher with the same key and
+    number of rounds.
+
+    \param[out] schedule The expanded key.
+    \param[in] ROUNDS The number of rounds to perform.  Must be no more than
+      ONE_NET_XTEA_MAX_SCHEDULE_ROUNDS.
+    \param[in] KEY The key to expand.
+
+    \return TRUE if the schedule was built, FALSE if the parameters were
+      invalid.
+*/
+BOOL one_net_xtea_key_schedule(one_net_xtea_key_schedule_t * const schedule,
+  const UInt8 ROUNDS, const one_net_xtea_key_t * const KEY)
+{
+    UInt32 k[4] = {0x00};
+    UInt32 sum = 0;
+    UInt8 i;
+
+    if(!schedule || !KEY || ROUNDS > ONE_NET_XTEA_MAX_SCHEDULE_ROUNDS)
+    {
+        return FALSE;
+    } // if invalid parameter //
+
+    // get k
+    for(i = 0; i < sizeof(UInt32); i++)
+    {
+        k[i] = one_net_byte_stream_to_uint32((const UInt8 * const)KEY
+          + i * sizeof(UInt32));
+    } // loop to get k //
+
+    schedule->rounds = ROUNDS;
+    for(i = 0; i < ROUNDS; i++)
+    {
+        schedule->sum_k0[i] = sum + k[sum & 3];
+        sum += DELTA;
+        schedule->sum_k1[i] = sum + k[sum >> 11 & 3];
+    } // loop through the rounds //
+
+    return TRUE;
+} // one_net_xtea_key_schedule //
+
+
+/*!
+    \brief Enciphers consecutive 64-bit blocks with one key schedule.
+
+    \param[in] SCHEDULE The expanded key (see one_net_xtea_key_schedule).
+    \param[in/out] data Input: NUM_BLOCKS blocks of plain text.
+                        Output: The cipher text.
+    \param[in] NUM_BLOCKS The number of 8 byte blocks in data.
+
+    \return void
+*/
+void one_net_xtea_encipher_blocks(
+  const one_net_xtea_key_schedule_t * const SCHEDULE, UInt8 * data,
+  const UInt16 NUM_BLOCKS)
+{
+    cipher_blocks(TRUE, 0, SCHEDULE, data, NUM_BLOCKS);
+} // one_net_xtea_encipher_blocks //
+
+
+/*!
+    \brief Deciphers consecutive 64-bit blocks with one key schedule.
+
+    \param[in] SCHEDULE The expanded key (see one_net_xtea_key_schedule).
+    \param[in/out] data Input: NUM_BLOCKS blocks of cipher text.
+                        Output: The plain text.
+    \param[in] NUM_BLOCKS The number of 8 byte blocks in data.
+
+    \return void
+*/
+void one_net_xtea_decipher_blocks(
+  const one_net_xtea_key_schedule_t * const SCHEDULE, UInt8 * data,
+  const UInt16 NUM_BLOCKS)
+{
+    cipher_blocks(FALSE, 0, SCHEDULE, data, NUM_BLOCKS);
+} // one_net_xtea_decipher_blocks //
+
+
+/*!
+    \brief Enciphers consecutive 64-bit blocks, each with its own schedule.
+
+    Block i is enciphered with SCHEDULES[i].  This is for trying many keys
+    against the same data, in which case the data is repeated once per key.
+
+    \param[in] SCHEDULES NUM_BLOCKS pointers to expanded keys.
+    \param[in/out] data Input: NUM_BLOCKS blocks of plain text.
+                        Output: The cipher text.
+    \param[in] NUM_BLOCKS The number of 8 byte blocks in data.
+
+    \return void
+*/
+void one_net_xtea_encipher_blocks_multi_key(
+  const one_net_xtea_key_schedule_t * const * const SCHEDULES, UInt8 * data,
+  const UInt16 NUM_BLOCKS)
+{
+    cipher_blocks(TRUE, SCHEDULES, 0, data, NUM_BLOCKS);
+} // one_net_xtea_encipher_blocks_multi_key //
+
+
+/*!
+    \brief Deciphers consecutive 64-bit blocks, each with its own schedule.
+
+    Block i is deciphered with SCHEDULES[i].  This is for trying many keys
+    against the same data, in which case the data is repeated once per key.
+
+    \param[in] SCHEDULES NUM_BLOCKS pointers to expanded keys.
+    \param[in/out] data Input: NUM_BLOCKS blocks of cipher text.
+                        Output: The plain text.
+    \param[in] NUM_BLOCKS The number of 8 byte blocks in data.
+
+    \return void
+*/
+void one_net_xtea_decipher_blocks_multi_key(
+  const one_net_xtea_key_schedule_t * const * const SCHEDULES, UInt8 * data,
+  const UInt16 NUM_BLOCKS)
+{
+    cipher_blocks(FALSE, SCHEDULES, 0, data, NUM_BLOCKS);
+} // one_net_xtea_decipher_blocks_multi_key //
+#endif // ifdef XTEA_KEY_SCHEDULE //
+
 //! @} one_net_xtea_pub_func
 //                      PUBLIC FUNCTION IMPLEMENTATION END
 //==============================================================================
@@ -192,6 +341,302 @@ void one_net_xtea_decipher(const UInt8 ROUNDS, UInt8 * data,
 //! \ingroup one_net_xtea
 //! @{
 
+#ifdef XTEA_KEY_SCHEDULE
+/*!
+    \brief Enciphers or deciphers consecutive blocks.
+
+    If XTEA_SIMD is defined, groups of 8 (AVX2) or 4 (SSE2) blocks that use
+    the same number of rounds are done side by side, one block per lane.
+    Whatever is left is done one block at a time.
+
+    \param[in] ENCIPHER TRUE to encipher, FALSE to decipher.
+    \param[in] SCHEDULES If not 0, the schedule for each block.
+    \param[in] SCHEDULE The schedule for every block if SCHEDULES is 0.
+    \param[in/out] data The blocks.
+    \param[in] NUM_BLOCKS The number of 8 byte blocks in data.
+
+    \return void
+*/
+static void cipher_blocks(const BOOL ENCIPHER,
+  const one_net_xtea_key_schedule_t * const * const SCHEDULES,
+  const one_net_xtea_key_schedule_t * const SCHEDULE, UInt8 * data,
+  const UInt16 NUM_BLOCKS)
+{
+    UInt16 block = 0;
+
+    if(!data || (!SCHEDULES && !SCHEDULE))
+    {
+        return;
+    } // if invalid parameter //
+
+    #ifdef XTEA_X86_SIMD
+    {
+        const one_net_xtea_key_schedule_t * same[8];
+        const one_net_xtea_key_schedule_t * const * lanes = same;
+        BOOL avx2 = (__builtin_cpu_supports("avx2") != 0);
+        UInt8 group, i;
+
+        for(i = 0; i < 8; i++)
+        {
+            same[i] = SCHEDULE;
+        } // loop to fill in same //
+
+        while(NUM_BLOCKS - block >= 4)
+        {
+            group = (avx2 && NUM_BLOCKS - block >= 8) ? 8 : 4;
+            if(SCHEDULES)
+            {
+                lanes = &SCHEDULES[block];
+                for(i = 1; i < group; i++)
+                {
+                    if(lanes[i]->rounds != lanes[0]->rounds)
+                    {
+                        break;
+                    } // if rounds do not match //
+                } // loop through the lanes //
+
+                if(i < group)
+                {
+                    // lanes can't be run together, so do one block
+                    cipher_block(ENCIPHER, lanes[0],
+                      &data[block * ONE_NET_XTEA_BLOCK_SIZE]);
+                    block++;
+                    continue;
+                } // if lanes do not match //
+            } // if a schedule for each block //
+
+            if(group == 8)
+            {
+                cipher_8_blocks_avx2(ENCIPHER, lanes,
+                  &data[block * ONE_NET_XTEA_BLOCK_SIZE]);
+            } // if 8 blocks //
+            else
+            {
+                cipher_4_blocks_sse2(ENCIPHER, lanes,
+                  &data[block * ONE_NET_XTEA_BLOCK_SIZE]);
+            } // else 4 blocks //
+            block += group;
+        } // while there is a whole group left //
+    }
+    #endif
+
+    for(; block < NUM_BLOCKS; block++)
+    {
+        cipher_block(ENCIPHER, SCHEDULES ? SCHEDULES[block] : SCHEDULE,
+          &data[block * ONE_NET_XTEA_BLOCK_SIZE]);
+    } // loop through the blocks that are left //
+} // cipher_blocks //
+
+
+/*!
+    \brief Enciphers or deciphers one block with a key schedule.
+
+    \param[in] ENCIPHER TRUE to encipher, FALSE to decipher.
+    \param[in] SCHEDULE The expanded key.
+    \param[in/out] data The block.
+
+    \return void
+*/
+static void cipher_block(const BOOL ENCIPHER,
+  const one_net_xtea_key_schedule_t * const SCHEDULE, UInt8 * const data)
+{
+    UInt32 v0, v1;
+    UInt8 i;
+
+    v0 = one_net_byte_stream_to_uint32(data);
+    v1 = one_net_byte_stream_to_uint32(data + sizeof(UInt32));
+
+    if(ENCIPHER)
+    {
+        for(i = 0; i < SCHEDULE->rounds; i++)
+        {
+            v0 += ((v1 << 4 ^ v1 >> 5) + v1) ^ SCHEDULE->sum_k0[i];
+            v1 += ((v0 << 4 ^ v0 >> 5) + v0) ^ SCHEDULE->sum_k1[i];
+        } // encipher loop //
+    } // if enciphering //
+    else
+    {
+        for(i = SCHEDULE->rounds; i > 0; i--)
+        {
+            v1 -= ((v0 << 4 ^ v0 >> 5) + v0) ^ SCHEDULE->sum_k1[i - 1];
+            v0 -= ((v1 << 4 ^ v1 >> 5) + v1) ^ SCHEDULE->sum_k0[i - 1];
+        } // decipher loop //
+    } // else deciphering //
+
+    one_net_uint32_to_byte_stream(v0, data);
+    one_net_uint32_to_byte_stream(v1, data + sizeof(UInt32));
+} // cipher_block //
+
+
+#ifdef XTEA_X86_SIMD
+/*!
+    \brief Enciphers or deciphers 4 blocks side by side using SSE2.
+
+    v[0] and v[1] of each block go in one 32 bit lane of two registers.  All
+    4 schedules must have the same number of rounds.
+
+    \param[in] ENCIPHER TRUE to encipher, FALSE to decipher.
+    \param[in] SCHEDULES The schedule for each of the 4 blocks.
+    \param[in/out] data The 4 blocks.
+
+    \return void
+*/
+__attribute__((target("sse2")))
+static void cipher_4_blocks_sse2(const BOOL ENCIPHER,
+  const one_net_xtea_key_schedule_t * const * const SCHEDULES,
+  UInt8 * const data)
+{
+    UInt32 out0[4], out1[4];
+    __m128i v0, v1, k;
+    UInt8 i, r;
+
+    v0 = _mm_setr_epi32(
+      one_net_byte_stream_to_uint32(&data[0]),
+      one_net_byte_stream_to_uint32(&data[8]),
+      one_net_byte_stream_to_uint32(&data[16]),
+      one_net_byte_stream_to_uint32(&data[24]));
+    v1 = _mm_setr_epi32(
+      one_net_byte_stream_to_uint32(&data[4]),
+      one_net_byte_stream_to_uint32(&data[12]),
+      one_net_byte_stream_to_uint32(&data[20]),
+      one_net_byte_stream_to_uint32(&data[28]));
+
+    if(ENCIPHER)
+    {
+        for(r = 0; r < SCHEDULES[0]->rounds; r++)
+        {
+            k = _mm_setr_epi32(SCHEDULES[0]->sum_k0[r],
+              SCHEDULES[1]->sum_k0[r], SCHEDULES[2]->sum_k0[r],
+              SCHEDULES[3]->sum_k0[r]);
+            v0 = _mm_add_epi32(v0, _mm_xor_si128(_mm_add_epi32(_mm_xor_si128(
+              _mm_slli_epi32(v1, 4), _mm_srli_epi32(v1, 5)), v1), k));
+            k = _mm_setr_epi32(SCHEDULES[0]->sum_k1[r],
+              SCHEDULES[1]->sum_k1[r], SCHEDULES[2]->sum_k1[r],
+              SCHEDULES[3]->sum_k1[r]);
+            v1 = _mm_add_epi32(v1, _mm_xor_si128(_mm_add_epi32(_mm_xor_si128(
+              _mm_slli_epi32(v0, 4), _mm_srli_epi32(v0, 5)), v0), k));
+        } // encipher loop //
+    } // if enciphering //
+    else
+    {
+        for(r = SCHEDULES[0]->rounds; r > 0; r--)
+        {
+            k = _mm_setr_epi32(SCHEDULES[0]->sum_k1[r - 1],
+              SCHEDULES[1]->sum_k1[r - 1], SCHEDULES[2]->sum_k1[r - 1],
+              SCHEDULES[3]->sum_k1[r - 1]);
+            v1 = _mm_sub_epi32(v1, _mm_xor_si128(_mm_add_epi32(_mm_xor_si128(
+              _mm_slli_epi32(v0, 4), _mm_srli_epi32(v0, 5)), v0), k));
+            k = _mm_setr_epi32(SCHEDULES[0]->sum_k0[r - 1],
+              SCHEDULES[1]->sum_k0[r - 1], SCHEDULES[2]->sum_k0[r - 1],
+              SCHEDULES[3]->sum_k0[r - 1]);
+            v0 = _mm_sub_epi32(v0, _mm_xor_si128(_mm_add_epi32(_mm_xor_si128(
+              _mm_slli_epi32(v1, 4), _mm_srli_epi32(v1, 5)), v1), k));
+        } // decipher loop //
+    } // else deciphering //
+
+    _mm_storeu_si128((__m128i *)out0, v0);
+    _mm_storeu_si128((__m128i *)out1, v1);
+    for(i = 0; i < 4; i++)
+    {
+        one_net_uint32_to_byte_stream(out0[i],
+          &data[i * ONE_NET_XTEA_BLOCK_SIZE]);
+        one_net_uint32_to_byte_stream(out1[i],
+          &data[i * ONE_NET_XTEA_BLOCK_SIZE + sizeof(UInt32)]);
+    } // loop through the blocks //
+} // cipher_4_blocks_sse2 //
+
+
+/*!
+    \brief Enciphers or deciphers 8 blocks side by side using AVX2.
+
+    Same as cipher_4_blocks_sse2 with 8 lanes.  All 8 schedules must have the
+    same number of rounds.  When every lane uses the same schedule, each
+    round key is broadcast instead of being gathered from the 8 schedules.
+
+    \param[in] ENCIPHER TRUE to encipher, FALSE to decipher.
+    \param[in] SCHEDULES The schedule for each of the 8 blocks.
+    \param[in/out] data The 8 blocks.
+
+    \return void
+*/
+__attribute__((target("avx2")))
+static void cipher_8_blocks_avx2(const BOOL ENCIPHER,
+  const one_net_xtea_key_schedule_t * const * const SCHEDULES,
+  UInt8 * const data)
+{
+    UInt32 in0[8], in1[8], lane_k0[8], lane_k1[8];
+    __m256i v0, v1, k0, k1;
+    BOOL same_key;
+    UInt8 i, r;
+
+    for(i = 0; i < 8; i++)
+    {
+        in0[i] = one_net_byte_stream_to_uint32(
+          &data[i * ONE_NET_XTEA_BLOCK_SIZE]);
+        in1[i] = one_net_byte_stream_to_uint32(
+          &data[i * ONE_NET_XTEA_BLOCK_SIZE + sizeof(UInt32)]);
+    } // loop through the blocks //
+    v0 = _mm256_loadu_si256((const __m256i *)in0);
+    v1 = _mm256_loadu_si256((const __m256i *)in1);
+
+    for(i = 1; i < 8 && SCHEDULES[i] == SCHEDULES[0]; i++)
+    {
+    } // loop to see if every lane uses the same key //
+    same_key = (i == 8);
+
+    for(r = 0; r < SCHEDULES[0]->rounds; r++)
+    {
+        UInt8 round = ENCIPHER ? r : SCHEDULES[0]->rounds - 1 - r;
+
+        if(same_key)
+        {
+            k0 = _mm256_set1_epi32(SCHEDULES[0]->sum_k0[round]);
+            k1 = _mm256_set1_epi32(SCHEDULES[0]->sum_k1[round]);
+        } // if one key //
+        else
+        {
+            for(i = 0; i < 8; i++)
+            {
+                lane_k0[i] = SCHEDULES[i]->sum_k0[round];
+                lane_k1[i] = SCHEDULES[i]->sum_k1[round];
+            } // loop through the lanes //
+            k0 = _mm256_loadu_si256((const __m256i *)lane_k0);
+            k1 = _mm256_loadu_si256((const __m256i *)lane_k1);
+        } // else a key for each lane //
+
+        if(ENCIPHER)
+        {
+            v0 = _mm256_add_epi32(v0, _mm256_xor_si256(_mm256_add_epi32(
+              _mm256_xor_si256(_mm256_slli_epi32(v1, 4),
+              _mm256_srli_epi32(v1, 5)), v1), k0));
+            v1 = _mm256_add_epi32(v1, _mm256_xor_si256(_mm256_add_epi32(
+              _mm256_xor_si256(_mm256_slli_epi32(v0, 4),
+              _mm256_srli_epi32(v0, 5)), v0), k1));
+        } // if enciphering //
+        else
+        {
+            v1 = _mm256_sub_epi32(v1, _mm256_xor_si256(_mm256_add_epi32(
+              _mm256_xor_si256(_mm256_slli_epi32(v0, 4),
+              _mm256_srli_epi32(v0, 5)), v0), k1));
+            v0 = _mm256_sub_epi32(v0, _mm256_xor_si256(_mm256_add_epi32(
+              _mm256_xor_si256(_mm256_slli_epi32(v1, 4),
+              _mm256_srli_epi32(v1, 5)), v1), k0));
+        } // else deciphering //
+    } // loop through the rounds //
+
+    _mm256_storeu_si256((__m256i *)in0, v0);
+    _mm256_storeu_si256((__m256i *)in1, v1);
+    for(i = 0; i < 8; i++)
+    {
+        one_net_uint32_to_byte_stream(in0[i],
+          &data[i * ONE_NET_XTEA_BLOCK_SIZE]);
+        one_net_uint32_to_byte_stream(in1[i],
+          &data[i * ONE_NET_XTEA_BLOCK_SIZE + sizeof(UInt32)]);
+    } // loop through the blocks //
+} // cipher_8_blocks_avx2 //
+#endif // ifdef XTEA_X86_SIMD //
+#endif // ifdef XTEA_KEY_SCHEDULE //
+
 //! @} one_net_xtea_pri_func
 //                      PRIVATE FUNCTION IMPLEMENTATION END
 //==============================================================================
@@ -66,6 +66,26 @@ enum
     ONE_NET_XTEA_BLOCK_SIZE = 8
 };
 
+
+#ifdef XTEA_KEY_SCHEDULE
+enum
+{
+    //! The most rounds a key schedule can hold.
+    ONE_NET_XTEA_MAX_SCHEDULE_ROUNDS = 32
+};
+#endif
+
+#if defined(XTEA_SIMD) && !defined(XTEA_KEY_SCHEDULE)
+    #error "XTEA_SIMD requires XTEA_KEY_SCHEDULE"
+#endif
+
+//! The SIMD batch cipher is only available on x86 with gcc style
+//! intrinsics.  AVX2 is chosen at run-time if the processor supports it.
+#if defined(XTEA_SIMD) && defined(__GNUC__) && (defined(__x86_64__) \
+  || defined(__i386__))
+    #define XTEA_X86_SIMD
+#endif
+
 //! @} one_net_xtea_const
 //                                  CONSTANTS END
 //==============================================================================
@@ -130,6 +150,28 @@ typedef enum
 } one_net_stream_encryption_t;
 #endif
 
+#ifdef XTEA_KEY_SCHEDULE
+/*!
+    \brief A key expanded for a given number of rounds.
+
+    XTEA only ever uses the key as sum + k[...] where sum only depends on the
+    round.  Those values are worked out once here so enciphering or
+    deciphering a block does not have to convert the key each time.
+*/
+typedef struct
+{
+    //! The number of rounds the schedule is for.
+    UInt8 rounds;
+
+    //! sum + k[sum & 3] for each round, used to update v[0].
+    UInt32 sum_k0[ONE_NET_XTEA_MAX_SCHEDULE_ROUNDS];
+
+    //! sum + k[sum >> 11 & 3] for each round (after DELTA has been added),
+    //! used to update v[1].
+    UInt32 sum_k1[ONE_NET_XTEA_MAX_SCHEDULE_ROUNDS];
+} one_net_xtea_key_schedule_t;
+#endif
+
 
 //! @} one_net_xtea_typedefs
 //                                  TYPEDEFS END
@@ -163,6 +205,23 @@ void one_net_xtea_encipher(const UInt8 ROUNDS, UInt8 * data,
 void one_net_xtea_decipher(const UInt8 ROUNDS, UInt8 * data,
   const one_net_xtea_key_t * const KEY);
 
+#ifdef XTEA_KEY_SCHEDULE
+BOOL one_net_xtea_key_schedule(one_net_xtea_key_schedule_t * const schedule,
+  const UInt8 ROUNDS, const one_net_xtea_key_t * const KEY);
+void one_net_xtea_encipher_blocks(
+  const one_net_xtea_key_schedule_t * const SCHEDULE, UInt8 * data,
+  const UInt16 NUM_BLOCKS);
+void one_net_xtea_decipher_blocks(
+  const one_net_xtea_key_schedule_t * const SCHEDULE, UInt8 * data,
+  const UInt16 NUM_BLOCKS);
+void one_net_xtea_encipher_blocks_multi_key(
+  const one_net_xtea_key_schedule_t * const * const SCHEDULES, UInt8 * data,
+  const UInt16 NUM_BLOCKS);
+void one_net_xtea_decipher_blocks_multi_key(
+  const one_net_xtea_key_schedule_t * const * const SCHEDULES, UInt8 * data,
+  const UInt16 NUM_BLOCKS);
+#endif
+
 //! @} one_net_xtea_pub_func
 //                      PUBLIC FUNCTION DECLARATIONS END
 //==============================================================================
@@ -169,6 +169,16 @@
         #endif
     #endif
 
+    #ifdef BLOCK_MESSAGES_ENABLED
+        // Enable to send block transfers in sliding windows of up to 40
+        // packets.  The packets in a window are sent back to back, only the
+        // ones the receiver's bitmap reports missing are sent again, and the
+        // window and the pauses adapt to the loss seen.
+        #ifndef BLOCK_SLIDING_WINDOW
+            //#define BLOCK_SLIDING_WINDOW
+        #endif
+    #endif
+
     #if defined(BLOCK_MESSAGES_ENABLED) && defined(ONE_NET_CLIENT)
         // Relevant only for clients initiating block / stream.  Enable if the
         // client has the ability to request permission from the master for
@@ -484,6 +494,12 @@
 		#define ENABLE_LIST_COMMAND
 	#endif
 
+	// ENABLE_RTT_COMMAND should be defined if you are implementing the "rtt" command option.
+	// ADAPTIVE_RESPONSE_TIMEOUT must be defined too.
+	#ifndef ENABLE_RTT_COMMAND
+		//#define ENABLE_RTT_COMMAND
+	#endif
+
     // Master Only Commands
     #ifdef ONE_NET_MASTER
 
@@ -677,6 +693,25 @@
 //    #define ONE_NET_MEMORY
 #endif
 
+// Enable ONE_NET_MEMORY_POOL to have one_net_malloc and one_net_free hand out
+// fixed size blocks from a few size classes instead of searching the "heap".
+// Allocating and freeing then take the same short time no matter how the
+// memory has been used.  If ONE_NET_MEMORY_POOL is enabled, ONE_NET_MEMORY
+// must be enabled too and the ONE_NET_POOL_ size classes must be defined in
+// one_net_port_const.h.
+#ifndef ONE_NET_MEMORY_POOL
+//    #define ONE_NET_MEMORY_POOL
+#endif
+
+// Enable ADAPTIVE_RESPONSE_TIMEOUT to keep an estimate of how long single
+// data responses take to come back from each recent destination and to wait
+// only that long (plus a margin) before retrying instead of always waiting
+// the worst case.  ONE_NET_RTT_TABLE_SIZE and ONE_NET_RTT_MIN_MARGIN must be
+// defined in one_net_port_const.h.
+#ifndef ADAPTIVE_RESPONSE_TIMEOUT
+//    #define ADAPTIVE_RESPONSE_TIMEOUT
+#endif
+
 
 
 // Use this feature to override any random channel searching and select a
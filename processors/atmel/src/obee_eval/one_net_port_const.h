@@ -207,8 +207,43 @@ enum
 
     ONE_NET_HEAP_NUM_ENTRIES = 5
 };
+
+#ifdef ONE_NET_MEMORY_POOL
+// see one_net_memory.h
+enum
+{
+    // Size classes of the pool that replaces the "heap" when
+    // ONE_NET_MEMORY_POOL is defined.  A request is given a block from the
+    // smallest class it fits in, so the block sizes must increase from SMALL
+    // to LARGE.  Blocks can be at most 255 bytes and there can be at most 254
+    // blocks in all.
+    ONE_NET_POOL_SMALL_BLOCK_SIZE = 8,
+    ONE_NET_POOL_SMALL_NUM_BLOCKS = 4,
+
+    ONE_NET_POOL_MEDIUM_BLOCK_SIZE = 16,
+    ONE_NET_POOL_MEDIUM_NUM_BLOCKS = 2,
+
+    ONE_NET_POOL_LARGE_BLOCK_SIZE = 36,
+    ONE_NET_POOL_LARGE_NUM_BLOCKS = 1
+};
+#endif // ifdef ONE_NET_MEMORY_POOL //
 #endif
 
+#ifdef ADAPTIVE_RESPONSE_TIMEOUT
+// see one_net_rtt.h
+enum
+{
+    //! The number of destinations round trip times are kept for.  When the
+    //! table is full, the destination heard from least recently is dropped.
+    ONE_NET_RTT_TABLE_SIZE = 8,
+
+    //! The least time in ms added to the smoothed round trip time when
+    //! computing the response timeout, so a steady link that always answers
+    //! in the same time is not retried early because of a little jitter.
+    ONE_NET_RTT_MIN_MARGIN = 10
+};
+#endif // ifdef ADAPTIVE_RESPONSE_TIMEOUT //
+
 
 // data rates -- uncomment any data rates that this device handles.
 // 38,400 must be enabled / uncommented
@@ -238,8 +273,12 @@ enum
 
 #ifdef BLOCK_MESSAGES_ENABLED
 //! Default chunk size for block / stream transfers.  Must be between 1 and
-//! 40, inclusive.
+//! 40, inclusive.  Sliding window transfers ask for the largest window.
+#ifdef BLOCK_SLIDING_WINDOW
+#define DEFAULT_BS_CHUNK_SIZE 40
+#else
 #define DEFAULT_BS_CHUNK_SIZE 4
+#endif
 
 //! Default chunk delay for block / stream.
 #define DEFAULT_BS_CHUNK_DELAY 100
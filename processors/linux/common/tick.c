@@ -36,8 +36,14 @@
     \brief Linux specific timing module.
 
     This module contains functionality associated with timing.
+
+    If SIMULATED_TICK is defined, the tick count does not follow the clock.
+    It only changes when set_tick_count or increment_tick_count is called
+    (and the delay functions move it forward), so a simulation can run the
+    clock as fast or as slow as it likes.
 */
 
+#include "config_options.h"
 #include "tick.h"
 #include <sys/time.h>
 
@@ -173,21 +179,29 @@ void increment_tick_count(tick_t increment)
 
 void delay_ms(UInt16 count)
 {
+    #ifdef SIMULATED_TICK
+    increment_tick_count(MS_TO_TICK(count));
+    #else
     tick_t current_tick_count = get_tick_count();
     tick_t ending_tick_count = current_tick_count + MS_TO_TICK(count);
     while(get_tick_count() < ending_tick_count)
     {
     }
+    #endif
 } // delay_ms //
 
 
 void delay_100s_us(UInt16 count)
 {
+    #ifdef SIMULATED_TICK
+    increment_tick_count(count * (1000000 / 10000));
+    #else
     tick_t current_tick_count = get_tick_count();
     tick_t ending_tick_count = current_tick_count + count * (1000000 / 10000);
     while(get_tick_count() < ending_tick_count)
     {
     }
+    #endif
 } // delay_100us //
 
 
@@ -289,6 +303,11 @@ static struct timeval calculate_start_time_from_tick_count(tick_t tick_count)
 static void update_tick_count(void)
 {
     struct timeval time_now;
+
+    #ifdef SIMULATED_TICK
+    return;
+    #endif
+
     gettimeofday(&time_now, NULL);
     tick_count = elapsed_ticks(time0, time_now);
 }
@@ -76,6 +76,10 @@
     #error "BLOCK_MESSAGES_ENABLED must be defined if STREAM_MESSAGES_ENABLED is defined."
 #endif
 
+#if !defined(BLOCK_MESSAGES_ENABLED) && defined(BLOCK_SLIDING_WINDOW)
+    #error "BLOCK_MESSAGES_ENABLED must be defined if BLOCK_SLIDING_WINDOW is defined."
+#endif
+
 #if !defined(ONE_NET_CLIENT) && !defined(ONE_NET_MASTER)
     #error "ONE_NET_CLIENT and ONE_NET_MASTER cannot both be undefined."
 #endif
@@ -96,6 +100,14 @@
     #error "_US_CHANELS and EUROPE_CHANNELS cannot both be undefined."
 #endif
 
+#if defined(ONE_NET_MEMORY_POOL) && !defined(ONE_NET_MEMORY)
+    #error "ONE_NET_MEMORY must be defined if ONE_NET_MEMORY_POOL is defined."
+#endif
+
+#if defined(ENABLE_RTT_COMMAND) && !defined(ADAPTIVE_RESPONSE_TIMEOUT)
+    #error "ADAPTIVE_RESPONSE_TIMEOUT must be defined if ENABLE_RTT_COMMAND is defined."
+#endif
+
 #ifdef BLOCKING_UART
     #ifndef UART
         #error "UART must be defined if BLOCKING_UART is defined."
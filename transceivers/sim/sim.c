@@ -0,0 +1,1169 @@
+//! \addtogroup SIM
+//! @{
+
+/*
+    Copyright (c) 2012, Threshold Corporation
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+        * Redistributions of source code must retain the above copyright notice,
+          this list of conditions, and the following disclaimer.
+        * Redistributions in binary form must reproduce the above copyright
+          notice, this list of conditions and the following disclaimer in the
+          documentation and/or other materials provided with the distribution.
+        * Neither the name of Threshold Corporation (trustee of ONE-NET) nor the
+          names of its contributors may be used to endorse or promote products
+          derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+    CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+    INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+    BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+    OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+    BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHEWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*!
+    \file sim.c
+    \brief The simulated transceiver and radio medium.
+
+    See sim.h.  A packet that is written is kept as a transmission with a
+    start and end time.  Once it has ended (plus the longest propagation
+    delay) it is delivered to every node that is in range, on the same
+    channel and data rate, and heard nothing else on that channel while it
+    arrived.  A transmission is kept around for a while after it is
+    delivered so that later packets can be checked against it.
+
+    The TAL functions work on the current device.  Each device knows which
+    node it is from a ONE_NET_DEVICE_STATE variable, so the right node is
+    used whether the device was made current by sim_run or by the
+    application.
+*/
+
+#include "config_options.h"
+
+#if !defined(ONE_NET_DEVICE_CONTEXT) || !defined(SIMULATED_TICK)
+    #error "The simulated transceiver needs ONE_NET_DEVICE_CONTEXT and SIMULATED_TICK"
+#endif
+
+#include <stdlib.h>
+#include "sim.h"
+#include "tal.h"
+#include "tick.h"
+#include "one_net_types.h"
+#include "one_net_status_codes.h"
+#include "one_net_channel.h"
+#include "one_net_data_rate.h"
+#include "one_net_features.h"
+#include "one_net_packet.h"
+#include "one_net_port_specific.h"
+#include "one_net_timer.h"
+#include "one_net_message.h"
+#include "one_net.h"
+#ifdef ONE_NET_MASTER
+#include "one_net_master.h"
+#endif
+#ifdef ONE_NET_CLIENT
+#include "one_net_client.h"
+#endif
+#include "one_net_context.h"
+
+
+
+//==============================================================================
+//                                  CONSTANTS
+//! \defgroup SIM_const
+//! \ingroup SIM
+//! @{
+
+
+//! Never
+#define SIM_NEVER ((uint64_t) -1)
+
+
+//! Bits per second for each data rate
+static const UInt32 DATA_RATE_BPS[ONE_NET_DATA_RATE_LIMIT] =
+{
+    38400, 76800, 115200, 153600, 192000, 230400
+};
+
+
+//! @} SIM_const
+//                                  CONSTANTS END
+//==============================================================================
+
+//==============================================================================
+//                                  TYPEDEFS
+//! \defgroup SIM_typedefs
+//! \ingroup SIM
+//! @{
+
+
+//! A packet on the air
+typedef struct
+{
+    BOOL used;
+    BOOL delivered;
+    UInt16 src;
+    UInt8 channel;
+    UInt8 data_rate;
+    uint64_t start;
+    uint64_t end;
+    UInt8 len;
+    UInt8 pkt[ON_MAX_ENCODED_PKT_SIZE];
+} sim_tx_t;
+
+
+//! A packet a node has received
+typedef struct
+{
+    UInt8 len;
+    UInt8 pkt[ON_MAX_ENCODED_PKT_SIZE];
+} sim_rx_pkt_t;
+
+
+typedef struct
+{
+    on_device_context_t* ctx;
+    BOOL is_master;
+
+    //! The channel and data rate the device has set the transceiver to
+    UInt8 channel;
+    UInt8 data_rate;
+
+    //! When the packet being sent will be done, 0 if none has been sent
+    uint64_t tx_end;
+
+    //! When the node is to be run next.  Only the event with the matching
+    //! wake_gen counts.
+    BOOL wake_pending;
+    uint64_t wake_time;
+    UInt32 wake_gen;
+
+    //! Received packets that have not been looked for yet
+    sim_rx_pkt_t rx_queue[SIM_RX_QUEUE_SIZE];
+    UInt8 rx_head;
+    UInt8 rx_count;
+
+    //! The packet being read and how far it has been read
+    sim_rx_pkt_t rx_pkt;
+    UInt8 rx_idx;
+
+    //! Packets looked for, to tell if a run made progress
+    UInt32 rx_taken;
+
+    sim_node_stats_t stats;
+} sim_node_t;
+
+
+typedef enum
+{
+    SIM_EVENT_RUN_NODE,     //!< run a node
+    SIM_EVENT_DELIVER       //!< deliver a transmission
+} sim_event_type_t;
+
+
+typedef struct
+{
+    uint64_t time;
+    UInt32 seq;             //!< so events at the same time keep their order
+    UInt32 gen;             //!< wake_gen for SIM_EVENT_RUN_NODE
+    UInt16 index;           //!< the node or the transmission
+    UInt8 type;
+} sim_event_t;
+
+
+//! @} SIM_typedefs
+//                                  TYPEDEFS END
+//==============================================================================
+
+//==============================================================================
+//                              PUBLIC VARIABLES
+//! \defgroup SIM_pub_var
+//! \ingroup SIM
+//! @{
+
+
+//! The current ONE-NET channel
+ONE_NET_DEVICE_STATE UInt8 current_channel = 0;
+
+//! The current data rate
+ONE_NET_DEVICE_STATE UInt8 current_data_rate = ONE_NET_DATA_RATE_38_4;
+
+
+//! @} SIM_pub_var
+//                              PUBLIC VARIABLES END
+//==============================================================================
+
+//==============================================================================
+//                              PRIVATE VARIABLES
+//! \defgroup SIM_pri_var
+//! \ingroup SIM
+//! @{
+
+
+//! The node this device is
+static ONE_NET_DEVICE_STATE UInt16 this_node = SIM_NO_NODE;
+
+static sim_node_t* nodes = NULL;
+static UInt16 num_nodes = 0;
+static UInt16 max_nodes = 0;
+
+//! max_nodes x max_nodes, from * max_nodes + to
+static sim_link_t* links = NULL;
+
+//! The longest propagation delay of any link
+static UInt16 max_delay = 0;
+
+static sim_tx_t* txs = NULL;
+static UInt16 num_txs = 0;
+
+//! The event heap, earliest first
+static sim_event_t* events = NULL;
+static UInt32 num_events = 0;
+static UInt32 event_capacity = 0;
+static UInt32 event_seq = 0;
+
+static uint64_t now = 0;
+static uint64_t random_state = 1;
+static sim_tx_hook_t tx_hook = NULL;
+
+
+//! @} SIM_pri_var
+//                              PRIVATE VARIABLES END
+//==============================================================================
+
+//==============================================================================
+//                      PRIVATE FUNCTION DECLARATIONS
+//! \defgroup SIM_pri_func
+//! \ingroup SIM
+//! @{
+
+
+static UInt32 sim_random(void);
+static BOOL event_before(const sim_event_t* a, const sim_event_t* b);
+static BOOL push_event(uint64_t time, UInt8 type, UInt16 index, UInt32 gen);
+static void pop_event(sim_event_t* event);
+static void wake_node(UInt16 node, uint64_t time, BOOL replace);
+static void run_node(UInt16 node);
+static uint64_t next_wake_time(const sim_node_t* node);
+static void deliver(UInt16 tx_idx);
+static BOOL collides(UInt16 tx_idx, UInt16 node, uint64_t start,
+  uint64_t end);
+static UInt16 new_tx(void);
+static BOOL in_range(UInt16 from, UInt16 to);
+
+
+//! @} SIM_pri_func
+//                      PRIVATE FUNCTION DECLARATIONS END
+//==============================================================================
+
+//==============================================================================
+//                      PUBLIC FUNCTION IMPLEMENTATION
+//! \defgroup SIM_pub_func
+//! \ingroup SIM
+//! @{
+
+
+/*!
+    \brief Sets up an empty medium with room for max_num_nodes nodes.
+
+    Every link starts out in range with no loss or delay.  The time and the
+    tick count start at 0.
+
+    \param[in] max_num_nodes The most nodes that will be added
+    \param[in] seed Seeds the random numbers used for link loss, so a run
+      can be repeated
+
+    \return ONS_SUCCESS if the medium was set up
+             ONS_BAD_PARAM if max_num_nodes is 0
+             ONS_RSRC_FULL if there is not enough memory
+*/
+one_net_status_t sim_init(UInt16 max_num_nodes, UInt32 seed)
+{
+    sim_free();
+    if(!max_num_nodes || max_num_nodes == SIM_NO_NODE)
+    {
+        return ONS_BAD_PARAM;
+    } // if the parameter is invalid //
+
+    nodes = calloc(max_num_nodes, sizeof(sim_node_t));
+    links = calloc((size_t) max_num_nodes * max_num_nodes, sizeof(sim_link_t));
+    if(!nodes || !links)
+    {
+        sim_free();
+        return ONS_RSRC_FULL;
+    } // if out of memory //
+
+    max_nodes = max_num_nodes;
+    random_state = ((uint64_t) seed << 1) | 1;
+    now = 0;
+    set_tick_count(0);
+    return ONS_SUCCESS;
+} // sim_init //
+
+
+/*!
+    \brief Frees the medium.  The device contexts belong to the caller.
+
+    \return void
+*/
+void sim_free(void)
+{
+    free(nodes);
+    free(links);
+    free(txs);
+    free(events);
+    nodes = NULL;
+    links = NULL;
+    txs = NULL;
+    events = NULL;
+    num_nodes = 0;
+    max_nodes = 0;
+    num_txs = 0;
+    num_events = 0;
+    event_capacity = 0;
+    max_delay = 0;
+    now = 0;
+} // sim_free //
+
+
+/*!
+    \brief Adds a device to the medium.
+
+    The device is made current.  It should already be set up as a MASTER or
+    a CLIENT (or be set up once it is added, then woken with
+    sim_wake_node).  It will first be run at the current time.
+
+    \param[in] ctx The device, set up by one_net_context_init
+    \param[in] is_master TRUE to run it with one_net_master, FALSE to run it
+      with one_net_client
+    \param[out] node The node number it was given
+
+    \return ONS_SUCCESS if the node was added
+             ONS_BAD_PARAM if a parameter is invalid
+             ONS_RSRC_FULL if there is no room for another node
+*/
+one_net_status_t sim_add_node(on_device_context_t* ctx, BOOL is_master,
+  UInt16* node)
+{
+    sim_node_t* new_node;
+
+    if(!ctx || !node)
+    {
+        return ONS_BAD_PARAM;
+    } // if a parameter is invalid //
+
+    #ifndef ONE_NET_MASTER
+    if(is_master)
+    {
+        return ONS_BAD_PARAM;
+    } // if a MASTER can't be run //
+    #endif
+    #ifndef ONE_NET_CLIENT
+    if(!is_master)
+    {
+        return ONS_BAD_PARAM;
+    } // if a CLIENT can't be run //
+    #endif
+
+    if(num_nodes >= max_nodes)
+    {
+        return ONS_RSRC_FULL;
+    } // if no room //
+
+    *node = num_nodes++;
+    new_node = &nodes[*node];
+    one_net_memset(new_node, 0, sizeof(sim_node_t));
+    new_node->ctx = ctx;
+    new_node->is_master = is_master;
+
+    one_net_set_context(ctx);
+    this_node = *node;
+    new_node->channel = current_channel;
+    new_node->data_rate = current_data_rate;
+
+    wake_node(*node, now, FALSE);
+    return ONS_SUCCESS;
+} // sim_add_node //
+
+
+UInt16 sim_num_nodes(void)
+{
+    return num_nodes;
+} // sim_num_nodes //
+
+
+on_device_context_t* sim_node_context(UInt16 node)
+{
+    return node < num_nodes ? nodes[node].ctx : NULL;
+} // sim_node_context //
+
+
+/*!
+    \brief Sets one direction of a link.
+
+    \param[in] from The sending node
+    \param[in] to The receiving node
+    \param[in] loss The chance a packet is lost in hundredths of a percent,
+      or SIM_OUT_OF_RANGE
+    \param[in] delay The propagation delay in ticks
+
+    \return ONS_SUCCESS if the link was set
+             ONS_BAD_PARAM if a parameter is invalid
+*/
+one_net_status_t sim_set_link(UInt16 from, UInt16 to, UInt16 loss,
+  UInt16 delay)
+{
+    if(from >= max_nodes || to >= max_nodes || from == to ||
+      (loss > SIM_LOSS_ALL && loss != SIM_OUT_OF_RANGE))
+    {
+        return ONS_BAD_PARAM;
+    } // if a parameter is invalid //
+
+    links[(size_t) from * max_nodes + to].loss = loss;
+    links[(size_t) from * max_nodes + to].delay = delay;
+    if(delay > max_delay)
+    {
+        max_delay = delay;
+    } // if the longest delay so far //
+
+    return ONS_SUCCESS;
+} // sim_set_link //
+
+
+one_net_status_t sim_get_link(UInt16 from, UInt16 to, sim_link_t* link)
+{
+    if(from >= max_nodes || to >= max_nodes || !link)
+    {
+        return ONS_BAD_PARAM;
+    } // if a parameter is invalid //
+
+    *link = links[(size_t) from * max_nodes + to];
+    return ONS_SUCCESS;
+} // sim_get_link //
+
+
+/*!
+    \brief Has a node run at the current time.
+
+    Call this after doing something to a device from outside of sim_run
+    (queueing a message, starting a block transfer, etc.) so it is acted on
+    right away instead of whenever the node would next have woken up.
+
+    \param[in] node The node to run
+
+    \return void
+*/
+void sim_wake_node(UInt16 node)
+{
+    if(node < num_nodes)
+    {
+        wake_node(node, now, FALSE);
+    } // if the node is valid //
+} // sim_wake_node //
+
+
+void sim_set_tx_hook(sim_tx_hook_t hook)
+{
+    tx_hook = hook;
+} // sim_set_tx_hook //
+
+
+//! The current simulated time in ticks
+uint64_t sim_time(void)
+{
+    return now;
+} // sim_time //
+
+
+/*!
+    \brief Runs the simulation.
+
+    Handles every event up to and including end_time in order, then leaves
+    the time at end_time.
+
+    \param[in] end_time The time to run to in ticks
+
+    \return void
+*/
+void sim_run(uint64_t end_time)
+{
+    sim_run_until(end_time, NULL);
+} // sim_run //
+
+
+/*!
+    \brief Runs the simulation until something has happened.
+
+    Like sim_run, but done is called each time a node has been run.  If it
+    returns TRUE, the time is left where it is and nothing more is run.
+
+    \param[in] end_time The latest time to run to in ticks
+    \param[in] done Says when to stop.  May be NULL.
+
+    \return TRUE if done stopped the run
+             FALSE if end_time was reached
+*/
+BOOL sim_run_until(uint64_t end_time, sim_run_hook_t done)
+{
+    sim_event_t event;
+
+    while(num_events && events[0].time <= end_time)
+    {
+        pop_event(&event);
+        if(event.time > now)
+        {
+            now = event.time;
+        } // if time has moved on //
+
+        switch(event.type)
+        {
+            case SIM_EVENT_RUN_NODE:
+            {
+                if(nodes[event.index].wake_pending &&
+                  event.gen == nodes[event.index].wake_gen)
+                {
+                    run_node(event.index);
+                    if(done && (*done)(event.index))
+                    {
+                        return TRUE;
+                    } // if finished //
+                } // if the node has not been rescheduled since //
+                break;
+            } // case SIM_EVENT_RUN_NODE //
+
+            case SIM_EVENT_DELIVER:
+            {
+                deliver(event.index);
+                break;
+            } // case SIM_EVENT_DELIVER //
+        } // switch on the event type //
+    } // loop through the events //
+
+    if(end_time > now)
+    {
+        now = end_time;
+    } // if the time needs to be moved to the end //
+    set_tick_count((tick_t) now);
+    return FALSE;
+} // sim_run_until //
+
+
+const sim_node_stats_t* sim_node_stats(UInt16 node)
+{
+    return node < num_nodes ? &nodes[node].stats : NULL;
+} // sim_node_stats //
+
+
+/*!
+    \brief How long a packet takes to send.
+
+    \param[in] len The length of the packet including preamble and header
+    \param[in] data_rate The data rate it is sent at
+
+    \return The time on the air in ticks, rounded up
+*/
+UInt32 sim_airtime(UInt8 len, UInt8 data_rate)
+{
+    uint64_t bps;
+
+    if(data_rate >= ONE_NET_DATA_RATE_LIMIT)
+    {
+        data_rate = ONE_NET_DATA_RATE_38_4;
+    } // if the data rate is invalid //
+
+    bps = DATA_RATE_BPS[data_rate];
+    return (UInt32)(((uint64_t) len * 8 * MS_TO_TICK(1000) + bps - 1) / bps);
+} // sim_airtime //
+
+
+/*!
+    \brief The TAL for the simulated transceiver.  See tal.h.
+*/
+void tal_init_transceiver(void)
+{
+} // tal_init_transceiver //
+
+
+void tal_enable_transceiver(void)
+{
+} // tal_enable_transceiver //
+
+
+void tal_disable_transceiver(void)
+{
+} // tal_disable_transceiver //
+
+
+one_net_status_t tal_set_channel(const UInt8 channel)
+{
+    if(channel >= ONE_NET_NUM_CHANNELS)
+    {
+        return ONS_BAD_PARAM;
+    } // if the parameter is invalid //
+
+    current_channel = channel;
+    if(this_node != SIM_NO_NODE)
+    {
+        nodes[this_node].channel = channel;
+    } // if this device is on the medium //
+    return ONS_SUCCESS;
+} // tal_set_channel //
+
+
+one_net_status_t tal_set_data_rate(UInt8 data_rate)
+{
+    #ifndef DATA_RATE_CHANNEL
+    if(data_rate != ONE_NET_DATA_RATE_38_4)
+    {
+        return ONS_DEVICE_NOT_CAPABLE;
+    }
+    #else
+    if(!features_data_rate_capable(THIS_DEVICE_FEATURES, data_rate))
+    {
+        return ONS_DEVICE_NOT_CAPABLE;
+    }
+    #endif
+
+    current_data_rate = data_rate;
+    if(this_node != SIM_NO_NODE)
+    {
+        nodes[this_node].data_rate = data_rate;
+    } // if this device is on the medium //
+    return ONS_SUCCESS;
+} // tal_set_data_rate //
+
+
+//! Busy if this node can hear anything else on its channel right now
+BOOL tal_channel_is_clear(void)
+{
+    UInt16 i;
+    const sim_tx_t* tx;
+    uint64_t delay;
+
+    if(this_node == SIM_NO_NODE)
+    {
+        return TRUE;
+    } // if this device is not on the medium //
+
+    for(i = 0; i < num_txs; i++)
+    {
+        tx = &txs[i];
+        if(!tx->used || tx->src == this_node ||
+          tx->channel != nodes[this_node].channel ||
+          !in_range(tx->src, this_node))
+        {
+            continue;
+        } // if this node can't hear it //
+
+        delay = links[(size_t) tx->src * max_nodes + this_node].delay;
+        if(tx->start + delay <= now && now < tx->end + delay)
+        {
+            return FALSE;
+        } // if it is arriving now //
+    } // loop through the transmissions //
+
+    return TRUE;
+} // tal_channel_is_clear //
+
+
+UInt8 tal_write_packet(const UInt8 * data, const UInt8 len)
+{
+    UInt16 tx_idx;
+    sim_tx_t* tx;
+    sim_node_t* node;
+
+    if(!data || !len || len > ON_MAX_ENCODED_PKT_SIZE ||
+      this_node == SIM_NO_NODE)
+    {
+        return 0;
+    } // if the parameters are invalid or the device is not on the medium //
+
+    if((tx_idx = new_tx()) == SIM_NO_NODE)
+    {
+        return 0;
+    } // if out of memory //
+
+    node = &nodes[this_node];
+    tx = &txs[tx_idx];
+    tx->src = this_node;
+    tx->channel = node->channel;
+    tx->data_rate = node->data_rate;
+    tx->start = now;
+    tx->end = now + sim_airtime(len, node->data_rate);
+    tx->len = len;
+    one_net_memmove(tx->pkt, data, len);
+
+    if(!push_event(tx->end + max_delay, SIM_EVENT_DELIVER, tx_idx, 0))
+    {
+        tx->used = FALSE;
+        return 0;
+    } // if out of memory //
+
+    node->tx_end = tx->end;
+    node->stats.tx_pkts++;
+    node->stats.tx_time += tx->end - tx->start;
+
+    if(tx_hook)
+    {
+        (*tx_hook)(this_node, tx->start, tx->end, tx->channel, tx->data_rate,
+          tx->pkt, tx->len);
+    } // if someone is watching //
+
+    return len;
+} // tal_write_packet //
+
+
+BOOL tal_write_packet_done(void)
+{
+    return this_node == SIM_NO_NODE || nodes[this_node].tx_end <= now;
+} // tal_write_packet_done //
+
+
+UInt8 tal_read_bytes(UInt8 * data, const UInt8 len)
+{
+    sim_node_t* node;
+    UInt8 bytes_to_read;
+
+    if(!data || !len || this_node == SIM_NO_NODE)
+    {
+        return 0;
+    } // if the parameters are invalid or the device is not on the medium //
+
+    node = &nodes[this_node];
+    if(ONE_NET_PREAMBLE_HEADER_LEN + node->rx_idx >= node->rx_pkt.len)
+    {
+        return 0;
+    } // if there is no more to read //
+
+    bytes_to_read = node->rx_pkt.len - ONE_NET_PREAMBLE_HEADER_LEN -
+      node->rx_idx;
+    if(bytes_to_read > len)
+    {
+        bytes_to_read = len;
+    } // if more is available than was asked for //
+
+    one_net_memmove(data, &(node->rx_pkt.pkt[ONE_NET_PREAMBLE_HEADER_LEN +
+      node->rx_idx]), bytes_to_read);
+    node->rx_idx += bytes_to_read;
+    return bytes_to_read;
+} // tal_read_bytes //
+
+
+//! Time does not pass while looking.  If a packet has arrived it is there.
+one_net_status_t tal_look_for_packet(tick_t duration)
+{
+    sim_node_t* node;
+
+    if(this_node == SIM_NO_NODE)
+    {
+        return ONS_TIME_OUT;
+    } // if the device is not on the medium //
+
+    node = &nodes[this_node];
+    node->rx_pkt.len = 0;
+    node->rx_idx = 0;
+    if(!node->rx_count)
+    {
+        return ONS_TIME_OUT;
+    } // if nothing has arrived //
+
+    node->rx_pkt = node->rx_queue[node->rx_head];
+    node->rx_head = (node->rx_head + 1) % SIM_RX_QUEUE_SIZE;
+    node->rx_count--;
+    node->rx_taken++;
+    return ONS_SUCCESS;
+} // tal_look_for_packet //
+
+
+//! @} SIM_pub_func
+//                      PUBLIC FUNCTION IMPLEMENTATION END
+//==============================================================================
+
+//==============================================================================
+//                      PRIVATE FUNCTION IMPLEMENTATION
+//! \defgroup SIM_pri_func
+//! \ingroup SIM
+//! @{
+
+
+//! xorshift64*
+static UInt32 sim_random(void)
+{
+    random_state ^= random_state >> 12;
+    random_state ^= random_state << 25;
+    random_state ^= random_state >> 27;
+    return (UInt32)((random_state * 2685821657736338717ULL) >> 32);
+} // sim_random //
+
+
+static BOOL event_before(const sim_event_t* a, const sim_event_t* b)
+{
+    return a->time < b->time || (a->time == b->time && a->seq < b->seq);
+} // event_before //
+
+
+static BOOL push_event(uint64_t time, UInt8 type, UInt16 index, UInt32 gen)
+{
+    UInt32 i, parent;
+    sim_event_t event;
+
+    if(num_events == event_capacity)
+    {
+        UInt32 new_capacity = event_capacity ? event_capacity * 2 : 256;
+        sim_event_t* new_events = realloc(events, new_capacity *
+          sizeof(sim_event_t));
+        if(!new_events)
+        {
+            return FALSE;
+        } // if out of memory //
+        events = new_events;
+        event_capacity = new_capacity;
+    } // if the heap is full //
+
+    event.time = time;
+    event.seq = event_seq++;
+    event.gen = gen;
+    event.index = index;
+    event.type = type;
+
+    // sift up
+    for(i = num_events++; i > 0; i = parent)
+    {
+        parent = (i - 1) / 2;
+        if(!event_before(&event, &events[parent]))
+        {
+            break;
+        } // if in place //
+        events[i] = events[parent];
+    } // loop up the heap //
+    events[i] = event;
+    return TRUE;
+} // push_event //
+
+
+static void pop_event(sim_event_t* event)
+{
+    UInt32 i, child;
+    sim_event_t last;
+
+    *event = events[0];
+    last = events[--num_events];
+
+    // sift the last event down from the top
+    for(i = 0; (child = 2 * i + 1) < num_events; i = child)
+    {
+        if(child + 1 < num_events && event_before(&events[child + 1],
+          &events[child]))
+        {
+            child++;
+        } // if the right child is earlier //
+        if(!event_before(&events[child], &last))
+        {
+            break;
+        } // if in place //
+        events[i] = events[child];
+    } // loop down the heap //
+    events[i] = last;
+} // pop_event //
+
+
+/*!
+    \brief Schedules a node to be run.
+
+    \param[in] node The node
+    \param[in] time When to run it
+    \param[in] replace If TRUE, this replaces when the node was going to run.
+      If FALSE, the node runs at the earlier of the two.
+
+    \return void
+*/
+static void wake_node(UInt16 node, uint64_t time, BOOL replace)
+{
+    sim_node_t* sim_node = &nodes[node];
+
+    if(!replace && sim_node->wake_pending && sim_node->wake_time <= time)
+    {
+        return;
+    } // if it will already be run by then //
+
+    sim_node->wake_gen++;
+    if(push_event(time, SIM_EVENT_RUN_NODE, node, sim_node->wake_gen))
+    {
+        sim_node->wake_pending = TRUE;
+        sim_node->wake_time = time;
+    } // if scheduled //
+} // wake_node //
+
+
+/*!
+    \brief Runs a node for as long as it makes progress, then works out when
+      it next has something to do.
+
+    \param[in] node The node to run
+
+    \return void
+*/
+static void run_node(UInt16 node)
+{
+    sim_node_t* sim_node = &nodes[node];
+    on_state_t state;
+    UInt32 rx_taken, tx_pkts;
+    UInt8 i;
+
+    sim_node->wake_pending = FALSE;
+    set_tick_count((tick_t) now);
+    one_net_set_context(sim_node->ctx);
+
+    for(i = 0; i < SIM_MAX_RUNS_PER_EVENT; i++)
+    {
+        state = on_state;
+        rx_taken = sim_node->rx_taken;
+        tx_pkts = sim_node->stats.tx_pkts;
+
+        sim_node->stats.runs++;
+        #if defined(ONE_NET_MASTER) && defined(ONE_NET_CLIENT)
+        if(sim_node->is_master)
+        {
+            one_net_master(sim_node->ctx);
+        } // if a MASTER //
+        else
+        {
+            one_net_client(sim_node->ctx);
+        } // else a CLIENT //
+        #elif defined(ONE_NET_MASTER)
+        one_net_master(sim_node->ctx);
+        #else
+        one_net_client(sim_node->ctx);
+        #endif
+
+        if(on_state == state && sim_node->rx_taken == rx_taken &&
+          sim_node->stats.tx_pkts == tx_pkts)
+        {
+            break;
+        } // if nothing happened //
+    } // loop while the node is making progress //
+
+    wake_node(node, next_wake_time(sim_node), TRUE);
+} // run_node //
+
+
+/*!
+    \brief The next time the current device has something to do.
+
+    That is when its packet is done being sent, when the first of its
+    running timers expires, or when the first message in its queue is due,
+    but no later than SIM_MAX_SLEEP from now.  Packets arriving wake the
+    node too.
+
+    \param[in] node The node, whose device must be current
+
+    \return The time to run the node next
+*/
+static uint64_t next_wake_time(const sim_node_t* node)
+{
+    uint64_t next = now + SIM_MAX_SLEEP;
+    tick_t remaining;
+
+    if(node->tx_end > now && node->tx_end < next)
+    {
+        next = node->tx_end;
+    } // if sending //
+
+    // A timer that has expired but is still running is waiting on something
+    // else, so it is not a reason to run.
+    if(ont_next_deadline(&remaining) && now + remaining < next)
+    {
+        next = now + remaining;
+    } // if a timer expires before then //
+
+    #if SINGLE_QUEUE_LEVEL > MIN_SINGLE_QUEUE_LEVEL
+    if(single_data_queue_ready_to_send(&remaining) == -1 && remaining > 0 &&
+      now + remaining < next)
+    {
+        next = now + remaining;
+    } // if a queued message is due before then //
+    #endif
+
+    return next;
+} // next_wake_time //
+
+
+/*!
+    \brief Delivers a transmission to the nodes that receive it.
+
+    \param[in] tx_idx The transmission
+
+    \return void
+*/
+static void deliver(UInt16 tx_idx)
+{
+    sim_tx_t* tx = &txs[tx_idx];
+    const sim_link_t* link;
+    sim_node_t* node;
+    UInt16 i;
+
+    tx->delivered = TRUE;
+    for(i = 0; i < num_nodes; i++)
+    {
+        if(i == tx->src || !in_range(tx->src, i))
+        {
+            continue;
+        } // if this node can't hear it //
+
+        node = &nodes[i];
+        if(node->channel != tx->channel || node->data_rate != tx->data_rate)
+        {
+            continue;
+        } // if not listening to it //
+
+        link = &links[(size_t) tx->src * max_nodes + i];
+        if(collides(tx_idx, i, tx->start + link->delay, tx->end + link->delay))
+        {
+            node->stats.collided_pkts++;
+            continue;
+        } // if something else was heard at the same time //
+
+        if(link->loss && sim_random() % SIM_LOSS_ALL < link->loss)
+        {
+            node->stats.lost_pkts++;
+            continue;
+        } // if lost //
+
+        if(node->rx_count >= SIM_RX_QUEUE_SIZE)
+        {
+            node->stats.dropped_pkts++;
+            continue;
+        } // if there is no room //
+
+        node->rx_queue[(node->rx_head + node->rx_count) %
+          SIM_RX_QUEUE_SIZE].len = tx->len;
+        one_net_memmove(node->rx_queue[(node->rx_head + node->rx_count) %
+          SIM_RX_QUEUE_SIZE].pkt, tx->pkt, tx->len);
+        node->rx_count++;
+        node->stats.rx_pkts++;
+        wake_node(i, now, FALSE);
+    } // loop through the nodes //
+} // deliver //
+
+
+/*!
+    \brief Whether anything else on the channel reaches a node while a
+      packet is arriving at it, including the node sending itself.
+
+    \param[in] tx_idx The packet
+    \param[in] node The node receiving it
+    \param[in] start When the packet starts arriving
+    \param[in] end When it is done arriving
+
+    \return TRUE if the packet is lost to a collision
+*/
+static BOOL collides(UInt16 tx_idx, UInt16 node, uint64_t start,
+  uint64_t end)
+{
+    const sim_tx_t* tx;
+    uint64_t delay;
+    UInt16 i;
+
+    for(i = 0; i < num_txs; i++)
+    {
+        tx = &txs[i];
+        if(i == tx_idx || !tx->used || tx->channel != txs[tx_idx].channel)
+        {
+            continue;
+        } // if it can't collide //
+
+        if(tx->src == node)
+        {
+            delay = 0;
+        } // if the node was sending //
+        else if(in_range(tx->src, node))
+        {
+            delay = links[(size_t) tx->src * max_nodes + node].delay;
+        } // else if the node can hear it //
+        else
+        {
+            continue;
+        } // else it does not reach the node //
+
+        if(tx->start + delay < end && start < tx->end + delay)
+        {
+            return TRUE;
+        } // if they overlap //
+    } // loop through the transmissions //
+
+    return FALSE;
+} // collides //
+
+
+/*!
+    \brief Finds room for a new transmission.
+
+    A transmission that was delivered is kept until nothing that could have
+    overlapped it anywhere is still to be delivered, then its room is used
+    again.
+
+    \return The index of the transmission, SIM_NO_NODE if out of memory
+*/
+static UInt16 new_tx(void)
+{
+    uint64_t hold = 2 * (uint64_t) max_delay +
+      sim_airtime(ON_MAX_ENCODED_PKT_SIZE, ONE_NET_DATA_RATE_38_4);
+    UInt16 i, found = SIM_NO_NODE;
+
+    for(i = 0; i < num_txs; i++)
+    {
+        if(txs[i].used && txs[i].delivered && txs[i].end + hold < now)
+        {
+            txs[i].used = FALSE;
+        } // if done with it //
+
+        if(!txs[i].used && found == SIM_NO_NODE)
+        {
+            found = i;
+        } // if the first free one //
+    } // loop through the transmissions //
+
+    if(found == SIM_NO_NODE)
+    {
+        sim_tx_t* new_txs;
+
+        if(num_txs == SIM_NO_NODE - 1)
+        {
+            return SIM_NO_NODE;
+        } // if too many //
+
+        if(!(new_txs = realloc(txs, (num_txs + 1) * sizeof(sim_tx_t))))
+        {
+            return SIM_NO_NODE;
+        } // if out of memory //
+        txs = new_txs;
+        found = num_txs++;
+    } // if there was no free room //
+
+    txs[found].used = TRUE;
+    txs[found].delivered = FALSE;
+    return found;
+} // new_tx //
+
+
+static BOOL in_range(UInt16 from, UInt16 to)
+{
+    return links[(size_t) from * max_nodes + to].loss <= SIM_LOSS_ALL;
+} // in_range //
+
+
+//! @} SIM_pri_func
+//                      PRIVATE FUNCTION IMPLEMENTATION END
+//==============================================================================
+
+//! @} SIM
@@ -0,0 +1,227 @@
+#ifndef SIM_H
+#define SIM_H
+
+//! \defgroup SIM Simulated transceiver and radio medium.
+//! \ingroup TAL
+//! @{
+
+/*
+    Copyright (c) 2012, Threshold Corporation
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+        * Redistributions of source code must retain the above copyright notice,
+          this list of conditions, and the following disclaimer.
+        * Redistributions in binary form must reproduce the above copyright
+          notice, this list of conditions and the following disclaimer in the
+          documentation and/or other materials provided with the distribution.
+        * Neither the name of Threshold Corporation (trustee of ONE-NET) nor the
+          names of its contributors may be used to endorse or promote products
+          derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+    CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+    INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+    BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+    OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+    BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+    LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+    NEGLIGENCE OR OTHEWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*!
+    \file sim.h
+    \brief A simulated transceiver and the radio medium it shares.
+
+    sim.c implements the TAL for any number of devices run in one process
+    (see one_net_context.h).  Instead of a radio, every packet written goes
+    into a shared medium that delivers it to the other devices according to
+    the link between them (loss and propagation delay), their channel and
+    data rate, and whatever else is on the air at the same time (collisions,
+    carrier sense, half duplex).
+
+    Time is virtual.  sim_run runs the devices as a discrete event
+    simulation, jumping the tick count (SIMULATED_TICK) from one event to the
+    next: a packet arriving, a transmission ending, a ONE-NET timer expiring,
+    or a queued message coming due.  A device with nothing to do costs
+    nothing until one of those happens, so simulated time usually goes far
+    faster than real time.
+
+    Times are in ticks, which are microseconds on the Linux port, and are
+    kept in 64 bits.  The tick count ONE-NET sees is the low 32 bits, which
+    the ONE-NET timers already handle rolling over.
+
+    Needs ONE_NET_DEVICE_CONTEXT and SIMULATED_TICK.  Link with sim.o
+    instead of another transceiver.
+*/
+
+#include "config_options.h"
+#include "one_net_types.h"
+#include "one_net_status_codes.h"
+#include "one_net_context.h"
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+//==============================================================================
+//                                  CONSTANTS
+//! \defgroup SIM_const
+//! \ingroup SIM
+//! @{
+
+
+enum
+{
+    //! No loss on a link
+    SIM_LOSS_NONE = 0,
+
+    //! Every packet is lost.  A link with more loss than this is out of
+    //! range.  Nothing sent on it is heard at all, so it does not collide
+    //! with other packets or keep the channel busy.
+    SIM_LOSS_ALL = 10000,
+
+    //! Loss for a link that is out of range
+    SIM_OUT_OF_RANGE = 0xFFFF
+};
+
+
+//! Not a node
+#define SIM_NO_NODE 0xFFFF
+
+
+//! Packets a node can have received but not yet read.  Any more are
+//! dropped.
+#ifndef SIM_RX_QUEUE_SIZE
+    #define SIM_RX_QUEUE_SIZE 4
+#endif
+
+
+//! The longest a node is left alone in ticks, even if it has nothing
+//! scheduled
+#ifndef SIM_MAX_SLEEP
+    #define SIM_MAX_SLEEP 1000000
+#endif
+
+
+//! The most times a node is run at one point in time while it keeps making
+//! progress
+#ifndef SIM_MAX_RUNS_PER_EVENT
+    #define SIM_MAX_RUNS_PER_EVENT 32
+#endif
+
+
+//! @} SIM_const
+//                                  CONSTANTS END
+//==============================================================================
+
+//==============================================================================
+//                                  TYPEDEFS
+//! \defgroup SIM_typedefs
+//! \ingroup SIM
+//! @{
+
+
+//! One direction of the link between two nodes
+typedef struct
+{
+    //! The chance a packet is lost, in hundredths of a percent
+    //! (SIM_LOSS_NONE to SIM_LOSS_ALL), or SIM_OUT_OF_RANGE
+    UInt16 loss;
+
+    //! Propagation delay in ticks
+    UInt16 delay;
+} sim_link_t;
+
+
+//! What happened to the packets a node sent and the packets sent to it
+typedef struct
+{
+    UInt32 tx_pkts;         //!< packets sent
+    uint64_t tx_time;       //!< ticks spent sending
+    UInt32 rx_pkts;         //!< packets received
+    UInt32 lost_pkts;       //!< packets lost to link loss
+    UInt32 collided_pkts;   //!< packets lost to collisions or sending
+    UInt32 dropped_pkts;    //!< packets lost because the receive queue was full
+    UInt32 runs;            //!< times one_net_master / one_net_client was run
+} sim_node_stats_t;
+
+
+/*!
+    \brief Called for each packet put on the air.
+
+    \param[in] node The node sending the packet
+    \param[in] start The time the packet starts
+    \param[in] end The time the packet ends
+    \param[in] channel The channel it is sent on
+    \param[in] data_rate The data rate it is sent at
+    \param[in] pkt The encoded packet, including the preamble and header
+    \param[in] len The length of pkt
+
+    \return void
+*/
+typedef void (*sim_tx_hook_t)(UInt16 node, uint64_t start, uint64_t end,
+  UInt8 channel, UInt8 data_rate, const UInt8* pkt, UInt8 len);
+
+
+/*!
+    \brief Called after a node has been run by sim_run_until, while its device
+      is still the current one.
+
+    \param[in] node The node that was run
+
+    \return TRUE to stop running
+*/
+typedef BOOL (*sim_run_hook_t)(UInt16 node);
+
+
+//! @} SIM_typedefs
+//                                  TYPEDEFS END
+//==============================================================================
+
+//==============================================================================
+//                      PUBLIC FUNCTION DECLARATIONS
+//! \defgroup SIM_pub_func
+//! \ingroup SIM
+//! @{
+
+
+one_net_status_t sim_init(UInt16 max_num_nodes, UInt32 seed);
+void sim_free(void);
+one_net_status_t sim_add_node(on_device_context_t* ctx, BOOL is_master,
+  UInt16* node);
+UInt16 sim_num_nodes(void);
+on_device_context_t* sim_node_context(UInt16 node);
+one_net_status_t sim_set_link(UInt16 from, UInt16 to, UInt16 loss,
+  UInt16 delay);
+one_net_status_t sim_get_link(UInt16 from, UInt16 to, sim_link_t* link);
+void sim_wake_node(UInt16 node);
+void sim_set_tx_hook(sim_tx_hook_t hook);
+uint64_t sim_time(void);
+void sim_run(uint64_t end_time);
+BOOL sim_run_until(uint64_t end_time, sim_run_hook_t done);
+const sim_node_stats_t* sim_node_stats(UInt16 node);
+UInt32 sim_airtime(UInt8 len, UInt8 data_rate);
+
+
+//! @} SIM_pub_func
+//                      PUBLIC FUNCTION DECLARATIONS END
+//==============================================================================
+
+
+#ifdef __cplusplus
+}
+#endif
+
+//! @} SIM
+
+#endif // SIM_H //